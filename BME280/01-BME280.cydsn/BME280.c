@@ -6,7 +6,6 @@
 */
 
 #include "BME280.h"
-#include "BME280_I2C_Interface.h"
 #include "BME280_RegMap.h"
 #include "CyLib.h" 
 
@@ -15,44 +14,64 @@
 /******************************************/
 
 /**
-*   \brief I2C Address of the BME280 sensor.
+*   \brief Byte to write on the reset register.
 */
-#define BME280_I2C_ADDRESS 0x76
+#define BME280_SOFT_RESET_COMMAND 0xB6
 
 /**
-*   \brief Byte to write on the reset register.
+*   \brief Number of registers for temperature and pressure calibration data.
 */
-#define BME280_SOFT_RESET_COMMAND 0xB6
+#define BME280_TEMP_PRESS_CALIB_DATA_LEN 26
 
 /**
-*   \brief Device sleep mode bit settings.
+*   \brief Number of registers for humidity calibration data.
 */
-#define BME280_SLEEP_MODE 0x00
+#define BME280_HUMIDITY_CALIB_DATA_LEN 7
 
 /**
-*   \brief Device force mode bit settings.
+*   \brief Number of registers read to check stored calibration data (dig_T1 to dig_T3).
 */
-#define BME280_FORCED_MODE 0x01
+#define BME280_CALIB_CHECK_LEN 6
 
 /**
-*   \brief Device normal mode bit settings.
+*   \brief Number of registers from #BME280_CTRL_HUM_REG_ADDR to #BME280_CONFIG_REG_ADDR.
 */
-#define BME280_NORMAL_MODE 0x03
+#define BME280_CONFIG_REGS_LEN 4
 
 /**
-*   \brief Number of registers for temperature and pressure calibration data.
+*   \brief Maximum number of register/value pairs written by #BME280_ApplySettings.
 */
-#define BME280_TEMP_PRESS_CALIB_DATA_LEN 26
+#define BME280_MAX_SETTINGS_PAIRS 4
 
 /**
-*   \brief Number of registers for humidity calibration data.
+*   \brief Fixed part of the typical measurement time [us].
 */
-#define BME280_HUMIDITY_CALIB_DATA_LEN 7
+#define BME280_MEAS_TIME_TYP_OFFSET 1000
+
+/**
+*   \brief Typical measurement time per oversampling step [us].
+*/
+#define BME280_MEAS_TIME_TYP_PER_OSR 2000
+
+/**
+*   \brief Typical pressure and humidity setup time [us].
+*/
+#define BME280_MEAS_TIME_TYP_SETUP 500
+
+/**
+*   \brief Fixed part of the maximum measurement time [us].
+*/
+#define BME280_MEAS_TIME_MAX_OFFSET 1250
+
+/**
+*   \brief Maximum measurement time per oversampling step [us].
+*/
+#define BME280_MEAS_TIME_MAX_PER_OSR 2300
 
 /**
-*   \brief Number of registers with pressure, temperature, and humidity data.
+*   \brief Maximum pressure and humidity setup time [us].
 */
-#define BME280_P_T_H_DATA_LEN 8
+#define BME280_MEAS_TIME_MAX_SETUP 575
 
 /**
 *   \brief Macro to concatenate bytes together.
@@ -74,58 +93,35 @@
 static BME280_ErrorCode BME280_SetMode(BME280* bme280, uint8_t mode);
 
 /**
-*   \brief Compensate raw temperature values.
-*
-*   This function is used to compensate the raw temperature values and convert them
-*   in signed 32 bit integers.
-*
-*   \param[in] bme280 : pointer to device structure
-*
-*   \return Compensated temperature data.
-*   \retval Compensated temperature data as 32 bit signed integer.
-*
-*/
-static int32_t BME280_CompensateTemperature(BME280* bme280);
-
-/**
-*   \brief Compensate raw pressure values.
-*
-*   This function is used to compensate the raw pressure values and convert them
-*   in unsigned 32 bit integers.
-*
-*   \param[in] bme280 : pointer to device structure
-*
-*   \return Compensated pressure data.
-*   \retval Compensated pressure data as 32 bit unsigned integer.
-*
-*/
-static int32_t BME280_CompensatePressure(BME280* bme280);
-/**
-*   \brief Compensate raw humidity values.
-*
-*   This function is used to compensate the raw humidity values and convert them
-*   in unsigned 32 bit integers.
-*
-*   \param[in] bme280 : pointer to device structure
-*
-*   \return Compensated humidity data.
-*   \retval Compensated humidity data as 32 bit unsigned integer.
+*   \brief Initialize the sensor.
 *
+*   This function checks the presence of the sensor, resets it, and 
+*   loads the calibration data, either by reading them from the sensor
+*   or by copying the ones passed in as parameter, once checked.
+*   \param[in] bme280 Pointer to device struct
+*   \param[in] calib_data Calibration data to be used, NULL to read them from the sensor
+*   \return Result of function execution 
+*   \retval #BME280_E_NULL_PTR -> Null pointer
+*   \retval #BME280_E_COMM_FAIL -> Error during I2C communication
+*   \retval #BME280_E_DEV_NOT_FOUND -> Device not found on I2C bus
+*   \retval #BME280_E_CALIB_MISMATCH -> Calibration data of another sensor
+*   \retval #BME280_OK -> Success
 */
-static uint32_t BME280_CompensateHumidity(BME280* bme280);
-
+static BME280_ErrorCode BME280_Init(BME280* bme280, const BME280_Calib_Data* calib_data);
 
 /**
 *   \brief Read Who Am I register value.
 *
 *   This function reads the value of the Who Am I register.
 *   If everything is set up correctly, you should read 0x60
+*   \param[in] bme280 Pointer to device struct
+*   \param[out] value Value of the register
 *   \return Result of function execution 
 *   \retval BME280_I2C_ERROR -> Error during I2C communication
 *   \retval BME280_ERROR -> Generic error
 *   \retval BME280_OK -> Success
 */
-static BME280_ErrorCode BME280_ReadWhoAmI(uint8_t* value);
+static BME280_ErrorCode BME280_ReadWhoAmI(BME280* bme280, uint8_t* value);
 
 /**
 *   \brief Read device calibration data.
@@ -140,6 +136,23 @@ static BME280_ErrorCode BME280_ReadWhoAmI(uint8_t* value);
 */
 static BME280_ErrorCode BME280_ReadCalibrationData(BME280* bme280);
 
+/**
+*   \brief Check that stored calibration data belong to the sensor.
+*
+*   This function reads the temperature calibration registers of the
+*   sensor in a single short transaction and compares them with the
+*   stored calibration data. Calibration data are trimmed for each part,
+*   so a different sensor (e.g., a replaced one) is detected.
+*   \param[in] bme280 Pointer to device struct
+*   \param[in] calib_data Stored calibration data
+*   \return Result of function execution 
+*   \retval BME280_E_COMM_FAIL -> Error during I2C communication
+*   \retval BME280_E_CALIB_MISMATCH -> Calibration data of another sensor
+*   \retval BME280_OK -> Success
+*/
+static BME280_ErrorCode BME280_CheckCalibrationData(BME280* bme280, 
+                                                    const BME280_Calib_Data* calib_data);
+
 /**
 *   \brief Parse temperature and pressure calibration data.
 *
@@ -160,46 +173,149 @@ static void BME280_ParseTempPressCalibData(BME280* bme280, uint8_t* calib_data);
 */
 static void BME280_ParseHumidityCalibData(BME280* bme280, uint8_t* calib_data);
 
+/**
+*   \brief Read the configuration registers.
+*
+*   This function reads the #BME280_CTRL_HUM_REG_ADDR, #BME280_CTRL_MEAS_REG_ADDR,
+*   and #BME280_CONFIG_REG_ADDR registers in a single transaction and stores
+*   their values in the register copy of the device structure.
+*   \param[in] bme280 Pointer to device struct
+*   \return Result of function execution 
+*   \retval BME280_E_COMM_FAIL -> Error during I2C communication
+*   \retval BME280_OK -> Success
+*/
+static BME280_ErrorCode BME280_ReadConfigRegisters(BME280* bme280);
+
+/**
+*   \brief Compute measurement time.
+*
+*   This function computes the measurement time for the given oversampling
+*   settings using the formula from the sensor datasheet.
+*   \param[in] settings Pointer to sensor settings
+*   \param[in] offset Fixed part of the measurement time [us]
+*   \param[in] per_osr Time per oversampling step [us]
+*   \param[in] setup Pressure and humidity setup time [us]
+*   \return Measurement time in microseconds
+*/
+static uint32_t BME280_ComputeMeasurementTime(const BME280_Settings* settings, 
+                    uint32_t offset, uint32_t per_osr, uint32_t setup);
+
 /**
 *   \brief Validate device structure for null conditions.
 *
+*   The bus of the device structure is checked too, as it is used
+*   by all the functions that access the sensor.
+*
 *   \param[in] bme280 : pointer to device structure
 *   
 *   \return Result of null pointer check
 *   \retval BME280_OK -> Structure initialized
-*   \retval BME280_NULL_PTR ->
+*   \retval BME280_NULL_PTR -> Structure or its bus is NULL (#BME280_Setup not called)
 */
 static BME280_ErrorCode BME280_NullPtrCheck(const BME280* bme280);
 
+/******************************************/
+/*            Lookup Tables               */
+/******************************************/
+
+/**
+*   \brief Number of samples for each #BME280_Oversampling value.
+*/
+static const uint8_t BME280_OSR_SAMPLES[] = {0, 1, 2, 4, 8, 16, 16, 16};
+
+/**
+*   \brief Standby time in us for each #BME280_TStandby value.
+*/
+static const uint32_t BME280_STANDBY_TIME_US[] = {500, 62500, 125000, 250000, 
+                                                  500000, 1000000, 10000, 20000};
+
 /******************************************/
 /*          Function Definitions          */
 /******************************************/
 
+BME280_ErrorCode BME280_Setup(BME280* bme280, const BME280_Bus* bus, uint8_t address)
+{
+    BME280_ErrorCode error = BME280_OK;
+    // The bus is not set yet, BME280_NullPtrCheck would fail
+    if ( bme280 == NULL || bus == NULL)
+    {
+        error = BME280_E_NULL_PTR;
+    }
+    if ( error == BME280_OK)
+    {
+        bme280->bus = bus;
+        bme280->address = address;
+        bme280->shadow.valid = 0;
+        bme280->sample_pending = 0;
+        bme280->last_frame_valid = 0;
+        bme280->transaction.status = BME280_I2C_DONE;
+    }
+    return error;
+}
+
 BME280_ErrorCode BME280_Start(BME280* bme280)
+{
+    // Calibration data are read from the sensor
+    return BME280_Init(bme280, NULL);
+}
+
+BME280_ErrorCode BME280_StartWithCalibData(BME280* bme280, const BME280_Calib_Data* calib_data)
+{
+    BME280_ErrorCode error = BME280_OK;
+    if ( calib_data == NULL)
+    {
+        error = BME280_E_NULL_PTR;
+    }
+    else
+    {
+        error = BME280_Init(bme280, calib_data);
+    }
+    return error;
+}
+
+static BME280_ErrorCode BME280_Init(BME280* bme280, const BME280_Calib_Data* calib_data)
 {
     uint8_t try_counts = 5;
     BME280_ErrorCode error;
     uint8_t who_am_i_value = 0x00;
     
-    // Start I2C Interface
-    BME280_I2C_Interface_Start();
     // Check null pointer
     error = BME280_NullPtrCheck(bme280);
     if ( error == BME280_OK)
     {
+        // Start bus interface
+        bme280->bus->start();
+        // Register values are unknown until the sensor is reset
+        bme280->shadow.valid = 0;
+        // No non-blocking read in progress
+        bme280->transaction.status = BME280_I2C_DONE;
         while(try_counts)
         {
             // Check device presence on I2C bus
-            error = BME280_ReadWhoAmI(&who_am_i_value);
+            error = BME280_ReadWhoAmI(bme280, &who_am_i_value);
             if (error == BME280_OK && who_am_i_value == BME280_WHO_AM_I)
             {
                 bme280->chip_id = BME280_WHO_AM_I;
                 error = BME280_Reset(bme280);
-                if ( error == BME280_OK)
+                if ( error == BME280_OK && calib_data != NULL)
+                {
+                    // Use calibration data stored by the application, if they
+                    // belong to this sensor
+                    error = BME280_CheckCalibrationData(bme280, calib_data);
+                    if ( error == BME280_OK)
+                    {
+                        bme280->calib_data = *calib_data;
+                    }
+                }
+                else if ( error == BME280_OK)
                 {
                     // Read calibration data
                     error = BME280_ReadCalibrationData(bme280);
                 }
+                if ( error == BME280_OK)
+                {
+                    BME280_Compensation_Prepare(&bme280->comp_coeff, &bme280->calib_data);
+                }
                 break;
             }
             
@@ -218,11 +334,11 @@ BME280_ErrorCode BME280_Start(BME280* bme280)
     }
     return error;
 }
-BME280_ErrorCode BME280_ReadWhoAmI(uint8_t* who_am_i)
+static BME280_ErrorCode BME280_ReadWhoAmI(BME280* bme280, uint8_t* who_am_i)
 {
     // Read WHO AM I register 
-    return BME280_I2C_Interface_ReadRegister(BME280_I2C_ADDRESS, 
-                                        BME280_WHO_AM_I_REG_ADDR, who_am_i);
+    return bme280->bus->read(bme280->address, 
+                                        BME280_WHO_AM_I_REG_ADDR, 1, who_am_i);
 }
 
 BME280_ErrorCode BME280_Reset(BME280* bme280) 
@@ -236,16 +352,15 @@ BME280_ErrorCode BME280_Reset(BME280* bme280)
     if (error == BME280_OK)
     {
         // Write reset value to sensor reset register
-        error = BME280_I2C_Interface_WriteRegister(BME280_I2C_ADDRESS, 
-                            BME280_RESET_REG_ADDR, BME280_SOFT_RESET_COMMAND);
+        uint8_t reset_pair[2] = {BME280_RESET_REG_ADDR, BME280_SOFT_RESET_COMMAND};
+        error = bme280->bus->write_pairs(bme280->address, 1, reset_pair);
         if ( error == BME280_OK)
         {
             // If NVM not copied yet, wait for NVM to copy --> Status register
             do 
             {
                 CyDelay(2);
-                error = BME280_I2C_Interface_ReadRegister(BME280_I2C_ADDRESS, 
-                    BME280_STATUS_REG_ADDR, &status_reg);
+                error = BME280_ReadStatusRegister(bme280, &status_reg);
             } while ((error == BME280_OK) && (try_counts--) && (status_reg & BME280_STATUS_IM_UPDATE));
             
             if ( status_reg & BME280_STATUS_IM_UPDATE)
@@ -254,13 +369,14 @@ BME280_ErrorCode BME280_Reset(BME280* bme280)
             }
             else
             {
+                // After reset all the configuration registers are cleared
+                bme280->shadow.ctrl_hum = 0x00;
+                bme280->shadow.ctrl_meas = 0x00;
+                bme280->shadow.config = 0x00;
+                bme280->shadow.valid = 1;
                 // Restore settings
-                BME280_SetHumidityOversampling(bme280, bme280->settings.osr_h);
-                BME280_SetTemperatureOversampling(bme280, bme280->settings.osr_t);
-                BME280_SetPressureOversampling(bme280, bme280->settings.osr_p);
-                BME280_SetIIRFilter(bme280, bme280->settings.filter);
-                BME280_SetStandbyTime(bme280, bme280->settings.stanby_time);
-                BME280_SetMode(bme280, bme280->settings.mode);
+                BME280_Settings settings = bme280->settings;
+                error = BME280_ApplySettings(bme280, &settings);
             }
         }
     }
@@ -271,11 +387,15 @@ BME280_ErrorCode BME280_Reset(BME280* bme280)
     return error;
 }
 
-BME280_ErrorCode BME280_ReadStatusRegister(uint8_t* value)
+BME280_ErrorCode BME280_ReadStatusRegister(BME280* bme280, uint8_t* value)
 {
     BME280_ErrorCode error;
-    error = BME280_I2C_Interface_ReadRegister(BME280_I2C_ADDRESS,
-        BME280_STATUS_REG_ADDR, value);
+    error = BME280_NullPtrCheck(bme280);
+    if ( error == BME280_OK)
+    {
+        error = bme280->bus->read(bme280->address,
+            BME280_STATUS_REG_ADDR, 1, value);
+    }
     return error;
     
 }
@@ -287,59 +407,114 @@ BME280_ErrorCode BME280_GetSensorMode(BME280* bme280)
     if ( error == BME280_OK)
     {
         uint8_t reg_data;
-        error = BME280_I2C_Interface_ReadRegister(BME280_I2C_ADDRESS,
-            BME280_CONFIG_REG_ADDR,
+        error = bme280->bus->read(bme280->address,
+            BME280_CTRL_MEAS_REG_ADDR, 1,
             &reg_data);
         if ( error == BME280_OK)
         {
             bme280->settings.mode = reg_data & 0x03;
+            // Forced mode returns to sleep mode on its own
+            bme280->shadow.ctrl_meas = reg_data;
         }
     }
     return error;
 }
 
-BME280_ErrorCode BME280_SetHumidityOversampling(BME280* bme280, BME280_Oversampling hos)
+BME280_ErrorCode BME280_ApplySettings(BME280* bme280, const BME280_Settings* settings)
 {
     BME280_ErrorCode error;
-    // Read current register value
-    uint8_t reg_data = 0x00;
     error = BME280_NullPtrCheck(bme280);
-    if (error == BME280_OK)
+    if ( error == BME280_OK && settings == NULL)
+    {
+        error = BME280_E_NULL_PTR;
+    }
+    if ( error == BME280_OK && !bme280->shadow.valid)
     {
-        // Check if device is in sleep mode
-        error = BME280_GetSensorMode(bme280);
-        if ( error == BME280_OK && bme280->settings.mode != BME280_SLEEP_MODE)
+        // Register values not known, read them back once
+        error = BME280_ReadConfigRegisters(bme280);
+    }
+    if ( error == BME280_OK)
+    {
+        BME280_Reg_Shadow* shadow = &bme280->shadow;
+        // Register/value pairs to be written
+        uint8_t pairs[2 * BME280_MAX_SETTINGS_PAIRS];
+        uint8_t pair_count = 0;
+        // Compute new register values
+        uint8_t ctrl_hum = (shadow->ctrl_hum & ~0x07) | (settings->osr_h & 0x07);
+        uint8_t ctrl_meas = ((settings->osr_t & 0x07) << 5) | ((settings->osr_p & 0x07) << 2) 
+                            | (settings->mode & 0x03);
+        uint8_t config = ((settings->stanby_time & 0x07) << 5) | ((settings->filter & 0x07) << 2) 
+                            | (shadow->config & 0x02) | (settings->spi_enable & 0x01);
+        // Value of ctrl meas register on the device after the queued writes
+        uint8_t current_meas = shadow->ctrl_meas;
+        
+        if ( config != shadow->config)
+        {
+            // Writes to config register may be ignored in normal mode
+            if ( (current_meas & 0x03) != BME280_SLEEP_MODE)
+            {
+                current_meas &= ~0x03;
+                pairs[2*pair_count] = BME280_CTRL_MEAS_REG_ADDR;
+                pairs[2*pair_count+1] = current_meas;
+                pair_count++;
+            }
+            pairs[2*pair_count] = BME280_CONFIG_REG_ADDR;
+            pairs[2*pair_count+1] = config;
+            pair_count++;
+        }
+        if ( ctrl_hum != shadow->ctrl_hum)
+        {
+            pairs[2*pair_count] = BME280_CTRL_HUM_REG_ADDR;
+            pairs[2*pair_count+1] = ctrl_hum;
+            pair_count++;
+        }
+        // Changes to ctrl hum become effective only after writing ctrl meas,
+        // and each write of forced mode triggers a new measurement
+        if ( (ctrl_meas != current_meas) || (ctrl_hum != shadow->ctrl_hum) 
+                || ((ctrl_meas & 0x03) == BME280_FORCED_MODE))
         {
-            error = BME280_SetSleepMode(bme280);
+            pairs[2*pair_count] = BME280_CTRL_MEAS_REG_ADDR;
+            pairs[2*pair_count+1] = ctrl_meas;
+            pair_count++;
         }
         
+        if ( pair_count > 0)
+        {
+            error = bme280->bus->write_pairs(bme280->address, 
+                pair_count, pairs);
+        }
         if ( error == BME280_OK)
         {
-            error = BME280_I2C_Interface_ReadRegister(BME280_I2C_ADDRESS,
-                BME280_CTRL_HUM_REG_ADDR, &reg_data);
-            if (error == BME280_OK)
+            shadow->ctrl_hum = ctrl_hum;
+            shadow->ctrl_meas = ctrl_meas;
+            shadow->config = config;
+            bme280->settings = *settings;
+            if ( (ctrl_meas & 0x03) == BME280_FORCED_MODE)
             {
-                // Set new value of register
-                reg_data &= ~0x07;
-                reg_data |= hos;
-                // Write new value to ctrl hum register
-                error = BME280_I2C_Interface_WriteRegister(BME280_I2C_ADDRESS, BME280_CTRL_HUM_REG_ADDR, reg_data);
-                if ( error == BME280_OK)
-                {
-                    // Read value of control meas register
-                    error = BME280_I2C_Interface_ReadRegister(BME280_I2C_ADDRESS, BME280_CTRL_MEAS_REG_ADDR, &reg_data);
-                    if ( error == BME280_OK)
-                    {
-                        // Write value of control meas register
-                        error = BME280_I2C_Interface_WriteRegister(BME280_I2C_ADDRESS, BME280_CTRL_MEAS_REG_ADDR, reg_data);
-                        if (error == BME280_OK)
-                        {
-                            bme280->settings.osr_h = hos;
-                        }
-                    }
-                }
+                // A new measurement was triggered
+                bme280->sample_pending = 1;
             }
         }
+        else
+        {
+            // We do not know which registers were written
+            shadow->valid = 0;
+        }
+    }
+    return error;
+}
+
+BME280_ErrorCode BME280_SetHumidityOversampling(BME280* bme280, BME280_Oversampling hos)
+{
+    BME280_ErrorCode error;
+    error = BME280_NullPtrCheck(bme280);
+    if (error == BME280_OK)
+    {
+        // Settings are changed with the device in sleep mode
+        BME280_Settings settings = bme280->settings;
+        settings.mode = BME280_SLEEP_MODE;
+        settings.osr_h = hos;
+        error = BME280_ApplySettings(bme280, &settings);
     }
     return error;
 }
@@ -347,36 +522,14 @@ BME280_ErrorCode BME280_SetHumidityOversampling(BME280* bme280, BME280_Oversampl
 BME280_ErrorCode BME280_SetTemperatureOversampling(BME280* bme280, BME280_Oversampling tos)
 {
     BME280_ErrorCode error;
-    // Read current register value
-    uint8_t reg_data = 0x00;
     error = BME280_NullPtrCheck(bme280);
     if ( error == BME280_OK)
     {
-        error = BME280_GetSensorMode(bme280);
-        if ( error == BME280_OK && bme280->settings.mode != BME280_SLEEP_MODE)
-        {
-            error = BME280_SetSleepMode(bme280);
-        }
-        
-        if ( error == BME280_OK)
-        {
-            error = BME280_I2C_Interface_ReadRegister(BME280_I2C_ADDRESS, 
-                    BME280_CTRL_MEAS_REG_ADDR, &reg_data);
-            if ( error == BME280_OK)
-            {
-                // Set new value of register
-                reg_data &= ~0xE0; // Clear bits 7,6,5
-                reg_data |= tos << 5;
-                // Write new value to ctrl meas register
-                error = BME280_I2C_Interface_WriteRegister(BME280_I2C_ADDRESS,
-                                    BME280_CTRL_MEAS_REG_ADDR, reg_data);
-                if ( error == BME280_OK)
-                {
-                    bme280->settings.osr_t = tos;
-                }
-
-            }
-        }
+        // Settings are changed with the device in sleep mode
+        BME280_Settings settings = bme280->settings;
+        settings.mode = BME280_SLEEP_MODE;
+        settings.osr_t = tos;
+        error = BME280_ApplySettings(bme280, &settings);
     }
     return error;
 }
@@ -384,61 +537,27 @@ BME280_ErrorCode BME280_SetTemperatureOversampling(BME280* bme280, BME280_Oversa
 BME280_ErrorCode BME280_SetPressureOversampling(BME280* bme280, BME280_Oversampling pos)
 {
     BME280_ErrorCode error;
-    // Read current register value
-    uint8_t reg_data = 0x00;
     error = BME280_NullPtrCheck(bme280);
     if ( error == BME280_OK)
     {
-        error = BME280_GetSensorMode(bme280);
-        if ( error == BME280_OK && bme280->settings.mode != BME280_SLEEP_MODE)
-        {
-            error = BME280_SetSleepMode(bme280);
-        }
-        if ( error == BME280_OK)
-        {
-            error = BME280_I2C_Interface_ReadRegister(BME280_I2C_ADDRESS, 
-                BME280_CTRL_MEAS_REG_ADDR, &reg_data);
-            if ( error == BME280_OK)
-            {
-                // Set new value of register
-                reg_data &= ~0x1C;    // Clear bits 4,3,2
-                reg_data |= pos << 2;  
-                // Write new value to ctrl meas register
-                error = BME280_I2C_Interface_WriteRegister(BME280_I2C_ADDRESS, 
-                    BME280_CTRL_MEAS_REG_ADDR, reg_data);
-                if (error == BME280_OK)
-                {
-                    bme280->settings.osr_p = pos;
-                }
-            }
-        }
+        // Settings are changed with the device in sleep mode
+        BME280_Settings settings = bme280->settings;
+        settings.mode = BME280_SLEEP_MODE;
+        settings.osr_p = pos;
+        error = BME280_ApplySettings(bme280, &settings);
     }
-    
     return error;
 }
 
 BME280_ErrorCode BME280_SetMode(BME280* bme280, uint8_t mode)
 {
     BME280_ErrorCode error;
-    uint8_t reg_data = 0x00;
     error = BME280_NullPtrCheck(bme280);
     if ( error == BME280_OK)
     {
-        // Read current register value
-        error = BME280_I2C_Interface_ReadRegister(BME280_I2C_ADDRESS, 
-            BME280_CTRL_MEAS_REG_ADDR, &reg_data);
-        if ( error == BME280_OK)
-        {
-            // Set new value of register
-            reg_data &= ~0x03; // Bit 1,0
-            reg_data |= mode;
-            // Write new value to ctrl meas register
-            error = BME280_I2C_Interface_WriteRegister(BME280_I2C_ADDRESS, BME280_CTRL_MEAS_REG_ADDR, reg_data);
-            if ( error == BME280_OK)
-            {
-                bme280->settings.mode = mode;
-            }
-        }
+        BME280_Settings settings = bme280->settings;
+        settings.mode = mode;
+        error = BME280_ApplySettings(bme280, &settings);
     }
     return error;
 }
@@ -467,29 +586,11 @@ BME280_ErrorCode BME280_SetStandbyTime(BME280* bme280, BME280_TStandby tStandby)
     error = BME280_NullPtrCheck(bme280);
     if ( error == BME280_OK)
     {
-        error = BME280_GetSensorMode(bme280);
-        if ( error == BME280_OK && bme280->settings.mode != BME280_SLEEP_MODE)
-        {
-            error = BME280_SetSleepMode(bme280);
-        }
-        if ( error == BME280_OK)
-        {
-            // Read current register value
-            uint8_t reg_data = 0x00;
-            error = BME280_I2C_Interface_ReadRegister(BME280_I2C_ADDRESS, BME280_CONFIG_REG_ADDR, &reg_data);
-            if ( error == BME280_OK)
-            {
-                // Set new value of register
-                reg_data &= ~0xE0;    // Clear bits 7,6,5
-                reg_data |= tStandby << 5;  
-                // Write new value to config register
-                error = BME280_I2C_Interface_WriteRegister(BME280_I2C_ADDRESS, BME280_CONFIG_REG_ADDR, reg_data);
-                if ( error == BME280_OK)
-                {
-                    bme280->settings.stanby_time = tStandby;
-                }
-            }
-        }
+        // Settings are changed with the device in sleep mode
+        BME280_Settings settings = bme280->settings;
+        settings.mode = BME280_SLEEP_MODE;
+        settings.stanby_time = tStandby;
+        error = BME280_ApplySettings(bme280, &settings);
     }
     return error;
 }
@@ -500,29 +601,11 @@ BME280_ErrorCode BME280_SetIIRFilter(BME280* bme280, BME280_Filter filter)
     error = BME280_NullPtrCheck(bme280);
     if ( error == BME280_OK)
     {
-        error = BME280_GetSensorMode(bme280);
-        if ( error == BME280_OK && bme280->settings.mode != BME280_SLEEP_MODE)
-        {
-            error = BME280_SetSleepMode(bme280);
-        }
-        if ( error == BME280_OK)
-        {
-            // Read current register value
-            uint8_t reg_data = 0x00;
-            error = BME280_I2C_Interface_ReadRegister(BME280_I2C_ADDRESS, BME280_CONFIG_REG_ADDR, &reg_data);
-            if ( error == BME280_OK)
-            {
-                // Set new value of register
-                reg_data &= ~0x1C;    // Clear bits 4,3,2
-                reg_data |= filter << 2;  
-                // Write new value to ctrl hum register
-                error = BME280_I2C_Interface_WriteRegister(BME280_I2C_ADDRESS, BME280_CONFIG_REG_ADDR, reg_data);
-                if ( error == BME280_OK)
-                {
-                    bme280->settings.filter = filter;
-                }
-            }
-        }
+        // Settings are changed with the device in sleep mode
+        BME280_Settings settings = bme280->settings;
+        settings.mode = BME280_SLEEP_MODE;
+        settings.filter = filter;
+        error = BME280_ApplySettings(bme280, &settings);
     }
     return error;
 }
@@ -530,20 +613,12 @@ BME280_ErrorCode BME280_SetIIRFilter(BME280* bme280, BME280_Filter filter)
 BME280_ErrorCode BME280_EnableSPI(BME280* bme280)
 {
     BME280_ErrorCode error;
-    // Read current register value
-    uint8_t reg_data = 0x00;
-    error = BME280_I2C_Interface_ReadRegister(BME280_I2C_ADDRESS, BME280_CONFIG_REG_ADDR, &reg_data);
+    error = BME280_NullPtrCheck(bme280);
     if ( error == BME280_OK)
     {
-        // Set new value of register
-        reg_data &= ~0x01;    // Clear bit 1
-        reg_data |= 0x01;
-        // Write new value to ctrl hum register
-        error = BME280_I2C_Interface_WriteRegister(BME280_I2C_ADDRESS, BME280_CONFIG_REG_ADDR, reg_data);
-        if ( error == BME280_OK)
-        {
-            bme280->settings.spi_enable = 1;
-        }
+        BME280_Settings settings = bme280->settings;
+        settings.spi_enable = 1;
+        error = BME280_ApplySettings(bme280, &settings);
     }
     return error;
 }
@@ -551,20 +626,32 @@ BME280_ErrorCode BME280_EnableSPI(BME280* bme280)
 BME280_ErrorCode BME280_DisableSPI(BME280* bme280)
 {
     BME280_ErrorCode error;
-    // Read current register value
-    uint8_t reg_data = 0x00;
-    error = BME280_I2C_Interface_ReadRegister(BME280_I2C_ADDRESS, BME280_CONFIG_REG_ADDR, &reg_data);
+    error = BME280_NullPtrCheck(bme280);
     if ( error == BME280_OK)
     {
-        // Set new value of register
-        reg_data &= ~0x01;    // Clear bit 1
-        reg_data |= 0x00;
-        // Write new value to ctrl hum register
-        error = BME280_I2C_Interface_WriteRegister(BME280_I2C_ADDRESS, BME280_CONFIG_REG_ADDR, reg_data);
-        if ( error == BME280_OK)
-        {
-            bme280->settings.spi_enable = 0;
-        }
+        BME280_Settings settings = bme280->settings;
+        settings.spi_enable = 0;
+        error = BME280_ApplySettings(bme280, &settings);
+    }
+    return error;
+}
+
+static BME280_ErrorCode BME280_ReadConfigRegisters(BME280* bme280)
+{
+    BME280_ErrorCode error;
+    // ctrl hum, status, ctrl meas, config
+    uint8_t reg_data[BME280_CONFIG_REGS_LEN] = {0};
+    
+    error = bme280->bus->read(bme280->address,
+                BME280_CTRL_HUM_REG_ADDR,
+                BME280_CONFIG_REGS_LEN,
+                reg_data);
+    if ( error == BME280_OK)
+    {
+        bme280->shadow.ctrl_hum = reg_data[0];
+        bme280->shadow.ctrl_meas = reg_data[2];
+        bme280->shadow.config = reg_data[3];
+        bme280->shadow.valid = 1;
     }
     return error;
 }
@@ -577,7 +664,7 @@ static BME280_ErrorCode BME280_ReadCalibrationData(BME280* bme280)
     uint8_t calib_data[BME280_TEMP_PRESS_CALIB_DATA_LEN] = {0};
     
     // Read calibration data
-    error = BME280_I2C_Interface_ReadRegisterMulti(BME280_I2C_ADDRESS,
+    error = bme280->bus->read(bme280->address,
                 BME280_CALIB_TEMP_PRESS_REG_ADDR, 
                 BME280_TEMP_PRESS_CALIB_DATA_LEN, 
                 calib_data);
@@ -586,9 +673,9 @@ static BME280_ErrorCode BME280_ReadCalibrationData(BME280* bme280)
         // Parse calibration data
         BME280_ParseTempPressCalibData(bme280, calib_data);
         // Read humidity calibration data
-        error = BME280_I2C_Interface_ReadRegisterMulti(BME280_I2C_ADDRESS,
+        error = bme280->bus->read(bme280->address,
                 BME280_CALIB_HUM_REG_ADDR, 
-                BME280_TEMP_PRESS_CALIB_DATA_LEN, 
+                BME280_HUMIDITY_CALIB_DATA_LEN, 
                 calib_data);
         if (error == BME280_OK)
         {
@@ -599,6 +686,28 @@ static BME280_ErrorCode BME280_ReadCalibrationData(BME280* bme280)
     
 }
 
+static BME280_ErrorCode BME280_CheckCalibrationData(BME280* bme280, 
+                                                    const BME280_Calib_Data* calib_data)
+{
+    BME280_ErrorCode error;
+    uint8_t reg_data[BME280_CALIB_CHECK_LEN] = {0};
+    
+    error = bme280->bus->read(bme280->address,
+                BME280_CALIB_TEMP_PRESS_REG_ADDR,
+                BME280_CALIB_CHECK_LEN,
+                reg_data);
+    if ( error == BME280_OK)
+    {
+        if ( (BME280_CONCAT_BYTES(reg_data[1], reg_data[0]) != calib_data->dig_T1) ||
+             ((int16_t)BME280_CONCAT_BYTES(reg_data[3], reg_data[2]) != calib_data->dig_T2) ||
+             ((int16_t)BME280_CONCAT_BYTES(reg_data[5], reg_data[4]) != calib_data->dig_T3))
+        {
+            error = BME280_E_CALIB_MISMATCH;
+        }
+    }
+    return error;
+}
+
 BME280_ErrorCode BME280_ReadData(BME280* bme280, uint8_t sensor_comp)
 {
     BME280_ErrorCode error;
@@ -607,7 +716,7 @@ BME280_ErrorCode BME280_ReadData(BME280* bme280, uint8_t sensor_comp)
     error = BME280_NullPtrCheck(bme280);
     if ( error == BME280_OK)
     {
-        error = BME280_I2C_Interface_ReadRegisterMulti(BME280_I2C_ADDRESS,
+        error = bme280->bus->read(bme280->address,
                         BME280_PRESS_MSB_REG_ADDR,
                         BME280_P_T_H_DATA_LEN,
                         reg_data);
@@ -627,6 +736,215 @@ BME280_ErrorCode BME280_ReadData(BME280* bme280, uint8_t sensor_comp)
     return error;
 }
 
+BME280_ErrorCode BME280_ReadDataIfReady(BME280* bme280, uint8_t sensor_comp)
+{
+    BME280_ErrorCode error;
+    uint8_t reg_data[BME280_STATUS_DATA_LEN] = {0};
+    uint8_t* frame = &reg_data[BME280_PRESS_MSB_REG_ADDR - BME280_STATUS_REG_ADDR];
+    uint8_t mode;
+    uint8_t changed = 0;
+    
+    error = BME280_NullPtrCheck(bme280);
+    if ( error == BME280_OK)
+    {
+        // Status, ctrl_meas, config and data registers in one burst
+        error = bme280->bus->read(bme280->address,
+                        BME280_STATUS_REG_ADDR,
+                        BME280_STATUS_DATA_LEN,
+                        reg_data);
+        if ( error == BME280_OK)
+        {
+            // Mode bits go back to sleep when a forced measurement is completed
+            mode = reg_data[BME280_CTRL_MEAS_REG_ADDR - BME280_STATUS_REG_ADDR] & 0x03;
+            for (uint8_t j = 0; j < BME280_P_T_H_DATA_LEN; j++)
+            {
+                changed |= (uint8_t)(frame[j] ^ bme280->last_frame[j]);
+            }
+            if ( (reg_data[0] & (BME280_STATUS_MEASURING | BME280_STATUS_IM_UPDATE))
+                || ((mode != BME280_SLEEP_MODE) && (mode != BME280_NORMAL_MODE)))
+            {
+                error = BME280_E_NOT_READY;
+            }
+            else if ( (mode == BME280_SLEEP_MODE) && !bme280->sample_pending)
+            {
+                // No trigger since the last sample returned
+                error = BME280_E_NOT_READY;
+            }
+            else if ( (mode == BME280_NORMAL_MODE) && bme280->last_frame_valid && !changed)
+            {
+                // Sample already returned
+                error = BME280_E_NOT_READY;
+            }
+            else
+            {
+                bme280->sample_pending = 0;
+                for (uint8_t j = 0; j < BME280_P_T_H_DATA_LEN; j++)
+                {
+                    bme280->last_frame[j] = frame[j];
+                }
+                bme280->last_frame_valid = 1;
+                BME280_ParseSensorData(bme280, frame);
+                error = BME280_CompensateData(bme280, sensor_comp);
+            }
+        }
+    }
+    return error;
+}
+
+BME280_ErrorCode BME280_ReadDataAsync(BME280* bme280, BME280_I2C_Callback callback, void* context)
+{
+    BME280_ErrorCode error;
+    
+    error = BME280_NullPtrCheck(bme280);
+    if ( error == BME280_OK)
+    {
+        BME280_I2C_Transaction* transaction = &bme280->transaction;
+        // Do not reuse the transaction while the previous read is running
+        if ( transaction->status == BME280_I2C_PENDING)
+        {
+            error = BME280_E_BUSY;
+        }
+        else
+        {
+            transaction->device_address = bme280->address;
+            transaction->register_address = BME280_PRESS_MSB_REG_ADDR;
+            transaction->register_count = BME280_P_T_H_DATA_LEN;
+            transaction->direction = BME280_I2C_READ;
+            transaction->data = bme280->raw_data;
+            transaction->callback = callback;
+            transaction->context = context;
+            error = bme280->bus->submit(transaction);
+        }
+    }
+    return error;
+}
+
+BME280_ErrorCode BME280_PollDevices(BME280** devices, uint8_t count, uint8_t sensor_comp)
+{
+    BME280_ErrorCode error = BME280_OK;
+    BME280_ErrorCode device_error;
+    
+    if ( devices == NULL)
+    {
+        error = BME280_E_NULL_PTR;
+    }
+    else
+    {
+        // Queue all the reads, the bus goes from one to the next in the interrupt
+        for (uint8_t i = 0; i < count; i++)
+        {
+            // A full queue is emptied only by the interrupt
+            do
+            {
+                device_error = BME280_ReadDataAsync(devices[i], NULL, NULL);
+            } while ( (device_error == BME280_E_BUSY) && BME280_I2C_Interface_CanWait());
+            if ( error == BME280_OK)
+            {
+                error = device_error;
+            }
+        }
+        // Compensate each sensor while the following reads are running
+        for (uint8_t i = 0; i < count; i++)
+        {
+            BME280* bme280 = devices[i];
+            // A device without bus was not queued
+            if ( BME280_NullPtrCheck(bme280) == BME280_OK)
+            {
+                if ( (bme280->transaction.status == BME280_I2C_PENDING)
+                        && !BME280_I2C_Interface_CanWait())
+                {
+                    device_error = BME280_E_INT_DISABLED;
+                }
+                else
+                {
+                    while ( bme280->transaction.status == BME280_I2C_PENDING);
+                    device_error = bme280->transaction.error;
+                }
+                if ( device_error == BME280_OK)
+                {
+                    BME280_ParseSensorData(bme280, bme280->raw_data);
+                    device_error = BME280_CompensateData(bme280, sensor_comp);
+                }
+                if ( error == BME280_OK)
+                {
+                    error = device_error;
+                }
+            }
+        }
+    }
+    return error;
+}
+
+BME280_ErrorCode BME280_TriggerAndRead(BME280* bme280, uint8_t sensor_comp)
+{
+    BME280_ErrorCode error;
+    
+    error = BME280_NullPtrCheck(bme280);
+    if ( error == BME280_OK)
+    {
+        // Start a single measurement
+        error = BME280_SetForcedMode(bme280);
+        if ( error == BME280_OK)
+        {
+            // Wait until data are surely available, rounding up to ms
+            CyDelay((BME280_GetMaxMeasurementTime(bme280) + 999) / 1000);
+            error = BME280_ReadData(bme280, sensor_comp);
+        }
+    }
+    return error;
+}
+
+uint32_t BME280_GetTypicalMeasurementTime(BME280* bme280)
+{
+    return BME280_ComputeMeasurementTime(&bme280->settings, BME280_MEAS_TIME_TYP_OFFSET,
+                BME280_MEAS_TIME_TYP_PER_OSR, BME280_MEAS_TIME_TYP_SETUP);
+}
+
+uint32_t BME280_GetMaxMeasurementTime(BME280* bme280)
+{
+    return BME280_ComputeMeasurementTime(&bme280->settings, BME280_MEAS_TIME_MAX_OFFSET,
+                BME280_MEAS_TIME_MAX_PER_OSR, BME280_MEAS_TIME_MAX_SETUP);
+}
+
+uint32_t BME280_GetStandbyTime(BME280* bme280)
+{
+    return BME280_STANDBY_TIME_US[bme280->settings.stanby_time & 0x07];
+}
+
+uint32_t BME280_GetSamplePeriod(BME280* bme280)
+{
+    uint32_t period = BME280_GetMaxMeasurementTime(bme280);
+    if ( (bme280->settings.mode & 0x03) == BME280_NORMAL_MODE)
+    {
+        // Normal mode cycles between measurement and standby
+        period += BME280_GetStandbyTime(bme280);
+    }
+    return period;
+}
+
+static uint32_t BME280_ComputeMeasurementTime(const BME280_Settings* settings, 
+                    uint32_t offset, uint32_t per_osr, uint32_t setup)
+{
+    uint32_t time = offset;
+    uint8_t samples;
+    
+    // Temperature
+    time += per_osr * BME280_OSR_SAMPLES[settings->osr_t & 0x07];
+    // Pressure
+    samples = BME280_OSR_SAMPLES[settings->osr_p & 0x07];
+    if ( samples > 0)
+    {
+        time += per_osr * samples + setup;
+    }
+    // Humidity
+    samples = BME280_OSR_SAMPLES[settings->osr_h & 0x07];
+    if ( samples > 0)
+    {
+        time += per_osr * samples + setup;
+    }
+    return time;
+}
+
 static void BME280_ParseTempPressCalibData(BME280* bme280, uint8_t* reg_data)
 {
     // Get pointer to struct to calibration data
@@ -708,152 +1026,30 @@ BME280_ErrorCode BME280_CompensateData(BME280* bme280, uint8_t sensor_comp)
     if ( sensor_comp & ( BME280_TEMP_COMP | BME280_PRESS_COMP | BME280_HUM_COMP ))
     {
         // Compensate temperature data
-        data->temperature = BME280_CompensateTemperature(bme280);
+        data->temperature = BME280_Compensation_Temperature(&bme280->comp_coeff,
+                                bme280->uncomp_data.temperature, &bme280->calib_data.t_fine);
     }
     if (sensor_comp & BME280_PRESS_COMP)
     {
         
         // Compensate pressure data
-        data->pressure = BME280_CompensatePressure(bme280);
+        data->pressure = BME280_Compensation_Pressure(&bme280->comp_coeff,
+                                bme280->uncomp_data.pressure, bme280->calib_data.t_fine);
     }
     if (sensor_comp & BME280_HUM_COMP)
     {
         // Compensate humidity data
-        data->humidity = BME280_CompensateHumidity(bme280);
+        data->humidity = BME280_Compensation_Humidity(&bme280->comp_coeff,
+                                bme280->uncomp_data.humidity, bme280->calib_data.t_fine);
     }
     
     return error;
 }
 
-static int32_t BME280_CompensateTemperature(BME280* bme280)
-{
-    // Set up variables
-    int32_t var1;
-    int32_t var2;
-    int32_t temperature;
-    int32_t temperature_min = -4000;
-    int32_t temperature_max = 8500;
-    
-    // Get pointer to uncompensated data structure
-    BME280_Uncomp_Data* uncomp_data = &bme280->uncomp_data;
-    // Get pointer to calibration data 
-    BME280_Calib_Data* calib_data = &bme280->calib_data;
-    
-    var1 = (int32_t)((uncomp_data->temperature/8) - ((int32_t)calib_data->dig_T1 * 2));
-    var1 = (var1*((int32_t)calib_data->dig_T2))/2048;
-    var2 = (int32_t)((uncomp_data->temperature / 16) - ((int32_t)calib_data->dig_T1));
-    var2 = (((var2*var2)/4096) * ((int32_t)calib_data->dig_T3))/16384;
-    calib_data->t_fine = var1 + var2;
-    temperature = (calib_data->t_fine * 5 + 128 ) / 256;
-    if (temperature < temperature_min)
-        temperature = temperature_min;
-    if (temperature > temperature_max)
-        temperature = temperature_max;
-    return temperature;
-}
-
-static int32_t BME280_CompensatePressure(BME280* bme280)
-{
-    // Set up variables
-    int32_t var1;
-    int32_t var2;
-    int32_t var3;
-    int32_t var4;
-    uint32_t var5;
-    uint32_t pressure;
-    uint32_t pressure_min = 30000;
-    uint32_t pressure_max = 110000;
-    
-    // Get pointer to uncompensated data structure
-    BME280_Uncomp_Data* uncomp_data = &bme280->uncomp_data;
-    // Get pointer to calibration data 
-    BME280_Calib_Data* calib_data = &bme280->calib_data;
-    
-    var1 = (((int32_t)calib_data->t_fine) / 2) - (int32_t)64000;
-    var2 = (((var1 / 4) * (var1 / 4)) / 2048) * ((int32_t)calib_data->dig_P6);
-    var2 = var2 + ((var1 * ((int32_t)calib_data->dig_P5)) * 2);
-    var2 = (var2 / 4) + (((int32_t)calib_data->dig_P4) * 65536);
-    var3 = (calib_data->dig_P3 * (((var1 / 4) * (var1 / 4)) / 8192)) / 8;
-    var4 = (((int32_t)calib_data->dig_P2) * var1) / 2;
-    var1 = (var3 + var4) / 262144;
-    var1 = (((32768 + var1)) * ((int32_t)calib_data->dig_P1)) / 32768;
-
-    /* avoid exception caused by division by zero */
-    if (var1)
-    {
-        var5 = (uint32_t)((uint32_t)1048576) - uncomp_data->pressure;
-        pressure = ((uint32_t)(var5 - (uint32_t)(var2 / 4096))) * 3125;
-        if (pressure < 0x80000000)
-        {
-            pressure = (pressure << 1) / ((uint32_t)var1);
-        }
-        else
-        {
-            pressure = (pressure / (uint32_t)var1) * 2;
-        }
-        var1 = (((int32_t)calib_data->dig_P9) * ((int32_t)(((pressure / 8) * (pressure / 8)) / 8192))) / 4096;
-        var2 = (((int32_t)(pressure / 4)) * ((int32_t)calib_data->dig_P8)) / 8192;
-        pressure = (uint32_t)((int32_t)pressure + ((var1 + var2 + calib_data->dig_P7) / 16));
-        if (pressure < pressure_min)
-        {
-            pressure = pressure_min;
-        }
-        else if (pressure > pressure_max)
-        {
-            pressure = pressure_max;
-        }
-    }
-    else
-    {
-        pressure = pressure_min;
-    }
-
-    return pressure;
-}
-
-static uint32_t BME280_CompensateHumidity(BME280* bme280)
-{
-    // Set up variables
-    int32_t var1;
-    int32_t var2;
-    int32_t var3;
-    int32_t var4;
-    int32_t var5;
-    uint32_t humidity;
-    uint32_t humidity_max = 102400;
-    
-    // Get pointer to uncompensated data structure
-    BME280_Uncomp_Data* uncomp_data = &bme280->uncomp_data;
-    // Get pointer to calibration data 
-    BME280_Calib_Data* calib_data = &bme280->calib_data;
-    
-    var1 = calib_data->t_fine - ((int32_t)76800);
-    var2 = (int32_t)(uncomp_data->humidity * 16384);
-    var3 = (int32_t)(((int32_t)calib_data->dig_H4) * 1048576);
-    var4 = ((int32_t)calib_data->dig_H5) * var1;
-    var5 = (((var2 - var3) - var4) + (int32_t)16384) / 32768;
-    var2 = (var1 * ((int32_t)calib_data->dig_H6)) / 1024;
-    var3 = (var1 * ((int32_t)calib_data->dig_H3)) / 2048;
-    var4 = ((var2 * (var3 + (int32_t)32768)) / 1024) + (int32_t)2097152;
-    var2 = ((var4 * ((int32_t)calib_data->dig_H2)) + 8192) / 16384;
-    var3 = var5 * var2;
-    var4 = ((var3 / 32768) * (var3 / 32768)) / 128;
-    var5 = var3 - ((var4 * ((int32_t)calib_data->dig_H1)) / 16);
-    var5 = (var5 < 0 ? 0 : var5);
-    var5 = (var5 > 419430400 ? 419430400 : var5);
-    humidity = (uint32_t)(var5 / 4096);
-    if (humidity > humidity_max)
-    {
-        humidity = humidity_max;
-    }
-
-    return humidity;
-}
-
 static BME280_ErrorCode BME280_NullPtrCheck(const BME280* bme280)
 {
     BME280_ErrorCode error;
-    if (bme280 == NULL)
+    if (bme280 == NULL || bme280->bus == NULL)
     {
         error = BME280_E_NULL_PTR;
     }
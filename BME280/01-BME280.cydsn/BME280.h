@@ -14,6 +14,8 @@
 
     #include "cytypes.h"
     #include "BME280_ErrorCodes.h"
+    #include "BME280_I2C_Interface.h"
+    #include "BME280_Compensation.h"
     
     /******************************************/
     /*              Macros                    */
@@ -32,6 +34,20 @@
         #define BME280_WHO_AM_I 0x60
     #endif
     
+    /**
+    *   \brief I2C address of the sensor with SDO connected to GND.
+    */
+    #ifndef BME280_I2C_ADDRESS_PRIMARY
+        #define BME280_I2C_ADDRESS_PRIMARY 0x76
+    #endif
+    
+    /**
+    *   \brief I2C address of the sensor with SDO connected to VDDIO.
+    */
+    #ifndef BME280_I2C_ADDRESS_SECONDARY
+        #define BME280_I2C_ADDRESS_SECONDARY 0x77
+    #endif
+    
     /**
     *   \brief Macro for pressure compensation selection
     *
@@ -73,6 +89,13 @@
         #define BME280_ALL_COMP 0x07
     #endif
     
+    /**
+    *   \brief Number of registers with pressure, temperature, and humidity data.
+    */
+    #ifndef BME280_P_T_H_DATA_LEN
+        #define BME280_P_T_H_DATA_LEN 8
+    #endif
+    
     /**
     *   \brief Macro for status register check
     */
@@ -80,9 +103,35 @@
         #define BME280_STATUS_IM_UPDATE 0x01
     #endif
     
+    /**
+    *   \brief Status register bit set while a conversion is running.
+    */
+    #ifndef BME280_STATUS_MEASURING
+        #define BME280_STATUS_MEASURING 0x08
+    #endif
+    
+    /**
+    *   \brief Number of registers from the status register to humidity LSB.
+    */
+    #ifndef BME280_STATUS_DATA_LEN
+        #define BME280_STATUS_DATA_LEN 12
+    #endif
+    
     /******************************************/
     /*              Typedefs                  */
     /******************************************/
+    /**
+    *   \brief Sensor operating modes.
+    *
+    *   This enum contains all the possible values of the mode bits
+    *   in the #BME280_CTRL_MEAS_REG_ADDR register.
+    */
+    typedef enum {
+        BME280_SLEEP_MODE = 0x00,   ///< Sleep mode, no measurements performed
+        BME280_FORCED_MODE = 0x01,  ///< Forced mode, single measurement
+        BME280_NORMAL_MODE = 0x03   ///< Normal mode, continuous measurements
+    } BME280_Mode;
+    
     /**
     *   \brief Oversampling values.
     *
@@ -129,34 +178,6 @@
         BME280_FILTER_COEFF_16    ///< Temperature oversampling x16
     } BME280_Filter;
     
-    /**
-    *   \brief Struct with calibration coefficients
-    *
-    *   This struct holds the calibration coefficients of the sensor
-    *   that can be read from registers #BME280_CALIB_TEMP_PRESS_REG_ADDR and
-    *   #BME280_CALIB_HUM_REG_ADDR.
-    */
-    typedef struct {
-        uint16_t dig_T1;    ///< Temperature calibration coefficient T1
-        int16_t  dig_T2;    ///< Temperature calibration coefficient T2
-        int16_t  dig_T3;    ///< Temperature calibration coefficient T3
-        uint16_t dig_P1;    ///< Pressure calibration coefficient P1
-        int16_t  dig_P2;    ///< Pressure calibration coefficient P2
-        int16_t  dig_P3;    ///< Pressure calibration coefficient P3
-        int16_t  dig_P4;    ///< Pressure calibration coefficient P4
-        int16_t  dig_P5;    ///< Pressure calibration coefficient P5
-        int16_t  dig_P6;    ///< Pressure calibration coefficient P6
-        int16_t  dig_P7;    ///< Pressure calibration coefficient P7
-        int16_t  dig_P8;    ///< Pressure calibration coefficient P8
-        int16_t  dig_P9;    ///< Pressure calibration coefficient P9
-        uint8_t  dig_H1;    ///< Humidity calibration coefficient H1
-        int16_t  dig_H2;    ///< Humidity calibration coefficient H2
-        uint8_t  dig_H3;    ///< Humidity calibration coefficient H3
-        int16_t  dig_H4;    ///< Humidity calibration coefficient H4
-        int16_t  dig_H5;    ///< Humidity calibration coefficient H5
-        int8_t   dig_H6;    ///< Humidity calibration coefficient H6
-        int32_t  t_fine;    ///< Fine temperature value
-    } BME280_Calib_Data;
     
     /**
     *   \brief Struct holding compensated data.
@@ -199,20 +220,62 @@
         uint8_t spi_enable;  ///< SPI enabled
     } BME280_Settings;
     
+    /**
+    *   \brief Struct holding a copy of the configuration registers.
+    *
+    *   This structure keeps in RAM the last values written to the
+    *   #BME280_CTRL_HUM_REG_ADDR, #BME280_CTRL_MEAS_REG_ADDR, and
+    *   #BME280_CONFIG_REG_ADDR registers, so that settings can be changed
+    *   without reading them back from the sensor.
+    */
+    typedef struct {
+        uint8_t ctrl_hum;    ///< Value of the ctrl_hum register
+        uint8_t ctrl_meas;   ///< Value of the ctrl_meas register
+        uint8_t config;      ///< Value of the config register
+        uint8_t valid;       ///< Set when the copy matches the sensor registers
+    } BME280_Reg_Shadow;
+    
     /**
     *   \brief BME280 Device structure that holds sensor settings and data.
     */
     typedef struct {
+        const BME280_Bus* bus;          ///< Transport used to talk to the device
+        uint8_t address;                ///< Address of the device on the bus
         uint8_t chip_id;                ///< Chip id of the device
         BME280_Calib_Data calib_data;   ///< Structure for calibration data
+        BME280_Comp_Coeff comp_coeff;   ///< Structure for compensation coefficients
         BME280_Data data;               ///< Structure for sensor data
         BME280_Uncomp_Data uncomp_data; ///< Structure for uncompensated data
         BME280_Settings settings;       ///< Structure for sensor settings
+        BME280_Reg_Shadow shadow;       ///< Copy of the configuration registers
+        uint8_t sample_pending;         ///< Set by a forced mode trigger, cleared when its sample is read
+        uint8_t last_frame_valid;       ///< Set when last_frame holds a sample
+        uint8_t last_frame[BME280_P_T_H_DATA_LEN]; ///< Data last returned by #BME280_ReadDataIfReady
+        uint8_t raw_data[BME280_P_T_H_DATA_LEN]; ///< Data read by #BME280_ReadDataAsync
+        BME280_I2C_Transaction transaction;      ///< Transaction used for non-blocking reads
     } BME280;
     
     /******************************************/
     /*          Function Prototypes           */
     /******************************************/
+    /**
+    *   \brief Set the bus and the address of the BME280 sensor.
+    *
+    *   This function sets the transport and the address used to talk to
+    *   the sensor. It must be called before #BME280_Start. Several sensors
+    *   can share the same bus, as long as they have different addresses.
+    *
+    *   \param[in] bme280 : Pointer to device struct
+    *   \param[in] bus : Transport used to talk to the sensor (e.g., #BME280_I2C_Bus)
+    *   \param[in] address : Address of the sensor (#BME280_I2C_ADDRESS_PRIMARY
+    *                       or #BME280_I2C_ADDRESS_SECONDARY)
+    *
+    *   \return Result of function execution 
+    *   \retval #BME280_E_NULL_PTR -> Null pointer
+    *   \retval #BME280_OK -> Success
+    */
+    BME280_ErrorCode BME280_Setup(BME280* bme280, const BME280_Bus* bus, uint8_t address);
+    
     /**
     *   \brief Start the BME280 sensor.
     *
@@ -225,13 +288,39 @@
     *   \param[in] bme280 : Pointer to device struct
     *
     *   \return Result of function execution 
-    *   \retval #BME280_E_NULL_PTR -> Null pointer
+    *   \retval #BME280_E_NULL_PTR -> Null pointer, or #BME280_Setup not called
     *   \retval #BME280_E_COMM_FAIL -> Error during I2C communication
     *   \retval #BME280_E_DEV_NOT_FOUND -> Device not found on I2C bus
     *   \retval #BME280_OK -> Success
     */
     BME280_ErrorCode BME280_Start(BME280* bme280);
     
+    /**
+    *   \brief Start the BME280 sensor with known calibration data.
+    *
+    *   This function starts the BME280 sensor as #BME280_Start does, but
+    *   it uses the calibration data passed in as parameter instead of
+    *   reading them from the sensor. It can be used to skip the reading
+    *   of the calibration registers when the calibration data were previously
+    *   stored by the application (e.g., in a non-volatile memory).
+    *   The dig_T1 to dig_T3 registers are read in one short transaction
+    *   and compared with the calibration data, which are trimmed for each
+    *   part, so that data stored for another sensor (e.g., before the
+    *   sensor was replaced) are not used: in this case the application
+    *   should start the sensor with #BME280_Start.
+    *
+    *   \param[in] bme280 : Pointer to device struct
+    *   \param[in] calib_data : Calibration data of the sensor
+    *
+    *   \return Result of function execution 
+    *   \retval #BME280_E_NULL_PTR -> Null pointer, or #BME280_Setup not called
+    *   \retval #BME280_E_COMM_FAIL -> Error during I2C communication
+    *   \retval #BME280_E_DEV_NOT_FOUND -> Device not found on I2C bus
+    *   \retval #BME280_E_CALIB_MISMATCH -> Calibration data of another sensor
+    *   \retval #BME280_OK -> Success
+    */
+    BME280_ErrorCode BME280_StartWithCalibData(BME280* bme280, const BME280_Calib_Data* calib_data);
+    
     /**
     *   \brief Reset the sensor.
     *
@@ -275,6 +364,155 @@
     */
     BME280_ErrorCode BME280_ReadData(BME280* bme280, uint8_t sensor_comp);
     
+    /**
+    *   \brief Read pressure, temperature and humidity if a new sample is available.
+    *
+    *   This function reads all the registers from #BME280_STATUS_REG_ADDR
+    *   to #BME280_HUM_LSB_REG_ADDR in a single burst, so that readiness and
+    *   data are checked with one bus transaction. If no conversion is running
+    *   and a sample not returned yet is available, data are parsed and 
+    *   compensated as #BME280_ReadData does. Otherwise, the device structure
+    *   is not modified.
+    *
+    *   In forced mode, a new sample is available once after each trigger
+    *   (#BME280_SetForcedMode or #BME280_ApplySettings with forced mode). 
+    *   In sleep mode with no trigger pending, #BME280_E_NOT_READY is returned.
+    *   In normal mode, a sample is new when its data registers differ from
+    *   the last sample returned; a new sample equal to the previous one is
+    *   reported as not ready.
+    *
+    *   \param[in] bme280 : pointer to device structure
+    *   \param[in] sensor_comp : flag to select which data to be compensated
+    *
+    *   \return Result of function execution
+    *   \retval #BME280_E_NULL_PTR -> Null pointer
+    *   \retval #BME280_E_COMM_FAIL -> Error during communication
+    *   \retval #BME280_E_NOT_READY -> No new sample, try again later
+    *   \retval #BME280_OK -> Success
+    */
+    BME280_ErrorCode BME280_ReadDataIfReady(BME280* bme280, uint8_t sensor_comp);
+    
+    /**
+    *   \brief Start a non-blocking read of pressure, temperature and humidity.
+    *
+    *   This function queues the read of the data registers and returns
+    *   immediately. The raw data are stored in the raw_data field of the device 
+    *   structure. The read is completed when the status of the transaction field
+    *   of the device structure is #BME280_I2C_DONE: then, the data can be parsed
+    *   with #BME280_ParseSensorData and compensated with #BME280_CompensateData.
+    *   The callback, if not NULL, is called from the I2C interrupt when the read 
+    *   is completed, and receives the context pointer in the context field of 
+    *   the transaction.
+    *
+    *   \param[in] bme280 : pointer to device structure
+    *   \param[in] callback : function called when the read is completed
+    *   \param[in] context : user pointer passed to the callback
+    *
+    *   \return Result of function execution
+    *   \retval #BME280_E_NULL_PTR -> Null pointer
+    *   \retval #BME280_E_BUSY -> A read is already in progress or the queue is full
+    *   \retval #BME280_OK -> Success
+    */
+    BME280_ErrorCode BME280_ReadDataAsync(BME280* bme280, BME280_I2C_Callback callback, void* context);
+    
+    /**
+    *   \brief Read pressure, temperature and humidity from several sensors.
+    *
+    *   This function queues the data reads of all the sensors back to back,
+    *   so that the bus goes from one sensor to the next without waiting for
+    *   the CPU. Data of each sensor are then parsed and compensated as soon
+    *   as its read is completed, while the following reads are still in progress.
+    *   The result of each read is stored in the transaction field of
+    *   the corresponding device structure.
+    *
+    *   \param[in] devices : Array of pointers to device structs
+    *   \param[in] count : Number of devices
+    *   \param[in] sensor_comp : flag to select which data to be compensated
+    *
+    *   \return Result of function execution 
+    *   \retval #BME280_E_NULL_PTR -> Null pointer
+    *   \retval #BME280_E_COMM_FAIL -> Error during communication with at least one sensor
+    *   \retval #BME280_E_INT_DISABLED -> Called with interrupts disabled while
+    *           I2C reads were pending, they complete once interrupts are enabled
+    *   \retval #BME280_OK -> Success
+    */
+    BME280_ErrorCode BME280_PollDevices(BME280** devices, uint8_t count, uint8_t sensor_comp);
+    
+    /**
+    *   \brief Trigger a forced mode measurement and read its result.
+    *
+    *   This function sets the device in forced mode to start a single 
+    *   measurement with the current oversampling settings, waits for the 
+    *   maximum measurement time computed with #BME280_GetMaxMeasurementTime,
+    *   and then reads and compensates the data as #BME280_ReadData does.
+    *   No polling of the status register is performed. After the measurement
+    *   the device goes back to sleep mode.
+    *
+    *   \param[in] bme280 : pointer to device structure
+    *   \param[in] sensor_comp : flag to select which data to be compensated
+    *
+    *   \return Result of function execution
+    *   \retval #BME280_E_NULL_PTR -> Null pointer
+    *   \retval #BME280_E_COMM_FAIL -> Error during I2C communication
+    *   \retval #BME280_OK -> Success
+    */
+    BME280_ErrorCode BME280_TriggerAndRead(BME280* bme280, uint8_t sensor_comp);
+    
+    /**
+    *   \brief Get the typical measurement time.
+    *
+    *   This function computes the typical time required by a measurement
+    *   cycle with the current oversampling settings, according to the
+    *   formulas in the sensor datasheet.
+    *
+    *   \param[in] bme280 : pointer to device structure
+    *
+    *   \return Typical measurement time in microseconds.
+    */
+    uint32_t BME280_GetTypicalMeasurementTime(BME280* bme280);
+    
+    /**
+    *   \brief Get the maximum measurement time.
+    *
+    *   This function computes the maximum time required by a measurement
+    *   cycle with the current oversampling settings, according to the
+    *   formulas in the sensor datasheet. After this time, new data are
+    *   guaranteed to be available in the data registers.
+    *
+    *   \param[in] bme280 : pointer to device structure
+    *
+    *   \return Maximum measurement time in microseconds.
+    */
+    uint32_t BME280_GetMaxMeasurementTime(BME280* bme280);
+    
+    /**
+    *   \brief Get the standby time.
+    *
+    *   This function returns the standby time set in the config register,
+    *   that is the time between the end of a measurement and the start of
+    *   the next one in normal mode.
+    *
+    *   \param[in] bme280 : pointer to device structure
+    *
+    *   \return Standby time in microseconds.
+    */
+    uint32_t BME280_GetStandbyTime(BME280* bme280);
+    
+    /**
+    *   \brief Get the time between two consecutive samples.
+    *
+    *   In normal mode, this is the maximum measurement time plus the
+    *   standby time. In forced mode, this is the maximum measurement
+    *   time, that is the minimum period achievable by triggering a new
+    *   measurement as soon as the previous one is read. The achievable 
+    *   sample rate is the inverse of this value.
+    *
+    *   \param[in] bme280 : pointer to device structure
+    *
+    *   \return Sample period in microseconds.
+    */
+    uint32_t BME280_GetSamplePeriod(BME280* bme280);
+    
     /**
     *   \brief Parse pressure, temperature, and humidity data.
     *
@@ -314,6 +552,27 @@
     */
     BME280_ErrorCode BME280_GetSensorMode(BME280* bme280);
     
+    /**
+    *   \brief Apply a complete set of sensor settings.
+    *
+    *   This function computes the values of the #BME280_CTRL_HUM_REG_ADDR,
+    *   #BME280_CTRL_MEAS_REG_ADDR, and #BME280_CONFIG_REG_ADDR registers from
+    *   the settings passed in as parameter, compares them with the copy kept
+    *   in the device structure, and writes only the registers that changed.
+    *   All the writes are performed in a single I2C transaction. If the 
+    *   #BME280_CONFIG_REG_ADDR register needs to be changed, the device is 
+    *   put in sleep mode before writing it, and then set to the requested mode.
+    *
+    *   \param[in] bme280 : pointer to device struct
+    *   \param[in] settings : new settings of the sensor
+    *
+    *   \return Result of function execution 
+    *   \retval #BME280_E_NULL_PTR -> Null pointer
+    *   \retval #BME280_E_COMM_FAIL -> Error during I2C communication
+    *   \retval #BME280_OK -> Success
+    */
+    BME280_ErrorCode BME280_ApplySettings(BME280* bme280, const BME280_Settings* settings);
+    
     /**
     *   \brief Set humidity oversampling value.
     *
@@ -370,6 +629,7 @@
     *   This function reads the #BME280_STATUS_REG_ADDR, that contains two bit ([3] and [0])
     *   which indicate the status of the device.
     *
+    *   \param[in] bme280 : Pointer to device struct
     *   \param[out] value : Value read from the status register
     *
     *   \return Result of function execution 
@@ -377,7 +637,7 @@
     *   \retval BME280_ERROR -> Generic error
     *   \retval BME280_OK -> Success
     */
-    BME280_ErrorCode BME280_ReadStatusRegister(uint8_t* value);
+    BME280_ErrorCode BME280_ReadStatusRegister(BME280* bme280, uint8_t* value);
     
     /**
     *   \brief Set device in sleep mode.
@@ -0,0 +1,363 @@
+/*
+*   This file includes all the required source code to adapt
+*   BME280 oversampling and filter settings to the signal.
+*
+*   \author Davide Marzorati
+*/
+
+#include "BME280_Adaptive.h"
+#include "BME280_Planner.h"
+
+/******************************************/
+/*               Macros                   */
+/******************************************/
+
+/**
+*   \brief Absolute value of an int32_t as uint32_t.
+*/
+#define BME280_ADAPTIVE_ABS(x) ((uint32_t)(((x) < 0) ? -(x) : (x)))
+
+/**
+*   \brief Largest second difference added to the statistics.
+*/
+#define BME280_ADAPTIVE_MAX_DIFFERENCE 2047
+
+/**
+*   \brief Mean squared second difference due to rounding, 6 / 12 LSB^2.
+*/
+#define BME280_ADAPTIVE_ROUNDING_SQUARES (1 << (BME280_ADAPTIVE_FRAC_BITS - 1))
+
+/**
+*   \brief Variance of the rounding, 1 / 12 LSB^2.
+*/
+#define BME280_ADAPTIVE_ROUNDING_VARIANCE ((1 << (2 * BME280_ADAPTIVE_FRAC_BITS)) / 12)
+
+/******************************************/
+/*            Lookup Tables               */
+/******************************************/
+
+/**
+*   \brief Variance over mean squared second difference, for each #BME280_Filter value.
+*
+*   The filtered noise is correlated, so its second differences are smaller.
+*   With filter coefficient c, the ratio is 1 / (2 / c * (2 + 1 / c)), with
+*   #BME280_ADAPTIVE_FRAC_BITS fractional bits.
+*/
+static const uint16_t BME280_ADAPTIVE_NOISE_SCALE[] = {43, 102, 228, 482, 993};
+
+/**
+*   \brief Lag in samples of the filter on a ramp, for each #BME280_Filter value.
+*/
+static const uint8_t BME280_ADAPTIVE_LAG[] = {0, 1, 3, 7, 15};
+
+/******************************************/
+/*          Function Prototypes           */
+/******************************************/
+
+/**
+*   \brief Choose the next settings from the statistics.
+*
+*   \param[in] adaptive : pointer to the controller
+*   \param[in,out] settings : current settings, changed by the controller
+*
+*   \return 1 if the settings were changed, 0 otherwise.
+*/
+static uint8_t BME280_Adaptive_Decide(BME280_Adaptive* adaptive, BME280_Settings* settings);
+
+/**
+*   \brief Compute slope and noise of a channel over the window.
+*
+*   \param[in,out] channel : pointer to the channel
+*   \param[in] filter : #BME280_Filter value of the samples
+*/
+static void BME280_Adaptive_Estimate(BME280_Adaptive_Channel* channel, uint16_t differences,
+                                     uint8_t filter);
+
+/**
+*   \brief Clear the noise statistics.
+*
+*   \param[in,out] adaptive : pointer to the controller
+*/
+static void BME280_Adaptive_Restart(BME280_Adaptive* adaptive);
+
+/**
+*   \brief Integer square root.
+*/
+static uint32_t BME280_Adaptive_Sqrt(uint32_t value);
+
+/**
+*   \brief Get the oversampling setting of a channel.
+*
+*   \param[in] settings : settings of the sensor
+*   \param[in] channel : index of the channel
+*
+*   \return Pointer to the oversampling field of the channel.
+*/
+static uint8_t* BME280_Adaptive_Oversampling(BME280_Settings* settings, uint8_t channel);
+
+/******************************************/
+/*          Function Definitions          */
+/******************************************/
+
+void BME280_Adaptive_Init(BME280_Adaptive* adaptive, uint16_t t_target, uint16_t p_target,
+                          uint16_t h_target, uint32_t time_budget)
+{
+    adaptive->channels[BME280_ADAPTIVE_PRESSURE].target = (uint32_t)p_target << BME280_ADAPTIVE_FRAC_BITS;
+    adaptive->channels[BME280_ADAPTIVE_TEMPERATURE].target = (uint32_t)t_target << BME280_ADAPTIVE_FRAC_BITS;
+    adaptive->channels[BME280_ADAPTIVE_HUMIDITY].target = (uint32_t)h_target << BME280_ADAPTIVE_FRAC_BITS;
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        adaptive->channels[i].slope = 0;
+        adaptive->channels[i].noise = 0;
+    }
+    adaptive->time_budget = time_budget;
+    adaptive->samples = 0;
+    adaptive->changes = 0;
+    BME280_Adaptive_Restart(adaptive);
+}
+
+uint8_t BME280_Adaptive_Update(BME280_Adaptive* adaptive, const BME280_Data* data,
+                               BME280_Settings* settings)
+{
+    int32_t values[3];
+    uint8_t filter = (settings->filter <= BME280_FILTER_COEFF_16) ? settings->filter : BME280_FILTER_COEFF_16;
+    uint8_t changed = 0;
+
+    values[BME280_ADAPTIVE_PRESSURE] = (int32_t)data->pressure;
+    values[BME280_ADAPTIVE_TEMPERATURE] = data->temperature;
+    values[BME280_ADAPTIVE_HUMIDITY] = (int32_t)data->humidity;
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        BME280_Adaptive_Channel* channel = &adaptive->channels[i];
+        int32_t difference = values[i] - channel->last;
+        uint32_t second_difference = BME280_ADAPTIVE_ABS(difference - channel->difference);
+
+        if ( adaptive->samples == 0)
+        {
+            // Samples are stored relative to the first one to keep sums small
+            channel->offset = values[i];
+            channel->sum = 0;
+            channel->weighted_sum = 0;
+        }
+        else
+        {
+            channel->sum += values[i] - channel->offset;
+            channel->weighted_sum += (int64_t)(values[i] - channel->offset) * adaptive->samples;
+        }
+        if ( adaptive->settled >= 2)
+        {
+            if ( second_difference > BME280_ADAPTIVE_MAX_DIFFERENCE)
+            {
+                second_difference = BME280_ADAPTIVE_MAX_DIFFERENCE;
+            }
+            channel->sum_squares += second_difference * second_difference;
+        }
+        channel->difference = difference;
+        channel->last = values[i];
+    }
+
+    if ( adaptive->settled >= 2)
+    {
+        adaptive->differences++;
+    }
+    else
+    {
+        adaptive->settled++;
+    }
+    if ( ++adaptive->samples >= BME280_ADAPTIVE_WINDOW)
+    {
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            // Humidity is not filtered by the sensor
+            BME280_Adaptive_Estimate(&adaptive->channels[i], adaptive->differences,
+                                     (i == BME280_ADAPTIVE_HUMIDITY) ? BME280_FILTER_COEFF_OFF : filter);
+        }
+        adaptive->samples = 0;
+        if ( BME280_Adaptive_Decide(adaptive, settings))
+        {
+            // Noise of the old settings does not apply anymore
+            BME280_Adaptive_Restart(adaptive);
+            adaptive->changes++;
+            changed = 1;
+        }
+        else if ( adaptive->differences >= BME280_ADAPTIVE_MEMORY)
+        {
+            // Forget older samples slowly
+            for (uint8_t i = 0; i < 3; i++)
+            {
+                adaptive->channels[i].sum_squares /= 2;
+            }
+            adaptive->differences /= 2;
+        }
+    }
+    return changed;
+}
+
+static uint8_t BME280_Adaptive_Decide(BME280_Adaptive* adaptive, BME280_Settings* settings)
+{
+    uint8_t filter = (settings->filter <= BME280_FILTER_COEFF_16) ? settings->filter : BME280_FILTER_COEFF_16;
+    uint8_t adapted[3];
+    uint8_t worst = 3;
+    uint8_t best = 3;
+    uint8_t allowed = filter;
+    uint8_t filter_up = (filter < BME280_FILTER_COEFF_16);
+    BME280_Settings candidate;
+    BME280_Plan plan;
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        BME280_Adaptive_Channel* channel = &adaptive->channels[i];
+        uint32_t slope = BME280_ADAPTIVE_ABS(channel->slope);
+
+        adapted[i] = (channel->target > 0 && *BME280_Adaptive_Oversampling(settings, i) != BME280_NO_OVERSAMPLING);
+        if ( !adapted[i])
+        {
+            continue;
+        }
+        if ( i != BME280_ADAPTIVE_HUMIDITY)
+        {
+            // Highest filter whose lag on the current slope is within the target
+            while ( allowed > BME280_FILTER_COEFF_OFF && (uint64_t)slope * BME280_ADAPTIVE_LAG[allowed] > channel->target)
+            {
+                allowed--;
+            }
+            // A higher filter must leave margin for the slope to grow
+            if ( filter_up && (uint64_t)slope * BME280_ADAPTIVE_LAG[filter + 1] * 2 > channel->target)
+            {
+                filter_up = 0;
+            }
+        }
+        // Noisiest channel among the ones that are not moving
+        if ( channel->noise > channel->target && slope * 2 <= channel->target
+             && (worst == 3 || (uint64_t)channel->noise * adaptive->channels[worst].target
+                               > (uint64_t)adaptive->channels[worst].noise * channel->target))
+        {
+            worst = i;
+        }
+        // Quietest channel that can be sampled faster
+        if ( channel->noise * 2 < channel->target
+             && *BME280_Adaptive_Oversampling(settings, i) > BME280_OVERSAMPLING_1X
+             && (best == 3 || (uint64_t)channel->noise * adaptive->channels[best].target
+                              < (uint64_t)adaptive->channels[best].noise * channel->target))
+        {
+            best = i;
+        }
+    }
+
+    // Filter too slow for the signal
+    if ( allowed < filter)
+    {
+        settings->filter = allowed;
+        return 1;
+    }
+    // Channel moving by more than its target every sample, sample faster
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        uint8_t* oversampling = BME280_Adaptive_Oversampling(settings, i);
+        if ( adapted[i] && BME280_ADAPTIVE_ABS(adaptive->channels[i].slope) > adaptive->channels[i].target
+             && *oversampling > BME280_OVERSAMPLING_1X)
+        {
+            (*oversampling)--;
+            return 1;
+        }
+    }
+    if ( worst < 3)
+    {
+        // Filter costs no time, try it first for temperature and pressure
+        if ( worst != BME280_ADAPTIVE_HUMIDITY && filter_up)
+        {
+            settings->filter = filter + 1;
+            return 1;
+        }
+        candidate = *settings;
+        if ( *BME280_Adaptive_Oversampling(&candidate, worst) < BME280_OVERSAMPLING_16X)
+        {
+            (*BME280_Adaptive_Oversampling(&candidate, worst))++;
+            BME280_Planner_Evaluate(&candidate, 0, &plan);
+            if ( adaptive->time_budget == 0 || plan.measurement_time <= adaptive->time_budget)
+            {
+                *settings = candidate;
+                return 1;
+            }
+        }
+        return 0;
+    }
+    if ( best < 3)
+    {
+        (*BME280_Adaptive_Oversampling(settings, best))--;
+        return 1;
+    }
+    return 0;
+}
+
+static void BME280_Adaptive_Estimate(BME280_Adaptive_Channel* channel, uint16_t differences,
+                                     uint8_t filter)
+{
+    const int64_t n = BME280_ADAPTIVE_WINDOW;
+    uint64_t mean_squares;
+    uint64_t variance = 0;
+
+    // Least squares line through the samples
+    channel->slope = (int32_t)((12 * channel->weighted_sum - 6 * (n - 1) * channel->sum)
+                     * (1 << BME280_ADAPTIVE_FRAC_BITS) / (n * (n * n - 1)));
+
+    // Variance of the noise without rounding, then with rounding
+    mean_squares = ((uint64_t)channel->sum_squares << BME280_ADAPTIVE_FRAC_BITS) / differences;
+    if ( mean_squares > BME280_ADAPTIVE_ROUNDING_SQUARES)
+    {
+        variance = (mean_squares - BME280_ADAPTIVE_ROUNDING_SQUARES) * BME280_ADAPTIVE_NOISE_SCALE[filter];
+    }
+    variance += BME280_ADAPTIVE_ROUNDING_VARIANCE;
+    channel->noise = BME280_Adaptive_Sqrt((variance > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)variance);
+}
+
+static void BME280_Adaptive_Restart(BME280_Adaptive* adaptive)
+{
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        adaptive->channels[i].sum_squares = 0;
+    }
+    adaptive->differences = 0;
+    adaptive->settled = 0;
+}
+
+static uint32_t BME280_Adaptive_Sqrt(uint32_t value)
+{
+    uint32_t result = 0;
+    uint32_t bit = 1UL << 30;
+
+    while ( bit > value)
+    {
+        bit >>= 2;
+    }
+    while ( bit != 0)
+    {
+        if ( value >= result + bit)
+        {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+        {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return result;
+}
+
+static uint8_t* BME280_Adaptive_Oversampling(BME280_Settings* settings, uint8_t channel)
+{
+    if ( channel == BME280_ADAPTIVE_PRESSURE)
+    {
+        return &settings->osr_p;
+    }
+    if ( channel == BME280_ADAPTIVE_TEMPERATURE)
+    {
+        return &settings->osr_t;
+    }
+    return &settings->osr_h;
+}
+
+/* [] END OF FILE */
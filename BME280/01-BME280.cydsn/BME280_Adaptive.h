@@ -0,0 +1,156 @@
+/**
+*   \file BME280_Adaptive.h
+*
+*   \brief Adaptive oversampling and filter settings.
+*
+*   This header file contains the functions to adapt the oversampling
+*   of each channel and the IIR filter to the signal. Samples are
+*   collected in windows of #BME280_ADAPTIVE_WINDOW samples; for each
+*   channel, the controller estimates the slope with a least squares
+*   line over the window, and the noise from the second differences of
+*   the samples since the last change, corrected for the correlation
+*   added by the filter and for the rounding of the output.
+*
+*   At the end of each window at most one step is taken. When the signal
+*   changes so fast that the lag of the filter would exceed the noise
+*   target, the filter is lowered at once, and the oversampling of a
+*   channel that moves by more than its target every sample is stepped
+*   down to sample faster. When the samples are noisier than the target,
+*   the filter (temperature and pressure) or the oversampling is stepped
+*   up within the time budget; when they are less than half as noisy,
+*   the oversampling is stepped down to save time. The new settings are
+*   meant to be written with #BME280_ApplySettings, which writes only
+*   the registers that changed.
+*
+*   \author Davide Marzorati
+*   \date November 8, 2019
+*/
+
+#ifndef __BME280_ADAPTIVE_H
+    #define __BME280_ADAPTIVE_H
+
+    #include "BME280.h"
+
+    /**
+    *   \brief Number of fractional bits of noise, slope, and targets.
+    */
+    #define BME280_ADAPTIVE_FRAC_BITS 8
+
+    /**
+    *   \brief Number of samples between two decisions, from 8 to 256.
+    */
+    #ifndef BME280_ADAPTIVE_WINDOW
+        #define BME280_ADAPTIVE_WINDOW 32
+    #endif
+
+    /**
+    *   \brief Number of second differences after which the older half is forgotten,
+    *   at most 256.
+    */
+    #ifndef BME280_ADAPTIVE_MEMORY
+        #define BME280_ADAPTIVE_MEMORY 256
+    #endif
+
+    /**
+    *   \brief Default noise target for temperature, in 0.01 degC.
+    */
+    #ifndef BME280_ADAPTIVE_NOISE_TEMPERATURE
+        #define BME280_ADAPTIVE_NOISE_TEMPERATURE 2
+    #endif
+
+    /**
+    *   \brief Default noise target for pressure, in Pa.
+    */
+    #ifndef BME280_ADAPTIVE_NOISE_PRESSURE
+        #define BME280_ADAPTIVE_NOISE_PRESSURE 1
+    #endif
+
+    /**
+    *   \brief Default noise target for humidity, in 1/1024 %RH.
+    */
+    #ifndef BME280_ADAPTIVE_NOISE_HUMIDITY
+        #define BME280_ADAPTIVE_NOISE_HUMIDITY 32
+    #endif
+
+    /**
+    *   \brief Index of the pressure channel.
+    */
+    #define BME280_ADAPTIVE_PRESSURE 0
+
+    /**
+    *   \brief Index of the temperature channel.
+    */
+    #define BME280_ADAPTIVE_TEMPERATURE 1
+
+    /**
+    *   \brief Index of the humidity channel.
+    */
+    #define BME280_ADAPTIVE_HUMIDITY 2
+
+    /**
+    *   \brief Statistics of a channel.
+    *
+    *   Noise, slope, and target are in the units of the compensated
+    *   output, with #BME280_ADAPTIVE_FRAC_BITS fractional bits.
+    */
+    typedef struct {
+        int32_t offset;                 ///< First sample of the window
+        int32_t last;                   ///< Last sample
+        int32_t difference;             ///< Last difference between samples
+        int32_t sum;                    ///< Sum of the samples minus offset
+        int64_t weighted_sum;           ///< Sum of the samples minus offset, times their index
+        uint32_t sum_squares;           ///< Sum of the squared second differences since the last change
+        int32_t slope;                  ///< Slope over the last window, per sample
+        uint32_t noise;                 ///< RMS noise since the last change
+        uint32_t target;                ///< Maximum RMS noise, 0 if the channel is not adapted
+    } BME280_Adaptive_Channel;
+
+    /**
+    *   \brief State of the controller.
+    */
+    typedef struct {
+        BME280_Adaptive_Channel channels[3];    ///< Pressure, temperature, and humidity
+        uint32_t time_budget;                   ///< Maximum measurement time in us, 0 for no limit
+        uint16_t samples;                       ///< Samples in the current window
+        uint16_t differences;                   ///< Second differences since the last change
+        uint8_t settled;                        ///< Samples since the last change, up to 2
+        uint16_t changes;                       ///< Number of changes of the settings
+    } BME280_Adaptive;
+
+    /**
+    *   \brief Initialize the controller.
+    *
+    *   Targets are in the units of the compensated output (0.01 degC,
+    *   Pa, and 1/1024 %RH). The oversampling of a channel with a target
+    *   of 0 is never changed.
+    *
+    *   \param[out] adaptive : pointer to the controller
+    *   \param[in] t_target : RMS noise target for temperature
+    *   \param[in] p_target : RMS noise target for pressure
+    *   \param[in] h_target : RMS noise target for humidity
+    *   \param[in] time_budget : maximum measurement time in us, 0 for no limit
+    */
+    void BME280_Adaptive_Init(BME280_Adaptive* adaptive, uint16_t t_target, uint16_t p_target,
+                              uint16_t h_target, uint32_t time_budget);
+
+    /**
+    *   \brief Add a sample and adapt the settings.
+    *
+    *   The sample must have been measured with the settings passed in
+    *   as parameter. If the settings are changed, the following samples
+    *   must be measured with the new settings. Skipped channels
+    *   (oversampling #BME280_NO_OVERSAMPLING) are not adapted.
+    *
+    *   \param[in,out] adaptive : pointer to the controller
+    *   \param[in] data : compensated sample
+    *   \param[in,out] settings : current settings, changed by the controller
+    *
+    *   \return 1 if the settings were changed, 0 otherwise.
+    */
+    uint8_t BME280_Adaptive_Update(BME280_Adaptive* adaptive, const BME280_Data* data,
+                                   BME280_Settings* settings);
+
+#endif
+
+
+/* [] END OF FILE */
@@ -0,0 +1,315 @@
+/**
+ * \file BME280_Compensation.h
+ * \brief Compensation of BME280 raw data.
+ *
+ * This file contains the functions to convert raw temperature, pressure,
+ * and humidity values into compensated values using the calibration
+ * coefficients of the sensor. Different implementations of the
+ * compensation formulas are available, and one of them is selected
+ * at compile time with #BME280_COMP_BACKEND. All of them return
+ * temperature in 0.01 degC, pressure in Pa, and humidity in 1/1024 %RH.
+ *
+ * \author Davide Marzorati
+ * \date October 25, 2019
+*/
+
+#ifndef __BME280_COMPENSATION_H
+    #define __BME280_COMPENSATION_H
+
+    #include "cytypes.h"
+
+    /******************************************/
+    /*              Macros                    */
+    /******************************************/
+
+    /**
+    *   \brief Compensation backend: 32 bit integer formulas.
+    *
+    *   Formulas from the datasheet using only 32 bit integer arithmetic.
+    *   Pressure resolution is 1 Pa.
+    */
+    #define BME280_COMP_INT32 0
+
+    /**
+    *   \brief Compensation backend: 64 bit integer pressure formula.
+    *
+    *   Same as #BME280_COMP_INT32, but pressure is computed with the
+    *   64 bit integer formula from the datasheet, which has a lower error.
+    */
+    #define BME280_COMP_INT64 1
+
+    /**
+    *   \brief Compensation backend: floating point formulas.
+    *
+    *   Formulas from the datasheet using double precision arithmetic.
+    *   Meant for hosts with a floating point unit.
+    */
+    #define BME280_COMP_FLOAT 2
+
+    /**
+    *   \brief Compensation backend: table interpolated formulas.
+    *
+    *   The terms of the 32 bit integer formulas depending only on
+    *   temperature are computed when calibration data are loaded at
+    *   equally spaced values of temperature, and linearly interpolated
+    *   for each sample. Meant for very high sample rates.
+    */
+    #define BME280_COMP_LUT 3
+
+    /**
+    *   \brief Compensation backend used by the driver.
+    */
+    #ifndef BME280_COMP_BACKEND
+        #define BME280_COMP_BACKEND BME280_COMP_INT32
+    #endif
+
+    /**
+    *   \brief Size of a raw data frame.
+    *
+    *   A raw data frame contains the values of the registers from
+    *   #BME280_PRESS_MSB_REG_ADDR to #BME280_HUM_LSB_REG_ADDR, in the
+    *   order they are read from the sensor.
+    */
+    #define BME280_COMP_FRAME_LEN 8
+
+    /**
+    *   \brief Length of packed calibration coefficients.
+    */
+    #define BME280_COMP_CALIB_PACKED_LEN 33
+
+    /**
+    *   \brief Number of samples compensated together by the batch functions.
+    *
+    *   The batch functions keep the fine temperature values of a block of
+    *   samples on the stack.
+    */
+    #ifndef BME280_COMP_BATCH_BLOCK
+        #define BME280_COMP_BATCH_BLOCK 32
+    #endif
+
+    #if BME280_COMP_BACKEND == BME280_COMP_LUT
+
+        /**
+        *   \brief Distance between table entries, as power of two of t_fine.
+        *
+        *   A step of 2^13 corresponds to 1.6 degC.
+        */
+        #ifndef BME280_COMP_LUT_STEP_BITS
+            #define BME280_COMP_LUT_STEP_BITS 13
+        #endif
+
+        /**
+        *   \brief Value of t_fine at -40 degC (first table entry).
+        */
+        #define BME280_COMP_LUT_T_FINE_MIN -204800
+
+        /**
+        *   \brief Value of t_fine at 85 degC.
+        */
+        #define BME280_COMP_LUT_T_FINE_MAX 435200
+
+        /**
+        *   \brief Number of table entries.
+        */
+        #define BME280_COMP_LUT_SIZE (((BME280_COMP_LUT_T_FINE_MAX - BME280_COMP_LUT_T_FINE_MIN) \
+                                        >> BME280_COMP_LUT_STEP_BITS) + 2)
+    #endif
+
+    /******************************************/
+    /*              Typedefs                  */
+    /******************************************/
+
+    /**
+    *   \brief Struct with calibration coefficients
+    *
+    *   This struct holds the calibration coefficients of the sensor
+    *   that can be read from registers #BME280_CALIB_TEMP_PRESS_REG_ADDR and
+    *   #BME280_CALIB_HUM_REG_ADDR.
+    */
+    typedef struct {
+        uint16_t dig_T1;    ///< Temperature calibration coefficient T1
+        int16_t  dig_T2;    ///< Temperature calibration coefficient T2
+        int16_t  dig_T3;    ///< Temperature calibration coefficient T3
+        uint16_t dig_P1;    ///< Pressure calibration coefficient P1
+        int16_t  dig_P2;    ///< Pressure calibration coefficient P2
+        int16_t  dig_P3;    ///< Pressure calibration coefficient P3
+        int16_t  dig_P4;    ///< Pressure calibration coefficient P4
+        int16_t  dig_P5;    ///< Pressure calibration coefficient P5
+        int16_t  dig_P6;    ///< Pressure calibration coefficient P6
+        int16_t  dig_P7;    ///< Pressure calibration coefficient P7
+        int16_t  dig_P8;    ///< Pressure calibration coefficient P8
+        int16_t  dig_P9;    ///< Pressure calibration coefficient P9
+        uint8_t  dig_H1;    ///< Humidity calibration coefficient H1
+        int16_t  dig_H2;    ///< Humidity calibration coefficient H2
+        uint8_t  dig_H3;    ///< Humidity calibration coefficient H3
+        int16_t  dig_H4;    ///< Humidity calibration coefficient H4
+        int16_t  dig_H5;    ///< Humidity calibration coefficient H5
+        int8_t   dig_H6;    ///< Humidity calibration coefficient H6
+        int32_t  t_fine;    ///< Fine temperature value
+    } BME280_Calib_Data;
+
+    /**
+    *   \brief Struct with compensation coefficients.
+    *
+    *   This struct holds the constants derived from the calibration
+    *   coefficients. They are computed once when calibration data are
+    *   loaded, so that the compensation only evaluates the terms
+    *   depending on the measured data.
+    */
+    typedef struct {
+        int32_t t1;         ///< T1
+        int32_t t1_x2;      ///< T1 * 2
+        int32_t t2;         ///< T2
+        int32_t t3;         ///< T3
+        int32_t p1;         ///< P1
+        int32_t p2;         ///< P2
+        int32_t p3;         ///< P3
+        int32_t p4_x65536;  ///< P4 * 65536
+        int32_t p5_x2;      ///< P5 * 2
+        int32_t p6;         ///< P6
+        int32_t p7;         ///< P7
+        int32_t p8;         ///< P8
+        int32_t p9;         ///< P9
+        int32_t h1;         ///< H1
+        int32_t h2;         ///< H2
+        int32_t h3;         ///< H3
+        int32_t h4_offset;  ///< H4 * 1048576 - 16384
+        int32_t h5;         ///< H5
+        int32_t h6;         ///< H6
+    #if BME280_COMP_BACKEND == BME280_COMP_INT64
+        int64_t p4_x2p35;   ///< P4 * 2^35
+        int64_t p5_x2p17;   ///< P5 * 2^17
+    #elif BME280_COMP_BACKEND == BME280_COMP_LUT
+        int32_t p_divisor[BME280_COMP_LUT_SIZE];    ///< Pressure divisor vs t_fine
+        int32_t p_offset[BME280_COMP_LUT_SIZE];     ///< Pressure offset vs t_fine
+        int32_t h_scale[BME280_COMP_LUT_SIZE];      ///< Humidity scale vs t_fine
+    #endif
+    } BME280_Comp_Coeff;
+
+    /******************************************/
+    /*          Function Prototypes           */
+    /******************************************/
+
+    /**
+    *   \brief Compute compensation coefficients.
+    *
+    *   This function computes the constants derived from the calibration
+    *   coefficients. It must be called every time calibration data change.
+    *
+    *   \param[out] coeff : pointer to struct where coefficients will be stored
+    *   \param[in] calib_data : pointer to calibration data
+    */
+    void BME280_Compensation_Prepare(BME280_Comp_Coeff* coeff,
+                                     const BME280_Calib_Data* calib_data);
+
+    /**
+    *   \brief Compensate raw temperature value.
+    *
+    *   \param[in] coeff : pointer to compensation coefficients
+    *   \param[in] uncomp_temperature : raw temperature value
+    *   \param[out] t_fine : fine temperature value, needed for
+    *                        pressure and humidity compensation
+    *
+    *   \return Compensated temperature in 0.01 degC.
+    */
+    int32_t BME280_Compensation_Temperature(const BME280_Comp_Coeff* coeff,
+                                            int32_t uncomp_temperature,
+                                            int32_t* t_fine);
+
+    /**
+    *   \brief Compensate raw pressure value.
+    *
+    *   \param[in] coeff : pointer to compensation coefficients
+    *   \param[in] uncomp_pressure : raw pressure value
+    *   \param[in] t_fine : fine temperature value
+    *
+    *   \return Compensated pressure in Pa.
+    */
+    uint32_t BME280_Compensation_Pressure(const BME280_Comp_Coeff* coeff,
+                                          uint32_t uncomp_pressure,
+                                          int32_t t_fine);
+
+    /**
+    *   \brief Compensate raw humidity value.
+    *
+    *   \param[in] coeff : pointer to compensation coefficients
+    *   \param[in] uncomp_humidity : raw humidity value
+    *   \param[in] t_fine : fine temperature value
+    *
+    *   \return Compensated humidity in 1/1024 %RH.
+    */
+    uint32_t BME280_Compensation_Humidity(const BME280_Comp_Coeff* coeff,
+                                          uint32_t uncomp_humidity,
+                                          int32_t t_fine);
+
+    /**
+    *   \brief Pack calibration coefficients in a byte array.
+    *
+    *   This function stores the coefficients in the order of
+    *   #BME280_Calib_Data, 16 bit values MSB first, so that they can be
+    *   saved or sent to a host and restored with
+    *   #BME280_Compensation_UnpackCalibData.
+    *
+    *   \param[in] calib_data : pointer to calibration data
+    *   \param[out] data : array of #BME280_COMP_CALIB_PACKED_LEN bytes
+    */
+    void BME280_Compensation_PackCalibData(const BME280_Calib_Data* calib_data,
+                                           uint8_t* data);
+
+    /**
+    *   \brief Unpack calibration coefficients from a byte array.
+    *
+    *   \param[out] calib_data : pointer to struct where coefficients will be stored
+    *   \param[in] data : array of #BME280_COMP_CALIB_PACKED_LEN bytes
+    */
+    void BME280_Compensation_UnpackCalibData(BME280_Calib_Data* calib_data,
+                                             const uint8_t* data);
+
+    /**
+    *   \brief Parse an array of raw data frames.
+    *
+    *   This function splits raw data frames of #BME280_COMP_FRAME_LEN bytes,
+    *   as read from the sensor or logged by the application, into separate
+    *   arrays of raw temperature, pressure, and humidity values.
+    *
+    *   \param[in] frames : array of count * #BME280_COMP_FRAME_LEN bytes
+    *   \param[in] count : number of frames
+    *   \param[out] uncomp_temperature : array of count raw temperature values
+    *   \param[out] uncomp_pressure : array of count raw pressure values
+    *   \param[out] uncomp_humidity : array of count raw humidity values
+    */
+    void BME280_Compensation_ParseFrames(const uint8_t* restrict frames, uint32_t count,
+                                         int32_t* restrict uncomp_temperature,
+                                         uint32_t* restrict uncomp_pressure,
+                                         uint32_t* restrict uncomp_humidity);
+
+    /**
+    *   \brief Compensate arrays of raw values.
+    *
+    *   This function compensates count samples stored as separate arrays
+    *   of raw values, all measured by the same sensor. Pressure and/or
+    *   humidity are skipped if the corresponding output array is NULL.
+    *   Each channel is processed by a separate loop over a block
+    *   of #BME280_COMP_BATCH_BLOCK samples, so that the compiler can
+    *   vectorize them. Input and output arrays must not overlap.
+    *
+    *   \param[in] coeff : pointer to compensation coefficients
+    *   \param[in] count : number of samples
+    *   \param[in] uncomp_temperature : array of raw temperature values
+    *   \param[in] uncomp_pressure : array of raw pressure values
+    *   \param[in] uncomp_humidity : array of raw humidity values
+    *   \param[out] temperature : array of temperature values in 0.01 degC
+    *   \param[out] pressure : array of pressure values in Pa, or NULL
+    *   \param[out] humidity : array of humidity values in 1/1024 %RH, or NULL
+    */
+    void BME280_Compensation_Batch(const BME280_Comp_Coeff* coeff, uint32_t count,
+                                   const int32_t* restrict uncomp_temperature,
+                                   const uint32_t* restrict uncomp_pressure,
+                                   const uint32_t* restrict uncomp_humidity,
+                                   int32_t* restrict temperature,
+                                   uint32_t* restrict pressure,
+                                   uint32_t* restrict humidity);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,236 @@
+/*
+*   This file includes all the required source code to compute
+*   quantities derived from BME280 data in fixed point.
+*
+*   Logarithms and powers are in Q24 format (24 fractional bits),
+*   intermediate results of powers in Q30.
+*
+*   \author Davide Marzorati
+*/
+
+#include "BME280_Derived.h"
+
+/******************************************/
+/*               Macros                   */
+/******************************************/
+
+/**
+*   \brief Fractional bits of logarithms.
+*/
+#define BME280_DERIVED_Q 24
+
+/**
+*   \brief Scale height of the barometric formula, in cm.
+*/
+#define BME280_DERIVED_ALTITUDE_SCALE 4433000
+
+/**
+*   \brief 1 / 5.255 in Q30.
+*/
+#define BME280_DERIVED_INV_EXPONENT 204327654
+
+/**
+*   \brief 5.255 in Q24.
+*/
+#define BME280_DERIVED_EXPONENT 88164270
+
+/**
+*   \brief ln(2) in Q30.
+*/
+#define BME280_DERIVED_LN2 744261118
+
+/**
+*   \brief Magnus coefficient b = 17.62 in Q24.
+*/
+#define BME280_DERIVED_MAGNUS_B 295614546
+
+/**
+*   \brief Magnus coefficient c = 243.12 degC, in 0.01 degC.
+*/
+#define BME280_DERIVED_MAGNUS_C 24312
+
+/**
+*   \brief 100 %RH in 1/1024 %RH.
+*/
+#define BME280_DERIVED_FULL_HUMIDITY 102400
+
+/******************************************/
+/*            Static variables            */
+/******************************************/
+
+// log2(1 + i / 128) in Q24, two entries more for interpolation
+static const uint32_t log2_table[130] = {
+    0, 188362, 375270, 560745, 744810, 927485,
+    1108793, 1288752, 1467383, 1644705, 1820738, 1995500,
+    2169009, 2341283, 2512340, 2682196, 2850868, 3018374,
+    3184728, 3349946, 3514044, 3677038, 3838941, 3999768,
+    4159533, 4318251, 4475935, 4632599, 4788255, 4942916,
+    5096595, 5249305, 5401057, 5551864, 5701737, 5850688,
+    5998727, 6145867, 6292118, 6437490, 6581994, 6725641,
+    6868440, 7010402, 7151536, 7291852, 7431359, 7570066,
+    7707984, 7845119, 7981483, 8117082, 8251926, 8386022,
+    8519380, 8652008, 8783912, 8915102, 9045584, 9175366,
+    9304457, 9432863, 9560591, 9687648, 9814042, 9939780,
+    10064867, 10189312, 10313120, 10436298, 10558852, 10680789,
+    10802114, 10922835, 11042956, 11162484, 11281425, 11399784,
+    11517568, 11634780, 11751428, 11867517, 11983051, 12098037,
+    12212479, 12326382, 12439752, 12552593, 12664911, 12776710,
+    12887994, 12998770, 13109041, 13218811, 13328087, 13436871,
+    13545168, 13652983, 13760320, 13867183, 13973576, 14079503,
+    14184969, 14289978, 14394532, 14498638, 14602297, 14705514,
+    14808293, 14910637, 15012551, 15114037, 15215099, 15315742,
+    15415967, 15515779, 15615181, 15714177, 15812769, 15910962,
+    16008758, 16106160, 16203172, 16299796, 16396036, 16491896,
+    16587377, 16682482, 16777216, 16871580
+};
+
+// Coefficients of 2^x - 1 = x * (c1 + x * (c2 + ...)) for x in [0, 1), in Q30
+static const int32_t exp2_poly[5] = {
+    744261533, 257920511, 59761307, 9877767, 1920246
+};
+
+/******************************************/
+/*          Function Prototypes           */
+/******************************************/
+
+/**
+*   \brief Compute the base 2 logarithm.
+*
+*   \param[in] x : value, not 0
+*
+*   \return log2(x) in Q24.
+*/
+static int32_t BME280_Derived_Log2(uint32_t x);
+
+/**
+*   \brief Compute a power of 2.
+*
+*   \param[in] y : exponent in Q24
+*
+*   \return 2^y in Q28, 0xFFFFFFFF if y is 4 or more.
+*/
+static uint32_t BME280_Derived_Exp2(int32_t y);
+
+/**
+*   \brief Divide and round to the nearest integer.
+*/
+static int64_t BME280_Derived_RoundDiv(int64_t numerator, int64_t denominator);
+
+/******************************************/
+/*          Function Definitions          */
+/******************************************/
+
+int32_t BME280_Derived_Altitude(uint32_t pressure, uint32_t sea_level_pressure)
+{
+    int32_t exponent;
+    uint32_t ratio;
+
+    // (p / p0)^(1 / 5.255) = 2^((log2(p) - log2(p0)) / 5.255)
+    exponent = (int32_t)(((int64_t)(BME280_Derived_Log2(pressure) - BME280_Derived_Log2(sea_level_pressure))
+               * BME280_DERIVED_INV_EXPONENT) >> 30);
+    ratio = BME280_Derived_Exp2(exponent);
+    return (int32_t)BME280_Derived_RoundDiv(
+        (int64_t)BME280_DERIVED_ALTITUDE_SCALE * ((1LL << 28) - ratio), 1LL << 28);
+}
+
+uint32_t BME280_Derived_SeaLevelPressure(uint32_t pressure, int32_t altitude)
+{
+    int32_t exponent;
+    uint64_t sea_level_pressure;
+
+    // (1 - h / 44330 m)^-5.255 = 2^(-5.255 * log2((44330 m - h) / 44330 m))
+    exponent = (int32_t)(((int64_t)(BME280_Derived_Log2(BME280_DERIVED_ALTITUDE_SCALE)
+               - BME280_Derived_Log2((uint32_t)(BME280_DERIVED_ALTITUDE_SCALE - altitude)))
+               * BME280_DERIVED_EXPONENT) >> BME280_DERIVED_Q);
+    sea_level_pressure = ((uint64_t)pressure * BME280_Derived_Exp2(exponent) + (1 << 27)) >> 28;
+    return (sea_level_pressure > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)sea_level_pressure;
+}
+
+int32_t BME280_Derived_DewPoint(int32_t temperature, uint32_t humidity)
+{
+    int64_t gamma;
+
+    if ( humidity == 0)
+    {
+        humidity = 1;
+    }
+    // ln(RH / 100) = ln(2) * (log2(RH) - log2(100))
+    gamma = ((int64_t)(BME280_Derived_Log2(humidity) - BME280_Derived_Log2(BME280_DERIVED_FULL_HUMIDITY))
+            * BME280_DERIVED_LN2) >> 30;
+    gamma += BME280_Derived_RoundDiv((int64_t)BME280_DERIVED_MAGNUS_B * temperature,
+                                     BME280_DERIVED_MAGNUS_C + temperature);
+    return (int32_t)BME280_Derived_RoundDiv(BME280_DERIVED_MAGNUS_C * gamma,
+                                            BME280_DERIVED_MAGNUS_B - gamma);
+}
+
+static int32_t BME280_Derived_Log2(uint32_t x)
+{
+    int32_t exponent = 31;
+    uint32_t index;
+    int64_t fraction;
+    int64_t delta;
+    int64_t delta2;
+
+    // Normalize x to 1.m with the leading 1 in bit 31
+    for (uint8_t shift = 16; shift > 0; shift >>= 1)
+    {
+        if ( (x >> (32 - shift)) == 0)
+        {
+            x <<= shift;
+            exponent -= shift;
+        }
+    }
+    // 7 bits of index, 24 bits of fraction between two entries
+    index = (x >> 24) & 0x7F;
+    fraction = x & 0xFFFFFF;
+    delta = (int64_t)log2_table[index + 1] - log2_table[index];
+    delta2 = (int64_t)log2_table[index + 2] - 2 * (int64_t)log2_table[index + 1] + log2_table[index];
+    // Newton forward interpolation: t0 + f * delta - f * (1 - f) / 2 * delta2
+    return (exponent << BME280_DERIVED_Q) + (int32_t)(log2_table[index]
+        + ((fraction * delta) >> BME280_DERIVED_Q)
+        - ((((fraction * ((1 << BME280_DERIVED_Q) - fraction)) >> (BME280_DERIVED_Q + 1)) * delta2)
+           >> BME280_DERIVED_Q));
+}
+
+static uint32_t BME280_Derived_Exp2(int32_t y)
+{
+    int32_t exponent = y >> BME280_DERIVED_Q;
+    int64_t fraction = y & ((1 << BME280_DERIVED_Q) - 1);
+    int64_t result = exp2_poly[4];
+
+    if ( exponent >= 4)
+    {
+        return 0xFFFFFFFF;
+    }
+    // Horner scheme in Q30
+    for (int8_t i = 3; i >= 0; i--)
+    {
+        result = exp2_poly[i] + ((result * fraction) >> BME280_DERIVED_Q);
+    }
+    result = (1 << 30) + ((result * fraction) >> BME280_DERIVED_Q);
+    // Scale by 2^exponent and convert to Q28
+    if ( exponent >= 2)
+    {
+        result <<= exponent - 2;
+    }
+    else if ( exponent > -30)
+    {
+        result = (result + (1LL << (1 - exponent))) >> (2 - exponent);
+    }
+    else
+    {
+        result = 0;
+    }
+    return (result > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)result;
+}
+
+static int64_t BME280_Derived_RoundDiv(int64_t numerator, int64_t denominator)
+{
+    if ( (numerator < 0) != (denominator < 0))
+    {
+        return (numerator - denominator / 2) / denominator;
+    }
+    return (numerator + denominator / 2) / denominator;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,81 @@
+/**
+*   \file BME280_Derived.h
+*
+*   \brief Quantities derived from BME280 data.
+*
+*   This header file contains the functions to compute barometric altitude,
+*   sea-level pressure, and dew point from the compensated integer outputs
+*   of a BME280 sensor without floating point operations.
+*
+*   Logarithms are computed in base 2 from a table of 130 entries with
+*   quadratic interpolation, powers of 2 with a polynomial of degree 5.
+*   Over the operating range of the sensor (300 to 1100 hPa, -40 to 85 degC,
+*   0 to 100 %RH), the error from the double precision formulas is:
+*   - altitude: less than 2 cm
+*   - sea-level pressure: less than 1 Pa, for altitudes up to 9000 m
+*   - dew point: less than 0.01 degC, for relative humidity of at least 1 %RH
+*
+*   The error of the formulas themselves (standard atmosphere, Magnus
+*   approximation) is not included.
+*
+*   \author Davide Marzorati
+*   \date November 8, 2019
+*/
+
+#ifndef __BME280_DERIVED_H
+    #define __BME280_DERIVED_H
+
+    #include "cytypes.h"
+
+    /**
+    *   \brief Standard sea-level pressure, in Pa.
+    */
+    #ifndef BME280_DERIVED_SEA_LEVEL_PRESSURE
+        #define BME280_DERIVED_SEA_LEVEL_PRESSURE 101325
+    #endif
+
+    /**
+    *   \brief Compute the barometric altitude.
+    *
+    *   The altitude is computed with the international barometric formula:
+    *   h = 44330 m * (1 - (p / p0)^(1 / 5.255)).
+    *
+    *   \param[in] pressure : pressure in Pa, not 0
+    *   \param[in] sea_level_pressure : pressure at sea level in Pa, not 0
+    *                                   (e.g., #BME280_DERIVED_SEA_LEVEL_PRESSURE)
+    *
+    *   \return Altitude in cm.
+    */
+    int32_t BME280_Derived_Altitude(uint32_t pressure, uint32_t sea_level_pressure);
+
+    /**
+    *   \brief Compute the pressure at sea level.
+    *
+    *   This is the inverse of #BME280_Derived_Altitude:
+    *   p0 = p / (1 - h / 44330 m)^5.255.
+    *
+    *   \param[in] pressure : pressure in Pa
+    *   \param[in] altitude : altitude in cm, less than 4433000
+    *
+    *   \return Pressure at sea level in Pa, 0xFFFFFFFF if too large.
+    */
+    uint32_t BME280_Derived_SeaLevelPressure(uint32_t pressure, int32_t altitude);
+
+    /**
+    *   \brief Compute the dew point.
+    *
+    *   The dew point is computed with the Magnus formula, with
+    *   b = 17.62 and c = 243.12 degC:
+    *   g = ln(RH / 100) + b * T / (c + T), Td = c * g / (b - g).
+    *
+    *   \param[in] temperature : temperature in 0.01 degC
+    *   \param[in] humidity : humidity in 1/1024 %RH, 0 is taken as 1
+    *
+    *   \return Dew point in 0.01 degC.
+    */
+    int32_t BME280_Derived_DewPoint(int32_t temperature, uint32_t humidity);
+
+#endif
+
+
+/* [] END OF FILE */
@@ -49,6 +49,31 @@
     */
     #define BME280_E_NVM_COPY_FAILED    -6
     
+    /**
+    *   \brief Busy error.
+    */
+    #define BME280_E_BUSY               -7
+    
+    /**
+    *   \brief Data not ready error.
+    */
+    #define BME280_E_NOT_READY          -8
+    
+    /**
+    *   \brief No settings meet the requirements.
+    */
+    #define BME280_E_NO_SETTINGS        -9
+    
+    /**
+    *   \brief Blocking call with interrupts disabled.
+    */
+    #define BME280_E_INT_DISABLED       -10
+    
+    /**
+    *   \brief Calibration data do not belong to the sensor.
+    */
+    #define BME280_E_CALIB_MISMATCH     -11
+    
     /**
     *   \brief Typedefs for error codes returned by functions.
     */
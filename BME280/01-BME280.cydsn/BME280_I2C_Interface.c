@@ -2,16 +2,102 @@
 *   This file includes all the required source code to interface
 *   the I2C peripheral.
 *
+*   Transactions are executed by the interrupt of the I2C component
+*   using the non-blocking MasterWriteBuf/MasterReadBuf APIs. The blocking
+*   functions queue a transaction and wait for its completion, so global
+*   interrupts must be enabled before using them: with interrupts disabled
+*   they return #BME280_E_INT_DISABLED instead of waiting forever.
+*
 *   \author Davide Marzorati
 */
 
 #include "BME280_ErrorCodes.h"
-#include "BME280_I2C_Interface.h" 
+#include "BME280_I2C_Interface.h"
 #include "I2C_Master.h"
+#include "CyLib.h"
+
+/******************************************/
+/*               Macros                   */
+/******************************************/
+
+/**
+*   \brief Engine state: no transaction in progress.
+*/
+#define BME280_I2C_STATE_IDLE 0x00
+
+/**
+*   \brief Engine state: sending register address before a read.
+*/
+#define BME280_I2C_STATE_ADDRESS 0x01
+
+/**
+*   \brief Engine state: reading data.
+*/
+#define BME280_I2C_STATE_READ 0x02
+
+/**
+*   \brief Engine state: writing register address and data.
+*/
+#define BME280_I2C_STATE_WRITE 0x03
+
+/******************************************/
+/*            Static variables            */
+/******************************************/
+
+// Queue of pending transactions, the head is the one in progress
+static BME280_I2C_Transaction* volatile queue[BME280_I2C_QUEUE_LENGTH];
+static volatile uint8_t queue_head = 0;
+static volatile uint8_t queue_count = 0;
+// State of the transaction in progress
+static volatile uint8_t state = BME280_I2C_STATE_IDLE;
+// Buffer with register address and data for write transactions
+static uint8_t tx_buffer[BME280_I2C_MAX_WRITE_LEN + 1];
+
+/******************************************/
+/*            Global variables            */
+/******************************************/
+
+const BME280_Bus BME280_I2C_Bus = {
+    .start = BME280_I2C_Interface_Start,
+    .read = BME280_I2C_Interface_ReadRegisterMulti,
+    .write_pairs = BME280_I2C_Interface_WriteRegisterPairs,
+    .submit = BME280_I2C_Interface_Submit
+};
 
-BME280_ErrorCode BME280_I2C_Interface_Start(void) 
+/******************************************/
+/*          Function Prototypes           */
+/******************************************/
+
+/**
+*   \brief Start the transaction at the head of the queue.
+*
+*   Must be called with the I2C interrupt disabled or from the I2C interrupt.
+*/
+static void BME280_I2C_Interface_StartNext(void);
+
+/**
+*   \brief Complete the transaction in progress and start the next one.
+*
+*   \param[in] error Result of the transaction.
+*/
+static void BME280_I2C_Interface_Complete(BME280_ErrorCode error);
+
+/**
+*   \brief Queue a transaction and wait for its completion.
+*
+*   \param[in] transaction Pointer to the transaction descriptor.
+*   \return Result of the transaction, #BME280_E_INT_DISABLED if called
+*   with interrupts disabled
+*/
+static BME280_ErrorCode BME280_I2C_Interface_Transfer(BME280_I2C_Transaction* transaction);
+
+/******************************************/
+/*          Function Definitions          */
+/******************************************/
+
+BME280_ErrorCode BME280_I2C_Interface_Start(void)
 {
-    // Start I2C peripheral 
+    // Start I2C peripheral
     I2C_Master_Start();
     // Return no error since start function does not return any error
     return BME280_OK;
@@ -26,33 +112,57 @@ BME280_ErrorCode BME280_I2C_Interface_Stop(void)
     return BME280_OK;
 }
 
-BME280_ErrorCode BME280_I2C_Interface_ReadRegister(uint8_t device_address, 
-                                        uint8_t register_address,
-                                        uint8_t* data)
+BME280_ErrorCode BME280_I2C_Interface_Submit(BME280_I2C_Transaction* transaction)
 {
-    // Send start condition
-    uint8_t error = I2C_Master_MasterSendStart(device_address,I2C_Master_WRITE_XFER_MODE);
-    if (error == I2C_Master_MSTR_NO_ERROR)
+    BME280_ErrorCode error = BME280_OK;
+    uint8_t interrupt_state;
+
+    if (transaction == NULL)
     {
-        // Write address of register to be read
-        error = I2C_Master_MasterWriteByte(register_address);
-        if (error == I2C_Master_MSTR_NO_ERROR)
+        error = BME280_E_NULL_PTR;
+    }
+    else if ( ((transaction->direction == BME280_I2C_READ) && (transaction->register_count == 0))
+                || ((transaction->direction == BME280_I2C_WRITE)
+                && (transaction->register_count > BME280_I2C_MAX_WRITE_LEN)))
+    {
+        error = BME280_E_INVALID_LEN;
+    }
+    else
+    {
+        interrupt_state = CyEnterCriticalSection();
+        if ( queue_count < BME280_I2C_QUEUE_LENGTH)
         {
-            // Send restart condition
-            error = I2C_Master_MasterSendRestart(device_address, I2C_Master_READ_XFER_MODE);
-            if (error == I2C_Master_MSTR_NO_ERROR)
+            transaction->status = BME280_I2C_PENDING;
+            transaction->error = BME280_OK;
+            queue[(queue_head + queue_count) % BME280_I2C_QUEUE_LENGTH] = transaction;
+            queue_count++;
+            // Start right away if the bus is free
+            if ( state == BME280_I2C_STATE_IDLE)
             {
-                // Read data without acknowledgement
-                *data = I2C_Master_MasterReadByte(I2C_Master_NAK_DATA);
+                BME280_I2C_Interface_StartNext();
             }
         }
+        else
+        {
+            error = BME280_E_BUSY;
+        }
+        CyExitCriticalSection(interrupt_state);
     }
-    // Send stop condition
-    I2C_Master_MasterSendStop();
-    // Return error code
-    if ( error != I2C_Master_MSTR_NO_ERROR)
-        return  BME280_E_COMM_FAIL;
-    return BME280_OK;
+    return error;
+}
+
+uint8_t BME280_I2C_Interface_IsBusy(void)
+{
+    return (queue_count > 0);
+}
+
+BME280_ErrorCode BME280_I2C_Interface_ReadRegister(uint8_t device_address,
+                                        uint8_t register_address,
+                                        uint8_t* data)
+{
+    // Read a single register
+    return BME280_I2C_Interface_ReadRegisterMulti(device_address,
+                register_address, 1, data);
 }
 
 BME280_ErrorCode BME280_I2C_Interface_ReadRegisterMulti(uint8_t device_address,
@@ -60,62 +170,25 @@ BME280_ErrorCode BME280_I2C_Interface_ReadRegisterMulti(uint8_t device_address,
                                             uint8_t register_count,
                                             uint8_t* data)
 {
-    // Send start condition
-    uint8_t error = I2C_Master_MasterSendStart(device_address,I2C_Master_WRITE_XFER_MODE);
-    if (error == I2C_Master_MSTR_NO_ERROR)
-    {
-        // Write address of register to be read
-        error = I2C_Master_MasterWriteByte(register_address);
-        if (error == I2C_Master_MSTR_NO_ERROR)
-        {
-            // Send restart condition
-            error = I2C_Master_MasterSendRestart(device_address, I2C_Master_READ_XFER_MODE);
-            if (error == I2C_Master_MSTR_NO_ERROR)
-            {
-                // Continue reading until we have register to read
-                uint8_t counter = register_count;
-                while(counter>1)
-                {
-                    data[register_count-counter] =
-                        I2C_Master_MasterReadByte(I2C_Master_ACK_DATA);
-                    counter--;
-                }
-                // Read last data without acknowledgement
-                data[register_count-1]
-                    = I2C_Master_MasterReadByte(I2C_Master_NAK_DATA);
-            }
-        }
-    }
-    // Send stop condition
-    I2C_Master_MasterSendStop();
-    // Return error code
-    if ( error != I2C_Master_MSTR_NO_ERROR)
-        return  BME280_E_COMM_FAIL;
-    return BME280_OK;
+    BME280_I2C_Transaction transaction = {
+        .device_address = device_address,
+        .register_address = register_address,
+        .register_count = register_count,
+        .direction = BME280_I2C_READ,
+        .data = data,
+        .callback = NULL,
+        .context = NULL
+    };
+    return BME280_I2C_Interface_Transfer(&transaction);
 }
 
 BME280_ErrorCode BME280_I2C_Interface_WriteRegister(uint8_t device_address,
                                         uint8_t register_address,
                                         uint8_t data)
 {
-    // Send start condition
-    uint8_t error = I2C_Master_MasterSendStart(device_address, I2C_Master_WRITE_XFER_MODE);
-    if (error == I2C_Master_MSTR_NO_ERROR)
-    {
-        // Write register address
-        error = I2C_Master_MasterWriteByte(register_address);
-        if (error == I2C_Master_MSTR_NO_ERROR)
-        {
-            // Write byte of interest
-            error = I2C_Master_MasterWriteByte(data);
-        }
-    }
-    // Send stop condition 
-    I2C_Master_MasterSendStop();
-    // Return error code
-    if ( error != I2C_Master_MSTR_NO_ERROR)
-        return  BME280_E_COMM_FAIL;
-    return BME280_OK;
+    // Write a single register
+    return BME280_I2C_Interface_WriteRegisterMulti(device_address,
+                register_address, 1, &data);
 }
 
 BME280_ErrorCode BME280_I2C_Interface_WriteRegisterMulti(uint8_t device_address,
@@ -123,49 +196,176 @@ BME280_ErrorCode BME280_I2C_Interface_WriteRegisterMulti(uint8_t device_address,
                                         uint8_t register_count,
                                         uint8_t* data)
 {
-    // Send start condition
-    uint8_t error = I2C_Master_MasterSendStart(device_address, I2C_Master_WRITE_XFER_MODE);
-    if (error == I2C_Master_MSTR_NO_ERROR)
+    BME280_I2C_Transaction transaction = {
+        .device_address = device_address,
+        .register_address = register_address,
+        .register_count = register_count,
+        .direction = BME280_I2C_WRITE,
+        .data = data,
+        .callback = NULL,
+        .context = NULL
+    };
+    return BME280_I2C_Interface_Transfer(&transaction);
+}
+
+BME280_ErrorCode BME280_I2C_Interface_WriteRegisterPairs(uint8_t device_address,
+                                        uint8_t pair_count,
+                                        uint8_t* data)
+{
+    // The first register address is followed by value, address, value, ...
+    return BME280_I2C_Interface_WriteRegisterMulti(device_address, data[0],
+                2 * pair_count - 1, &data[1]);
+}
+
+BME280_ErrorCode BME280_I2C_Interface_IsDeviceConnected(uint8_t device_address)
+{
+    // Write of no registers: only the register address is sent
+    BME280_I2C_Transaction transaction = {
+        .device_address = device_address,
+        .register_address = 0x00,
+        .register_count = 0,
+        .direction = BME280_I2C_WRITE,
+        .data = NULL,
+        .callback = NULL,
+        .context = NULL
+    };
+    BME280_ErrorCode error = BME280_I2C_Interface_Transfer(&transaction);
+    // If the address is not acknowledged the transaction fails
+    if (error == BME280_E_COMM_FAIL)
     {
-        // Write register address
-        error = I2C_Master_MasterWriteByte(register_address);
-        if (error == I2C_Master_MSTR_NO_ERROR)
+        error = BME280_E_DEV_NOT_FOUND;
+    }
+    return error;
+}
+
+uint8_t BME280_I2C_Interface_CanWait(void)
+{
+    // Read the interrupt mask without changing it
+    uint8_t interrupt_state = CyEnterCriticalSection();
+    CyExitCriticalSection(interrupt_state);
+    return (interrupt_state == 0);
+}
+
+void I2C_Master_ISR_ExitCallback(void)
+{
+    uint8_t status;
+    BME280_I2C_Transaction* transaction;
+
+    if ( state != BME280_I2C_STATE_IDLE)
+    {
+        transaction = queue[queue_head];
+        status = I2C_Master_MasterStatus();
+        if (status & I2C_Master_MSTAT_ERR_XFER)
         {
-            // Continue writing until we have data to write
-            uint8_t counter = register_count;
-            while(counter > 0)
+            BME280_I2C_Interface_Complete(BME280_E_COMM_FAIL);
+        }
+        else if ( (state == BME280_I2C_STATE_ADDRESS) &&
+                    (status & (I2C_Master_MSTAT_WR_CMPLT | I2C_Master_MSTAT_XFER_HALT)))
+        {
+            // Register address sent, read data after a repeated start
+            state = BME280_I2C_STATE_READ;
+            I2C_Master_MasterClearStatus();
+            if ( I2C_Master_MasterReadBuf(transaction->device_address, transaction->data,
+                    transaction->register_count, I2C_Master_MODE_REPEAT_START) != I2C_Master_MSTR_NO_ERROR)
             {
-                error = I2C_Master_MasterWriteByte(data[register_count-counter]);
-                if (error != I2C_Master_MSTR_NO_ERROR)
-                {
-                    break;
-                }
-                counter--;
+                BME280_I2C_Interface_Complete(BME280_E_COMM_FAIL);
             }
         }
+        else if ( (state == BME280_I2C_STATE_READ) && (status & I2C_Master_MSTAT_RD_CMPLT))
+        {
+            BME280_I2C_Interface_Complete(BME280_OK);
+        }
+        else if ( (state == BME280_I2C_STATE_WRITE) && (status & I2C_Master_MSTAT_WR_CMPLT))
+        {
+            BME280_I2C_Interface_Complete(BME280_OK);
+        }
     }
-    // Send stop condition
-    I2C_Master_MasterSendStop();
-    // Return error code
-    if ( error != I2C_Master_MSTR_NO_ERROR)
-        return  BME280_E_COMM_FAIL;
-    return BME280_OK;
 }
 
+static void BME280_I2C_Interface_StartNext(void)
+{
+    BME280_I2C_Transaction* transaction;
+    uint8_t error;
 
-BME280_ErrorCode BME280_I2C_Interface_IsDeviceConnected(uint8_t device_address)
+    if ( queue_count > 0)
+    {
+        transaction = queue[queue_head];
+        I2C_Master_MasterClearStatus();
+        if ( transaction->direction == BME280_I2C_READ)
+        {
+            // Write register address without stop condition
+            state = BME280_I2C_STATE_ADDRESS;
+            tx_buffer[0] = transaction->register_address;
+            error = I2C_Master_MasterWriteBuf(transaction->device_address, tx_buffer, 1,
+                        I2C_Master_MODE_NO_STOP);
+        }
+        else
+        {
+            // Write register address followed by data
+            state = BME280_I2C_STATE_WRITE;
+            tx_buffer[0] = transaction->register_address;
+            for (uint8_t i = 0; i < transaction->register_count; i++)
+            {
+                tx_buffer[i+1] = transaction->data[i];
+            }
+            error = I2C_Master_MasterWriteBuf(transaction->device_address, tx_buffer,
+                        transaction->register_count + 1, I2C_Master_MODE_COMPLETE_XFER);
+        }
+        if ( error != I2C_Master_MSTR_NO_ERROR)
+        {
+            BME280_I2C_Interface_Complete(BME280_E_COMM_FAIL);
+        }
+    }
+    else
+    {
+        state = BME280_I2C_STATE_IDLE;
+    }
+}
+
+static void BME280_I2C_Interface_Complete(BME280_ErrorCode error)
 {
-    BME280_ErrorCode rslt = BME280_OK;
-    // Send a start condition followed by a stop condition
-    uint8_t error = I2C_Master_MasterSendStart(device_address, 
-        I2C_Master_WRITE_XFER_MODE);
-    I2C_Master_MasterSendStop();
-    // If no error generated during start, device is connected
-    if (error != I2C_Master_MSTR_NO_ERROR)
+    BME280_I2C_Transaction* transaction = queue[queue_head];
+
+    // Remove transaction from the queue
+    queue_head = (queue_head + 1) % BME280_I2C_QUEUE_LENGTH;
+    queue_count--;
+    state = BME280_I2C_STATE_IDLE;
+
+    transaction->error = error;
+    transaction->status = BME280_I2C_DONE;
+    if ( transaction->callback != NULL)
+    {
+        transaction->callback(transaction);
+    }
+
+    // Move on with the next transaction
+    if ( state == BME280_I2C_STATE_IDLE)
+    {
+        BME280_I2C_Interface_StartNext();
+    }
+}
+
+static BME280_ErrorCode BME280_I2C_Interface_Transfer(BME280_I2C_Transaction* transaction)
+{
+    BME280_ErrorCode error;
+
+    // The interrupt that completes the transactions could never run
+    if ( !BME280_I2C_Interface_CanWait())
+    {
+        return BME280_E_INT_DISABLED;
+    }
+    // Wait for a free slot in the queue
+    do
+    {
+        error = BME280_I2C_Interface_Submit(transaction);
+    } while ( error == BME280_E_BUSY);
+    if ( error == BME280_OK)
     {
-        rslt = BME280_E_DEV_NOT_FOUND;
+        // Wait for the interrupt to complete the transaction
+        while ( transaction->status == BME280_I2C_PENDING);
+        error = transaction->error;
     }
-    return rslt;
+    return error;
 }
 
 /* [] END OF FILE */
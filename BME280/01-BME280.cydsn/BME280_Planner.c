@@ -0,0 +1,243 @@
+/*
+*   This file includes all the required source code to estimate
+*   the performance of BME280 settings and choose among them.
+*
+*   \author Davide Marzorati
+*/
+
+#include "BME280_Planner.h"
+
+/******************************************/
+/*               Macros                   */
+/******************************************/
+
+/**
+*   \brief Fixed part of the typical measurement time [us].
+*/
+#define BME280_PLANNER_TYP_OFFSET 1000
+
+/**
+*   \brief Fixed part of the maximum measurement time [us].
+*/
+#define BME280_PLANNER_MAX_OFFSET 1250
+
+/**
+*   \brief Typical measurement time per oversampling step [us].
+*/
+#define BME280_PLANNER_TYP_PER_OSR 2000
+
+/**
+*   \brief Maximum measurement time per oversampling step [us].
+*/
+#define BME280_PLANNER_MAX_PER_OSR 2300
+
+/**
+*   \brief Typical pressure and humidity setup time [us].
+*/
+#define BME280_PLANNER_TYP_SETUP 500
+
+/**
+*   \brief Maximum pressure and humidity setup time [us].
+*/
+#define BME280_PLANNER_MAX_SETUP 575
+
+/**
+*   \brief Current during temperature measurement [uA].
+*/
+#define BME280_PLANNER_CURRENT_T 350
+
+/**
+*   \brief Current during pressure measurement [uA].
+*/
+#define BME280_PLANNER_CURRENT_P 714
+
+/**
+*   \brief Current during humidity measurement [uA].
+*/
+#define BME280_PLANNER_CURRENT_H 340
+
+/**
+*   \brief Current in sleep mode [nA].
+*/
+#define BME280_PLANNER_CURRENT_SLEEP 100
+
+/**
+*   \brief Current in standby in normal mode [nA].
+*/
+#define BME280_PLANNER_CURRENT_STANDBY 200
+
+/******************************************/
+/*            Lookup Tables               */
+/******************************************/
+
+/**
+*   \brief Number of samples for each #BME280_Oversampling value.
+*/
+static const uint8_t BME280_PLANNER_OSR_SAMPLES[] = {0, 1, 2, 4, 8, 16, 16, 16};
+
+/**
+*   \brief Standby time in us for each #BME280_TStandby value.
+*/
+static const uint32_t BME280_PLANNER_STANDBY_US[] = {500, 62500, 125000, 250000,
+                                                     500000, 1000000, 10000, 20000};
+
+/**
+*   \brief Pressure noise in 0.01 Pa for each oversampling (1x to 16x) and filter.
+*/
+static const uint16_t BME280_PLANNER_NOISE[5][5] = {
+    {330, 191, 125, 85, 59},
+    {260, 150, 98, 67, 47},
+    {210, 121, 79, 54, 38},
+    {160, 92, 60, 41, 29},
+    {130, 75, 49, 34, 23}
+};
+
+/**
+*   \brief Samples to reach 75% of a step for each #BME280_Filter value.
+*/
+static const uint8_t BME280_PLANNER_STEP_SAMPLES[] = {1, 2, 5, 11, 22};
+
+/******************************************/
+/*          Function Prototypes           */
+/******************************************/
+
+/**
+*   \brief Check if a plan is better than the best one found so far.
+*
+*   \param[in] plan : plan to be checked
+*   \param[in] target : requirements for the settings
+*   \param[in] best : best plan found so far, NULL if none
+*
+*   \return 1 if plan meets the target and is better than best, 0 otherwise.
+*/
+static uint8_t BME280_Planner_IsBetter(const BME280_Plan* plan, const BME280_Plan_Target* target,
+                                       const BME280_Plan* best);
+
+/******************************************/
+/*          Function Definitions          */
+/******************************************/
+
+void BME280_Planner_Evaluate(const BME280_Settings* settings, uint32_t trigger_period,
+                             BME280_Plan* plan)
+{
+    uint8_t samples_t = BME280_PLANNER_OSR_SAMPLES[settings->osr_t & 0x07];
+    uint8_t samples_p = BME280_PLANNER_OSR_SAMPLES[settings->osr_p & 0x07];
+    uint8_t samples_h = BME280_PLANNER_OSR_SAMPLES[settings->osr_h & 0x07];
+    uint8_t filter = (settings->filter <= BME280_FILTER_COEFF_16) ? settings->filter : BME280_FILTER_COEFF_16;
+    uint32_t typical_time;
+    uint32_t typical_period;
+    uint32_t charge;
+    uint32_t idle_current;
+    uint8_t osr_index = 0;
+
+    plan->settings = *settings;
+
+    // Charge of a measurement in pC (uA * us), the fixed part at temperature current
+    typical_time = BME280_PLANNER_TYP_OFFSET + BME280_PLANNER_TYP_PER_OSR * samples_t;
+    charge = BME280_PLANNER_CURRENT_T * typical_time;
+    plan->measurement_time = BME280_PLANNER_MAX_OFFSET + BME280_PLANNER_MAX_PER_OSR * samples_t;
+    if ( samples_p > 0)
+    {
+        typical_time += BME280_PLANNER_TYP_PER_OSR * samples_p + BME280_PLANNER_TYP_SETUP;
+        charge += BME280_PLANNER_CURRENT_P * (BME280_PLANNER_TYP_PER_OSR * samples_p + BME280_PLANNER_TYP_SETUP);
+        plan->measurement_time += BME280_PLANNER_MAX_PER_OSR * samples_p + BME280_PLANNER_MAX_SETUP;
+    }
+    if ( samples_h > 0)
+    {
+        typical_time += BME280_PLANNER_TYP_PER_OSR * samples_h + BME280_PLANNER_TYP_SETUP;
+        charge += BME280_PLANNER_CURRENT_H * (BME280_PLANNER_TYP_PER_OSR * samples_h + BME280_PLANNER_TYP_SETUP);
+        plan->measurement_time += BME280_PLANNER_MAX_PER_OSR * samples_h + BME280_PLANNER_MAX_SETUP;
+    }
+
+    if ( (settings->mode & 0x03) == BME280_NORMAL_MODE)
+    {
+        // Normal mode cycles between measurement and standby
+        plan->sample_period = plan->measurement_time + BME280_PLANNER_STANDBY_US[settings->stanby_time & 0x07];
+        // The sensor runs faster than the guaranteed period, and so needs more current
+        typical_period = typical_time + BME280_PLANNER_STANDBY_US[settings->stanby_time & 0x07];
+        idle_current = BME280_PLANNER_CURRENT_STANDBY;
+    }
+    else
+    {
+        // A new measurement cannot start before the previous one is completed
+        plan->sample_period = (trigger_period > plan->measurement_time) ? trigger_period : plan->measurement_time;
+        typical_period = plan->sample_period;
+        idle_current = BME280_PLANNER_CURRENT_SLEEP;
+    }
+    // Average current in nA
+    plan->current = (uint32_t)(((uint64_t)charge * 1000
+                    + (uint64_t)idle_current * (typical_period - typical_time)
+                    + typical_period / 2) / typical_period);
+
+    // Noise and response time depend on pressure oversampling and filter
+    while ( osr_index < 4 && (1 << osr_index) < samples_p)
+    {
+        osr_index++;
+    }
+    plan->pressure_noise = (samples_p > 0) ? BME280_PLANNER_NOISE[osr_index][filter] : 0xFFFF;
+    plan->response_time = plan->sample_period * BME280_PLANNER_STEP_SAMPLES[filter];
+}
+
+BME280_ErrorCode BME280_Planner_Find(const BME280_Plan_Target* target, BME280_Plan* plan)
+{
+    BME280_Settings settings;
+    BME280_Plan candidate;
+    uint8_t found = 0;
+
+    if ( target == NULL || plan == NULL)
+    {
+        return BME280_E_NULL_PTR;
+    }
+    settings.osr_h = target->humidity ? BME280_OVERSAMPLING_1X : BME280_NO_OVERSAMPLING;
+    settings.spi_enable = 0;
+    for (uint8_t osr_p = BME280_OVERSAMPLING_1X; osr_p <= BME280_OVERSAMPLING_16X; osr_p++)
+    {
+        settings.osr_p = osr_p;
+        // Temperature resolution limits pressure resolution at 16x
+        settings.osr_t = (osr_p == BME280_OVERSAMPLING_16X) ? BME280_OVERSAMPLING_2X : BME280_OVERSAMPLING_1X;
+        for (uint8_t filter = BME280_FILTER_COEFF_OFF; filter <= BME280_FILTER_COEFF_16; filter++)
+        {
+            settings.filter = filter;
+            // Forced mode, a measurement every target period
+            settings.mode = BME280_FORCED_MODE;
+            settings.stanby_time = BME280_TSTANBDY_0_5_MS;
+            BME280_Planner_Evaluate(&settings, target->sample_period, &candidate);
+            if ( BME280_Planner_IsBetter(&candidate, target, found ? plan : NULL))
+            {
+                *plan = candidate;
+                found = 1;
+            }
+            // Normal mode, all the standby times
+            settings.mode = BME280_NORMAL_MODE;
+            for (uint8_t standby = BME280_TSTANBDY_0_5_MS; standby <= BME280_TSTANBDY_20_MS; standby++)
+            {
+                settings.stanby_time = standby;
+                BME280_Planner_Evaluate(&settings, 0, &candidate);
+                if ( BME280_Planner_IsBetter(&candidate, target, found ? plan : NULL))
+                {
+                    *plan = candidate;
+                    found = 1;
+                }
+            }
+        }
+    }
+    return found ? BME280_OK : BME280_E_NO_SETTINGS;
+}
+
+static uint8_t BME280_Planner_IsBetter(const BME280_Plan* plan, const BME280_Plan_Target* target,
+                                       const BME280_Plan* best)
+{
+    if ( plan->sample_period > target->sample_period
+         || plan->pressure_noise > target->pressure_noise
+         || (target->response_time > 0 && plan->response_time > target->response_time))
+    {
+        return 0;
+    }
+    if ( best == NULL || plan->current < best->current)
+    {
+        return 1;
+    }
+    return (plan->current == best->current && plan->pressure_noise < best->pressure_noise);
+}
+
+/* [] END OF FILE */
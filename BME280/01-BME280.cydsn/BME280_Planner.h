@@ -0,0 +1,95 @@
+/**
+*   \file BME280_Planner.h
+*
+*   \brief Selection of BME280 settings for a power budget.
+*
+*   This header file contains the functions to estimate sample period,
+*   average current, pressure noise, and response time of BME280 settings,
+*   and to find the settings with the lowest current that meet a target
+*   sample period and noise level.
+*
+*   Estimates are based on the typical values of the datasheet:
+*   - measurement time: same formulas as #BME280_GetTypicalMeasurementTime
+*     and #BME280_GetMaxMeasurementTime
+*   - current during temperature, pressure, and humidity measurements:
+*     350, 714, and 340 uA; in sleep mode 0.1 uA, in standby 0.2 uA
+*   - pressure noise without filter: 3.3, 2.6, 2.1, 1.6, 1.3 Pa RMS
+*     for oversampling 1x to 16x, divided by sqrt(2 * c - 1) by the IIR
+*     filter with coefficient c
+*   - response time: 1, 2, 5, 11, 22 samples to reach 75% of a step,
+*     for filter off and coefficient 2 to 16
+*
+*   The model reproduces the current of the weather monitoring, indoor
+*   navigation, and gaming examples of the datasheet within 5%. Only the
+*   current of the sensor is included: in forced mode, the microcontroller
+*   has to wake up to start each measurement.
+*
+*   \author Davide Marzorati
+*   \date November 8, 2019
+*/
+
+#ifndef __BME280_PLANNER_H
+    #define __BME280_PLANNER_H
+
+    #include "BME280.h"
+
+    /**
+    *   \brief Requirements for the settings.
+    */
+    typedef struct {
+        uint32_t sample_period;         ///< Maximum time between two samples in us
+        uint16_t pressure_noise;        ///< Maximum RMS pressure noise in 0.01 Pa
+        uint32_t response_time;         ///< Maximum time to reach 75% of a pressure step in us,
+                                        ///  0 for no limit
+        uint8_t humidity;               ///< 1 if humidity has to be measured
+    } BME280_Plan_Target;
+
+    /**
+    *   \brief Settings with their estimated performance.
+    */
+    typedef struct {
+        BME280_Settings settings;       ///< Settings, to be written with #BME280_ApplySettings
+        uint32_t measurement_time;      ///< Maximum measurement time in us
+        uint32_t sample_period;         ///< Time between two samples in us
+        uint32_t current;               ///< Average current in nA
+        uint16_t pressure_noise;        ///< RMS pressure noise in 0.01 Pa
+        uint32_t response_time;         ///< Time to reach 75% of a pressure step in us
+    } BME280_Plan;
+
+    /**
+    *   \brief Estimate the performance of settings.
+    *
+    *   \param[in] settings : settings in forced or normal mode
+    *   \param[in] trigger_period : time between two measurements started in
+    *                               forced mode in us, ignored in normal mode
+    *   \param[out] plan : pointer to struct where settings and estimates
+    *                      will be stored
+    */
+    void BME280_Planner_Evaluate(const BME280_Settings* settings, uint32_t trigger_period,
+                                 BME280_Plan* plan);
+
+    /**
+    *   \brief Find the settings with the lowest current for a target.
+    *
+    *   All the combinations of mode, pressure oversampling, filter, and
+    *   standby time are evaluated. Temperature is measured with 1x
+    *   oversampling (2x with pressure oversampling 16x), humidity with 1x
+    *   oversampling if requested. In forced mode, a measurement is started
+    *   every target sample period. If two settings need the same current,
+    *   the one with the lowest noise is chosen.
+    *
+    *   \param[in] target : requirements for the settings
+    *   \param[out] plan : pointer to struct where settings and estimates
+    *                      will be stored
+    *
+    *   \return Result of function execution
+    *   \retval #BME280_E_NULL_PTR -> Null pointer
+    *   \retval #BME280_E_NO_SETTINGS -> No settings meet the target
+    *   \retval #BME280_OK -> Success
+    */
+    BME280_ErrorCode BME280_Planner_Find(const BME280_Plan_Target* target, BME280_Plan* plan);
+
+#endif
+
+
+/* [] END OF FILE */
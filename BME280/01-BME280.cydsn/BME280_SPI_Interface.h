@@ -0,0 +1,105 @@
+/** 
+ * \file BME280_SPI_Interface.h
+ * \brief Hardware specific SPI interface.
+ *
+ * This is an interface to a SPI Master component named SPIM_BME280 and
+ * to a chip select pin named BME280_CS, for the 4-wire SPI mode of the
+ * sensor. Register addresses are sent with bit 7 set for reads and
+ * cleared for writes. Reads use the auto-increment of the sensor, so 
+ * consecutive registers are read in a single burst.
+ *
+ * The interface is compiled only if the SPIM_BME280 component is
+ * placed in the TopDesign: otherwise #BME280_SPI_Bus is not declared,
+ * and using it is a compile error instead of a link error. To use it,
+ * pass #BME280_SPI_Bus to #BME280_Setup, the address is ignored.
+ *
+ * Interrupts are not disabled during the transfers. A transfer started
+ * while another one is in progress, e.g. from an interrupt that
+ * preempted it, returns #BME280_E_BUSY.
+ *
+ * \author Davide Marzorati
+ * \date November 8, 2019
+*/
+
+#ifndef __BME280_SPI_Interface_H
+    #define __BME280_SPI_Interface_H
+    
+    #include "project.h"
+    #include "BME280_ErrorCodes.h"
+    #include "BME280_I2C_Interface.h"
+    
+    /**
+    *   \brief Bit set in the register address for read operations.
+    */
+    #define BME280_SPI_READ_FLAG 0x80
+    
+    #ifdef CY_SPIM_SPIM_BME280_H
+    
+    /**
+    *   \brief Transport over the SPIM_BME280 component.
+    */
+    extern const BME280_Bus BME280_SPI_Bus;
+    
+    /** \brief Start the SPI peripheral.
+    *   
+    *   \return Result of function execution 
+    *   \retval BME280_OK -> Success
+    */
+    BME280_ErrorCode BME280_SPI_Interface_Start(void);
+    
+    /** \brief Stop the SPI peripheral.
+    *   
+    *   \return Result of function execution 
+    *   \retval BME280_OK -> Success
+    */
+    BME280_ErrorCode BME280_SPI_Interface_Stop(void);
+    
+    /** 
+    *   \brief Read multiple bytes over SPI.
+    *   
+    *   \param[in] device_address Not used, one device per chip select.
+    *   \param[in] register_address Address of the first register to be read.
+    *   \param[in] register_count Number of registers we want to read.
+    *   \param[out] data Pointer to an array where data will be saved.
+    *   \return Result of function execution
+    *   \retval BME280_OK -> Success
+    *   \retval BME280_E_BUSY -> Another transfer is in progress
+    */
+    BME280_ErrorCode BME280_SPI_Interface_ReadRegisterMulti(uint8_t device_address,
+                                                uint8_t register_address,
+                                                uint8_t register_count,
+                                                uint8_t* data);
+    
+    /** 
+    *   \brief Write register/value pairs over SPI.
+    *   
+    *   \param[in] device_address Not used, one device per chip select.
+    *   \param[in] pair_count Number of register/value pairs to be written.
+    *   \param[in] data Array of register addresses and values, interleaved.
+    *   \return Result of function execution
+    *   \retval BME280_OK -> Success
+    *   \retval BME280_E_BUSY -> Another transfer is in progress
+    */
+    BME280_ErrorCode BME280_SPI_Interface_WriteRegisterPairs(uint8_t device_address,
+                                            uint8_t pair_count,
+                                            uint8_t* data);
+    
+    /**
+    *   \brief Execute a transaction.
+    *
+    *   SPI transfers take a few microseconds, so the transaction is executed
+    *   immediately: its status is #BME280_I2C_DONE and its callback, if any,
+    *   has been called when this function returns.
+    *   \param[in] transaction Pointer to the transaction descriptor.
+    *   \return Result of function execution 
+    *   \retval BME280_OK -> Transaction executed
+    *   \retval BME280_E_NULL_PTR -> Null pointer
+    *   \retval BME280_E_BUSY -> Another transfer is in progress, the
+    *           transaction was not started
+    */
+    BME280_ErrorCode BME280_SPI_Interface_Submit(BME280_I2C_Transaction* transaction);
+    
+    #endif
+    
+#endif // SPI_Interface_H
+/* [] END OF FILE */
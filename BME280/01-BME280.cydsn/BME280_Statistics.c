@@ -0,0 +1,181 @@
+/*
+*   This file includes all the required source code to compute
+*   windowed statistics of BME280 data.
+*
+*   \author Davide Marzorati
+*/
+
+#include "BME280_Statistics.h"
+
+/******************************************/
+/*          Function Prototypes           */
+/******************************************/
+
+/**
+*   \brief Add a value to the accumulator of a channel.
+*
+*   \param[in,out] acc : pointer to accumulator
+*   \param[in] value : new value
+*   \param[in] first : 1 for the first sample of the window
+*/
+static void BME280_Statistics_Accumulate(BME280_Stats_Accumulator* acc,
+                                         int32_t value, uint8_t first);
+
+/**
+*   \brief Compute the summary of a channel.
+*
+*   \param[in] acc : pointer to accumulator
+*   \param[in] count : number of samples, at least 1
+*   \param[out] channel : pointer to struct where the summary will be stored
+*/
+static void BME280_Statistics_Summarize(const BME280_Stats_Accumulator* acc,
+                                        uint32_t count, BME280_Stats_Channel* channel);
+
+/**
+*   \brief Integer square root, rounded down.
+*/
+static uint32_t BME280_Statistics_Sqrt(uint64_t value);
+
+/******************************************/
+/*          Function Definitions          */
+/******************************************/
+
+void BME280_Statistics_Init(BME280_Statistics* stats, uint16_t window)
+{
+    stats->count = 0;
+    stats->window = (window > 0) ? window : 1;
+}
+
+uint8_t BME280_Statistics_Add(BME280_Statistics* stats, const BME280_Data* data,
+                              BME280_Stats_Summary* summary)
+{
+    uint8_t first = (stats->count == 0);
+
+    BME280_Statistics_Accumulate(&stats->pressure, (int32_t)data->pressure, first);
+    BME280_Statistics_Accumulate(&stats->temperature, data->temperature, first);
+    BME280_Statistics_Accumulate(&stats->humidity, (int32_t)data->humidity, first);
+    stats->count++;
+    if ( stats->count >= stats->window)
+    {
+        BME280_Statistics_GetSummary(stats, summary);
+        stats->count = 0;
+        return 1;
+    }
+    return 0;
+}
+
+void BME280_Statistics_GetSummary(const BME280_Statistics* stats,
+                                  BME280_Stats_Summary* summary)
+{
+    summary->count = stats->count;
+    if ( stats->count > 0)
+    {
+        BME280_Statistics_Summarize(&stats->pressure, stats->count, &summary->pressure);
+        BME280_Statistics_Summarize(&stats->temperature, stats->count, &summary->temperature);
+        BME280_Statistics_Summarize(&stats->humidity, stats->count, &summary->humidity);
+    }
+}
+
+static void BME280_Statistics_Accumulate(BME280_Stats_Accumulator* acc,
+                                         int32_t value, uint8_t first)
+{
+    int32_t deviation;
+
+    if ( first)
+    {
+        acc->offset = value;
+        acc->sum = 0;
+        acc->sum_squares = 0;
+        acc->min = value;
+        acc->max = value;
+    }
+    deviation = value - acc->offset;
+    acc->sum += deviation;
+    acc->sum_squares += (uint64_t)((int64_t)deviation * deviation);
+    if ( value < acc->min)
+    {
+        acc->min = value;
+    }
+    if ( value > acc->max)
+    {
+        acc->max = value;
+    }
+}
+
+static void BME280_Statistics_Summarize(const BME280_Stats_Accumulator* acc,
+                                        uint32_t count, BME280_Stats_Channel* channel)
+{
+    uint64_t magnitude;
+    uint64_t product;
+    uint64_t m2;
+    uint64_t m2_fraction;
+    uint64_t quotient;
+    uint64_t fraction;
+    int64_t mean;
+
+    channel->min = acc->min;
+    channel->max = acc->max;
+
+    // Mean of the deviations, rounded half away from zero
+    magnitude = (uint64_t)((acc->sum < 0) ? -acc->sum : acc->sum);
+    mean = (int64_t)(((magnitude << BME280_STATS_FRAC_BITS) + count / 2) / count);
+    if ( acc->sum < 0)
+    {
+        mean = -mean;
+    }
+    channel->mean = (int32_t)(((int64_t)acc->offset << BME280_STATS_FRAC_BITS) + mean);
+
+    if ( count > 1)
+    {
+        // Sum of squared deviations from the mean, sum_squares - sum^2 / count,
+        // as m2 + m2_fraction / count, with sum^2 split to avoid overflow
+        product = (magnitude % count) * magnitude;
+        m2 = acc->sum_squares - (magnitude / count) * magnitude - product / count;
+        m2_fraction = 0;
+        if ( product % count != 0)
+        {
+            m2--;
+            m2_fraction = count - product % count;
+        }
+        // Variance as quotient + fraction / (count * (count - 1)), exact
+        quotient = m2 / (count - 1);
+        fraction = (m2 % (count - 1)) * count + m2_fraction;
+        // floor(2 * standard deviation) with the fractional bits, from
+        // floor(4 * variance), then rounded to nearest. The variance of
+        // the channels is below 2^34, so 2 fractional bits more fit in 64 bits
+        product = (quotient << (2 * BME280_STATS_FRAC_BITS + 2))
+                  + (fraction << (2 * BME280_STATS_FRAC_BITS + 2)) / ((uint64_t)count * (count - 1));
+        channel->std_dev = (BME280_Statistics_Sqrt(product) + 1) >> 1;
+    }
+    else
+    {
+        channel->std_dev = 0;
+    }
+}
+
+static uint32_t BME280_Statistics_Sqrt(uint64_t value)
+{
+    uint64_t result = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while ( bit > value)
+    {
+        bit >>= 2;
+    }
+    while ( bit != 0)
+    {
+        if ( value >= result + bit)
+        {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+        {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)result;
+}
+
+/* [] END OF FILE */
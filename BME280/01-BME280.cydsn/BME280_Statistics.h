@@ -0,0 +1,118 @@
+/**
+*   \file BME280_Statistics.h
+*
+*   \brief Windowed statistics of BME280 data.
+*
+*   This header file contains the functions to summarize the compensated
+*   data of a BME280 sensor over windows of a fixed number of samples.
+*   For each window, minimum, maximum, mean, and sample standard
+*   deviation of pressure, temperature, and humidity are computed, so
+*   that a single summary can be sent instead of all the samples.
+*
+*   Samples are accumulated as deviations from the first sample of the
+*   window, in 64 bit integers. Sums are exact, so the variance does not
+*   suffer from the cancellation of the textbook formula and no division
+*   is needed for each sample. Mean and standard deviation are rounded
+*   to the nearest value with #BME280_STATS_FRAC_BITS fractional bits.
+*
+*   \author Davide Marzorati
+*   \date November 8, 2019
+*/
+
+#ifndef __BME280_STATISTICS_H
+    #define __BME280_STATISTICS_H
+
+    #include "BME280.h"
+
+    /**
+    *   \brief Number of fractional bits of mean and standard deviation.
+    */
+    #define BME280_STATS_FRAC_BITS 8
+
+    /**
+    *   \brief Maximum number of samples in a window.
+    */
+    #define BME280_STATS_MAX_WINDOW 65535
+
+    /**
+    *   \brief Accumulated values of a channel.
+    */
+    typedef struct {
+        int32_t offset;         ///< First sample of the window
+        int64_t sum;            ///< Sum of deviations from offset
+        uint64_t sum_squares;   ///< Sum of squared deviations from offset
+        int32_t min;            ///< Minimum value
+        int32_t max;            ///< Maximum value
+    } BME280_Stats_Accumulator;
+
+    /**
+    *   \brief State of the statistics of a sensor.
+    */
+    typedef struct {
+        BME280_Stats_Accumulator pressure;      ///< Pressure in Pa
+        BME280_Stats_Accumulator temperature;   ///< Temperature in 0.01 degC
+        BME280_Stats_Accumulator humidity;      ///< Humidity in 1/1024 %RH
+        uint16_t count;                         ///< Samples in the current window
+        uint16_t window;                        ///< Samples per window
+    } BME280_Statistics;
+
+    /**
+    *   \brief Summary of a channel over a window.
+    */
+    typedef struct {
+        int32_t min;            ///< Minimum value
+        int32_t max;            ///< Maximum value
+        int32_t mean;           ///< Mean, with #BME280_STATS_FRAC_BITS fractional bits
+        uint32_t std_dev;       ///< Sample standard deviation, with #BME280_STATS_FRAC_BITS fractional bits
+    } BME280_Stats_Channel;
+
+    /**
+    *   \brief Summary of a window.
+    */
+    typedef struct {
+        uint16_t count;                     ///< Number of samples
+        BME280_Stats_Channel pressure;      ///< Pressure in Pa
+        BME280_Stats_Channel temperature;   ///< Temperature in 0.01 degC
+        BME280_Stats_Channel humidity;      ///< Humidity in 1/1024 %RH
+    } BME280_Stats_Summary;
+
+    /**
+    *   \brief Initialize the statistics.
+    *
+    *   \param[out] stats : pointer to statistics state
+    *   \param[in] window : samples per window, from 1 to #BME280_STATS_MAX_WINDOW
+    */
+    void BME280_Statistics_Init(BME280_Statistics* stats, uint16_t window);
+
+    /**
+    *   \brief Add a sample to the current window.
+    *
+    *   When the window is complete, its summary is computed and
+    *   a new window is started.
+    *
+    *   \param[in,out] stats : pointer to statistics state
+    *   \param[in] data : compensated data (e.g., data field of the device
+    *                     structure after #BME280_ReadData)
+    *   \param[out] summary : pointer to struct where the summary will be stored
+    *
+    *   \return 1 if the window is complete and summary was written, 0 otherwise.
+    */
+    uint8_t BME280_Statistics_Add(BME280_Statistics* stats, const BME280_Data* data,
+                                  BME280_Stats_Summary* summary);
+
+    /**
+    *   \brief Compute the summary of the samples in the current window.
+    *
+    *   The window is not restarted, so this function can be used
+    *   to get partial results.
+    *
+    *   \param[in] stats : pointer to statistics state
+    *   \param[out] summary : pointer to struct where the summary will be stored
+    */
+    void BME280_Statistics_GetSummary(const BME280_Statistics* stats,
+                                      BME280_Stats_Summary* summary);
+
+#endif
+
+
+/* [] END OF FILE */
@@ -0,0 +1,423 @@
+/*
+*   This file includes all the required source code for the timer
+*   driven acquisition of BME280 data.
+*
+*   The buffer is a single producer/single consumer ring: only the I2C
+*   interrupt writes frames and moves the head, only the main loop reads
+*   frames and moves the tail, so no critical section is needed.
+*
+*   The sensor is polled faster than it updates its data registers, and
+*   only the frames that differ from the previous read are stored. The
+*   update of the sensor happened between the two reads, so each frame
+*   is stamped halfway between the end of the previous read and the end
+*   of its own read, within half a poll period of the actual update.
+*   A new sample may have the same data as the previous one (e.g., with
+*   no oversampling and a steady signal): when no frame changed for 1.5
+*   sample periods, the unchanged frame is stored one sample period after
+*   the last frame stored.
+*
+*   \author Davide Marzorati
+*/
+
+#include "BME280_Stream.h"
+#include "CyLib.h"
+
+/******************************************/
+/*               Macros                   */
+/******************************************/
+
+/**
+*   \brief Mask to wrap indexes around the buffer.
+*/
+#define BME280_STREAM_BUFFER_MASK (BME280_STREAM_BUFFER_LENGTH - 1)
+
+/**
+*   \brief Interrupt Control and State Register of the Cortex-M3.
+*/
+#define BME280_STREAM_ICSR ((reg32*)0xE000ED04u)
+
+/**
+*   \brief SysTick exception pending bit of ICSR.
+*/
+#define BME280_STREAM_ICSR_PENDSTSET (1u << 26)
+
+/******************************************/
+/*            Static variables            */
+/******************************************/
+
+// Raw data frames and their timestamps
+static uint8_t buffer[BME280_STREAM_BUFFER_LENGTH][BME280_P_T_H_DATA_LEN];
+static uint32_t stamps[BME280_STREAM_BUFFER_LENGTH];
+// Free running indexes, written by the producer and by the consumer only
+static volatile uint16_t head = 0;
+static volatile uint16_t tail = 0;
+// Device and poll period
+static BME280* device = NULL;
+static uint32_t period = 0;
+static volatile uint32_t ticks = 0;
+// Counter used for the timestamps
+static BME280_Stream_Clock clock_source = NULL;
+static uint32_t clock_frequency = 0;
+static volatile uint32_t milliseconds = 0;
+// Previous frame and end of its read, by the I2C interrupt only
+static uint8_t last_frame[BME280_P_T_H_DATA_LEN];
+static uint32_t last_read = 0;
+static uint8_t first_read = 1;
+// Stamp of the last frame stored, and sample period in counts
+static uint32_t last_push = 0;
+static uint32_t nominal_counts = 0;
+// Conversion of timestamps to us, by the consumer only
+static uint32_t last_stamp = 0;
+static uint32_t last_time = 0;
+static uint32_t time_remainder = 0;
+static uint8_t first_frame = 1;
+// Timing of the intervals, by the consumer only
+static BME280_Stream_Timing timing;
+static int64_t sum_deviation = 0;
+static uint64_t sum_squares = 0;
+// Statistics, written by the interrupts only
+static volatile BME280_Stream_Stats stats;
+
+/******************************************/
+/*          Function Prototypes           */
+/******************************************/
+
+/**
+*   \brief SysTick callback, starts a read every poll period.
+*/
+static void BME280_Stream_Tick(void);
+
+/**
+*   \brief Read completion callback, stores a new frame in the buffer.
+*
+*   \param[in] transaction Completed read transaction.
+*/
+static void BME280_Stream_Push(BME280_I2C_Transaction* transaction);
+
+/**
+*   \brief Default counter, SysTick extended to 32 bits.
+*
+*   \return Number of SysTick clock cycles, modulo 2^32.
+*/
+static uint32_t BME280_Stream_SysTickClock(void);
+
+/**
+*   \brief Convert a timestamp to us and update the timing.
+*
+*   \param[in] stamp : value of the counter
+*
+*   \return Time since the start of the acquisition in us.
+*/
+static uint32_t BME280_Stream_Time(uint32_t stamp);
+
+/**
+*   \brief Integer square root.
+*/
+static uint32_t BME280_Stream_Sqrt(uint64_t value);
+
+/******************************************/
+/*          Function Definitions          */
+/******************************************/
+
+BME280_ErrorCode BME280_Stream_Start(BME280* bme280, uint32_t period_ms)
+{
+    BME280_ErrorCode error = BME280_OK;
+
+    if ( bme280 == NULL)
+    {
+        error = BME280_E_NULL_PTR;
+    }
+    else
+    {
+        device = bme280;
+        period = (period_ms > 0) ? period_ms : 1;
+        ticks = 0;
+        head = 0;
+        tail = 0;
+        stats.samples = 0;
+        stats.repeats = 0;
+        stats.overruns = 0;
+        stats.errors = 0;
+        stats.high_water = 0;
+        stats.last_error = BME280_OK;
+        timing.intervals = 0;
+        timing.gaps = 0;
+        // Sample period of the sensor in normal mode
+        timing.nominal_period = BME280_GetTypicalMeasurementTime(bme280)
+                                + BME280_GetStandbyTime(bme280);
+        timing.min_period = 0xFFFFFFFF;
+        timing.max_period = 0;
+        sum_deviation = 0;
+        sum_squares = 0;
+        // SysTick interrupt every 1 ms
+        CySysTickStart();
+        if ( clock_source == NULL)
+        {
+            clock_source = BME280_Stream_SysTickClock;
+            clock_frequency = (CySysTickGetReload() + 1) * 1000;
+        }
+        nominal_counts = (uint32_t)((uint64_t)timing.nominal_period * clock_frequency / 1000000);
+        last_stamp = clock_source();
+        last_time = 0;
+        time_remainder = 0;
+        first_frame = 1;
+        first_read = 1;
+        CySysTickSetCallback(BME280_STREAM_SYSTICK_CALLBACK, BME280_Stream_Tick);
+    }
+    return error;
+}
+
+void BME280_Stream_Stop(void)
+{
+    CySysTickSetCallback(BME280_STREAM_SYSTICK_CALLBACK, NULL);
+}
+
+void BME280_Stream_SetClock(BME280_Stream_Clock clock, uint32_t frequency)
+{
+    clock_source = clock;
+    clock_frequency = frequency;
+}
+
+uint16_t BME280_Stream_Read(uint8_t* frames, uint16_t max_frames)
+{
+    return BME280_Stream_ReadStamped(frames, NULL, max_frames);
+}
+
+uint16_t BME280_Stream_ReadStamped(uint8_t* frames, uint32_t* timestamps,
+                                   uint16_t max_frames)
+{
+    uint16_t current_tail = tail;
+    uint16_t count = head - current_tail;
+    uint32_t time;
+
+    if ( count > max_frames)
+    {
+        count = max_frames;
+    }
+    for (uint16_t i = 0; i < count; i++)
+    {
+        uint8_t* frame = buffer[(current_tail + i) & BME280_STREAM_BUFFER_MASK];
+        for (uint8_t j = 0; j < BME280_P_T_H_DATA_LEN; j++)
+        {
+            frames[i * BME280_P_T_H_DATA_LEN + j] = frame[j];
+        }
+        time = BME280_Stream_Time(stamps[(current_tail + i) & BME280_STREAM_BUFFER_MASK]);
+        if ( timestamps != NULL)
+        {
+            timestamps[i] = time;
+        }
+    }
+    // Frames must be copied before the producer can overwrite them
+    __DMB();
+    tail = current_tail + count;
+    return count;
+}
+
+void BME280_Stream_GetStats(BME280_Stream_Stats* stats_copy)
+{
+    uint8_t interrupt_state = CyEnterCriticalSection();
+    *stats_copy = stats;
+    CyExitCriticalSection(interrupt_state);
+}
+
+void BME280_Stream_GetTiming(BME280_Stream_Timing* timing_copy)
+{
+    int64_t mean_deviation = 0;
+    uint64_t mean_square = 0;
+
+    *timing_copy = timing;
+    timing_copy->mean_period = timing.nominal_period;
+    timing_copy->drift = 0;
+    timing_copy->jitter = 0;
+    if ( timing.intervals > 0)
+    {
+        mean_deviation = sum_deviation / (int64_t)timing.intervals;
+        mean_square = sum_squares / timing.intervals;
+        // Rounded to the nearest us
+        timing_copy->mean_period = (uint32_t)(timing.nominal_period
+            + (sum_deviation + ((sum_deviation < 0) ? -1 : 1) * (int64_t)(timing.intervals / 2))
+            / (int64_t)timing.intervals);
+        timing_copy->drift = (int32_t)(sum_deviation * 1000000
+                             / ((int64_t)timing.intervals * timing.nominal_period));
+        timing_copy->jitter = BME280_Stream_Sqrt(mean_square
+                              - (uint64_t)(mean_deviation * mean_deviation));
+    }
+    else
+    {
+        timing_copy->min_period = 0;
+    }
+}
+
+static void BME280_Stream_Tick(void)
+{
+    BME280_ErrorCode error;
+
+    milliseconds++;
+    if ( ++ticks >= period)
+    {
+        ticks = 0;
+        error = BME280_ReadDataAsync(device, BME280_Stream_Push, NULL);
+        if ( error != BME280_OK)
+        {
+            // Previous read still running or queue full
+            stats.errors++;
+            stats.last_error = error;
+        }
+    }
+}
+
+static void BME280_Stream_Push(BME280_I2C_Transaction* transaction)
+{
+    uint32_t stamp = clock_source();
+    uint16_t current_head = head;
+    uint16_t count = current_head - tail;
+    uint8_t changed = 0;
+    uint8_t store = 0;
+
+    if ( transaction->error != BME280_OK)
+    {
+        stats.errors++;
+        stats.last_error = transaction->error;
+    }
+    else
+    {
+        for (uint8_t j = 0; j < BME280_P_T_H_DATA_LEN; j++)
+        {
+            changed |= (uint8_t)(transaction->data[j] ^ last_frame[j]);
+            last_frame[j] = transaction->data[j];
+        }
+        if ( first_read)
+        {
+            // Unknown update time, the first frame is only a reference
+            first_read = 0;
+            last_push = stamp;
+        }
+        else if ( changed != 0)
+        {
+            // Updated between the previous read and this one
+            last_push = last_read + (stamp - last_read) / 2;
+            store = 1;
+        }
+        else if ( stamp - last_push > nominal_counts + nominal_counts / 2)
+        {
+            // New sample with the same data as the previous one
+            last_push += nominal_counts;
+            store = 1;
+        }
+        else
+        {
+            // Sensor not updated since the previous read
+            stats.repeats++;
+        }
+        
+        if ( store && (count >= BME280_STREAM_BUFFER_LENGTH))
+        {
+            // Consumer too slow, drop the new frame
+            stats.overruns++;
+        }
+        else if ( store)
+        {
+            uint8_t* frame = buffer[current_head & BME280_STREAM_BUFFER_MASK];
+            for (uint8_t j = 0; j < BME280_P_T_H_DATA_LEN; j++)
+            {
+                frame[j] = transaction->data[j];
+            }
+            stamps[current_head & BME280_STREAM_BUFFER_MASK] = last_push;
+            // Frame must be complete before the consumer can see it
+            __DMB();
+            head = current_head + 1;
+            count++;
+            stats.samples++;
+            if ( count > stats.high_water)
+            {
+                stats.high_water = count;
+            }
+        }
+        last_read = stamp;
+    }
+}
+
+static uint32_t BME280_Stream_SysTickClock(void)
+{
+    uint8_t interrupt_state = CyEnterCriticalSection();
+    uint32_t reload = CySysTickGetReload();
+    uint32_t count = milliseconds;
+    uint32_t value = CySysTickGetValue();
+
+    if ( (CY_GET_REG32(BME280_STREAM_ICSR) & BME280_STREAM_ICSR_PENDSTSET) != 0)
+    {
+        // SysTick wrapped, but the interrupt was not served yet
+        count++;
+        value = CySysTickGetValue();
+    }
+    CyExitCriticalSection(interrupt_state);
+    // SysTick counts down from reload to 0
+    return count * (reload + 1) + (reload - value);
+}
+
+static uint32_t BME280_Stream_Time(uint32_t stamp)
+{
+    uint64_t elapsed;
+    uint32_t interval;
+    int32_t deviation;
+
+    // Keep the remainder, so that rounding errors do not add up
+    elapsed = (uint64_t)(stamp - last_stamp) * 1000000 + time_remainder;
+    interval = (uint32_t)(elapsed / clock_frequency);
+    time_remainder = (uint32_t)(elapsed % clock_frequency);
+    last_stamp = stamp;
+    last_time += interval;
+
+    if ( first_frame)
+    {
+        // No interval before the first frame
+        first_frame = 0;
+    }
+    else if ( interval > timing.nominal_period + timing.nominal_period / 2)
+    {
+        timing.gaps++;
+    }
+    else
+    {
+        deviation = (int32_t)(interval - timing.nominal_period);
+        timing.intervals++;
+        sum_deviation += deviation;
+        sum_squares += (uint64_t)((int64_t)deviation * deviation);
+        if ( interval < timing.min_period)
+        {
+            timing.min_period = interval;
+        }
+        if ( interval > timing.max_period)
+        {
+            timing.max_period = interval;
+        }
+    }
+    return last_time;
+}
+
+static uint32_t BME280_Stream_Sqrt(uint64_t value)
+{
+    uint64_t result = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while ( bit > value)
+    {
+        bit >>= 2;
+    }
+    while ( bit != 0)
+    {
+        if ( value >= result + bit)
+        {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+        {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)result;
+}
+
+/* [] END OF FILE */
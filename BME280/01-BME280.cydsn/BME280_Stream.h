@@ -0,0 +1,178 @@
+/**
+*   \file BME280_Stream.h
+*
+*   \brief Timer driven acquisition of BME280 data.
+*
+*   This header file contains the functions to read data from a BME280
+*   sensor in normal mode in the background. The SysTick timer starts
+*   a non-blocking read of the sensor every poll period, shorter than
+*   the sample period of the sensor, and the I2C interrupt stores the
+*   raw data frame in a buffer when it differs from the previous one,
+*   or when it did not change for 1.5 sample periods (a new sample equal
+*   to the previous one). The main loop reads the frames from the buffer
+*   in batches, so that a slow consumer (e.g., the UART) does not delay
+*   the acquisition.
+*
+*   Each frame is stamped with a free-running counter, by default the
+*   SysTick timer extended to 32 bits, halfway between the end of the
+*   previous read and the end of its own read: this is the time at which
+*   the sensor updated its data registers, within half a poll period.
+*   Frames that did not change are stamped one sample period after the
+*   previous frame. The intervals between consecutive frames are
+*   compared with the typical sample period of the sensor (measurement
+*   time plus standby time) to measure the jitter and the drift of the
+*   sensor against the counter.
+*
+*   \author Davide Marzorati
+*   \date November 8, 2019
+*/
+
+#ifndef __BME280_STREAM_H
+    #define __BME280_STREAM_H
+
+    #include "BME280.h"
+
+    /**
+    *   \brief Number of frames in the buffer, must be a power of two.
+    */
+    #ifndef BME280_STREAM_BUFFER_LENGTH
+        #define BME280_STREAM_BUFFER_LENGTH 32
+    #endif
+
+    /**
+    *   \brief Number of the SysTick callback slot used by the stream.
+    */
+    #ifndef BME280_STREAM_SYSTICK_CALLBACK
+        #define BME280_STREAM_SYSTICK_CALLBACK 0
+    #endif
+
+    /**
+    *   \brief Statistics of the acquisition.
+    */
+    typedef struct {
+        uint32_t samples;               ///< Frames stored in the buffer
+        uint32_t repeats;               ///< Reads within a sample period that returned the previous frame
+        uint16_t overruns;              ///< Frames dropped because the buffer was full
+        uint16_t errors;                ///< Reads that could not be started or failed
+        uint16_t high_water;            ///< Maximum number of frames in the buffer
+        BME280_ErrorCode last_error;    ///< Error of the last failed read
+    } BME280_Stream_Stats;
+
+    /**
+    *   \brief Timing of the acquisition.
+    *
+    *   Intervals longer than 1.5 sample periods (e.g., after an overrun)
+    *   are counted as gaps and not included in the other fields. The
+    *   jitter includes the resolution of the timestamps, about 0.4 poll
+    *   periods.
+    */
+    typedef struct {
+        uint32_t intervals;             ///< Intervals between consecutive frames
+        uint32_t gaps;                  ///< Intervals longer than 1.5 sample periods
+        uint32_t nominal_period;        ///< Typical sample period of the sensor in us
+        uint32_t mean_period;           ///< Mean interval in us
+        int32_t drift;                  ///< Mean interval error, in ppm of the sample period
+        uint32_t jitter;                ///< Standard deviation of the intervals in us
+        uint32_t min_period;            ///< Minimum interval in us
+        uint32_t max_period;            ///< Maximum interval in us
+    } BME280_Stream_Timing;
+
+    /**
+    *   \brief Free-running counter used to stamp the frames.
+    *
+    *   The counter must count up and wrap around at 2^32. It is
+    *   called from the I2C interrupt.
+    */
+    typedef uint32_t (*BME280_Stream_Clock)(void);
+
+    /**
+    *   \brief Start the acquisition.
+    *
+    *   This function clears the buffer and the statistics and starts
+    *   the SysTick timer, which reads the sensor every period_ms milliseconds.
+    *   The sensor must be started and configured in normal mode before
+    *   calling this function. The poll period should be a fraction of
+    *   the sample period of the sensor (#BME280_GetSamplePeriod): the
+    *   timestamps are accurate to half a poll period. The first read
+    *   is only used as reference, and is not stored.
+    *
+    *   \param[in] bme280 : Pointer to device struct
+    *   \param[in] period_ms : Poll period in milliseconds
+    *
+    *   \return Result of function execution
+    *   \retval #BME280_E_NULL_PTR -> Null pointer
+    *   \retval #BME280_OK -> Success
+    */
+    BME280_ErrorCode BME280_Stream_Start(BME280* bme280, uint32_t period_ms);
+
+    /**
+    *   \brief Stop the acquisition.
+    *
+    *   Frames already in the buffer can still be read.
+    */
+    void BME280_Stream_Stop(void);
+
+    /**
+    *   \brief Set the counter used to stamp the frames.
+    *
+    *   By default, the SysTick timer is used, with the resolution
+    *   of the SysTick clock. A Timer component clocked by a crystal
+    *   can be used instead, so that the drift is measured against
+    *   the crystal.
+    *   This function must be called before #BME280_Stream_Start.
+    *
+    *   \param[in] clock : counter, NULL for SysTick
+    *   \param[in] frequency : frequency of the counter in Hz
+    */
+    void BME280_Stream_SetClock(BME280_Stream_Clock clock, uint32_t frequency);
+
+    /**
+    *   \brief Read frames from the buffer.
+    *
+    *   This function copies up to max_frames raw data frames of
+    *   #BME280_P_T_H_DATA_LEN bytes from the buffer, oldest first. It must
+    *   be called from a single context (e.g., the main loop).
+    *
+    *   \param[out] frames : array of max_frames * #BME280_P_T_H_DATA_LEN bytes
+    *   \param[in] max_frames : maximum number of frames to be read
+    *
+    *   \return Number of frames read.
+    */
+    uint16_t BME280_Stream_Read(uint8_t* frames, uint16_t max_frames);
+
+    /**
+    *   \brief Read frames from the buffer with their timestamps.
+    *
+    *   This function is the same as #BME280_Stream_Read, and also returns
+    *   the time at which the sensor updated each frame, in us since
+    *   #BME280_Stream_Start (wrapping around after about 71 minutes).
+    *
+    *   \param[out] frames : array of max_frames * #BME280_P_T_H_DATA_LEN bytes
+    *   \param[out] timestamps : array of max_frames timestamps, may be NULL
+    *   \param[in] max_frames : maximum number of frames to be read
+    *
+    *   \return Number of frames read.
+    */
+    uint16_t BME280_Stream_ReadStamped(uint8_t* frames, uint32_t* timestamps,
+                                       uint16_t max_frames);
+
+    /**
+    *   \brief Get the statistics of the acquisition.
+    *
+    *   \param[out] stats : pointer to struct where statistics will be stored
+    */
+    void BME280_Stream_GetStats(BME280_Stream_Stats* stats);
+
+    /**
+    *   \brief Get the timing of the frames read since the start of the acquisition.
+    *
+    *   It must be called from the same context as #BME280_Stream_Read.
+    *
+    *   \param[out] timing : pointer to struct where timing will be stored
+    */
+    void BME280_Stream_GetTiming(BME280_Stream_Timing* timing);
+
+#endif
+
+
+/* [] END OF FILE */
@@ -0,0 +1,249 @@
+/*
+*   This file includes all the required source code to pack
+*   BME280 data in telemetry packets.
+*
+*   \author Davide Marzorati
+*/
+
+#include "BME280_Telemetry.h"
+
+/******************************************/
+/*          Function Prototypes           */
+/******************************************/
+
+/**
+*   \brief Write a value as a varint.
+*
+*   \param[in] value : value to be written
+*   \param[out] data : array where the bytes will be written
+*
+*   \return Number of bytes written.
+*/
+static uint8_t BME280_Telemetry_PutVarint(uint32_t value, uint8_t* data);
+
+/**
+*   \brief Map a signed value to an unsigned one with small magnitude first.
+*/
+static uint32_t BME280_Telemetry_ZigZag(int32_t value);
+
+/**
+*   \brief Write the summary of a channel, big endian.
+*
+*   \param[in] channel : summary of the channel
+*   \param[out] data : array of 16 bytes
+*/
+static void BME280_Telemetry_PutChannel(const BME280_Stats_Channel* channel,
+                                        uint8_t* data);
+
+/**
+*   \brief Write a 32 bit value, big endian.
+*
+*   \param[in] value : value to be written
+*   \param[out] data : array of 4 bytes
+*/
+static void BME280_Telemetry_PutUint32(uint32_t value, uint8_t* data);
+
+/******************************************/
+/*          Function Definitions          */
+/******************************************/
+
+void BME280_Telemetry_PackCalibration(const BME280* bme280, uint8_t* packet)
+{
+    uint8_t checksum = 0;
+
+    packet[0] = 0x0A;
+    packet[1] = 0x0C;
+    packet[2] = bme280->chip_id;
+    BME280_Compensation_PackCalibData(&bme280->calib_data, &packet[3]);
+    for (uint8_t i = 2; i < 3 + BME280_COMP_CALIB_PACKED_LEN; i++)
+    {
+        checksum += packet[i];
+    }
+    packet[BME280_TELEMETRY_CALIB_PACKET_LEN-3] = (uint8_t)(-checksum);
+    packet[BME280_TELEMETRY_CALIB_PACKET_LEN-2] = 0xA0;
+    packet[BME280_TELEMETRY_CALIB_PACKET_LEN-1] = 0xC0;
+}
+
+void BME280_Telemetry_PackRawFrame(const uint8_t* frame, uint8_t sequence,
+                                   uint8_t* packet)
+{
+    packet[0] = BME280_TELEMETRY_RAW_SYNC;
+    for (uint8_t i = 0; i < BME280_P_T_H_DATA_LEN; i++)
+    {
+        packet[1 + i] = frame[i];
+    }
+    // Only the high nibble of the XLSB registers holds data
+    packet[3] = (packet[3] & 0xF0) | (sequence >> 4);
+    packet[6] = (packet[6] & 0xF0) | (sequence & 0x0F);
+}
+
+void BME280_Telemetry_EncoderInit(BME280_Telemetry_Encoder* encoder,
+                                  uint16_t keyframe_interval)
+{
+    encoder->temperature = 0;
+    encoder->pressure = 0;
+    encoder->humidity = 0;
+    encoder->count = 0;
+    encoder->keyframe_interval = (keyframe_interval > 0) ? keyframe_interval : 1;
+}
+
+uint8_t BME280_Telemetry_Encode(BME280_Telemetry_Encoder* encoder,
+                                int32_t temperature, uint32_t pressure,
+                                uint32_t humidity, uint8_t* packet)
+{
+    uint8_t length;
+    uint8_t checksum = 0;
+
+    if ( encoder->count == 0)
+    {
+        // Keyframe with full values
+        packet[0] = BME280_TELEMETRY_DELTA_SYNC_0;
+        packet[1] = BME280_TELEMETRY_DELTA_SYNC_1;
+        length = 2;
+        length += BME280_Telemetry_PutVarint(BME280_Telemetry_ZigZag(temperature), &packet[length]);
+        length += BME280_Telemetry_PutVarint(pressure, &packet[length]);
+        length += BME280_Telemetry_PutVarint(humidity, &packet[length]);
+        for (uint8_t i = 2; i < length; i++)
+        {
+            checksum += packet[i];
+        }
+        // 7 bit checksum, so that it cannot be taken for a sync byte
+        packet[length++] = (uint8_t)(-checksum) & 0x7F;
+        encoder->count = encoder->keyframe_interval;
+    }
+    else
+    {
+        // Differences from the previous sample
+        length = BME280_Telemetry_PutVarint(
+            BME280_Telemetry_ZigZag(temperature - encoder->temperature), packet);
+        length += BME280_Telemetry_PutVarint(
+            BME280_Telemetry_ZigZag((int32_t)(pressure - encoder->pressure)), &packet[length]);
+        length += BME280_Telemetry_PutVarint(
+            BME280_Telemetry_ZigZag((int32_t)(humidity - encoder->humidity)), &packet[length]);
+    }
+    encoder->count--;
+    encoder->temperature = temperature;
+    encoder->pressure = pressure;
+    encoder->humidity = humidity;
+    return length;
+}
+
+void BME280_Telemetry_DeadbandInit(BME280_Telemetry_Deadband* deadband,
+                                   uint32_t temperature_threshold,
+                                   uint32_t pressure_threshold,
+                                   uint32_t humidity_threshold,
+                                   uint16_t heartbeat)
+{
+    deadband->temperature_threshold = temperature_threshold;
+    deadband->pressure_threshold = pressure_threshold;
+    deadband->humidity_threshold = humidity_threshold;
+    deadband->heartbeat = (heartbeat > 0) ? heartbeat : 1;
+    deadband->sequence = 0;
+    deadband->silence = 0;
+}
+
+uint8_t BME280_Telemetry_ReportOnChange(BME280_Telemetry_Deadband* deadband,
+                                        int32_t temperature, uint32_t pressure,
+                                        uint32_t humidity, uint8_t* packet)
+{
+    int32_t delta_t = temperature - deadband->temperature;
+    int32_t delta_p = (int32_t)(pressure - deadband->pressure);
+    int32_t delta_h = (int32_t)(humidity - deadband->humidity);
+    uint16_t sequence = deadband->sequence++;
+
+    if ( deadband->silence > 0
+         && (uint32_t)((delta_t < 0) ? -delta_t : delta_t) <= deadband->temperature_threshold
+         && (uint32_t)((delta_p < 0) ? -delta_p : delta_p) <= deadband->pressure_threshold
+         && (uint32_t)((delta_h < 0) ? -delta_h : delta_h) <= deadband->humidity_threshold)
+    {
+        // Within the thresholds, the host keeps the last values
+        deadband->silence--;
+        return 0;
+    }
+    packet[0] = 0x0A;
+    packet[1] = 0x0E;
+    packet[2] = (uint8_t)(sequence >> 8);
+    packet[3] = (uint8_t)(sequence);
+    BME280_Telemetry_PutUint32(pressure, &packet[4]);
+    BME280_Telemetry_PutUint32((uint32_t)temperature, &packet[8]);
+    BME280_Telemetry_PutUint32(humidity, &packet[12]);
+    packet[BME280_TELEMETRY_CHANGE_PACKET_LEN-2] = 0xA0;
+    packet[BME280_TELEMETRY_CHANGE_PACKET_LEN-1] = 0xC0;
+    deadband->temperature = temperature;
+    deadband->pressure = pressure;
+    deadband->humidity = humidity;
+    deadband->silence = deadband->heartbeat - 1;
+    return BME280_TELEMETRY_CHANGE_PACKET_LEN;
+}
+
+void BME280_Telemetry_PackStamped(uint32_t timestamp, int32_t temperature,
+                                  uint32_t pressure, uint32_t humidity,
+                                  uint8_t* packet)
+{
+    packet[0] = 0x0A;
+    packet[1] = 0x0B;
+    BME280_Telemetry_PutUint32(timestamp, &packet[2]);
+    BME280_Telemetry_PutUint32(pressure, &packet[6]);
+    BME280_Telemetry_PutUint32((uint32_t)temperature, &packet[10]);
+    BME280_Telemetry_PutUint32(humidity, &packet[14]);
+    packet[BME280_TELEMETRY_STAMPED_PACKET_LEN-2] = 0xA0;
+    packet[BME280_TELEMETRY_STAMPED_PACKET_LEN-1] = 0xC0;
+}
+
+void BME280_Telemetry_PackSummary(const BME280_Stats_Summary* summary,
+                                  uint8_t* packet)
+{
+    uint8_t checksum = 0;
+
+    packet[0] = 0x0A;
+    packet[1] = 0x0F;
+    packet[2] = (uint8_t)(summary->count >> 8);
+    packet[3] = (uint8_t)(summary->count);
+    BME280_Telemetry_PutChannel(&summary->pressure, &packet[4]);
+    BME280_Telemetry_PutChannel(&summary->temperature, &packet[20]);
+    BME280_Telemetry_PutChannel(&summary->humidity, &packet[36]);
+    for (uint8_t i = 2; i < BME280_TELEMETRY_SUMMARY_PACKET_LEN-3; i++)
+    {
+        checksum += packet[i];
+    }
+    packet[BME280_TELEMETRY_SUMMARY_PACKET_LEN-3] = (uint8_t)(-checksum);
+    packet[BME280_TELEMETRY_SUMMARY_PACKET_LEN-2] = 0xA0;
+    packet[BME280_TELEMETRY_SUMMARY_PACKET_LEN-1] = 0xC0;
+}
+
+static uint8_t BME280_Telemetry_PutVarint(uint32_t value, uint8_t* data)
+{
+    uint8_t length = 0;
+
+    while ( value >= 0x80)
+    {
+        data[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    data[length++] = (uint8_t)value;
+    return length;
+}
+
+static uint32_t BME280_Telemetry_ZigZag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static void BME280_Telemetry_PutChannel(const BME280_Stats_Channel* channel,
+                                        uint8_t* data)
+{
+    BME280_Telemetry_PutUint32((uint32_t)channel->min, &data[0]);
+    BME280_Telemetry_PutUint32((uint32_t)channel->max, &data[4]);
+    BME280_Telemetry_PutUint32((uint32_t)channel->mean, &data[8]);
+    BME280_Telemetry_PutUint32(channel->std_dev, &data[12]);
+}
+
+static void BME280_Telemetry_PutUint32(uint32_t value, uint8_t* data)
+{
+    data[0] = (uint8_t)(value >> 24);
+    data[1] = (uint8_t)(value >> 16);
+    data[2] = (uint8_t)(value >> 8);
+    data[3] = (uint8_t)(value);
+}
+
+/* [] END OF FILE */
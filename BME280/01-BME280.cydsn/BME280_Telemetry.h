@@ -0,0 +1,261 @@
+/**
+*   \file BME280_Telemetry.h
+*
+*   \brief Compact telemetry of BME280 data.
+*
+*   This header file contains the functions to pack BME280 data in
+*   compact packets to be sent to a host. Five formats are available.
+*
+*   In the raw format, the calibration coefficients are sent once,
+*   followed by the raw data frames read from the sensor. The host
+*   compensates the data, so that each sample needs less bandwidth and
+*   no computation on the device.
+*
+*   Calibration packet (#BME280_TELEMETRY_CALIB_PACKET_LEN bytes):
+*   - 0x0A 0x0C
+*   - chip id
+*   - calibration coefficients packed by #BME280_Compensation_PackCalibData
+*   - checksum, so that the sum of chip id, coefficients and checksum is 0
+*   - 0xA0 0xC0
+*
+*   Raw data packet (#BME280_TELEMETRY_RAW_PACKET_LEN bytes):
+*   - #BME280_TELEMETRY_RAW_SYNC
+*   - raw data frame as read from #BME280_PRESS_MSB_REG_ADDR, with the
+*     sequence number in the unused low nibbles of the pressure and
+*     temperature XLSB bytes (high nibble in pressure, low nibble in temperature)
+*
+*   In the delta format, compensated values are sent as the difference
+*   from the previous sample, since environmental data change slowly.
+*   Each value is zig-zag encoded (0, -1, 1, -2, ... become 0, 1, 2, 3, ...)
+*   and written as a varint: 7 bits per byte, least significant first,
+*   with the MSB set in all bytes but the last one. A keyframe with the
+*   full values is sent every keyframe interval samples, so that the host
+*   can start decoding or recover after lost bytes.
+*
+*   Keyframe (up to #BME280_TELEMETRY_DELTA_MAX_LEN bytes):
+*   - #BME280_TELEMETRY_DELTA_SYNC_0 #BME280_TELEMETRY_DELTA_SYNC_1
+*   - zig-zag varint temperature, varint pressure, varint humidity
+*   - 7 bit checksum, so that the sum of the varint bytes and checksum
+*     is 0 modulo 128
+*
+*   Delta record (3 to 15 bytes):
+*   - zig-zag varint difference of temperature, pressure, humidity
+*
+*   The sync bytes cannot appear elsewhere in the stream: a byte with
+*   the MSB set is always followed by another byte of the same varint,
+*   and the last byte of a varint longer than one byte is never 0.
+*
+*   \author Davide Marzorati
+*   \date November 8, 2019
+*/
+
+#ifndef __BME280_TELEMETRY_H
+    #define __BME280_TELEMETRY_H
+
+    #include "BME280.h"
+    #include "BME280_Statistics.h"
+
+    /**
+    *   \brief Length of the calibration packet.
+    */
+    #define BME280_TELEMETRY_CALIB_PACKET_LEN (2 + 1 + BME280_COMP_CALIB_PACKED_LEN + 1 + 2)
+
+    /**
+    *   \brief Length of the raw data packet.
+    */
+    #define BME280_TELEMETRY_RAW_PACKET_LEN (1 + BME280_P_T_H_DATA_LEN)
+
+    /**
+    *   \brief First byte of the raw data packet.
+    */
+    #define BME280_TELEMETRY_RAW_SYNC 0x0B
+
+    /**
+    *   \brief First byte of the keyframe in the delta format.
+    */
+    #define BME280_TELEMETRY_DELTA_SYNC_0 0x80
+
+    /**
+    *   \brief Second byte of the keyframe in the delta format.
+    */
+    #define BME280_TELEMETRY_DELTA_SYNC_1 0x00
+
+    /**
+    *   \brief Maximum length of a keyframe or delta record.
+    */
+    #define BME280_TELEMETRY_DELTA_MAX_LEN (2 + 3 * 5 + 1)
+
+    /**
+    *   \brief Default number of samples between two keyframes.
+    */
+    #ifndef BME280_TELEMETRY_KEYFRAME_INTERVAL
+        #define BME280_TELEMETRY_KEYFRAME_INTERVAL 32
+    #endif
+
+    /**
+    *   \brief Length of the summary packet.
+    */
+    #define BME280_TELEMETRY_SUMMARY_PACKET_LEN (2 + 2 + 3 * 4 * 4 + 1 + 2)
+
+    /**
+    *   \brief Length of the change packet.
+    */
+    #define BME280_TELEMETRY_CHANGE_PACKET_LEN (2 + 2 + 3 * 4 + 2)
+
+    /**
+    *   \brief Length of the stamped packet.
+    */
+    #define BME280_TELEMETRY_STAMPED_PACKET_LEN (2 + 4 + 3 * 4 + 2)
+
+    /**
+    *   \brief Default temperature threshold of the change format, in 0.01 degC.
+    */
+    #ifndef BME280_TELEMETRY_DEADBAND_TEMPERATURE
+        #define BME280_TELEMETRY_DEADBAND_TEMPERATURE 10
+    #endif
+
+    /**
+    *   \brief Default pressure threshold of the change format, in Pa.
+    */
+    #ifndef BME280_TELEMETRY_DEADBAND_PRESSURE
+        #define BME280_TELEMETRY_DEADBAND_PRESSURE 12
+    #endif
+
+    /**
+    *   \brief Default humidity threshold of the change format, in 1/1024 %RH.
+    */
+    #ifndef BME280_TELEMETRY_DEADBAND_HUMIDITY
+        #define BME280_TELEMETRY_DEADBAND_HUMIDITY 512
+    #endif
+
+    /**
+    *   \brief State of the delta encoder.
+    */
+    typedef struct {
+        int32_t temperature;            ///< Previous temperature
+        uint32_t pressure;              ///< Previous pressure
+        uint32_t humidity;              ///< Previous humidity
+        uint16_t count;                 ///< Samples left before the next keyframe
+        uint16_t keyframe_interval;     ///< Samples between two keyframes
+    } BME280_Telemetry_Encoder;
+
+    /**
+    *   \brief State of the change format.
+    */
+    typedef struct {
+        int32_t temperature;            ///< Last temperature sent
+        uint32_t pressure;              ///< Last pressure sent
+        uint32_t humidity;              ///< Last humidity sent
+        uint32_t temperature_threshold; ///< Temperature threshold
+        uint32_t pressure_threshold;    ///< Pressure threshold
+        uint32_t humidity_threshold;    ///< Humidity threshold
+        uint16_t sequence;              ///< Number of the next sample
+        uint16_t silence;               ///< Samples left before the next heartbeat
+        uint16_t heartbeat;             ///< Maximum number of samples between two packets
+    } BME280_Telemetry_Deadband;
+
+    /**
+    *   \brief Pack the calibration packet.
+    *
+    *   \param[in] bme280 : Pointer to device struct, calibration data must be loaded
+    *   \param[out] packet : array of #BME280_TELEMETRY_CALIB_PACKET_LEN bytes
+    */
+    void BME280_Telemetry_PackCalibration(const BME280* bme280, uint8_t* packet);
+
+    /**
+    *   \brief Pack a raw data packet.
+    *
+    *   \param[in] frame : raw data frame of #BME280_P_T_H_DATA_LEN bytes
+    *   \param[in] sequence : sequence number of the frame
+    *   \param[out] packet : array of #BME280_TELEMETRY_RAW_PACKET_LEN bytes
+    */
+    void BME280_Telemetry_PackRawFrame(const uint8_t* frame, uint8_t sequence,
+                                       uint8_t* packet);
+
+    /**
+    *   \brief Initialize the delta encoder.
+    *
+    *   The next sample is sent as a keyframe. Call this function again
+    *   to force a keyframe, e.g. after a sensor reset.
+    *
+    *   \param[out] encoder : pointer to encoder state
+    *   \param[in] keyframe_interval : samples between two keyframes, 1 to
+    *                                  send only keyframes
+    */
+    void BME280_Telemetry_EncoderInit(BME280_Telemetry_Encoder* encoder,
+                                      uint16_t keyframe_interval);
+
+    /**
+    *   \brief Encode a compensated sample in the delta format.
+    *
+    *   \param[in,out] encoder : pointer to encoder state
+    *   \param[in] temperature : temperature in 0.01 degC
+    *   \param[in] pressure : pressure in Pa
+    *   \param[in] humidity : humidity in 1/1024 %RH
+    *   \param[out] packet : array of #BME280_TELEMETRY_DELTA_MAX_LEN bytes
+    *
+    *   \return Number of bytes written in packet.
+    */
+    uint8_t BME280_Telemetry_Encode(BME280_Telemetry_Encoder* encoder,
+                                    int32_t temperature, uint32_t pressure,
+                                    uint32_t humidity, uint8_t* packet);
+
+    /**
+    *   \brief Initialize the change format.
+    *
+    *   The next sample is always sent. Call this function again
+    *   to force a packet, e.g. after a sensor reset.
+    *
+    *   \param[out] deadband : pointer to change format state
+    *   \param[in] temperature_threshold : temperature threshold in 0.01 degC
+    *   \param[in] pressure_threshold : pressure threshold in Pa
+    *   \param[in] humidity_threshold : humidity threshold in 1/1024 %RH
+    *   \param[in] heartbeat : maximum number of samples between two packets
+    */
+    void BME280_Telemetry_DeadbandInit(BME280_Telemetry_Deadband* deadband,
+                                       uint32_t temperature_threshold,
+                                       uint32_t pressure_threshold,
+                                       uint32_t humidity_threshold,
+                                       uint16_t heartbeat);
+
+    /**
+    *   \brief Pack a change packet if the sample has to be sent.
+    *
+    *   \param[in,out] deadband : pointer to change format state
+    *   \param[in] temperature : temperature in 0.01 degC
+    *   \param[in] pressure : pressure in Pa
+    *   \param[in] humidity : humidity in 1/1024 %RH
+    *   \param[out] packet : array of #BME280_TELEMETRY_CHANGE_PACKET_LEN bytes
+    *
+    *   \return Number of bytes written in packet, 0 if the sample is not sent.
+    */
+    uint8_t BME280_Telemetry_ReportOnChange(BME280_Telemetry_Deadband* deadband,
+                                           int32_t temperature, uint32_t pressure,
+                                           uint32_t humidity, uint8_t* packet);
+
+    /**
+    *   \brief Pack a stamped packet.
+    *
+    *   \param[in] timestamp : time of the sample in us
+    *   \param[in] temperature : temperature in 0.01 degC
+    *   \param[in] pressure : pressure in Pa
+    *   \param[in] humidity : humidity in 1/1024 %RH
+    *   \param[out] packet : array of #BME280_TELEMETRY_STAMPED_PACKET_LEN bytes
+    */
+    void BME280_Telemetry_PackStamped(uint32_t timestamp, int32_t temperature,
+                                      uint32_t pressure, uint32_t humidity,
+                                      uint8_t* packet);
+
+    /**
+    *   \brief Pack a summary packet.
+    *
+    *   \param[in] summary : statistics of a window of samples
+    *   \param[out] packet : array of #BME280_TELEMETRY_SUMMARY_PACKET_LEN bytes
+    */
+    void BME280_Telemetry_PackSummary(const BME280_Stats_Summary* summary,
+                                      uint8_t* packet);
+
+#endif
+
+
+/* [] END OF FILE */
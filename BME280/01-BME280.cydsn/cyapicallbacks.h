@@ -15,6 +15,10 @@
 
     /*Define your macro callbacks here */
     /*For more information, refer to the Writing Code topic in the PSoC Creator Help.*/
+    
+    // The I2C interrupt drives the queued BME280 transactions
+    #define I2C_Master_ISR_EXIT_CALLBACK
+    void I2C_Master_ISR_ExitCallback(void);
 
     
 #endif /* CYAPICALLBACKS_H */   
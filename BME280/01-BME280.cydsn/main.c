@@ -14,12 +14,55 @@
 */
 
 #include "BME280.h"
+#include "BME280_Adaptive.h"
+#include "BME280_Statistics.h"
+#include "BME280_Stream.h"
+#include "BME280_Telemetry.h"
 #include "project.h"
 #include "stdio.h"
 
 #define HEADER_SIZE 2
 #define TAIL_SIZE 2
 #define PACKET_SIZE (HEADER_SIZE + TAIL_SIZE + 4*3) 
+#define BATCH_SIZE 8
+#define SUMMARY_WINDOW_MS 60000
+#define HEARTBEAT_MS 10000
+// Reads of the stream per sample of the sensor
+#define STREAM_POLLS 4
+
+/*
+*   Format of the data sent over UART (see Host_Tools/bme280_decode.py):
+*   - TELEMETRY_PACKETS: compensated values, for the Bridge Control Panel
+*   - TELEMETRY_RAW: calibration coefficients once, then raw data frames
+*   - TELEMETRY_DELTA: compensated values as varint differences
+*   - TELEMETRY_SUMMARY: statistics of the samples every SUMMARY_WINDOW_MS
+*   - TELEMETRY_CHANGE: compensated values when they change, at least
+*     every HEARTBEAT_MS
+*   - TELEMETRY_STAMPED: compensated values with the time they were measured
+*/
+#define TELEMETRY_PACKETS 0
+#define TELEMETRY_RAW 1
+#define TELEMETRY_DELTA 2
+#define TELEMETRY_SUMMARY 3
+#define TELEMETRY_CHANGE 4
+#define TELEMETRY_STAMPED 5
+
+#ifndef TELEMETRY_MODE
+    #define TELEMETRY_MODE TELEMETRY_PACKETS
+#endif
+
+/*
+*   With ADAPTIVE_SETTINGS set to 1, oversampling and filter are adapted
+*   to the signal (see BME280_Adaptive.h), with a measurement time up to
+*   ADAPTIVE_TIME_BUDGET_US. The sample period changes with the settings,
+*   while SUMMARY_WINDOW_MS and HEARTBEAT_MS are converted to samples with
+*   the initial one. Not available with TELEMETRY_RAW, since the device
+*   does not compensate data.
+*/
+#ifndef ADAPTIVE_SETTINGS
+    #define ADAPTIVE_SETTINGS 0
+#endif
+#define ADAPTIVE_TIME_BUDGET_US 40000
 
 int main(void)
 {
@@ -33,25 +76,112 @@ int main(void)
     char message[50];
     BME280 bme280;
     BME280_ErrorCode error;
+    uint32_t sample_period = 0;
+    uint32_t poll_period = 0;
+    // Frames read from the stream buffer
+    uint8_t frames[BATCH_SIZE * BME280_P_T_H_DATA_LEN];
+#if TELEMETRY_MODE == TELEMETRY_RAW
+    uint8_t raw_packet[BME280_TELEMETRY_CALIB_PACKET_LEN];
+    uint8_t sequence = 0;
+#else
+#if TELEMETRY_MODE == TELEMETRY_DELTA
+    uint8_t delta_packet[BME280_TELEMETRY_DELTA_MAX_LEN];
+    BME280_Telemetry_Encoder encoder;
+#elif TELEMETRY_MODE == TELEMETRY_SUMMARY
+    uint8_t summary_packet[BME280_TELEMETRY_SUMMARY_PACKET_LEN];
+    BME280_Statistics statistics;
+    BME280_Stats_Summary summary;
+    BME280_Data sample;
+    uint32_t window = 1;
+#elif TELEMETRY_MODE == TELEMETRY_CHANGE
+    uint8_t change_packet[BME280_TELEMETRY_CHANGE_PACKET_LEN];
+    BME280_Telemetry_Deadband deadband;
+    uint32_t heartbeat = 1;
+#elif TELEMETRY_MODE == TELEMETRY_STAMPED
+    uint8_t stamped_packet[BME280_TELEMETRY_STAMPED_PACKET_LEN];
+    uint32_t timestamps[BATCH_SIZE];
+#else
     uint8_t data_array[PACKET_SIZE] = {0};
-    uint8_t status_reg = 0;
+#endif
+    // Raw and compensated data
+    int32_t uncomp_temperature[BATCH_SIZE];
+    uint32_t uncomp_pressure[BATCH_SIZE];
+    uint32_t uncomp_humidity[BATCH_SIZE];
+    int32_t temperature[BATCH_SIZE];
+    uint32_t pressure[BATCH_SIZE];
+    uint32_t humidity[BATCH_SIZE];
+#if ADAPTIVE_SETTINGS
+    BME280_Adaptive adaptive;
+    BME280_Data adaptive_sample;
+#endif
+#endif
+    uint16_t count;
+    BME280_Stream_Stats stats;
+    uint16_t errors = 0;
+    BME280_Settings settings = {
+        .mode = BME280_NORMAL_MODE,
+        .osr_p = BME280_OVERSAMPLING_1X,
+        .osr_t = BME280_OVERSAMPLING_1X,
+        .osr_h = BME280_OVERSAMPLING_1X,
+        .filter = BME280_FILTER_COEFF_OFF,
+        .stanby_time = BME280_TSTANBDY_500_MS,
+        .spi_enable = 0
+    };
     
+#if TELEMETRY_MODE == TELEMETRY_PACKETS
     data_array[0] = 0x0A;
     data_array[1] = 0x0D;
     data_array[PACKET_SIZE-2] = 0xA0;
     data_array[PACKET_SIZE-1] = 0xC0;
+#elif TELEMETRY_MODE == TELEMETRY_DELTA
+    BME280_Telemetry_EncoderInit(&encoder, BME280_TELEMETRY_KEYFRAME_INTERVAL);
+#endif
 
+    // Sensor on the I2C bus with SDO connected to GND
+    // (with a SPIM_BME280 component and BME280_SPI_Interface.h included:
+    // BME280_Setup(&bme280, &BME280_SPI_Bus, 0))
+    BME280_Setup(&bme280, &BME280_I2C_Bus, BME280_I2C_ADDRESS_PRIMARY);
     error = BME280_Start(&bme280);
     if (error == BME280_OK)
     {
         UART_Debug_PutString("Sensor was initialized properly\r\n");
 
-        BME280_SetHumidityOversampling(&bme280, BME280_OVERSAMPLING_1X);
-        BME280_SetTemperatureOversampling(&bme280, BME280_OVERSAMPLING_1X);
-        BME280_SetPressureOversampling(&bme280, BME280_OVERSAMPLING_1X);
-        BME280_SetStandbyTime(&bme280, BME280_TSTANBDY_500_MS);
-        BME280_SetNormalMode(&bme280);
-
+        // Write all the settings at once
+        BME280_ApplySettings(&bme280, &settings);
+        // Time between two samples, rounded up to ms
+        sample_period = (BME280_GetSamplePeriod(&bme280) + 999) / 1000;
+        poll_period = sample_period / STREAM_POLLS;
+        sprintf(message, "Sample period: %lu ms\r\n", (unsigned long)sample_period);
+        UART_Debug_PutString(message);
+#if ADAPTIVE_SETTINGS && TELEMETRY_MODE != TELEMETRY_RAW
+        BME280_Adaptive_Init(&adaptive, BME280_ADAPTIVE_NOISE_TEMPERATURE, BME280_ADAPTIVE_NOISE_PRESSURE,
+            BME280_ADAPTIVE_NOISE_HUMIDITY, ADAPTIVE_TIME_BUDGET_US);
+#endif
+#if TELEMETRY_MODE == TELEMETRY_SUMMARY
+        // Number of samples in each summary
+        window = SUMMARY_WINDOW_MS / sample_period;
+        if (window > BME280_STATS_MAX_WINDOW)
+        {
+            window = BME280_STATS_MAX_WINDOW;
+        }
+        BME280_Statistics_Init(&statistics, window);
+#elif TELEMETRY_MODE == TELEMETRY_CHANGE
+        // Maximum number of samples between two packets
+        heartbeat = HEARTBEAT_MS / sample_period;
+        if (heartbeat > UINT16_MAX)
+        {
+            heartbeat = UINT16_MAX;
+        }
+        BME280_Telemetry_DeadbandInit(&deadband, BME280_TELEMETRY_DEADBAND_TEMPERATURE,
+            BME280_TELEMETRY_DEADBAND_PRESSURE, BME280_TELEMETRY_DEADBAND_HUMIDITY, heartbeat);
+#endif
+#if TELEMETRY_MODE == TELEMETRY_RAW
+        // The host needs the calibration data to compensate raw frames
+        BME280_Telemetry_PackCalibration(&bme280, raw_packet);
+        UART_Debug_PutArray(raw_packet, BME280_TELEMETRY_CALIB_PACKET_LEN);
+#endif
+        // Read the sensor in background
+        BME280_Stream_Start(&bme280, poll_period);
     }
     else
     {
@@ -61,41 +191,99 @@ int main(void)
     for(;;)
     {
         /* Place your application code here. */
-        do
+        // Get the frames acquired since the last iteration
+#if TELEMETRY_MODE == TELEMETRY_STAMPED
+        count = BME280_Stream_ReadStamped(frames, timestamps, BATCH_SIZE);
+#else
+        count = BME280_Stream_Read(frames, BATCH_SIZE);
+#endif
+#if TELEMETRY_MODE == TELEMETRY_RAW
+        for (uint16_t i = 0; i < count; i++)
         {
-            error = BME280_ReadStatusRegister(&status_reg);
-            if (error == BME280_OK && ( (status_reg & 16) == 0))
-            {
-                break;
-            }
-            else
+            // Send raw frames, no compensation on the device
+            BME280_Telemetry_PackRawFrame(&frames[i * BME280_P_T_H_DATA_LEN],
+                sequence++, raw_packet);
+            UART_Debug_PutArray(raw_packet, BME280_TELEMETRY_RAW_PACKET_LEN);
+        }
+#else
+        if (count > 0)
+        {
+            // Parse and compensate all the frames at once
+            BME280_Compensation_ParseFrames(frames, count, uncomp_temperature,
+                uncomp_pressure, uncomp_humidity);
+            BME280_Compensation_Batch(&bme280.comp_coeff, count, uncomp_temperature,
+                uncomp_pressure, uncomp_humidity, temperature, pressure, humidity);
+        }
+        for (uint16_t i = 0; i < count; i++)
+        {
+#if TELEMETRY_MODE == TELEMETRY_DELTA
+            // Send the differences from the previous sample
+            UART_Debug_PutArray(delta_packet, BME280_Telemetry_Encode(&encoder,
+                temperature[i], pressure[i], humidity[i], delta_packet));
+#elif TELEMETRY_MODE == TELEMETRY_SUMMARY
+            // Send the statistics when the window is complete
+            sample.pressure = pressure[i];
+            sample.temperature = temperature[i];
+            sample.humidity = humidity[i];
+            if (BME280_Statistics_Add(&statistics, &sample, &summary))
             {
-                CyDelay(1);
+                BME280_Telemetry_PackSummary(&summary, summary_packet);
+                UART_Debug_PutArray(summary_packet, BME280_TELEMETRY_SUMMARY_PACKET_LEN);
             }
-        } while ( (error!=BME280_OK) || (status_reg & 16));
-
-        error = BME280_ReadData(&bme280, BME280_ALL_COMP);
-        if (error == BME280_OK)
-        {
+#elif TELEMETRY_MODE == TELEMETRY_CHANGE
+            // Send only the samples that differ from the last one sent
+            UART_Debug_PutArray(change_packet, BME280_Telemetry_ReportOnChange(&deadband,
+                temperature[i], pressure[i], humidity[i], change_packet));
+#elif TELEMETRY_MODE == TELEMETRY_STAMPED
+            BME280_Telemetry_PackStamped(timestamps[i], temperature[i], pressure[i],
+                humidity[i], stamped_packet);
+            UART_Debug_PutArray(stamped_packet, BME280_TELEMETRY_STAMPED_PACKET_LEN);
+#else
             // Pressure
-            data_array[2] = ((uint8_t) (bme280.data.pressure >> 24) & 0xFF);
-            data_array[3] = ((uint8_t) (bme280.data.pressure >> 16) & 0xFF);
-            data_array[4] = ((uint8_t) (bme280.data.pressure >> 8) & 0xFF);
-            data_array[5] = ((uint8_t) (bme280.data.pressure) & 0xFF);
+            data_array[2] = ((uint8_t) (pressure[i] >> 24) & 0xFF);
+            data_array[3] = ((uint8_t) (pressure[i] >> 16) & 0xFF);
+            data_array[4] = ((uint8_t) (pressure[i] >> 8) & 0xFF);
+            data_array[5] = ((uint8_t) (pressure[i]) & 0xFF);
             // Temperature
-            data_array[6] = ((uint8_t) (bme280.data.temperature >> 24) & 0xFF);
-            data_array[7] = ((uint8_t) (bme280.data.temperature >> 16) & 0xFF);
-            data_array[8] = ((uint8_t) (bme280.data.temperature >> 8) & 0xFF);
-            data_array[9] = ((uint8_t) (bme280.data.temperature) & 0xFF);
+            data_array[6] = ((uint8_t) (temperature[i] >> 24) & 0xFF);
+            data_array[7] = ((uint8_t) (temperature[i] >> 16) & 0xFF);
+            data_array[8] = ((uint8_t) (temperature[i] >> 8) & 0xFF);
+            data_array[9] = ((uint8_t) (temperature[i]) & 0xFF);
             // Humidity
-            data_array[10] = ((uint8_t) (bme280.data.humidity >> 24) & 0xFF);
-            data_array[11] = ((uint8_t) (bme280.data.humidity >> 16) & 0xFF);
-            data_array[12] = ((uint8_t) (bme280.data.humidity >> 8) & 0xFF);
-            data_array[13] = ((uint8_t) (bme280.data.humidity) & 0xFF);
+            data_array[10] = ((uint8_t) (humidity[i] >> 24) & 0xFF);
+            data_array[11] = ((uint8_t) (humidity[i] >> 16) & 0xFF);
+            data_array[12] = ((uint8_t) (humidity[i] >> 8) & 0xFF);
+            data_array[13] = ((uint8_t) (humidity[i]) & 0xFF);
             UART_Debug_PutArray(data_array, PACKET_SIZE);
+#endif
+        }
+#if ADAPTIVE_SETTINGS
+        for (uint16_t i = 0; i < count; i++)
+        {
+            adaptive_sample.pressure = pressure[i];
+            adaptive_sample.temperature = temperature[i];
+            adaptive_sample.humidity = humidity[i];
+            if (BME280_Adaptive_Update(&adaptive, &adaptive_sample, &settings))
+            {
+                // Only the registers that changed are written, the frames
+                // still in the buffer were measured with the old settings
+                BME280_Stream_Stop();
+                BME280_ApplySettings(&bme280, &settings);
+                sample_period = (BME280_GetSamplePeriod(&bme280) + 999) / 1000;
+                poll_period = sample_period / STREAM_POLLS;
+                BME280_Stream_Start(&bme280, poll_period);
+                break;
+            }
         }
-        else
+#endif
+#endif
+        
+        // Check for failed reads
+        BME280_Stream_GetStats(&stats);
+        if (stats.errors != errors)
         {
+            errors = stats.errors;
+            error = stats.last_error;
             UART_Debug_PutString("Error: ");
             switch(error)
             {
@@ -117,8 +305,32 @@ int main(void)
                 case(BME280_E_NVM_COPY_FAILED):
                     UART_Debug_PutString("BME280_E_NVM_COPY_FAILED\r\n");
                 break;
+                case(BME280_E_BUSY):
+                    UART_Debug_PutString("BME280_E_BUSY\r\n");
+                break;
+            }
+            if (error != BME280_E_BUSY)
+            {
+                // Reset and configure the sensor again
+                BME280_Stream_Stop();
+                BME280_Reset(&bme280);
+                BME280_ApplySettings(&bme280, &settings);
+#if TELEMETRY_MODE == TELEMETRY_RAW
+                BME280_Telemetry_PackCalibration(&bme280, raw_packet);
+                UART_Debug_PutArray(raw_packet, BME280_TELEMETRY_CALIB_PACKET_LEN);
+#elif TELEMETRY_MODE == TELEMETRY_DELTA
+                // Do not send differences across the reset
+                BME280_Telemetry_EncoderInit(&encoder, BME280_TELEMETRY_KEYFRAME_INTERVAL);
+#elif TELEMETRY_MODE == TELEMETRY_SUMMARY
+                // Do not mix samples from before and after the reset
+                BME280_Statistics_Init(&statistics, window);
+#elif TELEMETRY_MODE == TELEMETRY_CHANGE
+                BME280_Telemetry_DeadbandInit(&deadband, BME280_TELEMETRY_DEADBAND_TEMPERATURE,
+                    BME280_TELEMETRY_DEADBAND_PRESSURE, BME280_TELEMETRY_DEADBAND_HUMIDITY, heartbeat);
+#endif
+                BME280_Stream_Start(&bme280, poll_period);
+                errors = 0;
             }
-            BME280_Reset(&bme280);    
         }
 
     }
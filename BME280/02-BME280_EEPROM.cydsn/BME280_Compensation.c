@@ -0,0 +1,659 @@
+/*
+*   This file includes all the required source code to compensate
+*   the raw values of the BME280 sensor.
+*
+*   The backend is selected with #BME280_COMP_BACKEND. The 32 bit
+*   integer backend gives the same results as the formulas in the
+*   datasheet, and the other backends are compared against it.
+*
+*   \author Davide Marzorati
+*/
+
+#include "BME280_Compensation.h"
+
+/******************************************/
+/*               Macros                   */
+/******************************************/
+
+/**
+*   \brief Minimum temperature value in 0.01 degC.
+*/
+#define BME280_COMP_TEMPERATURE_MIN -4000
+
+/**
+*   \brief Maximum temperature value in 0.01 degC.
+*/
+#define BME280_COMP_TEMPERATURE_MAX 8500
+
+/**
+*   \brief Minimum pressure value in Pa.
+*/
+#define BME280_COMP_PRESSURE_MIN 30000
+
+/**
+*   \brief Maximum pressure value in Pa.
+*/
+#define BME280_COMP_PRESSURE_MAX 110000
+
+/**
+*   \brief Maximum humidity value in 1/1024 %RH.
+*/
+#define BME280_COMP_HUMIDITY_MAX 102400
+
+/******************************************/
+/*          Function Prototypes           */
+/******************************************/
+
+#if (BME280_COMP_BACKEND == BME280_COMP_INT32) || (BME280_COMP_BACKEND == BME280_COMP_INT64) \
+    || (BME280_COMP_BACKEND == BME280_COMP_LUT)
+/**
+*   \brief Compute the humidity terms depending only on t_fine.
+*
+*   \param[in] coeff : pointer to compensation coefficients
+*   \param[in] t_fine : fine temperature value
+*
+*   \return Scale factor of the humidity value.
+*/
+static int32_t BME280_Compensation_HumidityScale(const BME280_Comp_Coeff* coeff,
+                                                 int32_t t_fine);
+
+/**
+*   \brief Compute compensated humidity from the scale factor.
+*
+*   \param[in] coeff : pointer to compensation coefficients
+*   \param[in] uncomp_humidity : raw humidity value
+*   \param[in] t_fine : fine temperature value
+*   \param[in] scale : value returned by #BME280_Compensation_HumidityScale
+*
+*   \return Compensated humidity in 1/1024 %RH.
+*/
+static uint32_t BME280_Compensation_HumidityFinal(const BME280_Comp_Coeff* coeff,
+                                                  uint32_t uncomp_humidity,
+                                                  int32_t t_fine, int32_t scale);
+#endif
+
+#if (BME280_COMP_BACKEND == BME280_COMP_INT32) || (BME280_COMP_BACKEND == BME280_COMP_LUT)
+/**
+*   \brief Compute the pressure terms depending only on t_fine.
+*
+*   \param[in] coeff : pointer to compensation coefficients
+*   \param[in] t_fine : fine temperature value
+*   \param[out] divisor : divisor of the pressure value
+*   \param[out] offset : offset of the pressure value
+*/
+static void BME280_Compensation_PressureTerms(const BME280_Comp_Coeff* coeff,
+                                              int32_t t_fine,
+                                              int32_t* divisor, int32_t* offset);
+
+/**
+*   \brief Compute compensated pressure from divisor and offset.
+*
+*   \param[in] coeff : pointer to compensation coefficients
+*   \param[in] uncomp_pressure : raw pressure value
+*   \param[in] divisor : divisor returned by #BME280_Compensation_PressureTerms
+*   \param[in] offset : offset returned by #BME280_Compensation_PressureTerms
+*
+*   \return Compensated pressure in Pa.
+*/
+static uint32_t BME280_Compensation_PressureFinal(const BME280_Comp_Coeff* coeff,
+                                                  uint32_t uncomp_pressure,
+                                                  int32_t divisor, int32_t offset);
+#endif
+
+#if BME280_COMP_BACKEND == BME280_COMP_FLOAT
+/**
+*   \brief Round a floating point value to the nearest integer.
+*/
+static int32_t BME280_Compensation_Round(double value);
+#endif
+
+#if BME280_COMP_BACKEND == BME280_COMP_LUT
+/**
+*   \brief Linear interpolation in a table indexed by t_fine.
+*
+*   \param[in] table : table with #BME280_COMP_LUT_SIZE entries
+*   \param[in] index : index of the entry before t_fine
+*   \param[in] fraction : distance of t_fine from the entry
+*
+*   \return Interpolated value.
+*/
+static int32_t BME280_Compensation_Interpolate(const int32_t* table,
+                                               int32_t index, int32_t fraction);
+#endif
+
+/******************************************/
+/*          Function Definitions          */
+/******************************************/
+
+void BME280_Compensation_Prepare(BME280_Comp_Coeff* coeff,
+                                 const BME280_Calib_Data* calib_data)
+{
+    coeff->t1 = (int32_t)calib_data->dig_T1;
+    coeff->t1_x2 = (int32_t)calib_data->dig_T1 * 2;
+    coeff->t2 = (int32_t)calib_data->dig_T2;
+    coeff->t3 = (int32_t)calib_data->dig_T3;
+    coeff->p1 = (int32_t)calib_data->dig_P1;
+    coeff->p2 = (int32_t)calib_data->dig_P2;
+    coeff->p3 = (int32_t)calib_data->dig_P3;
+    coeff->p4_x65536 = (int32_t)calib_data->dig_P4 * 65536;
+    coeff->p5_x2 = (int32_t)calib_data->dig_P5 * 2;
+    coeff->p6 = (int32_t)calib_data->dig_P6;
+    coeff->p7 = (int32_t)calib_data->dig_P7;
+    coeff->p8 = (int32_t)calib_data->dig_P8;
+    coeff->p9 = (int32_t)calib_data->dig_P9;
+    coeff->h1 = (int32_t)calib_data->dig_H1;
+    coeff->h2 = (int32_t)calib_data->dig_H2;
+    coeff->h3 = (int32_t)calib_data->dig_H3;
+    // Rounding constant of the humidity formula is folded in the offset
+    coeff->h4_offset = (int32_t)calib_data->dig_H4 * 1048576 - 16384;
+    coeff->h5 = (int32_t)calib_data->dig_H5;
+    coeff->h6 = (int32_t)calib_data->dig_H6;
+#if BME280_COMP_BACKEND == BME280_COMP_INT64
+    coeff->p4_x2p35 = (int64_t)calib_data->dig_P4 * 34359738368;
+    coeff->p5_x2p17 = (int64_t)calib_data->dig_P5 * 131072;
+#elif BME280_COMP_BACKEND == BME280_COMP_LUT
+    // Evaluate the 32 bit formulas at each table entry
+    for (int32_t i = 0; i < BME280_COMP_LUT_SIZE; i++)
+    {
+        int32_t t_fine = BME280_COMP_LUT_T_FINE_MIN + (i << BME280_COMP_LUT_STEP_BITS);
+        BME280_Compensation_PressureTerms(coeff, t_fine,
+            &coeff->p_divisor[i], &coeff->p_offset[i]);
+        coeff->h_scale[i] = BME280_Compensation_HumidityScale(coeff, t_fine);
+    }
+#endif
+}
+
+void BME280_Compensation_PackCalibData(const BME280_Calib_Data* calib_data,
+                                       uint8_t* data)
+{
+    data[0] = (uint8_t)(calib_data->dig_T1 >> 8);
+    data[1] = (uint8_t)(calib_data->dig_T1 & 0xFF);
+    data[2] = (uint8_t)(calib_data->dig_T2 >> 8);
+    data[3] = (uint8_t)(calib_data->dig_T2 & 0xFF);
+    data[4] = (uint8_t)(calib_data->dig_T3 >> 8);
+    data[5] = (uint8_t)(calib_data->dig_T3 & 0xFF);
+    data[6] = (uint8_t)(calib_data->dig_P1 >> 8);
+    data[7] = (uint8_t)(calib_data->dig_P1 & 0xFF);
+    data[8] = (uint8_t)(calib_data->dig_P2 >> 8);
+    data[9] = (uint8_t)(calib_data->dig_P2 & 0xFF);
+    data[10] = (uint8_t)(calib_data->dig_P3 >> 8);
+    data[11] = (uint8_t)(calib_data->dig_P3 & 0xFF);
+    data[12] = (uint8_t)(calib_data->dig_P4 >> 8);
+    data[13] = (uint8_t)(calib_data->dig_P4 & 0xFF);
+    data[14] = (uint8_t)(calib_data->dig_P5 >> 8);
+    data[15] = (uint8_t)(calib_data->dig_P5 & 0xFF);
+    data[16] = (uint8_t)(calib_data->dig_P6 >> 8);
+    data[17] = (uint8_t)(calib_data->dig_P6 & 0xFF);
+    data[18] = (uint8_t)(calib_data->dig_P7 >> 8);
+    data[19] = (uint8_t)(calib_data->dig_P7 & 0xFF);
+    data[20] = (uint8_t)(calib_data->dig_P8 >> 8);
+    data[21] = (uint8_t)(calib_data->dig_P8 & 0xFF);
+    data[22] = (uint8_t)(calib_data->dig_P9 >> 8);
+    data[23] = (uint8_t)(calib_data->dig_P9 & 0xFF);
+    data[24] = calib_data->dig_H1;
+    data[25] = (uint8_t)(calib_data->dig_H2 >> 8);
+    data[26] = (uint8_t)(calib_data->dig_H2 & 0xFF);
+    data[27] = calib_data->dig_H3;
+    data[28] = (uint8_t)(calib_data->dig_H4 >> 8);
+    data[29] = (uint8_t)(calib_data->dig_H4 & 0xFF);
+    data[30] = (uint8_t)(calib_data->dig_H5 >> 8);
+    data[31] = (uint8_t)(calib_data->dig_H5 & 0xFF);
+    data[32] = (uint8_t)calib_data->dig_H6;
+}
+
+void BME280_Compensation_UnpackCalibData(BME280_Calib_Data* calib_data,
+                                         const uint8_t* data)
+{
+    calib_data->dig_T1 = (data[0] << 8) | data[1];
+    calib_data->dig_T2 = (int16_t)((data[2] << 8) | data[3]);
+    calib_data->dig_T3 = (int16_t)((data[4] << 8) | data[5]);
+    calib_data->dig_P1 = (data[6] << 8) | data[7];
+    calib_data->dig_P2 = (int16_t)((data[8] << 8) | data[9]);
+    calib_data->dig_P3 = (int16_t)((data[10] << 8) | data[11]);
+    calib_data->dig_P4 = (int16_t)((data[12] << 8) | data[13]);
+    calib_data->dig_P5 = (int16_t)((data[14] << 8) | data[15]);
+    calib_data->dig_P6 = (int16_t)((data[16] << 8) | data[17]);
+    calib_data->dig_P7 = (int16_t)((data[18] << 8) | data[19]);
+    calib_data->dig_P8 = (int16_t)((data[20] << 8) | data[21]);
+    calib_data->dig_P9 = (int16_t)((data[22] << 8) | data[23]);
+    calib_data->dig_H1 = data[24];
+    calib_data->dig_H2 = (int16_t)((data[25] << 8) | data[26]);
+    calib_data->dig_H3 = data[27];
+    calib_data->dig_H4 = (int16_t)((data[28] << 8) | data[29]);
+    calib_data->dig_H5 = (int16_t)((data[30] << 8) | data[31]);
+    calib_data->dig_H6 = (int8_t)data[32];
+    calib_data->t_fine = 0;
+}
+
+void BME280_Compensation_ParseFrames(const uint8_t* restrict frames, uint32_t count,
+                                     int32_t* restrict uncomp_temperature,
+                                     uint32_t* restrict uncomp_pressure,
+                                     uint32_t* restrict uncomp_humidity)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const uint8_t* frame = &frames[i * BME280_COMP_FRAME_LEN];
+        uncomp_pressure[i] = ((uint32_t)frame[0] << 12) | ((uint32_t)frame[1] << 4) 
+                                | ((uint32_t)frame[2] >> 4);
+        uncomp_temperature[i] = (int32_t)(((uint32_t)frame[3] << 12) | ((uint32_t)frame[4] << 4) 
+                                | ((uint32_t)frame[5] >> 4));
+        uncomp_humidity[i] = ((uint32_t)frame[6] << 8) | (uint32_t)frame[7];
+    }
+}
+
+void BME280_Compensation_Batch(const BME280_Comp_Coeff* coeff, uint32_t count,
+                               const int32_t* restrict uncomp_temperature,
+                               const uint32_t* restrict uncomp_pressure,
+                               const uint32_t* restrict uncomp_humidity,
+                               int32_t* restrict temperature,
+                               uint32_t* restrict pressure,
+                               uint32_t* restrict humidity)
+{
+    int32_t t_fine[BME280_COMP_BATCH_BLOCK];
+    uint32_t block;
+
+    for (uint32_t start = 0; start < count; start += block)
+    {
+        block = count - start;
+        if (block > BME280_COMP_BATCH_BLOCK)
+        {
+            block = BME280_COMP_BATCH_BLOCK;
+        }
+        // Temperature first, since the other channels need t_fine
+        {
+            const int32_t* restrict in = &uncomp_temperature[start];
+            int32_t* restrict out = &temperature[start];
+            for (uint32_t i = 0; i < block; i++)
+            {
+                out[i] = BME280_Compensation_Temperature(coeff, in[i], &t_fine[i]);
+            }
+        }
+        if (pressure != NULL)
+        {
+            const uint32_t* restrict in = &uncomp_pressure[start];
+            uint32_t* restrict out = &pressure[start];
+            for (uint32_t i = 0; i < block; i++)
+            {
+                out[i] = BME280_Compensation_Pressure(coeff, in[i], t_fine[i]);
+            }
+        }
+        if (humidity != NULL)
+        {
+            const uint32_t* restrict in = &uncomp_humidity[start];
+            uint32_t* restrict out = &humidity[start];
+            for (uint32_t i = 0; i < block; i++)
+            {
+                out[i] = BME280_Compensation_Humidity(coeff, in[i], t_fine[i]);
+            }
+        }
+    }
+}
+
+#if BME280_COMP_BACKEND != BME280_COMP_FLOAT
+
+int32_t BME280_Compensation_Temperature(const BME280_Comp_Coeff* coeff,
+                                        int32_t uncomp_temperature,
+                                        int32_t* t_fine)
+{
+    // Set up variables
+    int32_t var1;
+    int32_t var2;
+    int32_t temperature;
+
+    var1 = (uncomp_temperature / 8) - coeff->t1_x2;
+    var1 = (var1 * coeff->t2) / 2048;
+    var2 = (uncomp_temperature / 16) - coeff->t1;
+    var2 = (((var2 * var2) / 4096) * coeff->t3) / 16384;
+    *t_fine = var1 + var2;
+    temperature = (*t_fine * 5 + 128 ) / 256;
+    if (temperature < BME280_COMP_TEMPERATURE_MIN)
+        temperature = BME280_COMP_TEMPERATURE_MIN;
+    if (temperature > BME280_COMP_TEMPERATURE_MAX)
+        temperature = BME280_COMP_TEMPERATURE_MAX;
+    return temperature;
+}
+
+uint32_t BME280_Compensation_Humidity(const BME280_Comp_Coeff* coeff,
+                                      uint32_t uncomp_humidity,
+                                      int32_t t_fine)
+{
+#if BME280_COMP_BACKEND == BME280_COMP_LUT
+    int32_t index;
+    int32_t fraction;
+
+    // Position of t_fine in the table, limited to the operating range
+    fraction = t_fine - BME280_COMP_LUT_T_FINE_MIN;
+    if (fraction < 0)
+    {
+        fraction = 0;
+    }
+    else if (fraction > (BME280_COMP_LUT_T_FINE_MAX - BME280_COMP_LUT_T_FINE_MIN))
+    {
+        fraction = BME280_COMP_LUT_T_FINE_MAX - BME280_COMP_LUT_T_FINE_MIN;
+    }
+    index = fraction >> BME280_COMP_LUT_STEP_BITS;
+    fraction &= (1 << BME280_COMP_LUT_STEP_BITS) - 1;
+    return BME280_Compensation_HumidityFinal(coeff, uncomp_humidity, t_fine,
+        BME280_Compensation_Interpolate(coeff->h_scale, index, fraction));
+#else
+    return BME280_Compensation_HumidityFinal(coeff, uncomp_humidity, t_fine,
+        BME280_Compensation_HumidityScale(coeff, t_fine));
+#endif
+}
+
+static int32_t BME280_Compensation_HumidityScale(const BME280_Comp_Coeff* coeff,
+                                                 int32_t t_fine)
+{
+    int32_t var1;
+    int32_t var2;
+    int32_t var3;
+    int32_t var4;
+
+    var1 = t_fine - ((int32_t)76800);
+    var2 = (var1 * coeff->h6) / 1024;
+    var3 = (var1 * coeff->h3) / 2048;
+    var4 = ((var2 * (var3 + (int32_t)32768)) / 1024) + (int32_t)2097152;
+    return ((var4 * coeff->h2) + 8192) / 16384;
+}
+
+static uint32_t BME280_Compensation_HumidityFinal(const BME280_Comp_Coeff* coeff,
+                                                  uint32_t uncomp_humidity,
+                                                  int32_t t_fine, int32_t scale)
+{
+    // Set up variables
+    int32_t var1;
+    int32_t var2;
+    int32_t var3;
+    int32_t var4;
+    int32_t var5;
+    uint32_t humidity;
+
+    var1 = t_fine - ((int32_t)76800);
+    var2 = (int32_t)(uncomp_humidity * 16384);
+    var5 = ((var2 - coeff->h4_offset) - (coeff->h5 * var1)) / 32768;
+    var3 = var5 * scale;
+    var4 = ((var3 / 32768) * (var3 / 32768)) / 128;
+    var5 = var3 - ((var4 * coeff->h1) / 16);
+    var5 = (var5 < 0 ? 0 : var5);
+    var5 = (var5 > 419430400 ? 419430400 : var5);
+    humidity = (uint32_t)(var5 / 4096);
+    if (humidity > BME280_COMP_HUMIDITY_MAX)
+    {
+        humidity = BME280_COMP_HUMIDITY_MAX;
+    }
+
+    return humidity;
+}
+
+#endif
+
+#if BME280_COMP_BACKEND == BME280_COMP_INT32
+
+uint32_t BME280_Compensation_Pressure(const BME280_Comp_Coeff* coeff,
+                                      uint32_t uncomp_pressure,
+                                      int32_t t_fine)
+{
+    int32_t divisor;
+    int32_t offset;
+
+    BME280_Compensation_PressureTerms(coeff, t_fine, &divisor, &offset);
+    return BME280_Compensation_PressureFinal(coeff, uncomp_pressure, divisor, offset);
+}
+
+#elif BME280_COMP_BACKEND == BME280_COMP_LUT
+
+uint32_t BME280_Compensation_Pressure(const BME280_Comp_Coeff* coeff,
+                                      uint32_t uncomp_pressure,
+                                      int32_t t_fine)
+{
+    int32_t index;
+    int32_t fraction;
+
+    // Position of t_fine in the table, limited to the operating range
+    fraction = t_fine - BME280_COMP_LUT_T_FINE_MIN;
+    if (fraction < 0)
+    {
+        fraction = 0;
+    }
+    else if (fraction > (BME280_COMP_LUT_T_FINE_MAX - BME280_COMP_LUT_T_FINE_MIN))
+    {
+        fraction = BME280_COMP_LUT_T_FINE_MAX - BME280_COMP_LUT_T_FINE_MIN;
+    }
+    index = fraction >> BME280_COMP_LUT_STEP_BITS;
+    fraction &= (1 << BME280_COMP_LUT_STEP_BITS) - 1;
+    return BME280_Compensation_PressureFinal(coeff, uncomp_pressure,
+        BME280_Compensation_Interpolate(coeff->p_divisor, index, fraction),
+        BME280_Compensation_Interpolate(coeff->p_offset, index, fraction));
+}
+
+static int32_t BME280_Compensation_Interpolate(const int32_t* table,
+                                               int32_t index, int32_t fraction)
+{
+    return table[index] + (((table[index+1] - table[index]) * fraction)
+                >> BME280_COMP_LUT_STEP_BITS);
+}
+
+#elif BME280_COMP_BACKEND == BME280_COMP_INT64
+
+uint32_t BME280_Compensation_Pressure(const BME280_Comp_Coeff* coeff,
+                                      uint32_t uncomp_pressure,
+                                      int32_t t_fine)
+{
+    // Set up variables
+    int64_t var1;
+    int64_t var2;
+    int64_t var4;
+    uint32_t pressure;
+
+    var1 = ((int64_t)t_fine) - 128000;
+    var2 = var1 * var1 * (int64_t)coeff->p6;
+    var2 = var2 + (var1 * coeff->p5_x2p17);
+    var2 = var2 + coeff->p4_x2p35;
+    var1 = ((var1 * var1 * (int64_t)coeff->p3) / 256) + (var1 * ((int64_t)coeff->p2) * 4096);
+    var1 = ((((int64_t)1) * 140737488355328) + var1) * ((int64_t)coeff->p1) / 8589934592;
+
+    /* avoid exception caused by division by zero */
+    if (var1 != 0)
+    {
+        var4 = 1048576 - (int64_t)uncomp_pressure;
+        var4 = (((var4 * 2147483648) - var2) * 3125) / var1;
+        var1 = (((int64_t)coeff->p9) * (var4 / 8192) * (var4 / 8192)) / 33554432;
+        var2 = (((int64_t)coeff->p8) * var4) / 524288;
+        var4 = ((var4 + var1 + var2) / 256) + (((int64_t)coeff->p7) * 16);
+        // Result is in Pa with 8 fractional bits
+        pressure = (uint32_t)((var4 + 128) / 256);
+        if (pressure < BME280_COMP_PRESSURE_MIN)
+        {
+            pressure = BME280_COMP_PRESSURE_MIN;
+        }
+        else if (pressure > BME280_COMP_PRESSURE_MAX)
+        {
+            pressure = BME280_COMP_PRESSURE_MAX;
+        }
+    }
+    else
+    {
+        pressure = BME280_COMP_PRESSURE_MIN;
+    }
+
+    return pressure;
+}
+
+#endif
+
+#if (BME280_COMP_BACKEND == BME280_COMP_INT32) || (BME280_COMP_BACKEND == BME280_COMP_LUT)
+
+static void BME280_Compensation_PressureTerms(const BME280_Comp_Coeff* coeff,
+                                              int32_t t_fine,
+                                              int32_t* divisor, int32_t* offset)
+{
+    // Set up variables
+    int32_t var1;
+    int32_t var2;
+    int32_t var3;
+    int32_t var4;
+
+    var1 = (t_fine / 2) - (int32_t)64000;
+    // Square term shared by var2 and var3
+    var3 = (var1 / 4) * (var1 / 4);
+    var2 = ((var3 / 2048) * coeff->p6) + (var1 * coeff->p5_x2);
+    var2 = (var2 / 4) + coeff->p4_x65536;
+    var3 = (coeff->p3 * (var3 / 8192)) / 8;
+    var4 = (coeff->p2 * var1) / 2;
+    var1 = (var3 + var4) / 262144;
+    *divisor = ((32768 + var1) * coeff->p1) / 32768;
+    *offset = var2 / 4096;
+}
+
+static uint32_t BME280_Compensation_PressureFinal(const BME280_Comp_Coeff* coeff,
+                                                  uint32_t uncomp_pressure,
+                                                  int32_t divisor, int32_t offset)
+{
+    // Set up variables
+    int32_t var1;
+    int32_t var2;
+    uint32_t var5;
+    uint32_t pressure;
+
+    /* avoid exception caused by division by zero */
+    if (divisor)
+    {
+        var5 = (uint32_t)((uint32_t)1048576) - uncomp_pressure;
+        pressure = ((uint32_t)(var5 - (uint32_t)offset)) * 3125;
+        if (pressure < 0x80000000)
+        {
+            pressure = (pressure << 1) / ((uint32_t)divisor);
+        }
+        else
+        {
+            pressure = (pressure / (uint32_t)divisor) * 2;
+        }
+        var1 = (coeff->p9 * ((int32_t)(((pressure / 8) * (pressure / 8)) / 8192))) / 4096;
+        var2 = (((int32_t)(pressure / 4)) * coeff->p8) / 8192;
+        pressure = (uint32_t)((int32_t)pressure + ((var1 + var2 + coeff->p7) / 16));
+        if (pressure < BME280_COMP_PRESSURE_MIN)
+        {
+            pressure = BME280_COMP_PRESSURE_MIN;
+        }
+        else if (pressure > BME280_COMP_PRESSURE_MAX)
+        {
+            pressure = BME280_COMP_PRESSURE_MAX;
+        }
+    }
+    else
+    {
+        pressure = BME280_COMP_PRESSURE_MIN;
+    }
+
+    return pressure;
+}
+
+#endif
+
+#if BME280_COMP_BACKEND == BME280_COMP_FLOAT
+
+int32_t BME280_Compensation_Temperature(const BME280_Comp_Coeff* coeff,
+                                        int32_t uncomp_temperature,
+                                        int32_t* t_fine)
+{
+    // Set up variables
+    double var1;
+    double var2;
+    int32_t temperature;
+
+    var1 = ((double)uncomp_temperature) / 16384.0 - ((double)coeff->t1) / 1024.0;
+    var1 = var1 * ((double)coeff->t2);
+    var2 = (((double)uncomp_temperature) / 131072.0 - ((double)coeff->t1) / 8192.0);
+    var2 = (var2 * var2) * ((double)coeff->t3);
+    *t_fine = (int32_t)(var1 + var2);
+    // Temperature in degC is (var1 + var2) / 5120
+    temperature = BME280_Compensation_Round((var1 + var2) / 51.2);
+    if (temperature < BME280_COMP_TEMPERATURE_MIN)
+        temperature = BME280_COMP_TEMPERATURE_MIN;
+    if (temperature > BME280_COMP_TEMPERATURE_MAX)
+        temperature = BME280_COMP_TEMPERATURE_MAX;
+    return temperature;
+}
+
+uint32_t BME280_Compensation_Pressure(const BME280_Comp_Coeff* coeff,
+                                      uint32_t uncomp_pressure,
+                                      int32_t t_fine)
+{
+    // Set up variables
+    double var1;
+    double var2;
+    double var3;
+    double pressure;
+    int32_t result = BME280_COMP_PRESSURE_MIN;
+
+    var1 = ((double)t_fine / 2.0) - 64000.0;
+    var2 = var1 * var1 * ((double)coeff->p6) / 32768.0;
+    var2 = var2 + var1 * ((double)coeff->p5_x2);
+    var2 = (var2 / 4.0) + ((double)coeff->p4_x65536);
+    var3 = ((double)coeff->p3) * var1 * var1 / 524288.0;
+    var1 = (var3 + ((double)coeff->p2) * var1) / 524288.0;
+    var1 = (1.0 + var1 / 32768.0) * ((double)coeff->p1);
+
+    /* avoid exception caused by division by zero */
+    if (var1 > 0.0)
+    {
+        pressure = 1048576.0 - (double)uncomp_pressure;
+        pressure = (pressure - (var2 / 4096.0)) * 6250.0 / var1;
+        var1 = ((double)coeff->p9) * pressure * pressure / 2147483648.0;
+        var2 = pressure * ((double)coeff->p8) / 32768.0;
+        pressure = pressure + (var1 + var2 + ((double)coeff->p7)) / 16.0;
+        if (pressure > (double)BME280_COMP_PRESSURE_MAX)
+        {
+            result = BME280_COMP_PRESSURE_MAX;
+        }
+        else if (pressure > (double)BME280_COMP_PRESSURE_MIN)
+        {
+            result = BME280_Compensation_Round(pressure);
+        }
+    }
+
+    return (uint32_t)result;
+}
+
+uint32_t BME280_Compensation_Humidity(const BME280_Comp_Coeff* coeff,
+                                      uint32_t uncomp_humidity,
+                                      int32_t t_fine)
+{
+    // Set up variables
+    double var1;
+    double var2;
+    double var3;
+    double var4;
+    double var5;
+    double var6;
+    double humidity;
+
+    // H4 * 64 is recovered from the offset of the integer formula
+    var1 = ((double)t_fine) - 76800.0;
+    var2 = (((double)coeff->h4_offset + 16384.0) / 16384.0) + (((double)coeff->h5) / 16384.0) * var1;
+    var3 = (double)uncomp_humidity - var2;
+    var4 = ((double)coeff->h2) / 65536.0;
+    var5 = (1.0 + (((double)coeff->h3) / 67108864.0) * var1);
+    var6 = 1.0 + (((double)coeff->h6) / 67108864.0) * var1 * var5;
+    var6 = var3 * var4 * (var5 * var6);
+    humidity = var6 * (1.0 - ((double)coeff->h1) * var6 / 524288.0);
+    if (humidity > 100.0)
+    {
+        humidity = 100.0;
+    }
+    else if (humidity < 0.0)
+    {
+        humidity = 0.0;
+    }
+
+    return (uint32_t)BME280_Compensation_Round(humidity * 1024.0);
+}
+
+static int32_t BME280_Compensation_Round(double value)
+{
+    return (int32_t)(value < 0.0 ? value - 0.5 : value + 0.5);
+}
+
+#endif
+
+/* [] END OF FILE */
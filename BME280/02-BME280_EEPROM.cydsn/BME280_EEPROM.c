@@ -11,39 +11,134 @@
 */
 #include "BME280_EEPROM.h"
 #include "EEPROM_Interface.h"
+#include "CyFlash.h"
 
 #define HEADER_LENGTH 4
 #define HEADER_START_ADDRESS 0
 
-#define COUNTER_LENGTH 2
-#define COUNTER_START_ADDRESS ( HEADER_START_ADDRESS + HEADER_LENGTH )
+// Calibration data: chip id, coefficients, CRC and commit marker in the last three rows
+#define CALIB_COEFF_LENGTH BME280_COMP_CALIB_PACKED_LEN
+#define CALIB_LENGTH ( 1 + CALIB_COEFF_LENGTH + 2 )
+#define CALIB_START_ADDRESS ( CY_EEPROM_SIZE - 3 * CY_EEPROM_SIZEOF_ROW )
 
-#define DATA_LENGTH 8
-#define DATA_START_ADDRESS ( COUNTER_START_ADDRESS + COUNTER_LENGTH )
+// Circular log of blocks of rows, after the header up to the calibration data
+#define LOG_START_ROW 1
+#define LOG_ROWS ( CALIB_START_ADDRESS / CY_EEPROM_SIZEOF_ROW - LOG_START_ROW )
+#define BLOCK_ROWS 4
+#define BLOCK_LENGTH ( BLOCK_ROWS * CY_EEPROM_SIZEOF_ROW )
+#define LOG_BLOCKS ( LOG_ROWS / BLOCK_ROWS )
+
+// Row: 16-bit slots (MSB first), then the CRC and the tag of the row
+#define ROW_DATA_LENGTH ( CY_EEPROM_SIZEOF_ROW - 2 )
+#define ROW_CRC ( CY_EEPROM_SIZEOF_ROW - 2 )
+#define ROW_TAG ( CY_EEPROM_SIZEOF_ROW - 1 )
+#define ROW_SLOTS ( ROW_DATA_LENGTH / 2 )
+#define BLOCK_SLOTS ( BLOCK_ROWS * ROW_SLOTS )
+
+// Tag: commit marker in the MSB, sequence number of the block in the
+// low bits. The CRC-8 (x^8 + x^5 + x^3 + x^2 + x + 1) covers the row,
+// its tag, and its number. Rows are programmed from the first byte, so
+// a row torn or erased by a power failure has the tag still erased (0),
+// without the marker. The calibration data end in the same way
+#define TAG_COMMIT 0x80
+#define SEQUENCE_MASK 0x7F
+
+// A keyframe takes three slots; after the first sample it follows SLOT_KEYFRAME
+#define KEYFRAME_SLOTS 3
+#define SLOT_EMPTY 0x0000
+#define SLOT_KEYFRAME 0xFFFF
+// Keyframe: temperature plus offset (14 bits), pressure and humidity (17 bits)
+#define KEYFRAME_T_OFFSET 4000
+#define KEYFRAME_T_MAX ( 0x3FFF - KEYFRAME_T_OFFSET )
+#define KEYFRAME_PH_MAX 0x1FFFFu
+// Delta from the previous sample plus half range: temperature, pressure, humidity
+#define DELTA_T_BITS 4
+#define DELTA_P_BITS 5
+#define DELTA_H_BITS 7
+#define DELTA_T_HALF ( 1 << (DELTA_T_BITS - 1) )
+#define DELTA_P_HALF ( 1 << (DELTA_P_BITS - 1) )
+#define DELTA_H_HALF ( 1 << (DELTA_H_BITS - 1) )
+
+// Decode all the samples of a block
+#define DECODE_ALL 0xFF
+// Samples of a block not decoded since start up
+#define BLOCK_UNCOUNTED 0xFF
 
 static EEPROM_ErrorCode BME280_EEPROM_CheckHeader(void);
-static EEPROM_ErrorCode BME280_EEPROM_WriteHeader(void);
-static EEPROM_ErrorCode BME280_EEPROM_WriteCounter(uint16_t counter);
-static EEPROM_ErrorCode BME280_EEPROM_ReadCounter(uint16_t* counter);
+static EEPROM_ErrorCode BME280_EEPROM_Format(void);
+static void BME280_EEPROM_Scan(void);
+static uint8_t BME280_EEPROM_ReadSequence(uint8_t block, uint8_t* sequence);
+static void BME280_EEPROM_CountSamples(void);
+static uint8_t BME280_EEPROM_ReadBlock(uint8_t block, uint8_t* image);
+static uint8_t BME280_EEPROM_Decode(const uint8_t* image, uint8_t rows, uint8_t index,
+    BME280_Data* data, uint8_t* slots);
+static uint16_t BME280_EEPROM_Delta(const BME280_Data* sample);
+static void BME280_EEPROM_PutKeyframe(const BME280_Data* sample);
+static void BME280_EEPROM_PutSlot(uint16_t slot);
+static uint16_t BME280_EEPROM_GetSlot(const uint8_t* image, uint8_t slot);
+static uint8_t BME280_EEPROM_DataOffset(uint8_t index);
+static uint8_t BME280_EEPROM_RowCrc(const uint8_t* image, uint8_t row);
+static uint8_t BME280_EEPROM_RowValid(const uint8_t* image, uint8_t row, uint8_t sequence);
+static void BME280_EEPROM_StartBlock(void);
+static EEPROM_ErrorCode BME280_EEPROM_CommitRows(uint8_t all);
+static uint8_t BME280_EEPROM_Crc(uint8_t crc, const uint8_t* data, uint8_t len);
 
-const uint8_t HEADER[HEADER_LENGTH] = {0xA0,0xC0,0xA1,0xC1};
+// Changed with the format of the log, so that old logs are formatted again
+const uint8_t HEADER[HEADER_LENGTH] = {0xA0,0xC0,0xA1,0xC5};
+
+// CRC-8 of each byte
+static const uint8_t CRC_TABLE[256] = {
+    0x00, 0x2F, 0x5E, 0x71, 0xBC, 0x93, 0xE2, 0xCD, 0x57, 0x78, 0x09, 0x26, 0xEB, 0xC4, 0xB5, 0x9A,
+    0xAE, 0x81, 0xF0, 0xDF, 0x12, 0x3D, 0x4C, 0x63, 0xF9, 0xD6, 0xA7, 0x88, 0x45, 0x6A, 0x1B, 0x34,
+    0x73, 0x5C, 0x2D, 0x02, 0xCF, 0xE0, 0x91, 0xBE, 0x24, 0x0B, 0x7A, 0x55, 0x98, 0xB7, 0xC6, 0xE9,
+    0xDD, 0xF2, 0x83, 0xAC, 0x61, 0x4E, 0x3F, 0x10, 0x8A, 0xA5, 0xD4, 0xFB, 0x36, 0x19, 0x68, 0x47,
+    0xE6, 0xC9, 0xB8, 0x97, 0x5A, 0x75, 0x04, 0x2B, 0xB1, 0x9E, 0xEF, 0xC0, 0x0D, 0x22, 0x53, 0x7C,
+    0x48, 0x67, 0x16, 0x39, 0xF4, 0xDB, 0xAA, 0x85, 0x1F, 0x30, 0x41, 0x6E, 0xA3, 0x8C, 0xFD, 0xD2,
+    0x95, 0xBA, 0xCB, 0xE4, 0x29, 0x06, 0x77, 0x58, 0xC2, 0xED, 0x9C, 0xB3, 0x7E, 0x51, 0x20, 0x0F,
+    0x3B, 0x14, 0x65, 0x4A, 0x87, 0xA8, 0xD9, 0xF6, 0x6C, 0x43, 0x32, 0x1D, 0xD0, 0xFF, 0x8E, 0xA1,
+    0xE3, 0xCC, 0xBD, 0x92, 0x5F, 0x70, 0x01, 0x2E, 0xB4, 0x9B, 0xEA, 0xC5, 0x08, 0x27, 0x56, 0x79,
+    0x4D, 0x62, 0x13, 0x3C, 0xF1, 0xDE, 0xAF, 0x80, 0x1A, 0x35, 0x44, 0x6B, 0xA6, 0x89, 0xF8, 0xD7,
+    0x90, 0xBF, 0xCE, 0xE1, 0x2C, 0x03, 0x72, 0x5D, 0xC7, 0xE8, 0x99, 0xB6, 0x7B, 0x54, 0x25, 0x0A,
+    0x3E, 0x11, 0x60, 0x4F, 0x82, 0xAD, 0xDC, 0xF3, 0x69, 0x46, 0x37, 0x18, 0xD5, 0xFA, 0x8B, 0xA4,
+    0x05, 0x2A, 0x5B, 0x74, 0xB9, 0x96, 0xE7, 0xC8, 0x52, 0x7D, 0x0C, 0x23, 0xEE, 0xC1, 0xB0, 0x9F,
+    0xAB, 0x84, 0xF5, 0xDA, 0x17, 0x38, 0x49, 0x66, 0xFC, 0xD3, 0xA2, 0x8D, 0x40, 0x6F, 0x1E, 0x31,
+    0x76, 0x59, 0x28, 0x07, 0xCA, 0xE5, 0x94, 0xBB, 0x21, 0x0E, 0x7F, 0x50, 0x9D, 0xB2, 0xC3, 0xEC,
+    0xD8, 0xF7, 0x86, 0xA9, 0x64, 0x4B, 0x3A, 0x15, 0x8F, 0xA0, 0xD1, 0xFE, 0x33, 0x1C, 0x6D, 0x42
+};
+
+// Block being written, and its copy in RAM
+static uint8_t block_buffer[BLOCK_LENGTH];
+static uint8_t head_block = LOG_BLOCKS - 1;
+static uint8_t block_sequence = 0;
+// Slots used in the block being written, BLOCK_SLOTS when it is closed.
+// After a flush, the partially filled row is closed
+static uint8_t block_slots = BLOCK_SLOTS;
+// Rows of the block changed since they were queued
+static uint8_t dirty_rows = 0;
+// Blocks in the log, including the one being written
+static uint8_t block_count = 0;
+// Samples in each block, BLOCK_UNCOUNTED until the block is first read
+static uint8_t block_samples[LOG_BLOCKS];
+// Samples in the counted blocks, including the ones still in RAM
+static uint16_t record_count = 0;
+// Last sample written, as decoded
+static BME280_Data last_sample;
 
 EEPROM_ErrorCode BME280_EEPROM_Start(void)
 {
     EEPROM_ErrorCode error;
     error = EEPROM_Interface_Start();  
-    if ( error == EEPROM_OK)
+    if ( error == EEPROM_OK && dirty_rows == 0)
     {
         error = BME280_EEPROM_CheckHeader();
         if ( error == EEPROM_E_HEADER)
         {
-            // Write header
-            error = BME280_EEPROM_WriteHeader();
-            if ( error == EEPROM_OK)
-            {
-                // Reset everything
-                error = BME280_EEPROM_WriteCounter(0);
-            }
+            error = BME280_EEPROM_Format();
+        }
+        if ( error == EEPROM_OK)
+        {
+            // Find the last block written
+            BME280_EEPROM_Scan();
         }
     }
     
@@ -54,34 +149,183 @@ EEPROM_ErrorCode BME280_EEPROM_Start(void)
 EEPROM_ErrorCode BME280_EEPROM_Stop(void)
 {
     EEPROM_ErrorCode error;
-    error = EEPROM_Interface_Stop();
+    error = BME280_EEPROM_Flush();
+    if ( error == EEPROM_OK)
+    {
+        error = EEPROM_Interface_Stop();
+    }
     return error;
 }
 
 EEPROM_ErrorCode BME280_EEPROM_WriteData(BME280* bme280)
 {
     EEPROM_ErrorCode error;
-    uint16_t counter;
-    error = BME280_EEPROM_ReadCounter(&counter);
-    if ( error == EEPROM_OK)
+    BME280_Data sample;
+    uint16_t delta;
+    uint8_t needed;
+
+    // Keep the values in the range of a keyframe
+    sample.temperature = bme280->data.temperature;
+    if ( sample.temperature < -KEYFRAME_T_OFFSET)
+    {
+        sample.temperature = -KEYFRAME_T_OFFSET;
+    }
+    else if ( sample.temperature > KEYFRAME_T_MAX)
+    {
+        sample.temperature = KEYFRAME_T_MAX;
+    }
+    sample.pressure = (bme280->data.pressure > KEYFRAME_PH_MAX) ? KEYFRAME_PH_MAX : bme280->data.pressure;
+    sample.humidity = (bme280->data.humidity > KEYFRAME_PH_MAX) ? KEYFRAME_PH_MAX : bme280->data.humidity;
+    delta = BME280_EEPROM_Delta(&sample);
+    needed = (delta == SLOT_KEYFRAME) ? KEYFRAME_SLOTS + 1 : 1;
+
+    // Rows filled by previous records must be queued before the next record
+    error = BME280_EEPROM_CommitRows(0);
+    if ( error == EEPROM_OK && block_slots + needed > BLOCK_SLOTS)
     {
-        uint8_t data_array[DATA_LENGTH];
-        data_array[0] = ((uint8_t)(bme280->data.temperature >> 24));
-        data_array[1] = ((uint8_t)(bme280->data.temperature >> 16));
-        data_array[2] = ((uint8_t)(bme280->data.temperature >> 8));
-        data_array[3] = ((uint8_t)(bme280->data.temperature & 0xFF));
-        data_array[4] = ((uint8_t)(bme280->data.humidity >> 24));
-        data_array[5] = ((uint8_t)(bme280->data.humidity >> 16));
-        data_array[6] = ((uint8_t)(bme280->data.humidity >> 8));
-        data_array[7] = ((uint8_t)(bme280->data.humidity & 0xFF));
-        error = EEPROM_Interface_WriteBytes(data_array, DATA_LENGTH,
-            DATA_START_ADDRESS + counter * DATA_LENGTH);
+        // Close the block, then start the next one with a keyframe
+        block_slots = BLOCK_SLOTS;
+        error = BME280_EEPROM_CommitRows(0);
         if ( error == EEPROM_OK)
         {
-            error = BME280_EEPROM_WriteCounter(counter+1);
+            BME280_EEPROM_StartBlock();
+        }
+    }
+    if ( error != EEPROM_OK)
+    {
+        return error;
+    }
+
+    if ( block_slots == 0)
+    {
+        BME280_EEPROM_PutKeyframe(&sample);
+    }
+    else
+    {
+        BME280_EEPROM_PutSlot(delta);
+        if ( delta == SLOT_KEYFRAME)
+        {
+            // The delta does not fit
+            BME280_EEPROM_PutKeyframe(&sample);
         }
     }
+    last_sample = sample;
+    block_samples[head_block]++;
+    record_count++;
+
+    // Full rows are programmed at once, in background
+    BME280_EEPROM_CommitRows(0);
+
+    return EEPROM_OK;
+}
+
+EEPROM_ErrorCode BME280_EEPROM_Process(void)
+{
+    EEPROM_ErrorCode error;
+    error = EEPROM_Interface_Process();
+    // Retry the full rows that found the queue full
+    BME280_EEPROM_CommitRows(0);
+    return error;
+}
+
+EEPROM_ErrorCode BME280_EEPROM_Flush(void)
+{
+    EEPROM_ErrorCode error;
+    while ( (error = BME280_EEPROM_CommitRows(1)) == EEPROM_E_BUSY)
+    {
+        EEPROM_Interface_Process();
+    }
+    if ( error == EEPROM_OK)
+    {
+        error = EEPROM_Interface_Wait();
+    }
+    if ( error == EEPROM_OK && block_slots % ROW_SLOTS != 0)
+    {
+        // The programmed row is never programmed again: the next samples
+        // start from the next row, the empty slots are skipped
+        block_slots += ROW_SLOTS - block_slots % ROW_SLOTS;
+    }
+    return error;
+}
+
+uint16_t BME280_EEPROM_GetCount(void)
+{
+    BME280_EEPROM_CountSamples();
+    return record_count;
+}
+
+EEPROM_ErrorCode BME280_EEPROM_ReadData(uint16_t index, BME280_Data* data)
+{
+    EEPROM_ErrorCode error = EEPROM_E_ADDR;
+    uint8_t image[BLOCK_LENGTH];
+    uint8_t rows = BLOCK_ROWS;
+    uint8_t slots;
+
+    BME280_EEPROM_CountSamples();
+    if ( index < record_count)
+    {
+        // Index 0 is the first sample of the oldest block
+        uint8_t block = (head_block + LOG_BLOCKS + 1 - block_count) % LOG_BLOCKS;
+        while ( index >= block_samples[block])
+        {
+            index -= block_samples[block];
+            block = (block + 1) % LOG_BLOCKS;
+        }
+        if ( block == head_block)
+        {
+            // The block being written is read from RAM
+            for (uint8_t i = 0; i < BLOCK_LENGTH; i++)
+            {
+                image[i] = block_buffer[i];
+            }
+        }
+        else
+        {
+            rows = BME280_EEPROM_ReadBlock(block, image);
+        }
+        error = EEPROM_E_CHECKSUM;
+        if ( BME280_EEPROM_Decode(image, rows, index, data, &slots) > index)
+        {
+            error = EEPROM_OK;
+        }
+    }
+    return error;
+}
+
+EEPROM_ErrorCode BME280_EEPROM_WriteCalibData(BME280* bme280)
+{
+    BME280_Calib_Data* calib_data = &bme280->calib_data;
+    uint8_t data_array[CALIB_LENGTH];
+    
+    // Chip id followed by coefficients, MSB first
+    data_array[0] = bme280->chip_id;
+    BME280_Compensation_PackCalibData(calib_data, &data_array[1]);
+    // The last byte is programmed last, with the commit marker
+    data_array[CALIB_LENGTH-1] = TAG_COMMIT;
+    data_array[CALIB_LENGTH-2] = BME280_EEPROM_Crc(0, data_array, CALIB_LENGTH-2);
     
+    return EEPROM_Interface_WriteBytes(data_array, CALIB_LENGTH, CALIB_START_ADDRESS);
+}
+
+EEPROM_ErrorCode BME280_EEPROM_ReadCalibData(BME280_Calib_Data* calib_data)
+{
+    EEPROM_ErrorCode error;
+    uint8_t data_array[CALIB_LENGTH];
+    
+    error = EEPROM_Interface_ReadBytes(data_array, CALIB_LENGTH, CALIB_START_ADDRESS);
+    if ( error == EEPROM_OK)
+    {
+        // Check that data were written for this sensor and are not corrupted
+        if ( (data_array[0] != BME280_WHO_AM_I) || (data_array[CALIB_LENGTH-1] != TAG_COMMIT) ||
+            (BME280_EEPROM_Crc(0, data_array, CALIB_LENGTH-2) != data_array[CALIB_LENGTH-2]))
+        {
+            error = EEPROM_E_CHECKSUM;
+        }
+    }
+    if ( error == EEPROM_OK)
+    {
+        BME280_Compensation_UnpackCalibData(calib_data, &data_array[1]);
+    }
     return error;
 }
 
@@ -106,29 +350,314 @@ static EEPROM_ErrorCode BME280_EEPROM_CheckHeader(void)
     }
     return error;
 }
-static EEPROM_ErrorCode BME280_EEPROM_WriteHeader(void)
+static EEPROM_ErrorCode BME280_EEPROM_Format(void)
 {
-    EEPROM_ErrorCode error;
-    
-    error = EEPROM_Interface_WriteBytes(HEADER, HEADER_LENGTH, HEADER_START_ADDRESS);
+    EEPROM_ErrorCode error = EEPROM_OK;
+    uint8_t row_data[CY_EEPROM_SIZEOF_ROW] = {0};
     
+    // Erase the log first, the header is written only if it was erased
+    for (uint16_t row = 0; row < LOG_ROWS && error == EEPROM_OK; row++)
+    {
+        error = EEPROM_Interface_WriteRow(row_data, LOG_START_ROW + row);
+    }
+    if ( error == EEPROM_OK)
+    {
+        error = EEPROM_Interface_WriteBytes(HEADER, HEADER_LENGTH, HEADER_START_ADDRESS);
+    }
     return error;
 }
-static EEPROM_ErrorCode BME280_EEPROM_WriteCounter(uint16_t counter)
+static void BME280_EEPROM_Scan(void)
 {
-    EEPROM_ErrorCode error;
-    uint8_t counter_array [] = { (uint8_t)counter >> 8, (uint8_t)counter & 0xFF};
-    error = EEPROM_Interface_WriteBytes(counter_array, COUNTER_LENGTH, COUNTER_START_ADDRESS);
-    
-    return error;
+    uint8_t image[BLOCK_LENGTH];
+    uint8_t first = 0;
+    uint8_t first_sequence;
+    uint8_t sequence;
+    uint8_t valid;
+
+    head_block = LOG_BLOCKS - 1;
+    block_sequence = 0;
+    block_slots = BLOCK_SLOTS;
+    block_count = 0;
+    record_count = 0;
+    dirty_rows = 0;
+
+    // The first block is not valid if it was being written over when the power failed
+    valid = BME280_EEPROM_ReadSequence(first, &first_sequence);
+    if ( valid == 0)
+    {
+        first++;
+        valid = BME280_EEPROM_ReadSequence(first, &first_sequence);
+    }
+    if ( valid)
+    {
+        uint8_t low = first;
+        uint8_t high = LOG_BLOCKS - 1;
+        uint8_t rows;
+        uint8_t slots;
+        BME280_Data data;
+
+        // The blocks written in the same lap as the first one follow its
+        // sequence number: binary search of the last one, the head
+        while ( low < high)
+        {
+            uint8_t mid = (low + high + 1) / 2;
+            if ( BME280_EEPROM_ReadSequence(mid, &sequence) &&
+                sequence == ((first_sequence + mid - first) & SEQUENCE_MASK))
+            {
+                low = mid;
+            }
+            else
+            {
+                high = mid - 1;
+            }
+        }
+        head_block = low;
+        block_sequence = (first_sequence + low - first) & SEQUENCE_MASK;
+
+        // After the head, the blocks of the previous lap, if the log is
+        // full (the first one may have been being written over)
+        block_count = low - first + 1;
+        if ( BME280_EEPROM_ReadSequence((low + 1) % LOG_BLOCKS, &sequence) &&
+            sequence == ((block_sequence + 1 - LOG_BLOCKS) & SEQUENCE_MASK))
+        {
+            block_count = LOG_BLOCKS;
+        }
+        else if ( BME280_EEPROM_ReadSequence((low + 2) % LOG_BLOCKS, &sequence) &&
+            sequence == ((block_sequence + 2 - LOG_BLOCKS) & SEQUENCE_MASK))
+        {
+            block_count = LOG_BLOCKS - 1;
+        }
+        for (uint8_t block = 0; block < LOG_BLOCKS; block++)
+        {
+            block_samples[block] = BLOCK_UNCOUNTED;
+        }
+
+        // Keep writing the head block after its valid rows, which are never
+        // programmed again; the other blocks are counted when the log is
+        // first read
+        rows = BME280_EEPROM_ReadBlock(head_block, image);
+        block_samples[head_block] = BME280_EEPROM_Decode(image, rows, DECODE_ALL, &data, &slots);
+        record_count = block_samples[head_block];
+        for (uint8_t i = 0; i < BLOCK_LENGTH; i++)
+        {
+            block_buffer[i] = (i < rows * CY_EEPROM_SIZEOF_ROW) ? image[i] : 0;
+        }
+        block_slots = rows * ROW_SLOTS;
+        if ( slots != block_slots)
+        {
+            // A keyframe continues in a torn row, close the block
+            block_slots = BLOCK_SLOTS;
+        }
+        last_sample = data;
+    }
 }
-static EEPROM_ErrorCode BME280_EEPROM_ReadCounter(uint16_t* counter)
+static uint8_t BME280_EEPROM_ReadSequence(uint8_t block, uint8_t* sequence)
 {
-    EEPROM_ErrorCode error;
-    uint8_t counter_array [2];
-    error = EEPROM_Interface_ReadBytes(counter_array, COUNTER_LENGTH, COUNTER_START_ADDRESS);
-    *counter  = (counter_array[0] << 8) | (counter_array[1] & 0xFF);
+    uint8_t row[CY_EEPROM_SIZEOF_ROW];
+
+    // Only the first row of the block is read
+    EEPROM_Interface_ReadBytes(row, CY_EEPROM_SIZEOF_ROW,
+        (LOG_START_ROW + block * BLOCK_ROWS) * CY_EEPROM_SIZEOF_ROW);
+    *sequence = row[ROW_TAG] & SEQUENCE_MASK;
+    return BME280_EEPROM_RowValid(row, 0, *sequence);
+}
+static void BME280_EEPROM_CountSamples(void)
+{
+    uint8_t image[BLOCK_LENGTH];
+    uint8_t slots;
+    BME280_Data data;
+
+    for (uint8_t i = 1; i < block_count; i++)
+    {
+        uint8_t block = (head_block + LOG_BLOCKS - i) % LOG_BLOCKS;
+        if ( block_samples[block] == BLOCK_UNCOUNTED)
+        {
+            uint8_t rows = BME280_EEPROM_ReadBlock(block, image);
+            block_samples[block] = BME280_EEPROM_Decode(image, rows, DECODE_ALL, &data, &slots);
+            record_count += block_samples[block];
+        }
+    }
+}
+static uint8_t BME280_EEPROM_ReadBlock(uint8_t block, uint8_t* image)
+{
+    uint8_t rows = 0;
+    uint8_t sequence;
+
+    EEPROM_Interface_ReadBytes(image, BLOCK_LENGTH,
+        (LOG_START_ROW + block * BLOCK_ROWS) * CY_EEPROM_SIZEOF_ROW);
+    // Rows are valid up to the first one torn, left from an older block,
+    // or with a wrong CRC, in a single pass
+    sequence = image[ROW_TAG] & SEQUENCE_MASK;
+    while ( rows < BLOCK_ROWS && BME280_EEPROM_RowValid(image, rows, sequence))
+    {
+        rows++;
+    }
+    return rows;
+}
+static uint8_t BME280_EEPROM_Decode(const uint8_t* image, uint8_t rows, uint8_t index,
+    BME280_Data* data, uint8_t* slots)
+{
+    uint8_t count = 0;
+    uint8_t slot = 0;
+    uint8_t limit;
+
+    // Only slots in valid rows are decoded
+    limit = rows * ROW_SLOTS;
+    while ( slot < limit && count <= index)
+    {
+        uint16_t code = BME280_EEPROM_GetSlot(image, slot);
+        if ( count == 0 || code == SLOT_KEYFRAME)
+        {
+            // The first sample of a block is a keyframe without marker
+            uint8_t first = slot + (count > 0);
+            if ( first + KEYFRAME_SLOTS > limit)
+            {
+                break;
+            }
+            uint16_t t_p = BME280_EEPROM_GetSlot(image, first);
+            uint16_t p_h = BME280_EEPROM_GetSlot(image, first + 1);
+            data->temperature = (int32_t)(t_p >> 2) - KEYFRAME_T_OFFSET;
+            data->pressure = ((uint32_t)(t_p & 0x03) << 15) | (p_h >> 1);
+            data->humidity = ((uint32_t)(p_h & 0x01) << 16) | BME280_EEPROM_GetSlot(image, first + 2);
+            slot = first + KEYFRAME_SLOTS;
+        }
+        else if ( code == SLOT_EMPTY)
+        {
+            // Rest of a row closed by a flush
+            slot += ROW_SLOTS - slot % ROW_SLOTS;
+            continue;
+        }
+        else
+        {
+            data->temperature += (int32_t)(code >> (DELTA_P_BITS + DELTA_H_BITS)) - DELTA_T_HALF;
+            data->pressure += (int32_t)((code >> DELTA_H_BITS) & ((1 << DELTA_P_BITS) - 1)) - DELTA_P_HALF;
+            data->humidity += (int32_t)(code & ((1 << DELTA_H_BITS) - 1)) - DELTA_H_HALF;
+            slot++;
+        }
+        count++;
+    }
+    *slots = slot;
+    return count;
+}
+static uint16_t BME280_EEPROM_Delta(const BME280_Data* sample)
+{
+    int32_t t = sample->temperature - last_sample.temperature + DELTA_T_HALF;
+    int32_t p = (int32_t)(sample->pressure - last_sample.pressure) + DELTA_P_HALF;
+    int32_t h = (int32_t)(sample->humidity - last_sample.humidity) + DELTA_H_HALF;
+    uint16_t code = SLOT_KEYFRAME;
+
+    if ( t >= 0 && t < 2 * DELTA_T_HALF && p >= 0 && p < 2 * DELTA_P_HALF &&
+        h >= 0 && h < 2 * DELTA_H_HALF)
+    {
+        code = (uint16_t)((t << (DELTA_P_BITS + DELTA_H_BITS)) | (p << DELTA_H_BITS) | h);
+        // The largest deltas are SLOT_KEYFRAME, the smallest are stored as a keyframe
+        if ( code == SLOT_EMPTY)
+        {
+            code = SLOT_KEYFRAME;
+        }
+    }
+    return code;
+}
+static void BME280_EEPROM_PutKeyframe(const BME280_Data* sample)
+{
+    uint16_t t = (uint16_t)(sample->temperature + KEYFRAME_T_OFFSET);
+
+    BME280_EEPROM_PutSlot((uint16_t)((t << 2) | (sample->pressure >> 15)));
+    BME280_EEPROM_PutSlot((uint16_t)(((sample->pressure & 0x7FFF) << 1) | (sample->humidity >> 16)));
+    BME280_EEPROM_PutSlot((uint16_t)(sample->humidity & 0xFFFF));
+}
+static void BME280_EEPROM_PutSlot(uint16_t slot)
+{
+    uint8_t msb = BME280_EEPROM_DataOffset(2 * block_slots);
+    uint8_t lsb = BME280_EEPROM_DataOffset(2 * block_slots + 1);
+
+    block_buffer[msb] = (uint8_t)(slot >> 8);
+    block_buffer[lsb] = (uint8_t)(slot & 0xFF);
+    dirty_rows |= (1 << (msb / CY_EEPROM_SIZEOF_ROW)) | (1 << (lsb / CY_EEPROM_SIZEOF_ROW));
+    block_slots++;
+}
+static uint16_t BME280_EEPROM_GetSlot(const uint8_t* image, uint8_t slot)
+{
+    return (uint16_t)((image[BME280_EEPROM_DataOffset(2 * slot)] << 8) |
+        image[BME280_EEPROM_DataOffset(2 * slot + 1)]);
+}
+static uint8_t BME280_EEPROM_DataOffset(uint8_t index)
+{
+    // Skip the CRC and the tag at the end of each row
+    return index + 2 * (index / ROW_DATA_LENGTH);
+}
+static uint8_t BME280_EEPROM_RowCrc(const uint8_t* image, uint8_t row)
+{
+    const uint8_t* data = &image[row * CY_EEPROM_SIZEOF_ROW];
+    uint8_t tag[2] = {data[ROW_TAG], row};
+    uint8_t crc;
+
+    // Also the tag and the row number, so that rows left from an older
+    // block are not valid
+    crc = BME280_EEPROM_Crc(0, data, ROW_DATA_LENGTH);
+    return BME280_EEPROM_Crc(crc, tag, 2);
+}
+static uint8_t BME280_EEPROM_RowValid(const uint8_t* image, uint8_t row, uint8_t sequence)
+{
+    const uint8_t* data = &image[row * CY_EEPROM_SIZEOF_ROW];
+
+    return ( data[ROW_TAG] == (TAG_COMMIT | sequence) &&
+        data[ROW_CRC] == BME280_EEPROM_RowCrc(image, row));
+}
+static void BME280_EEPROM_StartBlock(void)
+{
+    head_block = (head_block + 1) % LOG_BLOCKS;
+    block_sequence = (block_sequence + 1) & SEQUENCE_MASK;
+    // The oldest block is overwritten
+    if ( block_count == LOG_BLOCKS)
+    {
+        if ( block_samples[head_block] != BLOCK_UNCOUNTED)
+        {
+            record_count -= block_samples[head_block];
+        }
+    }
+    else
+    {
+        block_count++;
+    }
+    block_samples[head_block] = 0;
+    for (uint8_t i = 0; i < BLOCK_LENGTH; i++)
+    {
+        block_buffer[i] = 0;
+    }
+    block_slots = 0;
+}
+static EEPROM_ErrorCode BME280_EEPROM_CommitRows(uint8_t all)
+{
+    EEPROM_ErrorCode error = EEPROM_OK;
+
+    for (uint8_t row = 0; row < BLOCK_ROWS && error == EEPROM_OK; row++)
+    {
+        // A row is full when the slots reach the next row, or the block is closed
+        uint8_t full = (block_slots >= (row + 1) * ROW_SLOTS);
+        if ( (dirty_rows & (1 << row)) && (all || full))
+        {
+            block_buffer[row * CY_EEPROM_SIZEOF_ROW + ROW_TAG] = TAG_COMMIT | block_sequence;
+            block_buffer[row * CY_EEPROM_SIZEOF_ROW + ROW_CRC] =
+                BME280_EEPROM_RowCrc(block_buffer, row);
+            error = EEPROM_Interface_QueueRow(&block_buffer[row * CY_EEPROM_SIZEOF_ROW],
+                LOG_START_ROW + head_block * BLOCK_ROWS + row);
+            if ( error == EEPROM_OK)
+            {
+                dirty_rows &= ~(1 << row);
+            }
+        }
+    }
     return error;
 }
+static uint8_t BME280_EEPROM_Crc(uint8_t crc, const uint8_t* data, uint8_t len)
+{
+    // Table driven, one lookup per byte; crc is the CRC of the previous bytes
+    for (uint8_t i = 0; i < len; i++)
+    {
+        crc = CRC_TABLE[crc ^ data[i]];
+    }
+    return crc;
+}
 
 /* [] END OF FILE */
@@ -3,6 +3,24 @@
 *
 *   \brief Header file with function declarations to write BME280 data to EEPROM.
 *
+*   Samples are stored in a circular log that takes all the rows between
+*   the header (first row) and the calibration data (last three rows),
+*   in blocks of four rows. Each row ends with a table-driven CRC-8 of
+*   the row, of its tag, and of its number, and with the tag: a commit
+*   marker in the MSB and the 7-bit sequence number of the block. Rows
+*   are programmed from the first byte, so a row torn or erased by a
+*   power failure has no marker and is discarded at start up together
+*   with the next rows of the block. A programmed row is never
+*   programmed again. The other bytes hold seven 16-bit slots per row:
+*   the first sample of a block is a keyframe of three slots with
+*   temperature (0.01 degC), pressure (Pa), and humidity (1/1024 %RH);
+*   each next sample is the delta from the previous one in
+*   a single slot (4, 5, and 7 bits), or an escape slot followed by a
+*   keyframe when the delta does not fit. There is no counter in a fixed
+*   location: at start up the last block is found from the sequence
+*   numbers, and when the log is full the oldest block is overwritten,
+*   so that all the rows are programmed the same number of times.
+*
 *   \author Davide Marzorati
 *   \date November 7, 2019
 */
@@ -12,12 +30,147 @@
     #include "BME280.h"
     #include "EEPROM_ErrorCodes.h"
     
+    /**
+    *   \brief Start the EEPROM log.
+    *
+    *   This function starts the EEPROM and checks the header of the log.
+    *   If the header is not valid (e.g., the log was written with an
+    *   older format), the log is erased. Then the last block written is
+    *   found with a binary search over the sequence numbers of the
+    *   blocks, reading only the first row of a few blocks, and the next
+    *   samples are added to it. The write position is kept in RAM, so
+    *   #BME280_EEPROM_WriteData never reads the EEPROM. The other blocks
+    *   are decoded to count their samples only when the log is first
+    *   read. If samples are still buffered from before a
+    *   #BME280_EEPROM_Stop that failed, they are kept.
+    *
+    *   \return Result of function execution
+    *   \retval #EEPROM_OK -> Success
+    *   \retval #EEPROM_E_WRITE -> Error during erase of the log
+    */
     EEPROM_ErrorCode BME280_EEPROM_Start(void);
     
+    /**
+    *   \brief Flush the buffered samples and stop the EEPROM.
+    *
+    *   \return Result of function execution
+    *   \retval #EEPROM_OK -> Success
+    *   \retval #EEPROM_E_WRITE -> Error during write, the EEPROM is not stopped
+    */
     EEPROM_ErrorCode BME280_EEPROM_Stop(void);
     
+    /**
+    *   \brief Add the last temperature, pressure, and humidity to the log.
+    *
+    *   Samples are collected in a RAM copy of the block of EEPROM they
+    *   belong to, and each row is queued to be programmed in background
+    *   (see #EEPROM_Interface_QueueRow) only when it is full. Values out
+    *   of the range of a keyframe are clamped. When the log is full, the
+    *   oldest block is overwritten. Samples that are still in RAM are
+    *   lost on a reset or power failure: at most the rows of the block
+    *   not yet queued and the #EEPROM_INTERFACE_QUEUE_LENGTH queued rows.
+    *   Call #BME280_EEPROM_Process often to program the queued rows, and
+    *   #BME280_EEPROM_Flush to make all the samples durable, e.g. before
+    *   powering down.
+    *
+    *   \param[in] bme280 : pointer to device struct with valid data
+    *
+    *   \return Result of function execution
+    *   \retval #EEPROM_OK -> Success
+    *   \retval #EEPROM_E_BUSY -> Queue full, the sample was not added
+    */
     EEPROM_ErrorCode BME280_EEPROM_WriteData(BME280* bme280);
     
+    /**
+    *   \brief Program the queued rows of the log in background.
+    *
+    *   This function never waits for the EEPROM (see
+    *   #EEPROM_Interface_Process), and queues the full rows that
+    *   found the queue full. Call it often, e.g. in the main loop while
+    *   waiting for the next sample.
+    *
+    *   \return Result of function execution
+    *   \retval #EEPROM_OK -> Success
+    *   \retval #EEPROM_E_WRITE -> A row could not be programmed
+    */
+    EEPROM_ErrorCode BME280_EEPROM_Process(void);
+    
+    /**
+    *   \brief Program all the samples that are still in RAM.
+    *
+    *   The partially filled row is queued, and the function waits until
+    *   all the queued rows are programmed. Then the row is closed: the
+    *   next samples are added to the block from the next row, so that a
+    *   programmed row is never programmed again, and a power failure
+    *   cannot lose the flushed samples. Each flush of a partial row costs
+    *   a row program and leaves the rest of the row empty, so flush only
+    *   when the samples must survive a power failure.
+    *
+    *   \return Result of function execution
+    *   \retval #EEPROM_OK -> Success
+    *   \retval #EEPROM_E_WRITE -> Error during write
+    */
+    EEPROM_ErrorCode BME280_EEPROM_Flush(void);
+    
+    /**
+    *   \brief Get the number of samples in the log.
+    *
+    *   The first call after #BME280_EEPROM_Start decodes all the blocks.
+    *
+    *   \return Number of samples, including the buffered ones.
+    */
+    uint16_t BME280_EEPROM_GetCount(void);
+    
+    /**
+    *   \brief Read a sample of the log.
+    *
+    *   The block of the sample is read and decoded up to the sample.
+    *   Samples of the block being written are read from RAM.
+    *
+    *   \param[in] index : index of the sample, 0 for the oldest one
+    *   \param[out] data : temperature, pressure, and humidity of the sample
+    *
+    *   \return Result of function execution
+    *   \retval #EEPROM_OK -> Success
+    *   \retval #EEPROM_E_ADDR -> Index not lower than #BME280_EEPROM_GetCount
+    *   \retval #EEPROM_E_CHECKSUM -> Block corrupted
+    */
+    EEPROM_ErrorCode BME280_EEPROM_ReadData(uint16_t index, BME280_Data* data);
+    
+    /**
+    *   \brief Store the calibration data of the sensor.
+    *
+    *   This function stores the calibration data of the sensor in a
+    *   dedicated area at the end of the EEPROM, together with the chip id
+    *   and a CRC with commit marker, so that they can be loaded at the next start up
+    *   with #BME280_EEPROM_ReadCalibData.
+    *
+    *   \param[in] bme280 : pointer to device struct with valid calibration data
+    *
+    *   \return Result of function execution
+    *   \retval #EEPROM_OK -> Success
+    *   \retval #EEPROM_E_WRITE -> Error during write
+    */
+    EEPROM_ErrorCode BME280_EEPROM_WriteCalibData(BME280* bme280);
+    
+    /**
+    *   \brief Load the calibration data of the sensor.
+    *
+    *   This function loads the calibration data previously stored with
+    *   #BME280_EEPROM_WriteCalibData. The data are returned only if
+    *   the stored chip id and CRC are valid. The chip id is the same for
+    *   all the BME280 sensors: the data are checked against the sensor by
+    *   #BME280_StartWithCalibData, which returns #BME280_E_CALIB_MISMATCH
+    *   if the sensor was replaced since they were stored.
+    *
+    *   \param[out] calib_data : pointer to struct where data will be stored
+    *
+    *   \return Result of function execution
+    *   \retval #EEPROM_OK -> Success
+    *   \retval #EEPROM_E_CHECKSUM -> No valid calibration data stored
+    */
+    EEPROM_ErrorCode BME280_EEPROM_ReadCalibData(BME280_Calib_Data* calib_data);
+    
 #endif
 
 /* [] END OF FILE */
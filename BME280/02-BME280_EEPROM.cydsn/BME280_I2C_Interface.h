@@ -16,6 +16,94 @@
     #include "cytypes.h"
     #include "BME280_ErrorCodes.h"
     
+    /**
+    *   \brief Maximum number of transactions waiting in the queue.
+    */
+    #ifndef BME280_I2C_QUEUE_LENGTH
+        #define BME280_I2C_QUEUE_LENGTH 8
+    #endif
+    
+    /**
+    *   \brief Maximum number of data bytes in a write transaction.
+    */
+    #ifndef BME280_I2C_MAX_WRITE_LEN
+        #define BME280_I2C_MAX_WRITE_LEN 16
+    #endif
+    
+    /**
+    *   \brief Transaction direction: write registers.
+    */
+    #define BME280_I2C_WRITE 0x00
+    
+    /**
+    *   \brief Transaction direction: read registers.
+    */
+    #define BME280_I2C_READ 0x01
+    
+    /**
+    *   \brief Transaction status: waiting in the queue or in progress.
+    */
+    #define BME280_I2C_PENDING 0x00
+    
+    /**
+    *   \brief Transaction status: completed, result available in the error field.
+    */
+    #define BME280_I2C_DONE 0x01
+    
+    struct BME280_I2C_Transaction;
+    
+    /**
+    *   \brief Function called when a transaction is completed.
+    *
+    *   The function is called from the I2C interrupt, so it should
+    *   be kept short.
+    */
+    typedef void (*BME280_I2C_Callback)(struct BME280_I2C_Transaction* transaction);
+    
+    /**
+    *   \brief Descriptor of a queued I2C transaction.
+    *
+    *   The descriptor must not be modified or go out of scope
+    *   until its status is #BME280_I2C_DONE.
+    */
+    typedef struct BME280_I2C_Transaction {
+        uint8_t device_address;         ///< I2C address of the device to talk to
+        uint8_t register_address;       ///< Address of the first register
+        uint8_t register_count;         ///< Number of registers to read or write
+        uint8_t direction;              ///< #BME280_I2C_READ or #BME280_I2C_WRITE
+        uint8_t* data;                  ///< Data to be written or buffer for read data
+        BME280_I2C_Callback callback;   ///< Completion callback, may be NULL
+        void* context;                  ///< User pointer passed along with the transaction
+        volatile uint8_t status;        ///< #BME280_I2C_PENDING or #BME280_I2C_DONE
+        volatile BME280_ErrorCode error;///< Result of the transaction
+    } BME280_I2C_Transaction;
+    
+    /**
+    *   \brief Transport used by a BME280 device.
+    *
+    *   This structure groups the functions the driver uses to talk to a
+    *   sensor, so that each device structure can refer to its own bus.
+    *   The device address is passed to each function, so the same bus can
+    *   be shared by several sensors.
+    */
+    typedef struct {
+        /// Start the peripheral
+        BME280_ErrorCode (*start)(void);
+        /// Read consecutive registers, blocking
+        BME280_ErrorCode (*read)(uint8_t device_address, uint8_t register_address,
+                                 uint8_t register_count, uint8_t* data);
+        /// Write register/value pairs, blocking
+        BME280_ErrorCode (*write_pairs)(uint8_t device_address, uint8_t pair_count,
+                                        uint8_t* data);
+        /// Queue a transaction for non-blocking execution
+        BME280_ErrorCode (*submit)(BME280_I2C_Transaction* transaction);
+    } BME280_Bus;
+    
+    /**
+    *   \brief Transport over the I2C_Master component.
+    */
+    extern const BME280_Bus BME280_I2C_Bus;
+    
     /** \brief Start the I2C peripheral.
     *   
     *   This function starts the I2C peripheral so that it is ready to work.
@@ -32,6 +120,29 @@
     */
     BME280_ErrorCode BME280_I2C_Interface_Stop(void);
     
+    /**
+    *   \brief Queue a transaction for non-blocking execution.
+    *
+    *   This function adds the transaction to the queue and returns immediately.
+    *   Transactions are executed in order by the I2C interrupt. When a 
+    *   transaction is completed, its status is set to #BME280_I2C_DONE and its
+    *   callback, if any, is called.
+    *   \param[in] transaction Pointer to the transaction descriptor.
+    *   \return Result of function execution 
+    *   \retval BME280_OK -> Transaction queued
+    *   \retval BME280_E_NULL_PTR -> Null pointer
+    *   \retval BME280_E_INVALID_LEN -> Invalid number of registers (a write of no
+    *           registers is allowed and sends only the register address)
+    *   \retval BME280_E_BUSY -> Queue is full
+    */
+    BME280_ErrorCode BME280_I2C_Interface_Submit(BME280_I2C_Transaction* transaction);
+    
+    /**
+    *   \brief Check if there are transactions queued or in progress.
+    *   \return 1 if the bus is busy, 0 otherwise.
+    */
+    uint8_t BME280_I2C_Interface_IsBusy(void);
+    
     /**
     *   \brief Read one byte over I2C.
     *   
@@ -43,6 +154,7 @@
     *   \return Result of function execution 
     *   \retval BME280_OK -> Success
     *   \retval BME280_I2C_ERROR -> Error during I2C communication
+    *   \retval BME280_E_INT_DISABLED -> Called with interrupts disabled
     */
     BME280_ErrorCode BME280_I2C_Interface_ReadRegister(uint8_t device_address, 
                                             uint8_t register_address,
@@ -60,6 +172,7 @@
     *   \return Result of function execution
     *   \retval BME280_OK -> Success
     *   \retval BME280_I2C_ERROR -> Error during I2C communication
+    *   \retval BME280_E_INT_DISABLED -> Called with interrupts disabled
     */
     BME280_ErrorCode BME280_I2C_Interface_ReadRegisterMulti(uint8_t device_address,
                                                 uint8_t register_address,
@@ -76,6 +189,7 @@
     *   \return Result of function execution
     *   \retval BME280_OK -> Success
     *   \retval BME280_I2C_ERROR -> Error during I2C communication
+    *   \retval BME280_E_INT_DISABLED -> Called with interrupts disabled
     */
     BME280_ErrorCode BME280_I2C_Interface_WriteRegister(uint8_t device_address,
                                             uint8_t register_address,
@@ -93,22 +207,53 @@
     *   \return Result of function execution
     *   \retval BME280_OK -> Success
     *   \retval BME280_I2C_ERROR -> Error during I2C communication
+    *   \retval BME280_E_INT_DISABLED -> Called with interrupts disabled
     */
     BME280_ErrorCode BME280_I2C_Interface_WriteRegisterMulti(uint8_t device_address,
                                             uint8_t register_address,
                                             uint8_t register_count,
                                             uint8_t* data);
     
+    /** 
+    *   \brief Write register/value pairs over I2C.
+    *   
+    *   This function performs a complete writing operation over I2C where
+    *   each data byte is preceded by the address of the register to be
+    *   written. This allows to write several non-contiguous registers
+    *   in a single transaction.
+    *   \param[in] device_address I2C address of the device to talk to.
+    *   \param[in] pair_count Number of register/value pairs to be written.
+    *   \param[in] data Array of register addresses and values, interleaved.
+    *   \return Result of function execution
+    *   \retval BME280_OK -> Success
+    *   \retval BME280_I2C_ERROR -> Error during I2C communication
+    *   \retval BME280_E_INT_DISABLED -> Called with interrupts disabled
+    */
+    BME280_ErrorCode BME280_I2C_Interface_WriteRegisterPairs(uint8_t device_address,
+                                            uint8_t pair_count,
+                                            uint8_t* data);
+    
     /**
     *   \brief Check if device is connected over I2C.
     *
-    *   This function checks if a device is connected over the I2C bus.
+    *   This function checks if a device is connected over the I2C bus,
+    *   with a write of no registers queued as any other transaction.
     *   \param device_address I2C address of the device to be checked.
     *   \return Result of function execution
     *   \retval BME280_OK -> Device is connected 
     *   \retval BME280_DEVICE_NOT_FOUND -> Device not found on I2C bus.
+    *   \retval BME280_E_INT_DISABLED -> Called with interrupts disabled
     */
     BME280_ErrorCode BME280_I2C_Interface_IsDeviceConnected(uint8_t device_address);
     
+    /**
+    *   \brief Check if the caller can wait for a queued transaction.
+    *
+    *   Transactions are completed by the I2C interrupt, so waiting for
+    *   them with interrupts disabled would never end.
+    *   \return 1 if interrupts are enabled, 0 otherwise.
+    */
+    uint8_t BME280_I2C_Interface_CanWait(void);
+    
 #endif // I2C_Interface_H
 /* [] END OF FILE */
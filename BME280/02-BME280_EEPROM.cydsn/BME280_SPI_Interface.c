@@ -0,0 +1,210 @@
+/*
+*   This file includes all the required source code to interface
+*   the SPI peripheral.
+*
+*   Bytes are sent one at a time and each received byte is read back
+*   before sending the next one, so the RX FIFO never overflows.
+*   Interrupts stay enabled during the transfers: a transaction started
+*   while another one is in progress (e.g., from an interrupt) is refused
+*   with BME280_E_BUSY instead of interleaving its bytes.
+*
+*   \author Davide Marzorati
+*/
+
+#include "project.h"
+
+#ifdef CY_SPIM_SPIM_BME280_H
+
+#include "BME280_SPI_Interface.h"
+
+/******************************************/
+/*            Global variables            */
+/******************************************/
+
+const BME280_Bus BME280_SPI_Bus = {
+    .start = BME280_SPI_Interface_Start,
+    .read = BME280_SPI_Interface_ReadRegisterMulti,
+    .write_pairs = BME280_SPI_Interface_WriteRegisterPairs,
+    .submit = BME280_SPI_Interface_Submit
+};
+
+/******************************************/
+/*            Static variables            */
+/******************************************/
+
+// Set while a transfer is in progress
+static volatile uint8_t bus_busy = 0;
+
+/******************************************/
+/*          Function Prototypes           */
+/******************************************/
+
+/**
+*   \brief Take the bus for a transfer.
+*
+*   \return 1 if the bus was free, 0 if a transfer is in progress.
+*/
+static uint8_t BME280_SPI_Interface_Acquire(void);
+
+/**
+*   \brief Write a register address followed by bytes in one transfer.
+*
+*   The bus must have been taken with #BME280_SPI_Interface_Acquire,
+*   it is released at the end of the transfer.
+*/
+static void BME280_SPI_Interface_WriteBurst(uint8_t register_address,
+                                            uint8_t count, const uint8_t* data);
+
+/**
+*   \brief Send a byte and return the byte received at the same time.
+*/
+static uint8_t BME280_SPI_Interface_Transfer(uint8_t value);
+
+/******************************************/
+/*          Function Definitions          */
+/******************************************/
+
+BME280_ErrorCode BME280_SPI_Interface_Start(void)
+{
+    BME280_CS_Write(1);
+    SPIM_BME280_Start();
+    return BME280_OK;
+}
+
+BME280_ErrorCode BME280_SPI_Interface_Stop(void)
+{
+    SPIM_BME280_Stop();
+    return BME280_OK;
+}
+
+BME280_ErrorCode BME280_SPI_Interface_ReadRegisterMulti(uint8_t device_address,
+                                            uint8_t register_address,
+                                            uint8_t register_count,
+                                            uint8_t* data)
+{
+    BME280_ErrorCode error = BME280_OK;
+    // A single device, selected by BME280_CS
+    (void)device_address;
+    
+    // Transactions can be submitted from interrupts, keep transfers whole
+    if ( !BME280_SPI_Interface_Acquire())
+    {
+        error = BME280_E_BUSY;
+    }
+    else
+    {
+        SPIM_BME280_ClearRxBuffer();
+        BME280_CS_Write(0);
+        BME280_SPI_Interface_Transfer(register_address | BME280_SPI_READ_FLAG);
+        for (uint8_t i = 0; i < register_count; i++)
+        {
+            // Address is incremented by the sensor
+            data[i] = BME280_SPI_Interface_Transfer(0xFF);
+        }
+        BME280_CS_Write(1);
+        bus_busy = 0;
+    }
+    return error;
+}
+
+BME280_ErrorCode BME280_SPI_Interface_WriteRegisterPairs(uint8_t device_address,
+                                        uint8_t pair_count,
+                                        uint8_t* data)
+{
+    BME280_ErrorCode error = BME280_OK;
+    // A single device, selected by BME280_CS
+    (void)device_address;
+    
+    if ( !BME280_SPI_Interface_Acquire())
+    {
+        error = BME280_E_BUSY;
+    }
+    else
+    {
+        SPIM_BME280_ClearRxBuffer();
+        BME280_CS_Write(0);
+        for (uint8_t i = 0; i < pair_count; i++)
+        {
+            BME280_SPI_Interface_Transfer(data[2*i] & ~BME280_SPI_READ_FLAG);
+            BME280_SPI_Interface_Transfer(data[2*i+1]);
+        }
+        BME280_CS_Write(1);
+        bus_busy = 0;
+    }
+    return error;
+}
+
+BME280_ErrorCode BME280_SPI_Interface_Submit(BME280_I2C_Transaction* transaction)
+{
+    BME280_ErrorCode error = BME280_OK;
+    
+    if ( transaction == NULL)
+    {
+        error = BME280_E_NULL_PTR;
+    }
+    else if ( transaction->direction == BME280_I2C_READ)
+    {
+        error = BME280_SPI_Interface_ReadRegisterMulti(
+            transaction->device_address, transaction->register_address,
+            transaction->register_count, transaction->data);
+    }
+    else if ( !BME280_SPI_Interface_Acquire())
+    {
+        error = BME280_E_BUSY;
+    }
+    else
+    {
+        BME280_SPI_Interface_WriteBurst(transaction->register_address,
+            transaction->register_count, transaction->data);
+    }
+    // A transaction refused because the bus is busy is not started
+    if ( error == BME280_OK)
+    {
+        transaction->error = BME280_OK;
+        transaction->status = BME280_I2C_DONE;
+        if ( transaction->callback != NULL)
+        {
+            transaction->callback(transaction);
+        }
+    }
+    return error;
+}
+
+static uint8_t BME280_SPI_Interface_Acquire(void)
+{
+    uint8_t interrupt_state;
+    uint8_t acquired;
+    
+    // Only the test and set of the flag is atomic, not the transfer
+    interrupt_state = CyEnterCriticalSection();
+    acquired = !bus_busy;
+    bus_busy = 1;
+    CyExitCriticalSection(interrupt_state);
+    return acquired;
+}
+
+static void BME280_SPI_Interface_WriteBurst(uint8_t register_address,
+                                            uint8_t count, const uint8_t* data)
+{
+    SPIM_BME280_ClearRxBuffer();
+    BME280_CS_Write(0);
+    BME280_SPI_Interface_Transfer(register_address & ~BME280_SPI_READ_FLAG);
+    for (uint8_t i = 0; i < count; i++)
+    {
+        // As over I2C, the register address is followed by value, address, value, ...
+        BME280_SPI_Interface_Transfer((i & 0x01) ? (data[i] & ~BME280_SPI_READ_FLAG) : data[i]);
+    }
+    BME280_CS_Write(1);
+    bus_busy = 0;
+}
+
+static uint8_t BME280_SPI_Interface_Transfer(uint8_t value)
+{
+    SPIM_BME280_WriteTxData(value);
+    while ( SPIM_BME280_GetRxBufferSize() == 0);
+    return SPIM_BME280_ReadRxData();
+}
+
+#endif
+
+/* [] END OF FILE */
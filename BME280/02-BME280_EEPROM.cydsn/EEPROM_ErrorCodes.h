@@ -44,6 +44,20 @@
         #define EEPROM_E_HEADER -3
     #endif
 
+    /**
+    *   \brief Result of api execution -> Stored data not valid
+    */
+    #ifndef EEPROM_E_CHECKSUM
+        #define EEPROM_E_CHECKSUM -4
+    #endif
+
+    /**
+    *   \brief Result of api execution -> Queue of background writes full, retry later
+    */
+    #ifndef EEPROM_E_BUSY
+        #define EEPROM_E_BUSY -5
+    #endif
+
     /**
     *   \brief Error returned by api.
     */
@@ -8,6 +8,16 @@
 #include "EEPROM_Interface.h"
 #include "EEPROM.h"
 
+// Rows waiting to be programmed, the oldest one at queue_head
+static uint8_t queue_data[EEPROM_INTERFACE_QUEUE_LENGTH][CY_EEPROM_SIZEOF_ROW];
+static uint16_t queue_row[EEPROM_INTERFACE_QUEUE_LENGTH];
+static uint8_t queue_head = 0;
+static uint8_t queue_count = 0;
+// Programming of the oldest row was started
+static uint8_t write_started = 0;
+
+static void EEPROM_Interface_Pop(void);
+
 EEPROM_ErrorCode EEPROM_Interface_Start()
 {
     EEPROM_Start();
@@ -17,36 +27,68 @@ EEPROM_ErrorCode EEPROM_Interface_Start()
 
 EEPROM_ErrorCode EEPROM_Interface_Stop()
 {
+    EEPROM_ErrorCode error;
+    error = EEPROM_Interface_Wait();
     EEPROM_Stop();
-    return EEPROM_OK;
+    return error;
 }
 
 
 EEPROM_ErrorCode EEPROM_Interface_WriteBytes(const uint8_t* data, uint16_t len,
     uint16_t start_address)
 {
-    EEPROM_ErrorCode error;
-    cystatus api_error = CYRET_SUCCESS;
+    EEPROM_ErrorCode error = EEPROM_OK;
+    uint8_t row_data[CY_EEPROM_SIZEOF_ROW];
     
     // Check that addresses are valid
-    if ( ((start_address + len) < CY_EEPROM_SIZE))
+    if ( ((start_address + len) <= CY_EEPROM_SIZE))
     {
-        // Update temperature
-        EEPROM_UpdateTemperature();
-        
         uint16_t counter = 0;
         
-        // Write all the required bytes
-        while ( counter < len )
+        // Each write of a byte programs a whole row, so program each row once
+        while ( counter < len && error == EEPROM_OK)
         {
-            api_error = EEPROM_WriteByte(data[counter], start_address + counter);
-            counter++;
-            if ((api_error != CYRET_SUCCESS) )
+            uint16_t address = start_address + counter;
+            uint16_t row = address / CY_EEPROM_SIZEOF_ROW;
+            uint8_t changed = 0;
+            
+            // Keep the bytes of the row that are not written
+            EEPROM_Interface_ReadBytes(row_data, CY_EEPROM_SIZEOF_ROW, row * CY_EEPROM_SIZEOF_ROW);
+            for (uint8_t offset = address % CY_EEPROM_SIZEOF_ROW;
+                offset < CY_EEPROM_SIZEOF_ROW && counter < len; offset++)
             {
-                break;
+                changed |= (row_data[offset] != data[counter]);
+                row_data[offset] = data[counter];
+                counter++;
+            }
+            // Rows that already hold the data are not worn
+            if ( changed)
+            {
+                error = EEPROM_Interface_WriteRow(row_data, row);
             }
         }
-        
+    }
+    else
+    {
+        error = EEPROM_E_ADDR;
+    }
+    return error;
+}
+
+EEPROM_ErrorCode EEPROM_Interface_WriteRow(const uint8_t* data,
+        uint16_t row_number)
+{
+    EEPROM_ErrorCode error;
+    cystatus api_error;
+    
+    if ( row_number < CY_EEPROM_NUMBER_ROWS)
+    {
+        // Rows are programmed in the order they were written
+        EEPROM_Interface_Wait();
+        // Update temperature
+        EEPROM_UpdateTemperature();
+        // Write row worth of data
+        api_error = EEPROM_Write(data, row_number);
         if (api_error == CYRET_SUCCESS)
         {
             error = EEPROM_OK;
@@ -63,20 +105,94 @@ EEPROM_ErrorCode EEPROM_Interface_WriteBytes(const uint8_t* data, uint16_t len,
     return error;
 }
 
-EEPROM_ErrorCode EEPROM_Interface_WriteRow(const uint8_t* data,
+EEPROM_ErrorCode EEPROM_Interface_QueueRow(const uint8_t* data,
         uint16_t row_number)
 {
-    EEPROM_ErrorCode error;
+    EEPROM_ErrorCode error = EEPROM_OK;
+    uint8_t index = (queue_head + queue_count + EEPROM_INTERFACE_QUEUE_LENGTH - 1) %
+        EEPROM_INTERFACE_QUEUE_LENGTH;
+    
+    if ( row_number >= CY_EEPROM_NUMBER_ROWS)
+    {
+        error = EEPROM_E_ADDR;
+    }
+    // Replace the last row if it is the same one and it is not being programmed
+    else if ( queue_count <= write_started || queue_row[index] != row_number)
+    {
+        if ( queue_count < EEPROM_INTERFACE_QUEUE_LENGTH)
+        {
+            index = (queue_head + queue_count) % EEPROM_INTERFACE_QUEUE_LENGTH;
+            queue_row[index] = row_number;
+            queue_count++;
+        }
+        else
+        {
+            error = EEPROM_E_BUSY;
+        }
+    }
+    if ( error == EEPROM_OK)
+    {
+        for (uint8_t offset = 0; offset < CY_EEPROM_SIZEOF_ROW; offset++)
+        {
+            queue_data[index][offset] = data[offset];
+        }
+        EEPROM_Interface_Process();
+    }
+    return error;
+}
+
+EEPROM_ErrorCode EEPROM_Interface_Process(void)
+{
+    EEPROM_ErrorCode error = EEPROM_OK;
     cystatus api_error;
-    // Write row worth of data
-    api_error = EEPROM_Write(data, row_number);
-    if (api_error == CYRET_SUCCESS)
+    
+    if ( write_started)
     {
-        error = EEPROM_OK;
+        api_error = EEPROM_Query();
+        if ( api_error == CYRET_STARTED)
+        {
+            // Still programming
+            return EEPROM_OK;
+        }
+        if ( api_error != CYRET_SUCCESS)
+        {
+            error = EEPROM_E_WRITE;
+        }
+        write_started = 0;
+        EEPROM_Interface_Pop();
     }
-    else
+    if ( queue_count > 0)
     {
-        error = EEPROM_E_WRITE;
+        EEPROM_UpdateTemperature();
+        api_error = EEPROM_StartWrite(queue_data[queue_head], queue_row[queue_head]);
+        if ( api_error == CYRET_SUCCESS)
+        {
+            write_started = 1;
+        }
+        else if ( api_error != CYRET_LOCKED)
+        {
+            // The row cannot be programmed, retry only if the EEPROM was busy
+            error = EEPROM_E_WRITE;
+            EEPROM_Interface_Pop();
+        }
+    }
+    return error;
+}
+
+uint8_t EEPROM_Interface_GetPending(void)
+{
+    return queue_count;
+}
+
+EEPROM_ErrorCode EEPROM_Interface_Wait(void)
+{
+    EEPROM_ErrorCode error = EEPROM_OK;
+    while ( queue_count > 0)
+    {
+        if ( EEPROM_Interface_Process() != EEPROM_OK)
+        {
+            error = EEPROM_E_WRITE;
+        }
     }
     return error;
 }
@@ -86,7 +202,7 @@ EEPROM_ErrorCode EEPROM_Interface_ReadBytes(uint8_t* data,
 {
      EEPROM_ErrorCode error;
     // Check that addresses are valid
-    if ( ((start_address + len) < CY_EEPROM_SIZE))
+    if ( ((start_address + len) <= CY_EEPROM_SIZE))
     {
         // Read the data
         uint16_t counter = 0;
@@ -95,6 +211,19 @@ EEPROM_ErrorCode EEPROM_Interface_ReadBytes(uint8_t* data,
             data[counter] = EEPROM_ReadByte(start_address + counter);
             counter++;
         }
+        // Queued rows are newer than the EEPROM, the oldest one first
+        for (uint8_t i = 0; i < queue_count; i++)
+        {
+            uint8_t index = (queue_head + i) % EEPROM_INTERFACE_QUEUE_LENGTH;
+            uint16_t row_address = queue_row[index] * CY_EEPROM_SIZEOF_ROW;
+            for (uint8_t offset = 0; offset < CY_EEPROM_SIZEOF_ROW; offset++)
+            {
+                if ( row_address + offset >= start_address && row_address + offset < start_address + len)
+                {
+                    data[row_address + offset - start_address] = queue_data[index][offset];
+                }
+            }
+        }
         error = EEPROM_OK;
     }
     else
@@ -104,5 +233,10 @@ EEPROM_ErrorCode EEPROM_Interface_ReadBytes(uint8_t* data,
     return error;
 }
 
+static void EEPROM_Interface_Pop(void)
+{
+    queue_head = (queue_head + 1) % EEPROM_INTERFACE_QUEUE_LENGTH;
+    queue_count--;
+}
 
 /* [] END OF FILE */
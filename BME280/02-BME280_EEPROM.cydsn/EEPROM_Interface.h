@@ -31,6 +31,13 @@
         #define EEPROM_NO_BLOCK_WRITE 0x01
     #endif
     
+    /**
+    *   \brief Number of rows that can wait to be programmed in background.
+    */
+    #ifndef EEPROM_INTERFACE_QUEUE_LENGTH
+        #define EEPROM_INTERFACE_QUEUE_LENGTH 4
+    #endif
+    
     
     /**
     *   \brief Start the EEPROM.
@@ -44,7 +51,8 @@
     /**
     *   \brief Stop the EEPROM.
     *
-    *   This function stops and powers down the EEPROM.
+    *   This function waits for the rows queued with
+    *   #EEPROM_Interface_QueueRow, then stops and powers down the EEPROM.
     */
     EEPROM_ErrorCode EEPROM_Interface_Stop();
     
@@ -52,7 +60,10 @@
     *   \brief Write bytes to the EEPROM.
     *
     *   This function allows to write the bytes passed in as parameter
-    *   to a specific location of the EEPROM.
+    *   to a specific location of the EEPROM. The EEPROM is programmed
+    *   one row at a time: each row that contains the bytes is read,
+    *   updated, and programmed once, and rows that already contain the
+    *   bytes are not programmed.
     *
     *   \param[in] data : the data to be written to the EEPROM
     *   \param[in] len  : length of data to be written to the EEPROM
@@ -66,25 +77,80 @@
         uint16_t start_address);
     
     /**
-    *   \brief Write bytes to the EEPROM.
+    *   \brief Write a row of the EEPROM.
     *
-    *   This function allows to write the bytes passed in as parameter
-    *   to a specific row of the EEPROM.
+    *   This function allows to write CY_EEPROM_SIZEOF_ROW bytes passed
+    *   in as parameter to a specific row of the EEPROM, with a single
+    *   erase/program cycle. The CPU is blocked until the row is programmed,
+    *   after the rows queued with #EEPROM_Interface_QueueRow.
     *
-    *   \param[in] data : the data to be written to the EEPROM
-    *   \param[in] row_address : row address where data will be written
+    *   \param[in] data : the CY_EEPROM_SIZEOF_ROW bytes to be written to the EEPROM
+    *   \param[in] row_address : row number where data will be written
     *   
     *   \return Result of function execution
     *   \retval #EEPROM_OK -> Success
     *   \retval #EEPROM_E_WRITE -> Error
+    *   \retval #EEPROM_E_ADDR -> Row out of range
     */
     EEPROM_ErrorCode EEPROM_Interface_WriteRow(const uint8_t* data,
         uint16_t row_address);
     
+    /**
+    *   \brief Queue a row to be programmed in background.
+    *
+    *   This function copies CY_EEPROM_SIZEOF_ROW bytes to a queue of
+    *   #EEPROM_INTERFACE_QUEUE_LENGTH rows and returns at once. Rows are
+    *   programmed in order by #EEPROM_Interface_Process, one at a time,
+    *   while the CPU keeps running. If the last queued row is the same
+    *   row and its programming has not started, its data are replaced.
+    *
+    *   \param[in] data : the CY_EEPROM_SIZEOF_ROW bytes to be written to the EEPROM
+    *   \param[in] row_number : row number where data will be written
+    *   
+    *   \return Result of function execution
+    *   \retval #EEPROM_OK -> Row queued
+    *   \retval #EEPROM_E_BUSY -> Queue full, call #EEPROM_Interface_Process and retry
+    *   \retval #EEPROM_E_ADDR -> Row out of range
+    */
+    EEPROM_ErrorCode EEPROM_Interface_QueueRow(const uint8_t* data,
+        uint16_t row_number);
+    
+    /**
+    *   \brief Program the queued rows in background.
+    *
+    *   This function checks if the row being programmed is complete and,
+    *   if so, starts programming the next queued row. It never waits for
+    *   the EEPROM, and must be called often (e.g., in the main loop):
+    *   a row takes about 20 ms to be programmed.
+    *
+    *   \return Result of the rows completed since the last call
+    *   \retval #EEPROM_OK -> Success, or no row completed
+    *   \retval #EEPROM_E_WRITE -> A row could not be programmed and was dropped
+    */
+    EEPROM_ErrorCode EEPROM_Interface_Process(void);
+    
+    /**
+    *   \brief Get the number of rows queued and not programmed yet.
+    *
+    *   \return Number of rows, including the one being programmed.
+    */
+    uint8_t EEPROM_Interface_GetPending(void);
+    
+    /**
+    *   \brief Wait until all the queued rows are programmed.
+    *
+    *   \return Result of function execution
+    *   \retval #EEPROM_OK -> Success
+    *   \retval #EEPROM_E_WRITE -> A row could not be programmed
+    */
+    EEPROM_ErrorCode EEPROM_Interface_Wait(void);
+    
     /**
     *   \brief Read bytes from EEPROM.
     *
     *   This function allows to read bytes from the EEPROM memory.
+    *   Rows that are queued and not programmed yet are read from the
+    *   queue.
     *   \param[out] data :  pointer to an array where data will be stored
     *   \param[in] len  :  length of data to read
     *   \param[in] start_address : start address in EEPROM where reading will occur.
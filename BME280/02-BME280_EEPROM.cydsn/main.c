@@ -27,18 +27,50 @@ int main(void)
     UART_Debug_PutString("************************\r\n");
 
     BME280 bme280;
+    BME280_Calib_Data calib_data;
     BME280_ErrorCode error;
+    BME280_Settings settings = {
+        .mode = BME280_SLEEP_MODE,
+        .osr_p = BME280_OVERSAMPLING_1X,
+        .osr_t = BME280_OVERSAMPLING_1X,
+        .osr_h = BME280_OVERSAMPLING_1X,
+        .filter = BME280_FILTER_COEFF_OFF,
+        .stanby_time = BME280_TSTANBDY_62_5_MS,
+        .spi_enable = 0
+    };
 
-    error = BME280_Start(&bme280);
+    BME280_Setup(&bme280, &BME280_I2C_Bus, BME280_I2C_ADDRESS_PRIMARY);
+    BME280_EEPROM_Start();
+    // Without stored calibration data, start as with the data of another sensor
+    error = BME280_E_CALIB_MISMATCH;
+    if (BME280_EEPROM_ReadCalibData(&calib_data) == EEPROM_OK)
+    {
+        // Warm boot: skip reading calibration data from the sensor
+        error = BME280_StartWithCalibData(&bme280, &calib_data);
+        if (error == BME280_OK)
+        {
+            UART_Debug_PutString("Calibration data loaded from EEPROM\r\n");
+        }
+        else if (error == BME280_E_CALIB_MISMATCH)
+        {
+            UART_Debug_PutString("Sensor replaced, reading calibration data\r\n");
+        }
+    }
+    if (error == BME280_E_CALIB_MISMATCH)
+    {
+        // Cold boot: read calibration data and store them for next time
+        error = BME280_Start(&bme280);
+        if (error == BME280_OK)
+        {
+            BME280_EEPROM_WriteCalibData(&bme280);
+        }
+    }
     if (error == BME280_OK)
     {
         UART_Debug_PutString("Sensor was initialized properly\r\n");
 
-        BME280_SetHumidityOversampling(&bme280, BME280_OVERSAMPLING_1X);
-        BME280_SetTemperatureOversampling(&bme280, BME280_OVERSAMPLING_1X);
-        BME280_SetPressureOversampling(&bme280, BME280_OVERSAMPLING_1X);
-        BME280_SetStandbyTime(&bme280, BME280_TSTANBDY_62_5_MS);
-        BME280_SetSleepMode(&bme280);
+        // Write all the settings at once
+        BME280_ApplySettings(&bme280, &settings);
         
     }
     else
@@ -46,30 +78,36 @@ int main(void)
         UART_Debug_PutString("Could not initialize sensor\r\n");
     }
     
-    BME280_SetNormalMode(&bme280);
-    BME280_EEPROM_Start();
-    
     for (int i = 0; i < 10; i++)
     {
-        BME280_ReadData(&bme280, BME280_ALL_COMP);
-        BME280_EEPROM_Start();
+        // Single measurement, the sensor sleeps between samples
+        BME280_TriggerAndRead(&bme280, BME280_ALL_COMP);
+        // Samples are delta coded in RAM and programmed a row at a time
         BME280_EEPROM_WriteData(&bme280);
-        BME280_EEPROM_Stop();
-        CyDelay(20000);
+        // Rows are programmed in background while waiting for the next sample
+        for (uint16_t ms = 0; ms < 20000; ms++)
+        {
+            BME280_EEPROM_Process();
+            CyDelay(1);
+        }
     }
+
+    char message[64] = {'\0'};
+    BME280_Data data;
+    uint16_t count = BME280_EEPROM_GetCount();
     
-    char message[50] = {'\0'};
-    
-    for (int i = 0; i < 10; i++)
+    // Print the last samples of the log, the oldest first
+    for (uint16_t i = (count > 10) ? count - 10 : 0; i < count; i++)
     {
-        BME280_EEPROM_Start();
-        uint8_t data[8];
-        EEPROM_Interface_ReadBytes(data,8,6+i*8);
-        int32_t temperature = (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
-        uint32_t humidity = (data[4] << 24) | (data[5] << 16) | (data[6] << 8) | data[7];
-        sprintf(message, "%d - T: %ld - H: %ld\r\n", i, (long)temperature, (long)humidity);
-        UART_Debug_PutString(message);
+        if ( BME280_EEPROM_ReadData(i, &data) == EEPROM_OK)
+        {
+            sprintf(message, "%u - T: %ld - P: %lu - H: %lu\r\n", i, (long)data.temperature,
+                (unsigned long)data.pressure, (unsigned long)data.humidity);
+            UART_Debug_PutString(message);
+        }
     }
+    // Program the samples still in RAM before power down
+    BME280_EEPROM_Flush();
 
     for(;;)
     {
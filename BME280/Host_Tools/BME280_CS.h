@@ -0,0 +1,15 @@
+/*
+*   Replacement of the header of the PSoC Creator pin named BME280_CS,
+*   implemented by bme280_bus_model.c.
+*/
+
+#ifndef CY_PINS_BME280_CS_H
+    #define CY_PINS_BME280_CS_H
+
+    #include "cytypes.h"
+
+    void BME280_CS_Write(uint8 value);
+
+#endif
+
+/* [] END OF FILE */
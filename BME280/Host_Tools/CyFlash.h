@@ -0,0 +1,17 @@
+/*
+*   Minimal replacement of the PSoC Creator CyFlash.h, with the size
+*   of the EEPROM of the CY8C5888 used by the projects.
+*/
+
+#ifndef CY_BOOT_CYFLASH_H
+    #define CY_BOOT_CYFLASH_H
+
+    #include "cytypes.h"
+
+    #define CY_EEPROM_SIZE 2048u
+    #define CY_EEPROM_SIZEOF_ROW 16u
+    #define CY_EEPROM_NUMBER_ROWS (CY_EEPROM_SIZE / CY_EEPROM_SIZEOF_ROW)
+
+#endif
+
+/* [] END OF FILE */
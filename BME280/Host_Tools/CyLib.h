@@ -0,0 +1,38 @@
+/*
+*   Minimal replacement of the PSoC Creator CyLib.h.
+*
+*   CyDelay is implemented by eeprom_emulator.c or by bme280_bus_model.c,
+*   the other functions by bme280_bus_model.c.
+*/
+
+#ifndef CY_BOOT_CYLIB_H
+    #define CY_BOOT_CYLIB_H
+
+    #include "cytypes.h"
+
+    void CyDelay(uint32 milliseconds);
+    void CyDelayUs(uint16 microseconds);
+
+    uint8 CyEnterCriticalSection(void);
+    void CyExitCriticalSection(uint8 savedIntrStatus);
+    void CyHost_SetInterrupts(uint8 enable);
+
+    #define CyGlobalIntEnable CyHost_SetInterrupts(1u)
+    #define CyGlobalIntDisable CyHost_SetInterrupts(0u)
+
+    #define __DMB() __asm volatile("" ::: "memory")
+
+    typedef void (*cySysTickCallback)(void);
+
+    #define CY_SYS_SYST_NUM_OF_CALLBACKS 5u
+
+    void CySysTickStart(void);
+    void CySysTickStop(void);
+    void CySysTickSetReload(uint32 value);
+    uint32 CySysTickGetReload(void);
+    uint32 CySysTickGetValue(void);
+    cySysTickCallback CySysTickSetCallback(uint32 number, cySysTickCallback function);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,24 @@
+/*
+*   Replacement of the header of the PSoC Creator EEPROM component,
+*   implemented by eeprom_emulator.c.
+*/
+
+#ifndef CY_EEPROM_EEPROM_H
+    #define CY_EEPROM_EEPROM_H
+
+    #include "cytypes.h"
+    #include "CyFlash.h"
+    #include "CyLib.h"
+
+    void EEPROM_Start(void);
+    void EEPROM_Stop(void);
+    cystatus EEPROM_WriteByte(uint8 dataByte, uint16 address);
+    uint8 EEPROM_ReadByte(uint16 address);
+    cystatus EEPROM_Write(const uint8* rowData, uint8 rowNumber);
+    cystatus EEPROM_StartWrite(const uint8* rowData, uint8 rowNumber);
+    cystatus EEPROM_Query(void);
+    cystatus EEPROM_UpdateTemperature(void);
+
+#endif
+
+/* [] END OF FILE */
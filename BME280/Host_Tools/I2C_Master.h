@@ -0,0 +1,44 @@
+/*
+*   Replacement of the header of the PSoC Creator I2C component named
+*   I2C_Master, implemented by bme280_bus_model.c.
+*
+*   Only the non-blocking buffer APIs used by BME280_I2C_Interface.c
+*   are provided.
+*/
+
+#ifndef CY_I2C_I2C_Master_H
+    #define CY_I2C_I2C_Master_H
+
+    #include "cytypes.h"
+
+    #define I2C_Master_WRITE_XFER_MODE 0u
+    #define I2C_Master_READ_XFER_MODE 1u
+
+    #define I2C_Master_MODE_COMPLETE_XFER 0x00u
+    #define I2C_Master_MODE_REPEAT_START 0x01u
+    #define I2C_Master_MODE_NO_STOP 0x02u
+
+    #define I2C_Master_MSTR_NO_ERROR 0x00u
+    #define I2C_Master_MSTR_BUS_BUSY 0x01u
+    #define I2C_Master_MSTR_NOT_READY 0x02u
+
+    #define I2C_Master_MSTAT_RD_CMPLT 0x01u
+    #define I2C_Master_MSTAT_WR_CMPLT 0x02u
+    #define I2C_Master_MSTAT_XFER_INP 0x04u
+    #define I2C_Master_MSTAT_XFER_HALT 0x08u
+    #define I2C_Master_MSTAT_ERR_ADDR_NAK 0x20u
+    #define I2C_Master_MSTAT_ERR_XFER 0x80u
+
+    void I2C_Master_Start(void);
+    void I2C_Master_Stop(void);
+    uint8 I2C_Master_MasterWriteBuf(uint8 slaveAddress, uint8* wrData, uint8 cnt, uint8 mode);
+    uint8 I2C_Master_MasterReadBuf(uint8 slaveAddress, uint8* rdData, uint8 cnt, uint8 mode);
+    uint8 I2C_Master_MasterStatus(void);
+    uint8 I2C_Master_MasterClearStatus(void);
+
+    // Defined by the application, called at the end of the I2C interrupt
+    void I2C_Master_ISR_ExitCallback(void);
+
+#endif
+
+/* [] END OF FILE */
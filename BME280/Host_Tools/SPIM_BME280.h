@@ -0,0 +1,20 @@
+/*
+*   Replacement of the header of the PSoC Creator SPI Master component
+*   named SPIM_BME280, implemented by bme280_bus_model.c.
+*/
+
+#ifndef CY_SPIM_SPIM_BME280_H
+    #define CY_SPIM_SPIM_BME280_H
+
+    #include "cytypes.h"
+
+    void SPIM_BME280_Start(void);
+    void SPIM_BME280_Stop(void);
+    void SPIM_BME280_WriteTxData(uint8 txData);
+    uint8 SPIM_BME280_ReadRxData(void);
+    uint8 SPIM_BME280_GetRxBufferSize(void);
+    void SPIM_BME280_ClearRxBuffer(void);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,285 @@
+/*
+*   Simulation of BME280_Adaptive against fixed settings.
+*
+*   A trace of pressure, temperature, and humidity is sampled by a model
+*   of the sensor in normal mode: the time between samples is the typical
+*   measurement time plus the standby time, white noise is added for the
+*   oversampling of each channel, the IIR filter is applied to pressure
+*   and temperature, and the outputs are rounded to 1 Pa, 0.01 degC, and
+*   1/1024 %RH. For each configuration the sample rate, the mean measurement
+*   time, the register writes, and the RMS error of each channel against
+*   the trace are printed, separately for samples where the channel is
+*   stable and where it is moving.
+*
+*   Noise model: pressure 3.3, 2.6, 2.1, 1.6, 1.3 Pa RMS for oversampling
+*   1x to 16x (datasheet); temperature 0.02 degC and humidity 0.02 %RH RMS
+*   at 1x, divided by the square root of the oversampling.
+*
+*   The default trace is synthetic: still air with two elevator rides of
+*   30 m at 1 m/s, a temperature step of 2 degC with a time constant of
+*   60 s, and a humidity ramp. A trace printed by bme280_decode.py can be
+*   replayed instead, with linear interpolation between its samples.
+*
+*   Build and run from this folder:
+*   gcc -O2 -I. -I../01-BME280.cydsn bme280_adaptive_sim.c
+*       ../01-BME280.cydsn/BME280_Adaptive.c ../01-BME280.cydsn/BME280_Planner.c
+*       -lm -o bme280_adaptive_sim
+*   ./bme280_adaptive_sim
+*   ./bme280_adaptive_sim trace.csv [period_ms]
+*
+*   \author Davide Marzorati
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "BME280_Adaptive.h"
+
+#define SIM_DURATION_S 1200.0
+#define SIM_STANDBY BME280_TSTANBDY_62_5_MS
+#define SIM_STANDBY_S 0.0625
+#define SIM_TIME_BUDGET_US 40000
+#define SIM_MAX_TRACE 200000
+
+// Channels moving faster than this are counted as moving (per s)
+static const double MOVING[3] = {0.5, 0.005, 0.005};
+static const char* const NAMES[3] = {"P [Pa]", "T [degC]", "H [%RH]"};
+
+static const double NOISE_P[6] = {0, 3.3, 2.6, 2.1, 1.6, 1.3};
+static const int SAMPLES[8] = {0, 1, 2, 4, 8, 16, 16, 16};
+static const int COEFF[5] = {1, 2, 4, 8, 16};
+
+// Replayed trace: time in s, values in Pa, degC, %RH
+static double* trace_time;
+static double (*trace_values)[3];
+static int trace_length;
+
+static uint64_t rng_state = 0x2545F4914F6CDD1DULL;
+
+static double uniform(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return ((rng_state >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static double gauss(void)
+{
+    return sqrt(-2.0 * log(uniform())) * cos(6.283185307179586 * uniform());
+}
+
+static void truth(double t, double* values)
+{
+    if ( trace_length > 0)
+    {
+        int lo = 0;
+        int hi = trace_length - 1;
+        if ( t <= trace_time[0] || t >= trace_time[hi])
+        {
+            memcpy(values, trace_values[(t <= trace_time[0]) ? 0 : hi], sizeof(double) * 3);
+            return;
+        }
+        while ( hi - lo > 1)
+        {
+            int mid = (lo + hi) / 2;
+            if ( trace_time[mid] <= t)
+            {
+                lo = mid;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        double f = (t - trace_time[lo]) / (trace_time[hi] - trace_time[lo]);
+        for (int i = 0; i < 3; i++)
+        {
+            values[i] = trace_values[lo][i] + f * (trace_values[hi][i] - trace_values[lo][i]);
+        }
+        return;
+    }
+    // Elevator rides: 12 Pa/s for 30 s down and back up
+    values[0] = 100000.0 + 0.002 * t;
+    if ( t > 300.0)
+    {
+        values[0] += 12.0 * ((t < 330.0) ? t - 300.0 : 30.0);
+    }
+    if ( t > 600.0)
+    {
+        values[0] -= 12.0 * ((t < 630.0) ? t - 600.0 : 30.0);
+    }
+    values[1] = 22.0 + ((t > 800.0) ? 2.0 * (1.0 - exp(-(t - 800.0) / 60.0)) : 0.0);
+    values[2] = 45.0 + ((t > 900.0) ? 5.0 * ((t < 1000.0) ? (t - 900.0) / 100.0 : 1.0) : 0.0);
+}
+
+static int read_trace(const char* path, double period)
+{
+    char line[256];
+    FILE* f = fopen(path, "r");
+    int stamped;
+
+    if ( f == NULL || fgets(line, sizeof(line), f) == NULL)
+    {
+        return 0;
+    }
+    stamped = (strncmp(line, "time_us", 7) == 0);
+    trace_time = malloc(sizeof(double) * SIM_MAX_TRACE);
+    trace_values = malloc(sizeof(double[3]) * SIM_MAX_TRACE);
+    while ( trace_length < SIM_MAX_TRACE && fgets(line, sizeof(line), f) != NULL)
+    {
+        double key, t, p, h;
+        if ( sscanf(line, "%lf,%lf,%lf,%lf", &key, &t, &p, &h) != 4)
+        {
+            continue;
+        }
+        trace_time[trace_length] = stamped ? key / 1e6 : trace_length * period;
+        trace_values[trace_length][0] = p;
+        trace_values[trace_length][1] = t;
+        trace_values[trace_length][2] = h;
+        trace_length++;
+    }
+    fclose(f);
+    return trace_length > 1;
+}
+
+static uint32_t typical_time(const BME280_Settings* s)
+{
+    uint32_t time = 1000 + 2000 * SAMPLES[s->osr_t & 7];
+    if ( SAMPLES[s->osr_p & 7] > 0)
+    {
+        time += 2000 * SAMPLES[s->osr_p & 7] + 500;
+    }
+    if ( SAMPLES[s->osr_h & 7] > 0)
+    {
+        time += 2000 * SAMPLES[s->osr_h & 7] + 500;
+    }
+    return time;
+}
+
+// Register/value pairs written by BME280_ApplySettings in normal mode
+static int register_writes(const BME280_Settings* a, const BME280_Settings* b)
+{
+    int writes = 0;
+    int hum = (a->osr_h != b->osr_h);
+    if ( a->filter != b->filter || a->stanby_time != b->stanby_time)
+    {
+        writes += 2;
+    }
+    writes += hum;
+    if ( writes > 0 || a->osr_t != b->osr_t || a->osr_p != b->osr_p)
+    {
+        writes++;
+    }
+    return writes;
+}
+
+static void simulate(const char* name, BME280_Settings settings, uint8_t adapt)
+{
+    BME280_Adaptive adaptive;
+    BME280_Data data;
+    BME280_Settings previous;
+    double duration = (trace_length > 0) ? trace_time[trace_length - 1] : SIM_DURATION_S;
+    double t = 0;
+    double filtered[2] = {0, 0};
+    double sum[3][2] = {{0}};
+    long count[3][2] = {{0}};
+    double measurement = 0;
+    long samples = 0;
+    int writes = 0;
+    int reset = 1;
+
+    BME280_Adaptive_Init(&adaptive, BME280_ADAPTIVE_NOISE_TEMPERATURE, BME280_ADAPTIVE_NOISE_PRESSURE,
+                         BME280_ADAPTIVE_NOISE_HUMIDITY, SIM_TIME_BUDGET_US);
+    while ( t < duration)
+    {
+        double values[3], before[3], after[3], out[3];
+        uint32_t time = typical_time(&settings);
+        int n_p = SAMPLES[settings.osr_p & 7];
+        int n_t = SAMPLES[settings.osr_t & 7];
+        int n_h = SAMPLES[settings.osr_h & 7];
+        int c = COEFF[(settings.filter <= 4) ? settings.filter : 4];
+
+        t += time / 1e6 + SIM_STANDBY_S;
+        truth(t, values);
+        truth(t - 0.5, before);
+        truth(t + 0.5, after);
+        // Noise of the oversampled measurements, then the IIR filter
+        double raw_p = values[0] + NOISE_P[(n_p >= 16) ? 5 : (n_p >= 8) ? 4 : (n_p >= 4) ? 3 : n_p] * gauss();
+        double raw_t = values[1] + 0.02 / sqrt(n_t) * gauss();
+        if ( reset)
+        {
+            filtered[0] = raw_p;
+            filtered[1] = raw_t;
+            reset = 0;
+        }
+        filtered[0] += (raw_p - filtered[0]) / c;
+        filtered[1] += (raw_t - filtered[1]) / c;
+        out[0] = floor(filtered[0] + 0.5);
+        out[1] = floor(filtered[1] * 100 + 0.5) / 100;
+        out[2] = floor((values[2] + 0.02 / sqrt(n_h) * gauss()) * 1024 + 0.5) / 1024;
+        for (int i = 0; i < 3; i++)
+        {
+            int moving = fabs(after[i] - before[i]) > MOVING[i];
+            sum[i][moving] += (out[i] - values[i]) * (out[i] - values[i]);
+            count[i][moving]++;
+        }
+        samples++;
+        measurement += time;
+
+        if ( adapt)
+        {
+            data.pressure = (uint32_t)out[0];
+            data.temperature = (int32_t)lround(out[1] * 100);
+            data.humidity = (uint32_t)lround(out[2] * 1024);
+            previous = settings;
+            if ( BME280_Adaptive_Update(&adaptive, &data, &settings))
+            {
+                writes += register_writes(&previous, &settings);
+                // The filter starts again when config is written
+                reset = (previous.filter != settings.filter);
+            }
+        }
+    }
+
+    printf("%-20s %7.2f %8.2f %6d %6d", name, samples / duration, measurement / samples / 1000.0,
+           adapt ? adaptive.changes : 0, writes);
+    for (int i = 0; i < 3; i++)
+    {
+        for (int m = 0; m < 2; m++)
+        {
+            printf(" %9.4f", count[i][m] ? sqrt(sum[i][m] / count[i][m]) : 0.0);
+        }
+    }
+    printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+    BME280_Settings fixed_1x = {BME280_NORMAL_MODE, BME280_OVERSAMPLING_1X, BME280_OVERSAMPLING_1X,
+                                BME280_OVERSAMPLING_1X, BME280_FILTER_COEFF_OFF, SIM_STANDBY, 0};
+    BME280_Settings fixed_4x = {BME280_NORMAL_MODE, BME280_OVERSAMPLING_4X, BME280_OVERSAMPLING_1X,
+                                BME280_OVERSAMPLING_1X, BME280_FILTER_COEFF_4, SIM_STANDBY, 0};
+    BME280_Settings fixed_16x = {BME280_NORMAL_MODE, BME280_OVERSAMPLING_16X, BME280_OVERSAMPLING_2X,
+                                 BME280_OVERSAMPLING_1X, BME280_FILTER_COEFF_16, SIM_STANDBY, 0};
+
+    if ( argc > 1 && !read_trace(argv[1], (argc > 2) ? atof(argv[2]) / 1000.0 : 0.5))
+    {
+        fprintf(stderr, "Could not read %s\n", argv[1]);
+        return 1;
+    }
+    printf("%-20s %7s %8s %6s %6s", "Settings", "Rate", "Meas", "Steps", "Writes");
+    for (int i = 0; i < 3; i++)
+    {
+        printf(" %9.9s %9.9s", NAMES[i], "moving");
+    }
+    printf("\n%-20s %7s %8s\n", "", "[Hz]", "[ms]");
+    simulate("1x, filter off", fixed_1x, 0);
+    simulate("4x/1x/1x, filter 4", fixed_4x, 0);
+    simulate("16x/2x/1x, filter 16", fixed_16x, 0);
+    simulate("adaptive", fixed_1x, 1);
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,192 @@
+/*
+*   Accuracy and speed of the BME280 compensation backend on a host.
+*
+*   The backend selected with BME280_COMP_BACKEND is compared with the
+*   floating point formulas of the datasheet in double precision, without
+*   rounding, with the typical calibration coefficients of the datasheet:
+*   temperature over all the raw values between -40 and 85 degC, pressure
+*   (300 to 1100 hPa) and humidity (0 to 100 %RH) over all the raw values
+*   at each degC of the same range. The maximum error of each channel
+*   (0.01 degC, Pa, 1/1024 %RH) and the time per sample in ns of each
+*   channel and of a whole sample are printed.
+*
+*   Build and run from this folder, once per backend (BME280_COMP_INT32,
+*   BME280_COMP_INT64, BME280_COMP_FLOAT, BME280_COMP_LUT):
+*   gcc -O2 -I. -I../01-BME280.cydsn -DBME280_COMP_BACKEND=BME280_COMP_INT64
+*       bme280_backend_bench.c ../01-BME280.cydsn/BME280_Compensation.c
+*       -lm -o bme280_backend_bench
+*   ./bme280_backend_bench
+*
+*   \author Davide Marzorati
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include "BME280_Compensation.h"
+
+#define BENCH_RAW_MAX (1u << 20)
+#define BENCH_HUM_MAX (1u << 16)
+#define BENCH_COUNT 4096
+#define BENCH_REPEAT 2000
+
+static const char* const BACKEND_NAMES[] = {"BME280_COMP_INT32", "BME280_COMP_INT64",
+                                            "BME280_COMP_FLOAT", "BME280_COMP_LUT"};
+
+static const BME280_Calib_Data BENCH_CALIB = {
+    27504, 26435, -1000, 36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000,
+    75, 370, 0, 313, 50, 30, 0
+};
+
+/******************************************/
+/*          Reference formulas            */
+/******************************************/
+
+static double temperature_ref(const BME280_Calib_Data* c, int32_t adc_t, double* t_fine)
+{
+    double var1 = (adc_t / 16384.0 - c->dig_T1 / 1024.0) * c->dig_T2;
+    double var2 = (adc_t / 131072.0 - c->dig_T1 / 8192.0);
+
+    var2 = var2 * var2 * c->dig_T3;
+    *t_fine = var1 + var2;
+    return *t_fine / 5120.0;
+}
+
+static double pressure_ref(const BME280_Calib_Data* c, uint32_t adc_p, double t_fine)
+{
+    double var1 = t_fine / 2.0 - 64000.0;
+    double var2 = var1 * var1 * c->dig_P6 / 32768.0;
+    double p;
+
+    var2 = var2 + var1 * c->dig_P5 * 2.0;
+    var2 = var2 / 4.0 + c->dig_P4 * 65536.0;
+    var1 = (c->dig_P3 * var1 * var1 / 524288.0 + c->dig_P2 * var1) / 524288.0;
+    var1 = (1.0 + var1 / 32768.0) * c->dig_P1;
+    p = 1048576.0 - adc_p;
+    p = (p - var2 / 4096.0) * 6250.0 / var1;
+    var1 = c->dig_P9 * p * p / 2147483648.0;
+    var2 = p * c->dig_P8 / 32768.0;
+    return p + (var1 + var2 + c->dig_P7) / 16.0;
+}
+
+static double humidity_ref(const BME280_Calib_Data* c, uint32_t adc_h, double t_fine)
+{
+    double h = t_fine - 76800.0;
+
+    h = (adc_h - (c->dig_H4 * 64.0 + c->dig_H5 / 16384.0 * h))
+        * (c->dig_H2 / 65536.0 * (1.0 + c->dig_H6 / 67108864.0 * h
+        * (1.0 + c->dig_H3 / 67108864.0 * h)));
+    return h * (1.0 - c->dig_H1 * h / 524288.0);
+}
+
+/******************************************/
+/*                 Bench                  */
+/******************************************/
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(void)
+{
+    BME280_Comp_Coeff coeff;
+    double t_fine_ref, ref, error;
+    double max_t = 0, max_p = 0, max_h = 0;
+    int32_t t_fine, raw_t[BENCH_COUNT];
+    uint32_t raw_p[BENCH_COUNT], raw_h[BENCH_COUNT];
+    int32_t raw_at_degc[126];
+    int degc = -40;
+    double start, ns_t, ns_p, ns_h, ns_all;
+    volatile uint32_t sink = 0;
+
+    BME280_Compensation_Prepare(&coeff, &BENCH_CALIB);
+
+    // Temperature, and first raw value of each degC
+    for (uint32_t raw = 0; raw < BENCH_RAW_MAX; raw++)
+    {
+        ref = temperature_ref(&BENCH_CALIB, raw, &t_fine_ref);
+        if (ref < -40.0 || ref > 85.0)
+        {
+            continue;
+        }
+        if (degc <= 85 && ref >= degc)
+        {
+            raw_at_degc[degc + 40] = raw;
+            degc++;
+        }
+        error = fabs(BME280_Compensation_Temperature(&coeff, raw, &t_fine) - ref * 100.0);
+        max_t = (error > max_t) ? error : max_t;
+    }
+
+    // Pressure and humidity at each degC
+    for (int i = 0; i < degc + 40; i++)
+    {
+        temperature_ref(&BENCH_CALIB, raw_at_degc[i], &t_fine_ref);
+        BME280_Compensation_Temperature(&coeff, raw_at_degc[i], &t_fine);
+        for (uint32_t raw = 0; raw < BENCH_RAW_MAX; raw++)
+        {
+            ref = pressure_ref(&BENCH_CALIB, raw, t_fine_ref);
+            if (ref >= 30000.0 && ref <= 110000.0)
+            {
+                error = fabs(BME280_Compensation_Pressure(&coeff, raw, t_fine) - ref);
+                max_p = (error > max_p) ? error : max_p;
+            }
+        }
+        for (uint32_t raw = 0; raw < BENCH_HUM_MAX; raw++)
+        {
+            ref = humidity_ref(&BENCH_CALIB, raw, t_fine_ref);
+            if (ref >= 0.0 && ref <= 100.0)
+            {
+                error = fabs(BME280_Compensation_Humidity(&coeff, raw, t_fine) - ref * 1024.0);
+                max_h = (error > max_h) ? error : max_h;
+            }
+        }
+    }
+
+    // Speed on samples spread over the operating range
+    for (uint32_t i = 0; i < BENCH_COUNT; i++)
+    {
+        raw_t[i] = raw_at_degc[(i * 37) % 126] + (int32_t)(i % 64);
+        raw_p[i] = 250000 + (i * 2311) % 350000;
+        raw_h[i] = 20000 + (i * 613) % 30000;
+    }
+    start = now_ns();
+    for (uint32_t r = 0; r < BENCH_REPEAT; r++)
+        for (uint32_t i = 0; i < BENCH_COUNT; i++)
+            sink += BME280_Compensation_Temperature(&coeff, raw_t[i], &t_fine);
+    ns_t = (now_ns() - start) / BENCH_REPEAT / BENCH_COUNT;
+    start = now_ns();
+    for (uint32_t r = 0; r < BENCH_REPEAT; r++)
+        for (uint32_t i = 0; i < BENCH_COUNT; i++)
+            sink += BME280_Compensation_Pressure(&coeff, raw_p[i], 128000 + (int32_t)(i & 0xFFFF));
+    ns_p = (now_ns() - start) / BENCH_REPEAT / BENCH_COUNT;
+    start = now_ns();
+    for (uint32_t r = 0; r < BENCH_REPEAT; r++)
+        for (uint32_t i = 0; i < BENCH_COUNT; i++)
+            sink += BME280_Compensation_Humidity(&coeff, raw_h[i], 128000 + (int32_t)(i & 0xFFFF));
+    ns_h = (now_ns() - start) / BENCH_REPEAT / BENCH_COUNT;
+    start = now_ns();
+    for (uint32_t r = 0; r < BENCH_REPEAT; r++)
+    {
+        for (uint32_t i = 0; i < BENCH_COUNT; i++)
+        {
+            sink += BME280_Compensation_Temperature(&coeff, raw_t[i], &t_fine);
+            sink += BME280_Compensation_Pressure(&coeff, raw_p[i], t_fine);
+            sink += BME280_Compensation_Humidity(&coeff, raw_h[i], t_fine);
+        }
+    }
+    ns_all = (now_ns() - start) / BENCH_REPEAT / BENCH_COUNT;
+    (void)sink;
+
+    printf("%s\n", BACKEND_NAMES[BME280_COMP_BACKEND]);
+    printf("Max error: temperature %.2f (0.01 degC), pressure %.2f Pa, humidity %.2f (1/1024 %%RH)\n",
+           max_t, max_p, max_h);
+    printf("Time: temperature %.2f ns, pressure %.2f ns, humidity %.2f ns, sample %.2f ns\n",
+           ns_t, ns_p, ns_h, ns_all);
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,124 @@
+/*
+*   Batch compensation of logged BME280 raw frames on a host.
+*
+*   BENCH_FRAMES raw 8-byte frames (a slow trace over the operating range
+*   with noise) are compensated in two ways:
+*   - scalar: BME280_ParseSensorData and BME280_CompensateData on a
+*             BME280 struct, one frame at a time, as the driver does;
+*   - batch:  BME280_Compensation_ParseFrames and BME280_Compensation_Batch
+*             on arrays of raw values (struct of arrays).
+*   The outputs must be identical. The samples per second of each way,
+*   and of the batch compensation without parsing, are printed.
+*
+*   Build and run from this folder (add e.g. -O3 -march=native to let
+*   the compiler vectorize more of the batch loops):
+*   gcc -O2 -I. -I../01-BME280.cydsn bme280_batch_bench.c bme280_bus_model.c
+*       ../01-BME280.cydsn/BME280.c ../01-BME280.cydsn/BME280_I2C_Interface.c
+*       ../01-BME280.cydsn/BME280_Compensation.c -o bme280_batch_bench
+*   ./bme280_batch_bench
+*
+*   \author Davide Marzorati
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "BME280.h"
+#include "BME280_Compensation.h"
+
+#define BENCH_FRAMES (1u << 20)
+#define BENCH_REPEAT 10
+
+static const BME280_Calib_Data BENCH_CALIB = {
+    27504, 26435, -1000, 36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000,
+    75, 370, 0, 313, 50, 30, 0
+};
+
+static BME280 bme280;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(void)
+{
+    uint8_t* frames = malloc(BENCH_FRAMES * BME280_COMP_FRAME_LEN);
+    int32_t* raw_t = malloc(BENCH_FRAMES * sizeof(int32_t));
+    uint32_t* raw_p = malloc(BENCH_FRAMES * sizeof(uint32_t));
+    uint32_t* raw_h = malloc(BENCH_FRAMES * sizeof(uint32_t));
+    int32_t* temperature = malloc(BENCH_FRAMES * sizeof(int32_t));
+    uint32_t* pressure = malloc(BENCH_FRAMES * sizeof(uint32_t));
+    uint32_t* humidity = malloc(BENCH_FRAMES * sizeof(uint32_t));
+    BME280_Data* scalar = malloc(BENCH_FRAMES * sizeof(BME280_Data));
+    uint32_t mismatches = 0;
+    double start, scalar_s = 0, batch_s = 0, comp_s = 0;
+
+    // Slow trace over the operating range, with noise in the low bits
+    srand(1);
+    for (uint32_t i = 0; i < BENCH_FRAMES; i++)
+    {
+        uint8_t* frame = &frames[i * BME280_COMP_FRAME_LEN];
+        uint32_t p = 300000 + (i / 4) % 250000 + (rand() & 0x3F);
+        uint32_t t = 420000 + (i / 8) % 200000 + (rand() & 0x3F);
+        uint32_t h = 20000 + (i / 16) % 30000 + (rand() & 0x1F);
+        frame[0] = (uint8_t)(p >> 12);
+        frame[1] = (uint8_t)(p >> 4);
+        frame[2] = (uint8_t)(p << 4);
+        frame[3] = (uint8_t)(t >> 12);
+        frame[4] = (uint8_t)(t >> 4);
+        frame[5] = (uint8_t)(t << 4);
+        frame[6] = (uint8_t)(h >> 8);
+        frame[7] = (uint8_t)h;
+    }
+    bme280.calib_data = BENCH_CALIB;
+    BME280_Compensation_Prepare(&bme280.comp_coeff, &bme280.calib_data);
+
+    for (uint32_t r = 0; r < BENCH_REPEAT; r++)
+    {
+        start = now_s();
+        for (uint32_t i = 0; i < BENCH_FRAMES; i++)
+        {
+            BME280_ParseSensorData(&bme280, &frames[i * BME280_COMP_FRAME_LEN]);
+            BME280_CompensateData(&bme280, BME280_ALL_COMP);
+            scalar[i] = bme280.data;
+        }
+        scalar_s += now_s() - start;
+
+        start = now_s();
+        BME280_Compensation_ParseFrames(frames, BENCH_FRAMES, raw_t, raw_p, raw_h);
+        comp_s -= now_s();
+        BME280_Compensation_Batch(&bme280.comp_coeff, BENCH_FRAMES, raw_t, raw_p, raw_h,
+            temperature, pressure, humidity);
+        comp_s += now_s();
+        batch_s += now_s() - start;
+    }
+
+    for (uint32_t i = 0; i < BENCH_FRAMES; i++)
+    {
+        mismatches += (scalar[i].temperature != temperature[i])
+                        || (scalar[i].pressure != pressure[i])
+                        || (scalar[i].humidity != humidity[i]);
+    }
+    printf("Scalar (per struct):       %6.1f M samples/s\n",
+           BENCH_FRAMES * BENCH_REPEAT / scalar_s / 1e6);
+    printf("Batch (parse + compensate): %6.1f M samples/s\n",
+           BENCH_FRAMES * BENCH_REPEAT / batch_s / 1e6);
+    printf("Batch (compensate only):    %6.1f M samples/s\n",
+           BENCH_FRAMES * BENCH_REPEAT / comp_s / 1e6);
+    printf("%u mismatches\n", mismatches);
+
+    free(frames);
+    free(raw_t);
+    free(raw_p);
+    free(raw_h);
+    free(temperature);
+    free(pressure);
+    free(humidity);
+    free(scalar);
+    return mismatches ? 1 : 0;
+}
+
+/* [] END OF FILE */
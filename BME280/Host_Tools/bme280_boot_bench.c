@@ -0,0 +1,87 @@
+/*
+*   Cold and warm boot of the BME280 sensor on the host bus model.
+*
+*   Cold boot: BME280_Start reads the calibration registers of the
+*   sensor. Warm boot: BME280_StartWithCalibData uses the calibration
+*   data stored at the cold boot (by BME280_EEPROM_WriteCalibData in
+*   02-BME280_EEPROM; the EEPROM is memory mapped, so loading them does
+*   not use the bus) and checks them with a short read of the sensor.
+*   The start up time (soft reset and NVM copy included), the I2C
+*   transactions, and the bits on the bus are printed for both.
+*
+*   A warm boot with the calibration data of another sensor (as after
+*   the sensor was replaced) must return BME280_E_CALIB_MISMATCH, and
+*   the cold boot that follows must load the data of the new sensor.
+*
+*   Build and run from this folder:
+*   gcc -O2 -I. -I../02-BME280_EEPROM.cydsn bme280_boot_bench.c bme280_bus_model.c
+*       ../02-BME280_EEPROM.cydsn/BME280.c ../02-BME280_EEPROM.cydsn/BME280_I2C_Interface.c
+*       ../02-BME280_EEPROM.cydsn/BME280_Compensation.c -o bme280_boot_bench
+*   ./bme280_boot_bench
+*
+*   \author Davide Marzorati
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "project.h"
+#include "BME280.h"
+#include "bme280_bus_model.h"
+
+static BME280 bme280;
+
+// Start the sensor, with or without stored calibration data
+static BME280_ErrorCode boot(const char* name, const BME280_Calib_Data* calib_data)
+{
+    BME280_ErrorCode error;
+    uint64_t start;
+
+    BME280_Model_ClearStats();
+    memset(&bme280, 0, sizeof(bme280));
+    BME280_Setup(&bme280, &BME280_Model_I2C_Bus, BME280_I2C_ADDRESS_PRIMARY);
+    start = BME280_Model_Time();
+    if ( calib_data == NULL)
+    {
+        error = BME280_Start(&bme280);
+    }
+    else
+    {
+        error = BME280_StartWithCalibData(&bme280, calib_data);
+    }
+    printf("%-18s error %3d, %7.1f us, %u transactions, %4u bits (%6.1f us on the bus)\n",
+           name, error, (BME280_Model_Time() - start) / 1000.0,
+           (unsigned)BME280_Model_Stats_Data.transactions,
+           (unsigned)BME280_Model_Stats_Data.bits,
+           BME280_Model_Stats_Data.bus_time / 1000.0);
+    return error;
+}
+
+int main(void)
+{
+    BME280_Model_Device* device;
+    BME280_Calib_Data stored, replaced;
+    int failures = 0;
+
+    BME280_Model_Reset();
+    device = BME280_Model_AddDevice(BME280_I2C_ADDRESS_PRIMARY);
+
+    failures += (boot("Cold boot", NULL) != BME280_OK);
+    stored = bme280.calib_data;
+    failures += (boot("Warm boot", &stored) != BME280_OK);
+    failures += (memcmp(&bme280.calib_data, &stored, sizeof(stored)) != 0);
+
+    // Another part: only the trimmed coefficients differ
+    replaced = stored;
+    replaced.dig_T1 += 17;
+    replaced.dig_T3 -= 3;
+    replaced.dig_P1 += 250;
+    BME280_Model_SetCalibration(device, &replaced);
+    failures += (boot("Sensor replaced", &stored) != BME280_E_CALIB_MISMATCH);
+    failures += (boot("Cold boot again", NULL) != BME280_OK);
+    failures += (memcmp(&bme280.calib_data, &replaced, sizeof(replaced)) != 0);
+
+    printf("%s\n", failures ? "FAILED" : "Calibration data as expected");
+    return failures ? 1 : 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,759 @@
+/*
+*   Host model of BME280 sensors on the I2C_Master and SPIM_BME280
+*   components, with the SysTick timer and the interrupts of the PSoC.
+*
+*   \author Davide Marzorati
+*/
+
+#include <string.h>
+#include "project.h"
+#include "bme280_bus_model.h"
+#include "BME280_RegMap.h"
+
+/******************************************/
+/*               Macros                   */
+/******************************************/
+
+// Value written to the reset register for a soft reset
+#define MODEL_RESET_COMMAND 0xB6
+// Interrupt Control and State Register, SysTick pending bit
+#define MODEL_ICSR 0xE000ED04u
+#define MODEL_ICSR_PENDSTSET (1u << 26)
+// SysTick period in ns
+#define MODEL_SYSTICK_NS 1000000u
+
+/******************************************/
+/*            Global variables            */
+/******************************************/
+
+BME280_Model_Stats BME280_Model_Stats_Data;
+
+/******************************************/
+/*            Static variables            */
+/******************************************/
+
+static BME280_Model_Device devices[BME280_MODEL_MAX_DEVICES];
+static uint8_t device_count = 0;
+// Time seen by the CPU
+static uint64_t now = 0;
+// Interrupts disabled (PRIMASK), interrupt being served
+static uint8_t primask = 0;
+static uint8_t in_isr = 0;
+static uint64_t critical_start = 0;
+// I2C transfer in progress and its interrupt
+static uint8_t transfer_active = 0;
+static uint64_t transfer_end = 0;
+static uint8_t transfer_result = 0;
+static uint8_t master_status = 0;
+static uint64_t bus_free = 0;
+static BME280_Model_Device* addressed = NULL;
+// SPI state: chip select, phase of the transaction, received byte
+static uint8_t chip_select = 1;
+static uint8_t spi_phase = 0;
+static uint8_t spi_read = 0;
+static uint8_t spi_rx_data = 0;
+static uint8_t spi_rx_count = 0;
+// SysTick
+static uint8_t systick_running = 0;
+static uint32_t systick_reload = CYDEV_BCLK__SYSCLK__HZ / 1000u - 1u;
+static uint64_t systick_start = 0;
+static uint64_t next_tick = 0;
+static cySysTickCallback systick_callbacks[CY_SYS_SYST_NUM_OF_CALLBACKS];
+
+// Typical calibration coefficients of the datasheet
+static const BME280_Calib_Data TYPICAL_CALIB = {
+    .dig_T1 = 27504, .dig_T2 = 26435, .dig_T3 = -1000,
+    .dig_P1 = 36477, .dig_P2 = -10685, .dig_P3 = 3024, .dig_P4 = 2855, .dig_P5 = 140,
+    .dig_P6 = -7, .dig_P7 = 15500, .dig_P8 = -14600, .dig_P9 = 6000,
+    .dig_H1 = 75, .dig_H2 = 370, .dig_H3 = 0, .dig_H4 = 313, .dig_H5 = 50, .dig_H6 = 30
+};
+
+// Samples per oversampling setting, standby times in us
+static const uint8_t OSR_SAMPLES[8] = {0, 1, 2, 4, 8, 16, 16, 16};
+static const uint32_t STANDBY_US[8] = {500, 62500, 125000, 250000, 500000, 1000000, 10000, 20000};
+
+/******************************************/
+/*          Function Prototypes           */
+/******************************************/
+
+static BME280_ErrorCode BME280_Model_Read(uint8_t device_address, uint8_t register_address,
+                                          uint8_t register_count, uint8_t* data);
+static BME280_ErrorCode BME280_Model_WritePairs(uint8_t device_address, uint8_t pair_count,
+                                                uint8_t* data);
+
+const BME280_Bus BME280_Model_I2C_Bus = {
+    .start = BME280_I2C_Interface_Start,
+    .read = BME280_Model_Read,
+    .write_pairs = BME280_Model_WritePairs,
+    .submit = BME280_I2C_Interface_Submit
+};
+
+/******************************************/
+/*             Sensor model               */
+/******************************************/
+
+static uint64_t BME280_Model_Scale(const BME280_Model_Device* device, uint64_t ns)
+{
+    return ns + (uint64_t)((int64_t)ns * device->clock_ppm / 1000000);
+}
+
+static void BME280_Model_Sample(BME280_Model_Device* device, uint64_t time)
+{
+    uint8_t* data = &device->registers[BME280_PRESS_MSB_REG_ADDR];
+    uint8_t ctrl_meas = device->registers[BME280_CTRL_MEAS_REG_ADDR];
+    uint32_t n = device->constant ? 0 : device->measurements;
+    uint32_t pressure = 0x80000;
+    uint32_t temperature = 0x80000;
+    uint32_t humidity = 0x8000;
+
+    // Noise-like steps, so that consecutive samples differ
+    if ( OSR_SAMPLES[(ctrl_meas >> 5) & 0x07])
+    {
+        temperature = (uint32_t)device->raw_temperature + (n * 37) % 64;
+    }
+    if ( OSR_SAMPLES[(ctrl_meas >> 2) & 0x07])
+    {
+        pressure = device->raw_pressure + (n * 53) % 128;
+    }
+    if ( OSR_SAMPLES[device->registers[BME280_CTRL_HUM_REG_ADDR] & 0x07])
+    {
+        humidity = device->raw_humidity + (n * 11) % 32;
+    }
+    data[0] = (uint8_t)(pressure >> 12);
+    data[1] = (uint8_t)(pressure >> 4);
+    data[2] = (uint8_t)(pressure << 4);
+    data[3] = (uint8_t)(temperature >> 12);
+    data[4] = (uint8_t)(temperature >> 4);
+    data[5] = (uint8_t)(temperature << 4);
+    data[6] = (uint8_t)(humidity >> 8);
+    data[7] = (uint8_t)humidity;
+    device->measurements++;
+    device->last_update = time;
+}
+
+// Bring the measurements of the sensor up to the given time
+static void BME280_Model_Update(BME280_Model_Device* device, uint64_t time)
+{
+    uint8_t status = 0;
+    uint64_t cycle = device->measurement_time + device->standby_time;
+    uint32_t completed;
+
+    if ( device->mode == BME280_FORCED_MODE)
+    {
+        if ( time >= device->start + device->measurement_time)
+        {
+            BME280_Model_Sample(device, device->start + device->measurement_time);
+            device->mode = BME280_SLEEP_MODE;
+            device->registers[BME280_CTRL_MEAS_REG_ADDR] &= ~0x03;
+        }
+        else
+        {
+            status |= BME280_STATUS_MEASURING;
+        }
+    }
+    else if ( device->mode == BME280_NORMAL_MODE)
+    {
+        if ( time >= device->start + device->measurement_time)
+        {
+            completed = (uint32_t)((time - device->start - device->measurement_time) / cycle) + 1;
+            if ( completed > device->cycles)
+            {
+                // Only the last measurement is left in the data registers
+                device->measurements += completed - device->cycles - 1;
+                device->cycles = completed;
+                BME280_Model_Sample(device, device->start + device->measurement_time
+                    + (uint64_t)(completed - 1) * cycle);
+            }
+        }
+        if ( (time - device->start) % cycle < device->measurement_time)
+        {
+            status |= BME280_STATUS_MEASURING;
+        }
+    }
+    if ( time < device->reset_end)
+    {
+        status |= BME280_STATUS_IM_UPDATE;
+    }
+    device->registers[BME280_STATUS_REG_ADDR] = status;
+}
+
+static void BME280_Model_WriteRegister(BME280_Model_Device* device, uint8_t address,
+                                       uint8_t value, uint64_t time)
+{
+    uint8_t* registers = device->registers;
+    uint64_t us;
+
+    BME280_Model_Update(device, time);
+    switch ( address)
+    {
+        case BME280_RESET_REG_ADDR:
+            if ( value == MODEL_RESET_COMMAND)
+            {
+                registers[BME280_CTRL_HUM_REG_ADDR] = 0;
+                registers[BME280_CTRL_MEAS_REG_ADDR] = 0;
+                registers[BME280_CONFIG_REG_ADDR] = 0;
+                device->mode = BME280_SLEEP_MODE;
+                device->reset_end = time + BME280_MODEL_NVM_COPY_NS;
+                BME280_Model_Update(device, time);
+            }
+            break;
+        case BME280_CTRL_HUM_REG_ADDR:
+            registers[address] = value & 0x07;
+            break;
+        case BME280_CONFIG_REG_ADDR:
+            registers[address] = value & 0xFD;
+            break;
+        case BME280_CTRL_MEAS_REG_ADDR:
+            registers[address] = value;
+            // Typical measurement time of the datasheet with the new settings
+            us = 1000 + 2000 * OSR_SAMPLES[(value >> 5) & 0x07];
+            if ( OSR_SAMPLES[(value >> 2) & 0x07])
+            {
+                us += 2000 * OSR_SAMPLES[(value >> 2) & 0x07] + 500;
+            }
+            if ( OSR_SAMPLES[registers[BME280_CTRL_HUM_REG_ADDR] & 0x07])
+            {
+                us += 2000 * OSR_SAMPLES[registers[BME280_CTRL_HUM_REG_ADDR] & 0x07] + 500;
+            }
+            device->measurement_time = BME280_Model_Scale(device, us * 1000);
+            device->standby_time = BME280_Model_Scale(device,
+                (uint64_t)STANDBY_US[registers[BME280_CONFIG_REG_ADDR] >> 5] * 1000);
+            if ( (value & 0x03) == BME280_NORMAL_MODE)
+            {
+                if ( device->mode != BME280_NORMAL_MODE)
+                {
+                    device->start = time;
+                    device->cycles = 0;
+                }
+                device->mode = BME280_NORMAL_MODE;
+            }
+            else if ( (value & 0x03) != BME280_SLEEP_MODE)
+            {
+                device->start = time;
+                device->mode = BME280_FORCED_MODE;
+            }
+            else
+            {
+                device->mode = BME280_SLEEP_MODE;
+            }
+            BME280_Model_Update(device, time);
+            break;
+        default:
+            // Read only registers
+            break;
+    }
+}
+
+static uint8_t BME280_Model_ReadRegister(BME280_Model_Device* device, uint64_t time)
+{
+    BME280_Model_Update(device, time);
+    return device->registers[device->pointer++];
+}
+
+static BME280_Model_Device* BME280_Model_Find(uint8_t address)
+{
+    for (uint8_t i = 0; i < device_count; i++)
+    {
+        if ( devices[i].address == address)
+        {
+            return &devices[i];
+        }
+    }
+    return NULL;
+}
+
+void BME280_Model_SetCalibration(BME280_Model_Device* device, const BME280_Calib_Data* calib_data)
+{
+    uint8_t* tp = &device->registers[BME280_CALIB_TEMP_PRESS_REG_ADDR];
+    uint8_t* h = &device->registers[BME280_CALIB_HUM_REG_ADDR];
+    const uint16_t words[12] = {
+        calib_data->dig_T1, (uint16_t)calib_data->dig_T2, (uint16_t)calib_data->dig_T3,
+        calib_data->dig_P1, (uint16_t)calib_data->dig_P2, (uint16_t)calib_data->dig_P3,
+        (uint16_t)calib_data->dig_P4, (uint16_t)calib_data->dig_P5, (uint16_t)calib_data->dig_P6,
+        (uint16_t)calib_data->dig_P7, (uint16_t)calib_data->dig_P8, (uint16_t)calib_data->dig_P9
+    };
+
+    // Registers 0x88..0x9F, LSB first, then H1 in 0xA1
+    for (uint8_t i = 0; i < 12; i++)
+    {
+        tp[2*i] = (uint8_t)words[i];
+        tp[2*i+1] = (uint8_t)(words[i] >> 8);
+    }
+    tp[25] = calib_data->dig_H1;
+    // Registers 0xE1..0xE7, H4 and H5 are 12 bit values sharing 0xE5
+    h[0] = (uint8_t)calib_data->dig_H2;
+    h[1] = (uint8_t)((uint16_t)calib_data->dig_H2 >> 8);
+    h[2] = calib_data->dig_H3;
+    h[3] = (uint8_t)(calib_data->dig_H4 >> 4);
+    h[4] = (uint8_t)((calib_data->dig_H4 & 0x0F) | ((calib_data->dig_H5 & 0x0F) << 4));
+    h[5] = (uint8_t)(calib_data->dig_H5 >> 4);
+    h[6] = (uint8_t)calib_data->dig_H6;
+}
+
+BME280_Model_Device* BME280_Model_AddDevice(uint8_t address)
+{
+    BME280_Model_Device* device = NULL;
+
+    if ( device_count < BME280_MODEL_MAX_DEVICES)
+    {
+        device = &devices[device_count++];
+        memset(device, 0, sizeof(*device));
+        device->address = address;
+        device->registers[BME280_WHO_AM_I_REG_ADDR] = BME280_WHO_AM_I;
+        BME280_Model_SetCalibration(device, &TYPICAL_CALIB);
+        // Example of the datasheet: 25.08 degC, 100653 Pa, about 45 %RH
+        device->raw_temperature = 519888;
+        device->raw_pressure = 415148;
+        device->raw_humidity = 30000;
+        device->measurement_time = 1000000;
+        device->standby_time = 500000;
+        // Registers after power on: skipped measurements
+        BME280_Model_Sample(device, 0);
+        device->measurements = 0;
+    }
+    return device;
+}
+
+/******************************************/
+/*              Interrupts                */
+/******************************************/
+
+// Run the interrupts that are pending, if interrupts are enabled
+static void BME280_Model_Dispatch(void)
+{
+    uint64_t saved;
+
+    while ( !primask && !in_isr)
+    {
+        if ( transfer_active)
+        {
+            // End of the I2C transfer, seen at its end time by the interrupt
+            transfer_active = 0;
+            master_status = (master_status & ~I2C_Master_MSTAT_XFER_INP) | transfer_result;
+            saved = now;
+            if ( transfer_end > now)
+            {
+                now = transfer_end;
+            }
+            in_isr = 1;
+            I2C_Master_ISR_ExitCallback();
+            in_isr = 0;
+            now = saved;
+        }
+        else if ( systick_running && next_tick <= now)
+        {
+            next_tick += MODEL_SYSTICK_NS;
+            BME280_Model_Stats_Data.systick_interrupts++;
+            in_isr = 1;
+            for (uint8_t i = 0; i < CY_SYS_SYST_NUM_OF_CALLBACKS; i++)
+            {
+                if ( systick_callbacks[i] != NULL)
+                {
+                    systick_callbacks[i]();
+                }
+            }
+            in_isr = 0;
+        }
+        else
+        {
+            break;
+        }
+    }
+}
+
+uint8 CyEnterCriticalSection(void)
+{
+    uint8 state = primask;
+
+    if ( !primask)
+    {
+        critical_start = now;
+    }
+    primask = 1;
+    return state;
+}
+
+void CyExitCriticalSection(uint8 savedIntrStatus)
+{
+    if ( primask && !savedIntrStatus)
+    {
+        if ( now - critical_start > BME280_Model_Stats_Data.max_critical)
+        {
+            BME280_Model_Stats_Data.max_critical = now - critical_start;
+        }
+    }
+    primask = savedIntrStatus;
+    BME280_Model_Dispatch();
+}
+
+void CyHost_SetInterrupts(uint8 enable)
+{
+    if ( enable)
+    {
+        CyExitCriticalSection(0);
+    }
+    else
+    {
+        CyEnterCriticalSection();
+    }
+}
+
+uint32 CyHost_GetReg32(uintptr_t address)
+{
+    uint32 value = 0;
+
+    // SysTick interrupt pending: a tick elapsed and was not served yet
+    if ( address == MODEL_ICSR && systick_running && next_tick <= now)
+    {
+        value |= MODEL_ICSR_PENDSTSET;
+    }
+    return value;
+}
+
+/******************************************/
+/*                 Time                   */
+/******************************************/
+
+uint64_t BME280_Model_Time(void)
+{
+    return now;
+}
+
+void BME280_Model_Advance(uint64_t ns)
+{
+    uint64_t end = now + ns;
+
+    BME280_Model_Dispatch();
+    // Serve the SysTick interrupts on the way
+    while ( systick_running && !primask && next_tick <= end)
+    {
+        if ( next_tick > now)
+        {
+            now = next_tick;
+        }
+        BME280_Model_Dispatch();
+    }
+    if ( now < end)
+    {
+        now = end;
+    }
+    BME280_Model_Dispatch();
+}
+
+void BME280_Model_Wait(void)
+{
+    BME280_Model_Dispatch();
+    if ( bus_free > now)
+    {
+        BME280_Model_Advance(bus_free - now);
+    }
+}
+
+void CyDelay(uint32 milliseconds)
+{
+    BME280_Model_Advance((uint64_t)milliseconds * 1000000u);
+}
+
+void CyDelayUs(uint16 microseconds)
+{
+    BME280_Model_Advance((uint64_t)microseconds * 1000u);
+}
+
+void BME280_Model_Reset(void)
+{
+    device_count = 0;
+    now = 0;
+    primask = 0;
+    in_isr = 0;
+    transfer_active = 0;
+    master_status = 0;
+    bus_free = 0;
+    addressed = NULL;
+    chip_select = 1;
+    spi_rx_count = 0;
+    systick_running = 0;
+    systick_reload = CYDEV_BCLK__SYSCLK__HZ / 1000u - 1u;
+    memset(systick_callbacks, 0, sizeof(systick_callbacks));
+    BME280_Model_ClearStats();
+}
+
+void BME280_Model_ClearStats(void)
+{
+    memset(&BME280_Model_Stats_Data, 0, sizeof(BME280_Model_Stats_Data));
+}
+
+/******************************************/
+/*                SysTick                 */
+/******************************************/
+
+void CySysTickStart(void)
+{
+    if ( !systick_running)
+    {
+        systick_running = 1;
+        systick_start = now;
+        next_tick = now + MODEL_SYSTICK_NS;
+    }
+}
+
+void CySysTickStop(void)
+{
+    systick_running = 0;
+}
+
+void CySysTickSetReload(uint32 value)
+{
+    // The model keeps an interrupt every ms
+    systick_reload = value;
+}
+
+uint32 CySysTickGetReload(void)
+{
+    return systick_reload;
+}
+
+uint32 CySysTickGetValue(void)
+{
+    uint64_t phase = (now - systick_start) % MODEL_SYSTICK_NS;
+
+    // Counts down from reload to 0 every ms
+    return systick_reload - (uint32)(phase * (systick_reload + 1u) / MODEL_SYSTICK_NS);
+}
+
+cySysTickCallback CySysTickSetCallback(uint32 number, cySysTickCallback function)
+{
+    cySysTickCallback previous = systick_callbacks[number];
+
+    systick_callbacks[number] = function;
+    return previous;
+}
+
+/******************************************/
+/*              I2C_Master                */
+/******************************************/
+
+void I2C_Master_Start(void)
+{
+}
+
+void I2C_Master_Stop(void)
+{
+}
+
+uint8 I2C_Master_MasterStatus(void)
+{
+    return master_status;
+}
+
+uint8 I2C_Master_MasterClearStatus(void)
+{
+    uint8 status = master_status;
+
+    master_status &= I2C_Master_MSTAT_XFER_INP;
+    return status;
+}
+
+// Start a transfer: address byte, then count data bytes, then stop unless NO_STOP
+static BME280_Model_Device* BME280_Model_Transfer(uint8 address, uint8 count, uint8 mode,
+                                                  uint8 done, uint64_t* data_time)
+{
+    BME280_Model_Device* device = BME280_Model_Find(address);
+    uint64_t start = (bus_free > now) ? bus_free : now;
+    uint32_t bits = 1 + 9;
+
+    BME280_Model_Stats_Data.interrupts++;
+    if ( device == NULL)
+    {
+        // Address not acknowledged, the component sends a stop
+        bits += 1;
+        transfer_result = I2C_Master_MSTAT_ERR_XFER | I2C_Master_MSTAT_ERR_ADDR_NAK | done;
+        BME280_Model_Stats_Data.nacks++;
+        BME280_Model_Stats_Data.transactions++;
+    }
+    else
+    {
+        bits += 9 * count;
+        BME280_Model_Stats_Data.interrupts += count;
+        transfer_result = done;
+        if ( mode & I2C_Master_MODE_NO_STOP)
+        {
+            transfer_result |= I2C_Master_MSTAT_XFER_HALT;
+        }
+        else
+        {
+            bits += 1;
+            BME280_Model_Stats_Data.transactions++;
+        }
+    }
+    *data_time = start + 10 * BME280_MODEL_I2C_BIT_NS;
+    transfer_end = start + (uint64_t)bits * BME280_MODEL_I2C_BIT_NS;
+    bus_free = transfer_end;
+    BME280_Model_Stats_Data.bits += bits;
+    BME280_Model_Stats_Data.bus_time += (uint64_t)bits * BME280_MODEL_I2C_BIT_NS;
+    transfer_active = 1;
+    master_status |= I2C_Master_MSTAT_XFER_INP;
+    return device;
+}
+
+uint8 I2C_Master_MasterWriteBuf(uint8 slaveAddress, uint8* wrData, uint8 cnt, uint8 mode)
+{
+    uint64_t time;
+    BME280_Model_Device* device;
+
+    if ( transfer_active)
+    {
+        return I2C_Master_MSTR_NOT_READY;
+    }
+    device = BME280_Model_Transfer(slaveAddress, cnt, mode, I2C_Master_MSTAT_WR_CMPLT, &time);
+    addressed = device;
+    if ( device != NULL && cnt > 0)
+    {
+        // Register address, then register/value pairs
+        device->pointer = wrData[0];
+        for (uint8 i = 1; i + 1 < cnt; i += 2)
+        {
+            time += 18 * BME280_MODEL_I2C_BIT_NS;
+            BME280_Model_WriteRegister(device, device->pointer, wrData[i], time);
+            device->pointer = wrData[i+1];
+        }
+        if ( cnt % 2 == 0)
+        {
+            BME280_Model_WriteRegister(device, device->pointer, wrData[cnt-1], transfer_end);
+        }
+    }
+    if ( device != NULL && !(mode & I2C_Master_MODE_NO_STOP))
+    {
+        BME280_Model_Stats_Data.writes++;
+    }
+    BME280_Model_Dispatch();
+    return I2C_Master_MSTR_NO_ERROR;
+}
+
+uint8 I2C_Master_MasterReadBuf(uint8 slaveAddress, uint8* rdData, uint8 cnt, uint8 mode)
+{
+    uint64_t time;
+    BME280_Model_Device* device;
+
+    if ( transfer_active)
+    {
+        return I2C_Master_MSTR_NOT_READY;
+    }
+    device = BME280_Model_Transfer(slaveAddress, cnt, mode & ~I2C_Master_MODE_NO_STOP,
+                I2C_Master_MSTAT_RD_CMPLT, &time);
+    if ( device != NULL)
+    {
+        // Registers are shadowed during a burst read
+        for (uint8 i = 0; i < cnt; i++)
+        {
+            rdData[i] = BME280_Model_ReadRegister(device, time);
+        }
+        BME280_Model_Stats_Data.reads++;
+    }
+    addressed = NULL;
+    BME280_Model_Dispatch();
+    return I2C_Master_MSTR_NO_ERROR;
+}
+
+static BME280_ErrorCode BME280_Model_Read(uint8_t device_address, uint8_t register_address,
+                                          uint8_t register_count, uint8_t* data)
+{
+    BME280_ErrorCode error = BME280_I2C_Interface_ReadRegisterMulti(device_address,
+                                register_address, register_count, data);
+    BME280_Model_Wait();
+    return error;
+}
+
+static BME280_ErrorCode BME280_Model_WritePairs(uint8_t device_address, uint8_t pair_count,
+                                                uint8_t* data)
+{
+    BME280_ErrorCode error = BME280_I2C_Interface_WriteRegisterPairs(device_address,
+                                pair_count, data);
+    BME280_Model_Wait();
+    return error;
+}
+
+/******************************************/
+/*              SPIM_BME280               */
+/******************************************/
+
+void SPIM_BME280_Start(void)
+{
+}
+
+void SPIM_BME280_Stop(void)
+{
+}
+
+void BME280_CS_Write(uint8 value)
+{
+    if ( value && !chip_select)
+    {
+        // End of the transaction
+        BME280_Model_Stats_Data.transactions++;
+        if ( spi_read)
+        {
+            BME280_Model_Stats_Data.reads++;
+        }
+        else
+        {
+            BME280_Model_Stats_Data.writes++;
+        }
+    }
+    else if ( !value && chip_select)
+    {
+        spi_phase = 0;
+        spi_read = 0;
+    }
+    chip_select = value;
+}
+
+void SPIM_BME280_WriteTxData(uint8 txData)
+{
+    BME280_Model_Device* device = BME280_Model_Find(BME280_MODEL_SPI_DEVICE);
+
+    // The CPU waits for each byte
+    now += 8 * BME280_MODEL_SPI_BIT_NS + BME280_MODEL_SPI_GAP_NS;
+    BME280_Model_Stats_Data.bits += 8;
+    BME280_Model_Stats_Data.bus_time += 8 * BME280_MODEL_SPI_BIT_NS;
+    spi_rx_data = 0xFF;
+    if ( device != NULL && !chip_select)
+    {
+        if ( spi_phase == 0)
+        {
+            // Bit 7 selects read or write, the others the register
+            device->pointer = txData | 0x80;
+            spi_read |= txData >> 7;
+            spi_phase = (txData & 0x80) ? 2 : 1;
+        }
+        else if ( spi_phase == 1)
+        {
+            BME280_Model_WriteRegister(device, device->pointer, txData, now);
+            spi_phase = 0;
+        }
+        else
+        {
+            spi_rx_data = BME280_Model_ReadRegister(device, now);
+        }
+    }
+    spi_rx_count = 1;
+    // Interrupts pending during the byte are served now
+    BME280_Model_Dispatch();
+}
+
+uint8 SPIM_BME280_ReadRxData(void)
+{
+    spi_rx_count = 0;
+    return spi_rx_data;
+}
+
+uint8 SPIM_BME280_GetRxBufferSize(void)
+{
+    return spi_rx_count;
+}
+
+void SPIM_BME280_ClearRxBuffer(void)
+{
+    spi_rx_count = 0;
+}
+
+/* [] END OF FILE */
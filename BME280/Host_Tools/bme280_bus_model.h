@@ -0,0 +1,196 @@
+/*
+*   Host model of BME280 sensors on the I2C_Master and SPIM_BME280
+*   components, with the SysTick timer and the interrupts of the PSoC.
+*
+*   The driver files (BME280.c, BME280_I2C_Interface.c,
+*   BME280_SPI_Interface.c, BME280_Stream.c) are built unchanged against
+*   the replacement headers of this folder (project.h, CyLib.h,
+*   I2C_Master.h, SPIM_BME280.h, BME280_CS.h).
+*
+*   Sensors: each device has the registers of a BME280 with the typical
+*   calibration coefficients of the datasheet. Writing ctrl_meas starts
+*   a forced measurement or the normal mode cycle, which take the typical
+*   measurement time of the datasheet (and the standby time in normal
+*   mode), scaled by the error of the internal oscillator of the sensor
+*   (clock_ppm). The data registers change at the end of each measurement,
+*   so consecutive samples always differ unless constant is set; the
+*   status register reports the conversions and the NVM copy after a
+*   reset.
+*
+*   Time is simulated in ns: it advances with CyDelay, CyDelayUs,
+*   BME280_Model_Advance (work of the application), BME280_Model_Wait,
+*   and with the bytes sent over SPI, which the CPU waits for. SysTick
+*   interrupts are served every ms when interrupts are enabled, also
+*   between the bytes of a SPI transfer.
+*
+*   I2C: a transfer started with MasterWriteBuf or MasterReadBuf takes
+*   one bit time (BME280_MODEL_I2C_BIT_NS) per bit on the bus: start or
+*   repeated start, 9 bits per byte (address included), and stop. The
+*   interrupt that ends the transfer (I2C_Master_ISR_ExitCallback) is run
+*   as soon as interrupts are enabled, with the clocks showing the end
+*   time of the transfer, and the CPU time is left unchanged: the CPU
+*   is free while the bus is busy. A blocking read or write of the
+*   driver waits for the bus, so the blocking functions of
+*   #BME280_Model_I2C_Bus also advance the CPU time to the end of the
+*   transaction. An address that no device acknowledges ends the
+*   transfer with I2C_Master_MSTAT_ERR_XFER.
+*
+*   \author Davide Marzorati
+*/
+
+#ifndef __BME280_BUS_MODEL_H
+    #define __BME280_BUS_MODEL_H
+
+    #include "BME280.h"
+
+    /**
+    *   \brief Maximum number of sensors.
+    */
+    #ifndef BME280_MODEL_MAX_DEVICES
+        #define BME280_MODEL_MAX_DEVICES 8
+    #endif
+
+    /**
+    *   \brief Time of an I2C bit in ns (400 kHz).
+    */
+    #ifndef BME280_MODEL_I2C_BIT_NS
+        #define BME280_MODEL_I2C_BIT_NS 2500u
+    #endif
+
+    /**
+    *   \brief Time of a SPI bit in ns (8 MHz).
+    */
+    #ifndef BME280_MODEL_SPI_BIT_NS
+        #define BME280_MODEL_SPI_BIT_NS 125u
+    #endif
+
+    /**
+    *   \brief CPU time between two SPI bytes in ns (loop of the driver).
+    */
+    #ifndef BME280_MODEL_SPI_GAP_NS
+        #define BME280_MODEL_SPI_GAP_NS 500u
+    #endif
+
+    /**
+    *   \brief CPU time of an I2C interrupt in ns, one per byte.
+    */
+    #ifndef BME280_MODEL_ISR_NS
+        #define BME280_MODEL_ISR_NS 3000u
+    #endif
+
+    /**
+    *   \brief Time of the NVM copy after a soft reset in ns.
+    */
+    #ifndef BME280_MODEL_NVM_COPY_NS
+        #define BME280_MODEL_NVM_COPY_NS 1000000u
+    #endif
+
+    /**
+    *   \brief Address of the device connected to the chip select of SPIM_BME280.
+    */
+    #define BME280_MODEL_SPI_DEVICE 0xFF
+
+    /**
+    *   \brief Model of a sensor.
+    *
+    *   The fields can be changed by the application after
+    *   #BME280_Model_AddDevice.
+    */
+    typedef struct {
+        uint8_t address;            ///< I2C address, or #BME280_MODEL_SPI_DEVICE
+        uint8_t registers[256];     ///< Registers of the sensor
+        int32_t raw_temperature;    ///< Raw temperature of the next samples
+        uint32_t raw_pressure;      ///< Raw pressure of the next samples
+        uint32_t raw_humidity;      ///< Raw humidity of the next samples
+        int32_t clock_ppm;          ///< Error of the internal oscillator in ppm
+        uint8_t constant;           ///< Set to give the same data at each measurement
+        uint32_t measurements;      ///< Measurements completed
+        uint64_t last_update;       ///< Time of the last change of the data registers, in ns
+        uint8_t pointer;            ///< Register address for the next read
+        uint8_t mode;               ///< Mode of the measurement in progress
+        uint64_t start;             ///< Start of the forced measurement or of the normal mode
+        uint32_t cycles;            ///< Measurements completed since the start of the normal mode
+        uint64_t measurement_time;  ///< Measurement time in ns
+        uint64_t standby_time;      ///< Standby time in ns
+        uint64_t reset_end;         ///< End of the NVM copy in ns
+    } BME280_Model_Device;
+
+    /**
+    *   \brief Counters of the bus.
+    */
+    typedef struct {
+        uint32_t transactions;      ///< Transactions (stop conditions, or chip select pulses)
+        uint32_t reads;             ///< Transactions that read registers
+        uint32_t writes;            ///< Transactions that only write registers
+        uint32_t nacks;             ///< Addresses not acknowledged
+        uint32_t bits;              ///< Bits on the bus
+        uint64_t bus_time;          ///< Time the bus was busy in ns
+        uint32_t interrupts;        ///< I2C interrupts (bytes on the I2C bus)
+        uint32_t systick_interrupts;///< SysTick interrupts served
+        uint64_t max_critical;      ///< Longest time with interrupts disabled in ns
+    } BME280_Model_Stats;
+
+    /**
+    *   \brief Counters of the bus.
+    */
+    extern BME280_Model_Stats BME280_Model_Stats_Data;
+
+    /**
+    *   \brief I2C transport whose blocking functions wait for the bus.
+    *
+    *   The functions are the ones of #BME280_I2C_Bus, the read and the
+    *   write of register pairs advance the CPU time to the end of the
+    *   transaction, as the CPU of the PSoC waits for it.
+    */
+    extern const BME280_Bus BME280_Model_I2C_Bus;
+
+    /**
+    *   \brief Remove all the sensors, stop SysTick, enable interrupts,
+    *   and reset time and counters.
+    */
+    void BME280_Model_Reset(void);
+
+    /**
+    *   \brief Reset the counters of the bus.
+    */
+    void BME280_Model_ClearStats(void);
+
+    /**
+    *   \brief Connect a sensor.
+    *
+    *   \param[in] address : I2C address, or #BME280_MODEL_SPI_DEVICE
+    *
+    *   \return Model of the sensor, NULL if there are too many sensors.
+    */
+    BME280_Model_Device* BME280_Model_AddDevice(uint8_t address);
+
+    /**
+    *   \brief Set the calibration registers of a sensor.
+    *
+    *   \param[in] device : model of the sensor
+    *   \param[in] calib_data : calibration coefficients
+    */
+    void BME280_Model_SetCalibration(BME280_Model_Device* device, const BME280_Calib_Data* calib_data);
+
+    /**
+    *   \brief Get the simulated time.
+    *
+    *   \return Time in ns.
+    */
+    uint64_t BME280_Model_Time(void);
+
+    /**
+    *   \brief Advance the simulated time, e.g. for the work of the application.
+    *
+    *   \param[in] ns : time in ns
+    */
+    void BME280_Model_Advance(uint64_t ns);
+
+    /**
+    *   \brief Wait for the end of the transfers on the I2C bus.
+    */
+    void BME280_Model_Wait(void);
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,289 @@
+/*
+*   Comparison of the BME280 compensation with precomputed coefficients
+*   (BME280_Compensation_Prepare) and of the previous compensation of
+*   BME280.c, which evaluated the terms depending only on the calibration
+*   data at each sample.
+*
+*   Both paths are run over the full range of the raw values (20 bit
+*   temperature and pressure, 16 bit humidity; pressure and humidity at
+*   each temperature from -40 to 85 degC in steps of 5 degC), with the
+*   typical calibration coefficients of the datasheet and those of two
+*   other parts. The outputs must be identical. The time per sample of
+*   each channel is printed in ns and, on x86 hosts, in TSC cycles.
+*
+*   Build and run from this folder (32 bit integer backend):
+*   gcc -O2 -fwrapv -I. -I../01-BME280.cydsn bme280_comp_bench.c
+*       ../01-BME280.cydsn/BME280_Compensation.c -o bme280_comp_bench
+*   ./bme280_comp_bench
+*
+*   -fwrapv: the formulas overflow for raw values far from the operating
+*   range, as they do on the PSoC; both paths must wrap the same way.
+*
+*   \author Davide Marzorati
+*/
+
+#include <stdio.h>
+#include <time.h>
+#include "BME280_Compensation.h"
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define BENCH_CYCLES() __rdtsc()
+#else
+    #define BENCH_CYCLES() 0
+#endif
+
+#define BENCH_RAW_MAX (1u << 20)
+#define BENCH_HUM_MAX (1u << 16)
+#define BENCH_CALIB_COUNT 3
+
+static const BME280_Calib_Data BENCH_CALIB[BENCH_CALIB_COUNT] = {
+    // Typical coefficients of the datasheet
+    {27504, 26435, -1000, 36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000,
+     75, 370, 0, 313, 50, 30, 0},
+    {28485, 26571, 50, 37727, -10623, 3024, 6451, -52, -7, 9900, -10230, 4285,
+     75, 355, 0, 341, 0, 30, 0},
+    {27861, 26223, 50, 36906, -10505, 3024, 8052, -104, -7, 9900, -10230, 4285,
+     75, 364, 0, 317, 0, 30, 0}
+};
+
+/******************************************/
+/*          Previous compensation         */
+/******************************************/
+
+// Not inlined, as the functions of BME280_Compensation.c, so that the
+// terms of each sample are not moved out of the benchmark loops
+#define BENCH_NOINLINE __attribute__((noinline))
+
+static BENCH_NOINLINE int32_t previous_temperature(BME280_Calib_Data* calib_data, int32_t uncomp_temperature)
+{
+    int32_t var1;
+    int32_t var2;
+    int32_t temperature;
+
+    var1 = (int32_t)((uncomp_temperature / 8) - ((int32_t)calib_data->dig_T1 * 2));
+    var1 = (var1 * ((int32_t)calib_data->dig_T2)) / 2048;
+    var2 = (int32_t)((uncomp_temperature / 16) - ((int32_t)calib_data->dig_T1));
+    var2 = (((var2 * var2) / 4096) * ((int32_t)calib_data->dig_T3)) / 16384;
+    calib_data->t_fine = var1 + var2;
+    temperature = (calib_data->t_fine * 5 + 128) / 256;
+    if (temperature < -4000)
+        temperature = -4000;
+    if (temperature > 8500)
+        temperature = 8500;
+    return temperature;
+}
+
+static BENCH_NOINLINE uint32_t previous_pressure(const BME280_Calib_Data* calib_data, uint32_t uncomp_pressure)
+{
+    int32_t var1;
+    int32_t var2;
+    int32_t var3;
+    int32_t var4;
+    uint32_t var5;
+    uint32_t pressure;
+
+    var1 = (((int32_t)calib_data->t_fine) / 2) - (int32_t)64000;
+    var2 = (((var1 / 4) * (var1 / 4)) / 2048) * ((int32_t)calib_data->dig_P6);
+    var2 = var2 + ((var1 * ((int32_t)calib_data->dig_P5)) * 2);
+    var2 = (var2 / 4) + (((int32_t)calib_data->dig_P4) * 65536);
+    var3 = (calib_data->dig_P3 * (((var1 / 4) * (var1 / 4)) / 8192)) / 8;
+    var4 = (((int32_t)calib_data->dig_P2) * var1) / 2;
+    var1 = (var3 + var4) / 262144;
+    var1 = (((32768 + var1)) * ((int32_t)calib_data->dig_P1)) / 32768;
+    if (var1)
+    {
+        var5 = (uint32_t)((uint32_t)1048576) - uncomp_pressure;
+        pressure = ((uint32_t)(var5 - (uint32_t)(var2 / 4096))) * 3125;
+        if (pressure < 0x80000000)
+        {
+            pressure = (pressure << 1) / ((uint32_t)var1);
+        }
+        else
+        {
+            pressure = (pressure / (uint32_t)var1) * 2;
+        }
+        var1 = (((int32_t)calib_data->dig_P9) * ((int32_t)(((pressure / 8) * (pressure / 8)) / 8192))) / 4096;
+        var2 = (((int32_t)(pressure / 4)) * ((int32_t)calib_data->dig_P8)) / 8192;
+        pressure = (uint32_t)((int32_t)pressure + ((var1 + var2 + calib_data->dig_P7) / 16));
+        if (pressure < 30000)
+        {
+            pressure = 30000;
+        }
+        else if (pressure > 110000)
+        {
+            pressure = 110000;
+        }
+    }
+    else
+    {
+        pressure = 30000;
+    }
+    return pressure;
+}
+
+static BENCH_NOINLINE uint32_t previous_humidity(const BME280_Calib_Data* calib_data, uint32_t uncomp_humidity)
+{
+    int32_t var1;
+    int32_t var2;
+    int32_t var3;
+    int32_t var4;
+    int32_t var5;
+    uint32_t humidity;
+
+    var1 = calib_data->t_fine - ((int32_t)76800);
+    var2 = (int32_t)(uncomp_humidity * 16384);
+    var3 = (int32_t)(((int32_t)calib_data->dig_H4) * 1048576);
+    var4 = ((int32_t)calib_data->dig_H5) * var1;
+    var5 = (((var2 - var3) - var4) + (int32_t)16384) / 32768;
+    var2 = (var1 * ((int32_t)calib_data->dig_H6)) / 1024;
+    var3 = (var1 * ((int32_t)calib_data->dig_H3)) / 2048;
+    var4 = ((var2 * (var3 + (int32_t)32768)) / 1024) + (int32_t)2097152;
+    var2 = ((var4 * ((int32_t)calib_data->dig_H2)) + 8192) / 16384;
+    var3 = var5 * var2;
+    var4 = ((var3 / 32768) * (var3 / 32768)) / 128;
+    var5 = var3 - ((var4 * ((int32_t)calib_data->dig_H1)) / 16);
+    var5 = (var5 < 0 ? 0 : var5);
+    var5 = (var5 > 419430400 ? 419430400 : var5);
+    humidity = (uint32_t)(var5 / 4096);
+    if (humidity > 102400)
+    {
+        humidity = 102400;
+    }
+    return humidity;
+}
+
+/******************************************/
+/*                 Bench                  */
+/******************************************/
+
+typedef struct {
+    double ns;
+    double cycles;
+    uint64_t samples;
+} BenchTime;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void print_time(const char* name, const BenchTime* previous, const BenchTime* prepared)
+{
+    printf("%-12s previous %6.2f ns %6.1f cycles, prepared %6.2f ns %6.1f cycles\n", name,
+           previous->ns / previous->samples, previous->cycles / previous->samples,
+           prepared->ns / prepared->samples, prepared->cycles / prepared->samples);
+}
+
+// Raw temperature at which the previous path gives t_fine for the temperature in degC
+static int32_t raw_for_temperature(BME280_Calib_Data* calib_data, int32_t degc)
+{
+    int32_t low = 0, high = BENCH_RAW_MAX - 1, mid;
+
+    while (low < high)
+    {
+        mid = (low + high) / 2;
+        previous_temperature(calib_data, mid);
+        if (calib_data->t_fine < degc * 5120)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+int main(void)
+{
+    BenchTime time[6] = {{0}};
+    uint64_t mismatches = 0, start_cycles;
+    double start_ns;
+    volatile uint32_t sink = 0;
+
+    for (int c = 0; c < BENCH_CALIB_COUNT; c++)
+    {
+        BME280_Calib_Data calib_data = BENCH_CALIB[c];
+        BME280_Comp_Coeff coeff;
+        int32_t t_fine = 0;
+
+        BME280_Compensation_Prepare(&coeff, &calib_data);
+
+        // Temperature over the full raw range
+        for (uint32_t raw = 0; raw < BENCH_RAW_MAX; raw++)
+        {
+            int32_t t = previous_temperature(&calib_data, raw);
+            mismatches += (t != BME280_Compensation_Temperature(&coeff, raw, &t_fine))
+                            || (t_fine != calib_data.t_fine);
+        }
+        start_ns = now_ns();
+        start_cycles = BENCH_CYCLES();
+        for (uint32_t raw = 0; raw < BENCH_RAW_MAX; raw++)
+            sink += previous_temperature(&calib_data, raw);
+        time[0].cycles += BENCH_CYCLES() - start_cycles;
+        time[0].ns += now_ns() - start_ns;
+        time[0].samples += BENCH_RAW_MAX;
+        start_ns = now_ns();
+        start_cycles = BENCH_CYCLES();
+        for (uint32_t raw = 0; raw < BENCH_RAW_MAX; raw++)
+            sink += BME280_Compensation_Temperature(&coeff, raw, &t_fine);
+        time[1].cycles += BENCH_CYCLES() - start_cycles;
+        time[1].ns += now_ns() - start_ns;
+        time[1].samples += BENCH_RAW_MAX;
+
+        // Pressure and humidity over the full raw range at each temperature
+        for (int32_t degc = -40; degc <= 85; degc += 5)
+        {
+            previous_temperature(&calib_data, raw_for_temperature(&calib_data, degc));
+            t_fine = calib_data.t_fine;
+            for (uint32_t raw = 0; raw < BENCH_RAW_MAX; raw++)
+            {
+                mismatches += (previous_pressure(&calib_data, raw)
+                                != BME280_Compensation_Pressure(&coeff, raw, t_fine));
+            }
+            for (uint32_t raw = 0; raw < BENCH_HUM_MAX; raw++)
+            {
+                mismatches += (previous_humidity(&calib_data, raw)
+                                != BME280_Compensation_Humidity(&coeff, raw, t_fine));
+            }
+
+            start_ns = now_ns();
+            start_cycles = BENCH_CYCLES();
+            for (uint32_t raw = 0; raw < BENCH_RAW_MAX; raw++)
+                sink += previous_pressure(&calib_data, raw);
+            time[2].cycles += BENCH_CYCLES() - start_cycles;
+            time[2].ns += now_ns() - start_ns;
+            time[2].samples += BENCH_RAW_MAX;
+            start_ns = now_ns();
+            start_cycles = BENCH_CYCLES();
+            for (uint32_t raw = 0; raw < BENCH_RAW_MAX; raw++)
+                sink += BME280_Compensation_Pressure(&coeff, raw, t_fine);
+            time[3].cycles += BENCH_CYCLES() - start_cycles;
+            time[3].ns += now_ns() - start_ns;
+            time[3].samples += BENCH_RAW_MAX;
+
+            start_ns = now_ns();
+            start_cycles = BENCH_CYCLES();
+            for (uint32_t raw = 0; raw < BENCH_HUM_MAX; raw++)
+                sink += previous_humidity(&calib_data, raw);
+            time[4].cycles += BENCH_CYCLES() - start_cycles;
+            time[4].ns += now_ns() - start_ns;
+            time[4].samples += BENCH_HUM_MAX;
+            start_ns = now_ns();
+            start_cycles = BENCH_CYCLES();
+            for (uint32_t raw = 0; raw < BENCH_HUM_MAX; raw++)
+                sink += BME280_Compensation_Humidity(&coeff, raw, t_fine);
+            time[5].cycles += BENCH_CYCLES() - start_cycles;
+            time[5].ns += now_ns() - start_ns;
+            time[5].samples += BENCH_HUM_MAX;
+        }
+    }
+
+    print_time("Temperature", &time[0], &time[1]);
+    print_time("Pressure", &time[2], &time[3]);
+    print_time("Humidity", &time[4], &time[5]);
+    (void)sink;
+    printf("%llu mismatches\n", (unsigned long long)mismatches);
+    return mismatches ? 1 : 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,132 @@
+/*
+*   CPU-busy time of the BME280 I2C transaction engine on the host bus model.
+*
+*   Blocking: BME280_ReadData and the calibration read wait for the end
+*   of the transaction, so the CPU is busy for the whole bus time.
+*   Non-blocking: BME280_ReadDataAsync queues the read and returns; the
+*   CPU is busy only in the I2C interrupt (BME280_MODEL_ISR_NS per byte
+*   on the bus) while the application works (BENCH_WORK_US per sample,
+*   for compensation and UART output) and the bus runs the read.
+*   The CPU-busy time per sample and the time per sample with the
+*   application work are printed for both.
+*
+*   The blocking functions are also called with interrupts disabled:
+*   they must return BME280_E_INT_DISABLED instead of waiting forever.
+*   BME280_I2C_Interface_IsDeviceConnected must find the sensor and not
+*   an address with no device, as a queued transaction.
+*
+*   Build and run from this folder:
+*   gcc -O2 -I. -I../01-BME280.cydsn bme280_cpu_bench.c bme280_bus_model.c
+*       ../01-BME280.cydsn/BME280.c ../01-BME280.cydsn/BME280_I2C_Interface.c
+*       ../01-BME280.cydsn/BME280_Compensation.c -o bme280_cpu_bench
+*   ./bme280_cpu_bench
+*
+*   \author Davide Marzorati
+*/
+
+#include <stdio.h>
+#include "project.h"
+#include "BME280.h"
+#include "BME280_RegMap.h"
+#include "bme280_bus_model.h"
+
+#define BENCH_SAMPLES 1000
+
+// Temperature and pressure calibration registers (0x88-0xA1)
+#define BENCH_CALIB_LEN 26
+
+// Work of the application for each sample in us
+#define BENCH_WORK_US 150
+
+static BME280 bme280;
+
+static double us_per_sample(uint64_t ns)
+{
+    return ns / 1000.0 / BENCH_SAMPLES;
+}
+
+int main(void)
+{
+    uint64_t start, busy, elapsed;
+    uint8_t calib[BENCH_CALIB_LEN];
+    int failures = 0;
+
+    BME280_Model_Reset();
+    BME280_Model_AddDevice(BME280_I2C_ADDRESS_PRIMARY);
+    BME280_Setup(&bme280, &BME280_Model_I2C_Bus, BME280_I2C_ADDRESS_PRIMARY);
+    if ( BME280_Start(&bme280) != BME280_OK)
+    {
+        printf("Sensor not started\n");
+        return 1;
+    }
+
+    // Blocking: the CPU waits for each transaction
+    BME280_Model_ClearStats();
+    start = BME280_Model_Time();
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        failures += (BME280_ReadData(&bme280, BME280_ALL_COMP) != BME280_OK);
+    }
+    busy = BME280_Model_Time() - start;
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        BME280_Model_Advance(BENCH_WORK_US * 1000u);
+        BME280_ReadData(&bme280, BME280_ALL_COMP);
+    }
+    elapsed = BME280_Model_Time() - start - busy;
+    printf("Blocking:     CPU busy %6.1f us/sample, %6.1f us/sample with %u us of work\n",
+           us_per_sample(busy), us_per_sample(elapsed), BENCH_WORK_US);
+
+    // Non-blocking: the CPU works while the bus reads the next sample
+    BME280_Model_ClearStats();
+    start = BME280_Model_Time();
+    BME280_ReadDataAsync(&bme280, NULL, NULL);
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        BME280_Model_Advance(BENCH_WORK_US * 1000u);
+        BME280_Model_Wait();
+        failures += (bme280.transaction.error != BME280_OK);
+        BME280_ParseSensorData(&bme280, bme280.raw_data);
+        BME280_CompensateData(&bme280, BME280_ALL_COMP);
+        if ( i + 1 < BENCH_SAMPLES)
+        {
+            BME280_ReadDataAsync(&bme280, NULL, NULL);
+        }
+    }
+    elapsed = BME280_Model_Time() - start;
+    busy = (uint64_t)BME280_Model_Stats_Data.interrupts * BME280_MODEL_ISR_NS;
+    printf("Non-blocking: CPU busy %6.1f us/sample, %6.1f us/sample with %u us of work\n",
+           us_per_sample(busy), us_per_sample(elapsed), BENCH_WORK_US);
+
+    // Calibration read of temperature and pressure
+    BME280_Model_ClearStats();
+    start = BME280_Model_Time();
+    BME280_Model_I2C_Bus.read(bme280.address, BME280_CALIB_TEMP_PRESS_REG_ADDR,
+        BENCH_CALIB_LEN, calib);
+    printf("Calibration read: blocking %.1f us, interrupts %.1f us\n",
+           (BME280_Model_Time() - start) / 1000.0,
+           BME280_Model_Stats_Data.interrupts * BME280_MODEL_ISR_NS / 1000.0);
+
+    // Probe of the addresses through the queue
+    failures += (BME280_I2C_Interface_IsDeviceConnected(BME280_I2C_ADDRESS_PRIMARY) != BME280_OK);
+    failures += (BME280_I2C_Interface_IsDeviceConnected(BME280_I2C_ADDRESS_SECONDARY)
+                    != BME280_E_DEV_NOT_FOUND);
+
+    // Blocking calls with interrupts disabled
+    CyGlobalIntDisable;
+    failures += (BME280_ReadData(&bme280, BME280_ALL_COMP) != BME280_E_INT_DISABLED);
+    failures += (BME280_I2C_Interface_IsDeviceConnected(BME280_I2C_ADDRESS_PRIMARY)
+                    != BME280_E_INT_DISABLED);
+    {
+        BME280* devices[1] = {&bme280};
+        failures += (BME280_PollDevices(devices, 1, BME280_ALL_COMP) != BME280_E_INT_DISABLED);
+    }
+    CyGlobalIntEnable;
+    failures += (bme280.transaction.status != BME280_I2C_DONE);
+    failures += (BME280_ReadData(&bme280, BME280_ALL_COMP) != BME280_OK);
+
+    printf("%s\n", failures ? "FAILED" : "Errors and probes as expected");
+    return failures ? 1 : 0;
+}
+
+/* [] END OF FILE */
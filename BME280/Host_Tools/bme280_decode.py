@@ -0,0 +1,494 @@
+#!/usr/bin/env python3
+"""Decode the telemetry stream of the 01-BME280 project.
+
+The format is selected by TELEMETRY_MODE in main.c (see BME280_Telemetry.h):
+- TELEMETRY_RAW: the device sends the calibration packet once and then one
+  raw data packet per sample. This script compensates the raw frames with
+  the same 32 bit integer formulas used by the firmware.
+- TELEMETRY_DELTA: the device sends keyframes with compensated values and
+  varint differences in between.
+- TELEMETRY_SUMMARY: the device sends minimum, maximum, mean and standard
+  deviation of each channel once per window of samples.
+- TELEMETRY_CHANGE: the device sends compensated values only when they
+  change by more than a threshold. This script repeats the last values
+  for the samples that were not sent.
+- TELEMETRY_STAMPED: the device sends compensated values with the time
+  they were read, in us. The first column is the timestamp, and the
+  mean and jitter of the sample period are printed at the end.
+
+One CSV line is printed per sample, or per window for summaries.
+
+Usage:
+    python3 bme280_decode.py capture.bin
+    python3 bme280_decode.py --format delta capture.bin
+    python3 bme280_decode.py --format summary capture.bin
+    python3 bme280_decode.py --format change capture.bin
+    python3 bme280_decode.py --format stamped capture.bin
+    python3 bme280_decode.py --port COM3 --baud 115200   (needs pyserial)
+"""
+
+import argparse
+import struct
+import sys
+
+CALIB_HEADER = b"\x0A\x0C"
+CALIB_TAIL = b"\xA0\xC0"
+CALIB_PACKED_LEN = 33
+CALIB_PACKET_LEN = 2 + 1 + CALIB_PACKED_LEN + 1 + 2
+RAW_SYNC = 0x0B
+RAW_PACKET_LEN = 9
+BME280_WHO_AM_I = 0x60
+DELTA_SYNC = b"\x80\x00"
+CHANGE_HEADER = b"\x0A\x0E"
+CHANGE_TAIL = b"\xA0\xC0"
+CHANGE_PACKET_LEN = 2 + 2 + 3 * 4 + 2
+STAMPED_HEADER = b"\x0A\x0B"
+STAMPED_TAIL = b"\xA0\xC0"
+STAMPED_PACKET_LEN = 2 + 4 + 3 * 4 + 2
+SUMMARY_HEADER = b"\x0A\x0F"
+SUMMARY_TAIL = b"\xA0\xC0"
+SUMMARY_PACKET_LEN = 2 + 2 + 3 * 4 * 4 + 1 + 2
+SUMMARY_FRAC_BITS = 8
+# Scale of each channel to physical units: pressure, temperature, humidity
+SUMMARY_SCALES = (1.0, 100.0, 1024.0)
+
+
+def div(a, b):
+    """Integer division truncating toward zero, as in C."""
+    q = abs(a) // abs(b)
+    return q if (a >= 0) == (b >= 0) else -q
+
+
+def s32(x):
+    x &= 0xFFFFFFFF
+    return x - 0x100000000 if x & 0x80000000 else x
+
+
+def u32(x):
+    return x & 0xFFFFFFFF
+
+
+class Compensator:
+    """32 bit integer compensation, same results as BME280_Compensation.c."""
+
+    def __init__(self, packed):
+        (self.T1, self.T2, self.T3, self.P1, self.P2, self.P3, self.P4,
+         self.P5, self.P6, self.P7, self.P8, self.P9, self.H1, self.H2,
+         self.H3, self.H4, self.H5, self.H6) = struct.unpack(
+            ">HhhHhhhhhhhhBhBhhb", packed)
+
+    def temperature(self, adc_t):
+        var1 = div(s32((div(adc_t, 8) - self.T1 * 2) * self.T2), 2048)
+        var2 = div(adc_t, 16) - self.T1
+        var2 = div(s32(div(s32(var2 * var2), 4096) * self.T3), 16384)
+        t_fine = s32(var1 + var2)
+        t = div(s32(t_fine * 5 + 128), 256)
+        return min(max(t, -4000), 8500), t_fine
+
+    def pressure(self, adc_p, t_fine):
+        var1 = div(t_fine, 2) - 64000
+        var3 = s32(div(var1, 4) * div(var1, 4))
+        var2 = s32(div(var3, 2048) * self.P6 + s32(var1 * self.P5 * 2))
+        var2 = s32(div(var2, 4) + self.P4 * 65536)
+        var3 = div(s32(self.P3 * div(var3, 8192)), 8)
+        var4 = div(s32(self.P2 * var1), 2)
+        var1 = div(s32(var3 + var4), 262144)
+        divisor = div(s32((32768 + var1) * self.P1), 32768)
+        offset = div(var2, 4096)
+        if divisor == 0:
+            return 30000
+        p = u32(u32(u32(1048576 - adc_p) - u32(offset)) * 3125)
+        if p < 0x80000000:
+            p = u32(p << 1) // u32(divisor)
+        else:
+            p = (p // u32(divisor)) * 2
+        var1 = div(s32(self.P9 * s32(u32((p // 8) * (p // 8)) // 8192)), 4096)
+        var2 = div(s32(s32(p // 4) * self.P8), 8192)
+        p = u32(s32(p) + div(s32(var1 + var2 + self.P7), 16))
+        return min(max(p, 30000), 110000)
+
+    def humidity(self, adc_h, t_fine):
+        var1 = s32(t_fine - 76800)
+        var2 = div(s32(var1 * self.H6), 1024)
+        var3 = div(s32(var1 * self.H3), 2048)
+        var4 = s32(div(s32(var2 * (var3 + 32768)), 1024) + 2097152)
+        scale = div(s32(var4 * self.H2 + 8192), 16384)
+        var2 = s32(adc_h * 16384)
+        var5 = div(s32(var2 - (self.H4 * 1048576 - 16384) - s32(self.H5 * var1)), 32768)
+        var3 = s32(var5 * scale)
+        var4 = div(s32(div(var3, 32768) * div(var3, 32768)), 128)
+        var5 = s32(var3 - div(s32(var4 * self.H1), 16))
+        var5 = min(max(var5, 0), 419430400)
+        return min(div(var5, 4096), 102400)
+
+
+def parse_frame(frame):
+    adc_p = (frame[0] << 12) | (frame[1] << 4) | (frame[2] >> 4)
+    adc_t = (frame[3] << 12) | (frame[4] << 4) | (frame[5] >> 4)
+    adc_h = (frame[6] << 8) | frame[7]
+    return adc_t, adc_p, adc_h
+
+
+class RawDecoder:
+    """Split the byte stream in packets and compensate raw frames."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.comp = None
+        self.sequence = None
+        self.count = 0
+        self.lost = 0
+
+    def feed(self, data):
+        self.buffer += data
+        samples = []
+        while True:
+            if len(self.buffer) >= 2 and self.buffer[:2] == CALIB_HEADER:
+                if len(self.buffer) < CALIB_PACKET_LEN:
+                    break
+                packet = self.buffer[:CALIB_PACKET_LEN]
+                if (packet[-2:] == CALIB_TAIL and packet[2] == BME280_WHO_AM_I
+                        and sum(packet[2:-2]) & 0xFF == 0):
+                    self.comp = Compensator(bytes(packet[3:3 + CALIB_PACKED_LEN]))
+                    self.sequence = None
+                    del self.buffer[:CALIB_PACKET_LEN]
+                    continue
+            elif len(self.buffer) >= 1 and self.buffer[0] == RAW_SYNC:
+                if len(self.buffer) < RAW_PACKET_LEN + 1:
+                    break
+                nxt = self.buffer[RAW_PACKET_LEN]
+                if self.comp is not None and nxt in (RAW_SYNC, CALIB_HEADER[0]):
+                    samples.append(self._sample(self.buffer[1:RAW_PACKET_LEN]))
+                    del self.buffer[:RAW_PACKET_LEN]
+                    continue
+            elif len(self.buffer) < 1:
+                break
+            # Not aligned on a packet, resynchronize
+            del self.buffer[:1]
+        return samples
+
+    def flush(self):
+        """Decode the last packet, which is not followed by another one."""
+        if (self.comp is not None and len(self.buffer) == RAW_PACKET_LEN
+                and self.buffer[0] == RAW_SYNC):
+            sample = self._sample(self.buffer[1:])
+            del self.buffer[:]
+            return [sample]
+        return []
+
+    def _sample(self, frame):
+        sequence = ((frame[2] & 0x0F) << 4) | (frame[5] & 0x0F)
+        if self.sequence is not None:
+            self.lost += (sequence - self.sequence - 1) & 0xFF
+        self.sequence = sequence
+        self.count += 1
+        adc_t, adc_p, adc_h = parse_frame(frame)
+        t, t_fine = self.comp.temperature(adc_t)
+        return (sequence, t, self.comp.pressure(adc_p, t_fine),
+                self.comp.humidity(adc_h, t_fine))
+
+    def summary(self):
+        return "%d samples, %d lost" % (self.count, self.lost)
+
+
+def zigzag_decode(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+class DeltaDecoder:
+    """Rebuild compensated values from keyframes and varint differences."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.values = None
+        self.count = 0
+        self.skipped = 0
+        self.rejected = 0
+
+    def _varint(self, pos):
+        """Return (value, next position), None if incomplete, or raise on sync."""
+        value = 0
+        shift = 0
+        while pos < len(self.buffer):
+            byte = self.buffer[pos]
+            if byte & 0x80 and self.buffer[pos + 1:pos + 2] == b"\x00":
+                raise ValueError("sync inside a record")
+            value |= (byte & 0x7F) << shift
+            pos += 1
+            if not byte & 0x80:
+                return value, pos
+            shift += 7
+            if shift > 28:
+                raise ValueError("varint too long")
+        return None
+
+    def _record(self, pos, count):
+        fields = []
+        for _ in range(count):
+            result = self._varint(pos)
+            if result is None:
+                return None
+            value, pos = result
+            fields.append(value)
+        return fields, pos
+
+    def feed(self, data):
+        self.buffer += data
+        samples = []
+        while len(self.buffer) >= 2:
+            try:
+                if self.buffer[:2] == DELTA_SYNC:
+                    result = self._record(2, 3)
+                    if result is None or result[1] >= len(self.buffer):
+                        break
+                    fields, end = result[0], result[1] + 1
+                    if sum(self.buffer[2:end]) & 0x7F:
+                        raise ValueError("bad keyframe checksum")
+                    self.values = [zigzag_decode(fields[0]), fields[1], fields[2]]
+                elif self.values is not None:
+                    result = self._record(0, 3)
+                    if result is None:
+                        break
+                    fields, end = result
+                    self._apply(fields)
+                else:
+                    raise ValueError("not synchronized")
+            except ValueError:
+                if self.buffer[:2] == DELTA_SYNC:
+                    self.rejected += 1
+                # Wait for the next keyframe
+                self.values = None
+                self.skipped += 1
+                del self.buffer[:1]
+                continue
+            del self.buffer[:end]
+            samples.append(self._sample())
+        return samples
+
+    def _apply(self, fields):
+        for i in range(3):
+            self.values[i] += zigzag_decode(fields[i])
+        self.values[1] &= 0xFFFFFFFF
+        self.values[2] &= 0xFFFFFFFF
+
+    def _sample(self):
+        self.count += 1
+        return (self.count - 1, self.values[0], self.values[1], self.values[2])
+
+    def flush(self):
+        """Decode the last record, which may end with the stream."""
+        samples = self.feed(b"")
+        if self.values is not None and self.buffer:
+            try:
+                result = self._record(0, 3)
+            except ValueError:
+                result = None
+            if result is not None and result[1] == len(self.buffer):
+                self._apply(result[0])
+                samples.append(self._sample())
+                del self.buffer[:]
+        return samples
+
+    def summary(self):
+        return "%d samples, %d bytes skipped, %d keyframes rejected" % (
+            self.count, self.skipped, self.rejected)
+
+
+class ChangeDecoder:
+    """Rebuild all the samples from the change packets."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.sequence = None
+        self.values = None
+        self.count = 0
+        self.received = 0
+        self.skipped = 0
+
+    def feed(self, data):
+        self.buffer += data
+        samples = []
+        while len(self.buffer) >= 2:
+            if self.buffer[:2] == CHANGE_HEADER:
+                if len(self.buffer) < CHANGE_PACKET_LEN:
+                    break
+                packet = self.buffer[:CHANGE_PACKET_LEN]
+                if packet[-2:] == CHANGE_TAIL:
+                    samples += self._packet(bytes(packet))
+                    del self.buffer[:CHANGE_PACKET_LEN]
+                    continue
+            # Not aligned on a packet, resynchronize
+            self.skipped += 1
+            del self.buffer[:1]
+        return samples
+
+    def flush(self):
+        return self.feed(b"")
+
+    def _packet(self, packet):
+        sequence, p, t, h = struct.unpack(">HIiI", packet[2:-2])
+        samples = []
+        if self.sequence is not None:
+            # Samples within the thresholds keep the last values
+            for _ in range((sequence - self.sequence - 1) & 0xFFFF):
+                samples.append(self._sample())
+        self.sequence = sequence
+        self.values = (t, p, h)
+        self.received += 1
+        samples.append(self._sample())
+        return samples
+
+    def _sample(self):
+        self.count += 1
+        return (self.count - 1,) + self.values
+
+    def summary(self):
+        return "%d samples, %d packets, %d bytes skipped" % (
+            self.count, self.received, self.skipped)
+
+
+class StampedDecoder:
+    """Extract samples and timestamps from stamped packets."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.last = None
+        self.time = 0
+        self.intervals = []
+        self.skipped = 0
+
+    def feed(self, data):
+        self.buffer += data
+        samples = []
+        while len(self.buffer) >= 2:
+            if self.buffer[:2] == STAMPED_HEADER:
+                if len(self.buffer) < STAMPED_PACKET_LEN:
+                    break
+                packet = self.buffer[:STAMPED_PACKET_LEN]
+                if packet[-2:] == STAMPED_TAIL:
+                    samples.append(self._sample(bytes(packet)))
+                    del self.buffer[:STAMPED_PACKET_LEN]
+                    continue
+            # Not aligned on a packet, resynchronize
+            self.skipped += 1
+            del self.buffer[:1]
+        return samples
+
+    def flush(self):
+        return self.feed(b"")
+
+    def _sample(self, packet):
+        stamp, p, t, h = struct.unpack(">IIiI", packet[2:-2])
+        if self.last is not None:
+            # Timestamps wrap around at 2^32 us
+            interval = (stamp - self.last) & 0xFFFFFFFF
+            self.intervals.append(interval)
+            self.time += interval
+        else:
+            self.time = stamp
+        self.last = stamp
+        return (self.time, t, p, h)
+
+    def summary(self):
+        count = len(self.intervals)
+        if count == 0:
+            return "%d samples, %d bytes skipped" % (count + (self.last is not None),
+                                                     self.skipped)
+        mean = sum(self.intervals) / count
+        jitter = (sum((x - mean) ** 2 for x in self.intervals) / count) ** 0.5
+        return "%d samples, period %.1f us (min %d, max %d, jitter %.1f), %d bytes skipped" % (
+            count + 1, mean, min(self.intervals), max(self.intervals), jitter, self.skipped)
+
+
+class SummaryDecoder:
+    """Extract window statistics from summary packets."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.count = 0
+        self.skipped = 0
+
+    def feed(self, data):
+        self.buffer += data
+        summaries = []
+        while len(self.buffer) >= 2:
+            if self.buffer[:2] == SUMMARY_HEADER:
+                if len(self.buffer) < SUMMARY_PACKET_LEN:
+                    break
+                packet = self.buffer[:SUMMARY_PACKET_LEN]
+                if packet[-2:] == SUMMARY_TAIL and sum(packet[2:-2]) & 0xFF == 0:
+                    summaries.append(self._summary(bytes(packet)))
+                    del self.buffer[:SUMMARY_PACKET_LEN]
+                    continue
+            # Not aligned on a packet, resynchronize
+            self.skipped += 1
+            del self.buffer[:1]
+        return summaries
+
+    def flush(self):
+        return self.feed(b"")
+
+    def _summary(self, packet):
+        self.count += 1
+        values = struct.unpack(">H" + "iiiI" * 3, packet[2:-3])
+        channels = []
+        for i, scale in enumerate(SUMMARY_SCALES):
+            minimum, maximum, mean, std_dev = values[1 + 4 * i:5 + 4 * i]
+            channels.append((minimum / scale, maximum / scale,
+                             mean / scale / (1 << SUMMARY_FRAC_BITS),
+                             std_dev / scale / (1 << SUMMARY_FRAC_BITS)))
+        return values[0], channels
+
+    def summary(self):
+        return "%d windows, %d bytes skipped" % (self.count, self.skipped)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", nargs="?", help="binary capture of the UART stream")
+    parser.add_argument("--format", default="raw",
+                        choices=("raw", "delta", "summary", "change", "stamped"),
+                        help="TELEMETRY_MODE of the device")
+    parser.add_argument("--port", help="serial port to read from")
+    parser.add_argument("--baud", type=int, default=115200)
+    args = parser.parse_args()
+
+    if args.port:
+        import serial
+        source = serial.Serial(args.port, args.baud, timeout=1)
+    elif args.capture:
+        source = open(args.capture, "rb")
+    else:
+        source = sys.stdin.buffer
+
+    if args.format == "summary":
+        decoder = SummaryDecoder()
+        print("samples," + ",".join("%s_%s" % (name, stat)
+                                    for name in ("pressure_Pa", "temperature_C", "humidity_RH")
+                                    for stat in ("min", "max", "mean", "std")))
+    else:
+        decoder = {"raw": RawDecoder, "delta": DeltaDecoder,
+                   "change": ChangeDecoder, "stamped": StampedDecoder}[args.format]()
+        print("%s,temperature_C,pressure_Pa,humidity_RH" % (
+            "time_us" if args.format == "stamped" else "sequence"))
+    try:
+        while True:
+            data = source.read(256)
+            if not data and args.port:
+                continue
+            samples = decoder.feed(data) if data else decoder.flush()
+            if args.format == "summary":
+                for count, channels in samples:
+                    print("%d,%s" % (count, ",".join("%.6g" % v for c in channels for v in c)))
+            else:
+                for seq, t, p, h in samples:
+                    print("%d,%.2f,%d,%.3f" % (seq, t / 100.0, p, h / 1024.0))
+            if not data:
+                break
+    except KeyboardInterrupt:
+        pass
+    sys.stderr.write(decoder.summary() + "\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,140 @@
+/*
+*   Accuracy sweep and benchmark of BME280_Derived on a host.
+*
+*   The fixed point functions are compared with the double precision
+*   formulas over the operating range of the sensor, and timed against
+*   the float and double versions based on libm.
+*
+*   Build and run from this folder:
+*   gcc -O2 -I. -I../01-BME280.cydsn bme280_derived_bench.c
+*       ../01-BME280.cydsn/BME280_Derived.c -lm -o bme280_derived_bench
+*   ./bme280_derived_bench
+*
+*   \author Davide Marzorati
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include "BME280_Derived.h"
+
+#define BENCH_COUNT 2000000
+
+/******************************************/
+/*          Reference formulas            */
+/******************************************/
+
+static double altitude_ref(double p, double p0)
+{
+    return 44330.0 * (1.0 - pow(p / p0, 1.0 / 5.255));
+}
+
+static double sea_level_ref(double p, double h)
+{
+    return p / pow(1.0 - h / 44330.0, 5.255);
+}
+
+static double dew_point_ref(double t, double rh)
+{
+    double g = log(rh / 100.0) + 17.62 * t / (243.12 + t);
+    return 243.12 * g / (17.62 - g);
+}
+
+static float altitude_float(float p, float p0)
+{
+    return 44330.0f * (1.0f - powf(p / p0, 1.0f / 5.255f));
+}
+
+static float dew_point_float(float t, float rh)
+{
+    float g = logf(rh / 100.0f) + 17.62f * t / (243.12f + t);
+    return 243.12f * g / (17.62f - g);
+}
+
+static double elapsed_ns(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / BENCH_COUNT;
+}
+
+int main(void)
+{
+    double error, max_altitude = 0, max_sea_level = 0, max_dew_point = 0;
+    volatile int32_t sink_i = 0;
+    volatile float sink_f = 0;
+    volatile double sink_d = 0;
+    clock_t start;
+
+    // Altitude: 300 to 1100 hPa, sea-level pressure 950 to 1050 hPa
+    for (uint32_t p0 = 95000; p0 <= 105000; p0 += 2500)
+    {
+        for (uint32_t p = 30000; p <= 110000; p++)
+        {
+            error = fabs(BME280_Derived_Altitude(p, p0) / 100.0 - altitude_ref(p, p0));
+            max_altitude = (error > max_altitude) ? error : max_altitude;
+        }
+    }
+    // Sea-level pressure: -500 to 9000 m, 300 to 1100 hPa
+    for (int32_t h = -50000; h <= 900000; h += 97)
+    {
+        for (uint32_t p = 30000; p <= 110000; p += 5003)
+        {
+            error = fabs(BME280_Derived_SeaLevelPressure(p, h) - sea_level_ref(p, h / 100.0));
+            max_sea_level = (error > max_sea_level) ? error : max_sea_level;
+        }
+    }
+    // Dew point: -40 to 85 degC, 1 to 100 %RH
+    for (int32_t t = -4000; t <= 8500; t += 7)
+    {
+        for (uint32_t h = 1024; h <= 102400; h += 101)
+        {
+            error = fabs(BME280_Derived_DewPoint(t, h) / 100.0 - dew_point_ref(t / 100.0, h / 1024.0));
+            max_dew_point = (error > max_dew_point) ? error : max_dew_point;
+        }
+    }
+    printf("Max error: altitude %.4f m, sea-level pressure %.3f Pa, dew point %.4f degC\n",
+           max_altitude, max_sea_level, max_dew_point);
+
+    start = clock();
+    for (uint32_t i = 0; i < BENCH_COUNT; i++)
+    {
+        sink_i = BME280_Derived_Altitude(30000 + (i & 0xFFFF), 101325);
+    }
+    printf("Altitude: fixed point %.1f ns", elapsed_ns(start));
+    start = clock();
+    for (uint32_t i = 0; i < BENCH_COUNT; i++)
+    {
+        sink_f = altitude_float(30000 + (i & 0xFFFF), 101325);
+    }
+    printf(", float %.1f ns", elapsed_ns(start));
+    start = clock();
+    for (uint32_t i = 0; i < BENCH_COUNT; i++)
+    {
+        sink_d = altitude_ref(30000 + (i & 0xFFFF), 101325);
+    }
+    printf(", double %.1f ns\n", elapsed_ns(start));
+
+    start = clock();
+    for (uint32_t i = 0; i < BENCH_COUNT; i++)
+    {
+        sink_i = BME280_Derived_DewPoint(2000 + (i & 0x7FF), 1024 + (i & 0xFFFF));
+    }
+    printf("Dew point: fixed point %.1f ns", elapsed_ns(start));
+    start = clock();
+    for (uint32_t i = 0; i < BENCH_COUNT; i++)
+    {
+        sink_f = dew_point_float((2000 + (i & 0x7FF)) / 100.0f, (1024 + (i & 0xFFFF)) / 1024.0f);
+    }
+    printf(", float %.1f ns", elapsed_ns(start));
+    start = clock();
+    for (uint32_t i = 0; i < BENCH_COUNT; i++)
+    {
+        sink_d = dew_point_ref((2000 + (i & 0x7FF)) / 100.0, (1024 + (i & 0xFFFF)) / 1024.0);
+    }
+    printf(", double %.1f ns\n", elapsed_ns(start));
+    (void)sink_i;
+    (void)sink_f;
+    (void)sink_d;
+    return 0;
+}
+
+/* [] END OF FILE */
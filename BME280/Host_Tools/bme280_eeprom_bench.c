@@ -0,0 +1,599 @@
+/*
+*   Benchmark of the BME280 EEPROM log on the host EEPROM emulator.
+*
+*   Write paths: the log is filled once in three ways, and for each one
+*   the row programs per record and the records per second that the
+*   EEPROM can take (EEPROM_EMULATOR_ROW_TIME_US per row program) are
+*   printed:
+*   - byte:   record and counter written with EEPROM_WriteByte, one
+*             byte at a time, as the log used to do;
+*   - row:    record and counter written with EEPROM_Interface_WriteBytes,
+*             which programs each row once;
+*   - log:    BME280_EEPROM_WriteData, which programs whole rows of the
+*             circular log of delta-coded blocks from RAM.
+*
+*   Wear: one year of samples at one sample per minute is written with
+*   a counter in a fixed location updated with every row of records (the
+*   previous format, assuming it wrapped around), and with the circular
+*   log, also flushing after every sample. The programs of the most and
+*   least programmed rows, and the years before the most programmed row
+*   reaches EEPROM_EMULATOR_ENDURANCE, are printed.
+*
+*   Sampling: samples are taken at fixed deadlines by a main loop that
+*   polls every BENCH_POLL_US, reads the sensor (BENCH_READ_US), and logs
+*   the sample, for BENCH_SAMPLING_S. With the blocking path, the loop
+*   waits for each full row to be programmed, as EEPROM_Interface_WriteRow
+*   does; with the background path, the loop calls BME280_EEPROM_Process
+*   while waiting for the next sample. The lateness of the samples from
+*   their deadlines, the standard deviation of the time between samples,
+*   the deadlines missed (a whole period late), and the records refused
+*   because the queue was full are printed.
+*
+*   Compression: noisy traces (a slow weather and daily cycle plus the
+*   white noise of the sensor settings) are written until the log is
+*   full many times over. The samples in the full log, the samples per
+*   kB of log, the ratio to the BENCH_LOG_RECORDS of the previous format
+*   (8-byte records), and the host time per sample of
+*   BME280_EEPROM_WriteData (without the wait for the EEPROM) and of
+*   BME280_EEPROM_ReadData are printed. Every sample read back must
+*   be the one written.
+*
+*   Boot: the log is filled to a number of samples and flushed, then
+*   the EEPROM bytes read and the host time of BME280_EEPROM_Start
+*   (binary search of the last block), and of the first
+*   BME280_EEPROM_GetCount (which decodes the other blocks) are printed.
+*
+*   Restart: three laps of the log are written with a power failure
+*   after every record (RAM state of the log cleared, then
+*   BME280_EEPROM_Start); after each restart the records read back must
+*   be the last ones programmed, with no gaps, and only the samples of
+*   the rows not yet queued may be lost. Every third record is flushed,
+*   so the log keeps at least a sample per row.
+*
+*   Power failures: a full log is written for BENCH_FAULT_SAMPLES more
+*   samples, flushed every BENCH_FAULT_FLUSH samples, with the power cut
+*   at every byte of the row programs (EEPROM_Emulator_CutPower), leaving
+*   the row torn, erased, or with random bytes (EEPROM_Emulator_SetFault).
+*   After each failure the log must be read back without gaps or
+*   corrupted samples, and must accept new samples across a further
+*   restart. No sample flushed before the failure may be lost: a
+*   programmed row is never programmed again.
+*
+*   BME280_EEPROM.c is included in this file to clear its RAM state.
+*   Build and run from this folder:
+*   gcc -O2 -I. -I../02-BME280_EEPROM.cydsn bme280_eeprom_bench.c eeprom_emulator.c
+*       ../02-BME280_EEPROM.cydsn/EEPROM_Interface.c
+*       ../02-BME280_EEPROM.cydsn/BME280_Compensation.c -lm -o bme280_eeprom_bench
+*   ./bme280_eeprom_bench
+*
+*   \author Davide Marzorati
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "eeprom_emulator.h"
+#include "../02-BME280_EEPROM.cydsn/BME280_EEPROM.c"
+
+// Endurance of the EEPROM rows (program/erase cycles)
+#ifndef EEPROM_EMULATOR_ENDURANCE
+    #define EEPROM_EMULATOR_ENDURANCE 1000000.0
+#endif
+
+// Layout of the previous formats: header, counter, 8-byte records
+#define BENCH_COUNTER_ADDRESS 4
+#define BENCH_DATA_ADDRESS 6
+#define BENCH_RECORD_LENGTH 8
+#define BENCH_RECORDS ((CALIB_START_ADDRESS - BENCH_DATA_ADDRESS) / BENCH_RECORD_LENGTH)
+#define BENCH_RECORDS_PER_ROW (CY_EEPROM_SIZEOF_ROW / BENCH_RECORD_LENGTH)
+// Records of the circular log of 8-byte records
+#define BENCH_LOG_RECORDS (LOG_ROWS * BENCH_RECORDS_PER_ROW)
+// At least a sample in each row of the blocks not being overwritten
+#define BENCH_MIN_ROWS ((LOG_BLOCKS - 1) * BLOCK_ROWS)
+// Samples of the synthetic ramp that fill the log
+#define BENCH_FULL_LOG (LOG_BLOCKS * (BLOCK_SLOTS - KEYFRAME_SLOTS + 1))
+#define BENCH_YEAR_SAMPLES (365L * 24 * 60)
+
+// Main loop of the sampling benchmark
+#define BENCH_POLL_US 100
+#define BENCH_READ_US 500
+#define BENCH_SAMPLING_S 60
+
+// Power failure benchmark: samples written after the full log, flush period
+#define BENCH_FAULT_START (2 * BENCH_FULL_LOG - 40)
+#define BENCH_FAULT_SAMPLES 60
+#define BENCH_FAULT_FLUSH 4
+
+// Restarts timed for each fill of the boot benchmark
+#define BENCH_BOOTS 1000
+
+// Samples of each trace of the compression benchmark
+#define BENCH_TRACE_SAMPLES 5000
+
+typedef struct {
+    const char* name;
+    double period;      // s
+    double noise_p;     // Pa RMS
+    double noise_t;     // 0.01 degC RMS
+    double noise_h;     // 1/1024 %RH RMS
+} Trace;
+
+// Noise of 1x and 4x oversampling from the datasheet, divided by the IIR filter with 16x
+static const Trace TRACES[] = {
+    {"1x, 10 Hz", 0.1, 3.3, 2.0, 20.0},
+    {"16x, filter 16, 1 Hz", 1.0, 0.25, 0.1, 5.0},
+    {"4x, 1/min", 60.0, 2.1, 1.0, 10.0},
+};
+
+static BME280_Data trace[BENCH_TRACE_SAMPLES];
+static uint64_t rng_state = 0x2545F4914F6CDD1DULL;
+
+static void sample(BME280* bme280, long i)
+{
+    bme280->data.temperature = 2000 + (int32_t)(i % 4000);
+    bme280->data.pressure = 100000 + (uint32_t)(i % 2000);
+    bme280->data.humidity = 45000 + 3 * (uint32_t)(i % 10000);
+}
+
+static double uniform(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return ((rng_state >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static double gauss(void)
+{
+    return sqrt(-2.0 * log(uniform())) * cos(6.283185307179586 * uniform());
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Add a record and wait until it is programmed, as a blocking write
+static EEPROM_ErrorCode write_blocking(BME280* bme280)
+{
+    EEPROM_ErrorCode error = BME280_EEPROM_WriteData(bme280);
+    if ( error == EEPROM_OK)
+    {
+        error = EEPROM_Interface_Wait();
+    }
+    return error;
+}
+
+// Power failure: the RAM state of the log is lost
+static void power_fail(void)
+{
+    head_block = LOG_BLOCKS - 1;
+    block_sequence = 0;
+    block_slots = BLOCK_SLOTS;
+    dirty_rows = 0;
+    block_count = 0;
+    record_count = 0;
+    BME280_EEPROM_Start();
+}
+
+// Samples written that survived the last power failure, -1 if the last sample is not one of them
+static long survived(long written, long max_lost)
+{
+    BME280 expected;
+    BME280_Data data;
+    long lost = 0;
+
+    if ( BME280_EEPROM_ReadData(BME280_EEPROM_GetCount() - 1, &data) != EEPROM_OK)
+    {
+        return -1;
+    }
+    do
+    {
+        sample(&expected, written - 1 - lost);
+    } while ( (data.temperature != expected.data.temperature || data.pressure != expected.data.pressure) &&
+              ++lost <= max_lost);
+    return (lost <= max_lost) ? written - lost : -1;
+}
+
+static void row_range(uint32_t* max, uint32_t* min)
+{
+    *max = 0;
+    *min = UINT32_MAX;
+    for (uint16_t r = 0; r < CY_EEPROM_NUMBER_ROWS; r++)
+    {
+        uint32_t erases = EEPROM_Emulator_Stats_Data.row_erases[r];
+        if ( erases > *max)
+        {
+            *max = erases;
+        }
+        // Rows of the header and of the calibration data are not counted
+        if ( r >= LOG_START_ROW && r < LOG_START_ROW + LOG_ROWS && erases < *min)
+        {
+            *min = erases;
+        }
+    }
+}
+
+static void print_path(const char* name, long records)
+{
+    uint32_t max, min;
+    double programs = (double)EEPROM_Emulator_Stats_Data.row_programs;
+    row_range(&max, &min);
+    printf("%-8s %8ld %10.0f %10.2f %10.2f %10u\n", name, records, programs, programs / records,
+           records / (programs * EEPROM_EMULATOR_ROW_TIME_US / 1e6), max);
+}
+
+static void print_wear(const char* name)
+{
+    uint32_t max, min;
+    row_range(&max, &min);
+    printf("%-22s %10u %10u %14.1f\n", name, max, min, EEPROM_EMULATOR_ENDURANCE / max);
+}
+
+// The log must hold the last samples written, at least min_count of them
+static int check_log(long written, long min_count)
+{
+    BME280 expected;
+    BME280_Data data;
+    uint16_t count = BME280_EEPROM_GetCount();
+    int ok = (count <= written) && (count >= ((written < min_count) ? written : min_count));
+
+    for (uint16_t i = 0; i < count && ok; i++)
+    {
+        sample(&expected, written - count + i);
+        ok = (BME280_EEPROM_ReadData(i, &data) == EEPROM_OK) &&
+             data.temperature == expected.data.temperature && data.pressure == expected.data.pressure &&
+             data.humidity == expected.data.humidity;
+    }
+    return ok;
+}
+
+static void boot(const char* name, long samples)
+{
+    BME280 bme280;
+    double start, start_ns, count_ns;
+    uint32_t start_bytes, count_bytes;
+    uint16_t count;
+
+    EEPROM_Emulator_Reset();
+    power_fail();
+    for (long i = 0; i < samples; i++)
+    {
+        sample(&bme280, i);
+        write_blocking(&bme280);
+    }
+    BME280_EEPROM_Flush();
+    EEPROM_Emulator_Stats_Data.bytes_read = 0;
+    start = now_ns();
+    for (int i = 0; i < BENCH_BOOTS; i++)
+    {
+        power_fail();
+    }
+    start_ns = (now_ns() - start) / BENCH_BOOTS;
+    start_bytes = EEPROM_Emulator_Stats_Data.bytes_read / BENCH_BOOTS;
+    EEPROM_Emulator_Stats_Data.bytes_read = 0;
+    start = now_ns();
+    count = BME280_EEPROM_GetCount();
+    count_ns = now_ns() - start;
+    count_bytes = EEPROM_Emulator_Stats_Data.bytes_read;
+    printf("%-16s %8u %10u %10.0f %10u %10.0f\n", name, count, start_bytes, start_ns, count_bytes, count_ns);
+}
+
+// Write the power failure workload on the log in snapshot, with the power cut after cut bytes
+static int fault(const uint8_t* snapshot, EEPROM_Emulator_Fault mode, uint32_t cut,
+                 uint32_t* programmed, long* flushed_lost)
+{
+    BME280 bme280;
+    long written = BENCH_FAULT_START;
+    long flushed = written;
+    long recovered;
+    int ok = 1;
+
+    EEPROM_Emulator_Reset();
+    memcpy(EEPROM_Emulator_Memory, snapshot, CY_EEPROM_SIZE);
+    power_fail();
+    EEPROM_Emulator_SetFault(mode);
+    EEPROM_Emulator_CutPower(cut);
+    for (int i = 1; i <= BENCH_FAULT_SAMPLES; i++)
+    {
+        sample(&bme280, written++);
+        ok &= (write_blocking(&bme280) == EEPROM_OK);
+        if ( i % BENCH_FAULT_FLUSH == 0)
+        {
+            ok &= (BME280_EEPROM_Flush() == EEPROM_OK);
+            // Flushed if all the rows were programmed before the failure
+            if ( cut == EEPROM_EMULATOR_NO_FAULT || EEPROM_Emulator_Stats_Data.bytes_programmed <= cut)
+            {
+                flushed = written;
+            }
+        }
+    }
+    *programmed = EEPROM_Emulator_Stats_Data.bytes_programmed;
+
+    EEPROM_Emulator_CutPower(EEPROM_EMULATOR_NO_FAULT);
+    power_fail();
+    recovered = survived(written, written - BENCH_FAULT_START + BLOCK_SLOTS);
+    ok &= (recovered >= 0) && check_log(recovered, BENCH_LOG_RECORDS);
+    *flushed_lost = flushed - recovered;
+
+    // The log goes on after the torn rows
+    written = recovered;
+    for (int i = 0; i < BENCH_FAULT_SAMPLES; i++)
+    {
+        sample(&bme280, written++);
+        ok &= (write_blocking(&bme280) == EEPROM_OK);
+    }
+    ok &= (BME280_EEPROM_Flush() == EEPROM_OK);
+    power_fail();
+    ok &= check_log(written, BENCH_LOG_RECORDS);
+    return ok;
+}
+
+static int compression(const Trace* t)
+{
+    BME280 bme280;
+    BME280_Data data;
+    double start, write_ns, read_ns;
+    int ok = 1;
+
+    for (int i = 0; i < BENCH_TRACE_SAMPLES; i++)
+    {
+        // Weather over three days and daily cycle, plus the noise of the sensor
+        double day = 6.283185307179586 * i * t->period / 86400.0;
+        trace[i].pressure = (uint32_t)lround(100000.0 + 300.0 * sin(day / 3.0) + t->noise_p * gauss());
+        trace[i].temperature = (int32_t)lround(2200.0 + 200.0 * sin(day) + t->noise_t * gauss());
+        trace[i].humidity = (uint32_t)lround(46080.0 + 5120.0 * sin(day + 1.0) + t->noise_h * gauss());
+    }
+    EEPROM_Emulator_Reset();
+    power_fail();
+    write_ns = 0;
+    for (int i = 0; i < BENCH_TRACE_SAMPLES; i++)
+    {
+        bme280.data = trace[i];
+        // The wait for the emulated EEPROM is not timed
+        start = now_ns();
+        ok &= (BME280_EEPROM_WriteData(&bme280) == EEPROM_OK);
+        write_ns += now_ns() - start;
+        ok &= (EEPROM_Interface_Wait() == EEPROM_OK);
+    }
+    write_ns /= BENCH_TRACE_SAMPLES;
+
+    uint16_t count = BME280_EEPROM_GetCount();
+    start = now_ns();
+    for (uint16_t i = 0; i < count; i++)
+    {
+        const BME280_Data* expected = &trace[BENCH_TRACE_SAMPLES - count + i];
+        ok &= (BME280_EEPROM_ReadData(i, &data) == EEPROM_OK) && data.temperature == expected->temperature &&
+              data.pressure == expected->pressure && data.humidity == expected->humidity;
+    }
+    read_ns = (now_ns() - start) / count;
+    printf("%-22s %8u %10.1f %10.2f %10.0f %10.0f\n", t->name, count,
+           count / (LOG_ROWS * CY_EEPROM_SIZEOF_ROW / 1024.0), (double)count / BENCH_LOG_RECORDS, write_ns, read_ns);
+    return ok;
+}
+
+static void sampling(const char* name, uint32_t period, int blocking)
+{
+    BME280 bme280;
+    uint64_t deadline;
+    uint64_t last = 0;
+    double late_sum = 0, late_max = 0;
+    double interval_sum = 0, interval_squares = 0;
+    long samples = 0, missed = 0, refused = 0;
+
+    EEPROM_Emulator_Reset();
+    power_fail();
+    deadline = EEPROM_Emulator_Stats_Data.time + period;
+    while ( EEPROM_Emulator_Stats_Data.time < BENCH_SAMPLING_S * 1000000ULL)
+    {
+        uint64_t now = EEPROM_Emulator_Stats_Data.time;
+        if ( now < deadline)
+        {
+            if ( blocking == 0)
+            {
+                BME280_EEPROM_Process();
+            }
+            EEPROM_Emulator_Advance(BENCH_POLL_US);
+            continue;
+        }
+        double late = (now - deadline) / 1000.0;
+        late_sum += late;
+        late_max = (late > late_max) ? late : late_max;
+        if ( samples > 0)
+        {
+            double interval = (now - last) / 1000.0;
+            interval_sum += interval;
+            interval_squares += interval * interval;
+        }
+        last = now;
+        samples++;
+        EEPROM_Emulator_Advance(BENCH_READ_US);
+        sample(&bme280, samples);
+        if ( (blocking ? write_blocking(&bme280) : BME280_EEPROM_WriteData(&bme280)) == EEPROM_E_BUSY)
+        {
+            refused++;
+        }
+        // Deadlines that passed while the sample was taken are skipped
+        deadline += period;
+        while ( deadline <= EEPROM_Emulator_Stats_Data.time)
+        {
+            deadline += period;
+            missed++;
+        }
+    }
+    double mean = interval_sum / (samples - 1);
+    printf("%-10s %10.1f %8ld %10.3f %10.3f %10.3f %8ld %8ld\n", name, period / 1000.0, samples,
+           late_sum / samples, late_max, sqrt(interval_squares / (samples - 1) - mean * mean), missed, refused);
+}
+
+int main(void)
+{
+    BME280 bme280;
+    uint8_t bytes[BENCH_RECORD_LENGTH] = {0};
+    uint8_t row[CY_EEPROM_SIZEOF_ROW] = {0};
+    int ok = 1;
+
+    printf("%-8s %8s %10s %10s %10s %10s\n", "Path", "Records", "Programs", "Per record", "Records/s", "Max row");
+
+    EEPROM_Emulator_Reset();
+    for (uint16_t i = 0; i < BENCH_RECORDS; i++)
+    {
+        uint16_t address = BENCH_DATA_ADDRESS + i * BENCH_RECORD_LENGTH;
+        for (int b = 0; b < BENCH_RECORD_LENGTH; b++)
+        {
+            EEPROM_WriteByte((uint8_t)(i + b), address + b);
+        }
+        EEPROM_WriteByte((uint8_t)((i + 1) >> 8), BENCH_COUNTER_ADDRESS);
+        EEPROM_WriteByte((uint8_t)((i + 1) & 0xFF), BENCH_COUNTER_ADDRESS + 1);
+    }
+    print_path("byte", BENCH_RECORDS);
+
+    EEPROM_Emulator_Reset();
+    for (uint16_t i = 0; i < BENCH_RECORDS; i++)
+    {
+        uint8_t counter[2] = {(uint8_t)((i + 1) >> 8), (uint8_t)((i + 1) & 0xFF)};
+        for (int b = 0; b < BENCH_RECORD_LENGTH; b++)
+        {
+            bytes[b] = (uint8_t)(i + b);
+        }
+        EEPROM_Interface_WriteBytes(bytes, BENCH_RECORD_LENGTH, BENCH_DATA_ADDRESS + i * BENCH_RECORD_LENGTH);
+        EEPROM_Interface_WriteBytes(counter, 2, BENCH_COUNTER_ADDRESS);
+    }
+    print_path("row", BENCH_RECORDS);
+
+    EEPROM_Emulator_Reset();
+    BME280_EEPROM_Start();
+    // The log is erased once by the first start
+    EEPROM_Emulator_Stats_Data = (EEPROM_Emulator_Stats){0};
+    for (uint16_t i = 0; i < BENCH_FULL_LOG; i++)
+    {
+        sample(&bme280, i);
+        ok &= (write_blocking(&bme280) == EEPROM_OK);
+    }
+    ok &= check_log(BENCH_FULL_LOG, BENCH_LOG_RECORDS);
+    print_path("log", BENCH_FULL_LOG);
+
+    printf("\n%-22s %10s %10s %14s\n", "One sample per minute", "Max row", "Min row", "Lifetime");
+    printf("%-22s %10s %10s %14s\n", "", "[1/year]", "[1/year]", "[years]");
+
+    EEPROM_Emulator_Reset();
+    for (long i = 0; i < BENCH_YEAR_SAMPLES; i += BENCH_RECORDS_PER_ROW)
+    {
+        uint16_t r = (i / BENCH_RECORDS_PER_ROW) % (BENCH_RECORDS * BENCH_RECORD_LENGTH / CY_EEPROM_SIZEOF_ROW);
+        uint8_t counter[2] = {(uint8_t)(i >> 8), (uint8_t)(i & 0xFF)};
+        EEPROM_Interface_WriteRow(row, 1 + r);
+        EEPROM_Interface_WriteBytes(counter, 2, BENCH_COUNTER_ADDRESS);
+    }
+    print_wear("fixed counter");
+
+    EEPROM_Emulator_Reset();
+    power_fail();
+    EEPROM_Emulator_Stats_Data = (EEPROM_Emulator_Stats){0};
+    for (long i = 0; i < BENCH_YEAR_SAMPLES; i++)
+    {
+        sample(&bme280, i);
+        ok &= (BME280_EEPROM_WriteData(&bme280) == EEPROM_OK);
+        EEPROM_Emulator_Advance(60000000u);
+        ok &= (BME280_EEPROM_Process() == EEPROM_OK);
+    }
+    ok &= check_log(BENCH_YEAR_SAMPLES, BENCH_LOG_RECORDS);
+    print_wear("log");
+
+    EEPROM_Emulator_Reset();
+    power_fail();
+    EEPROM_Emulator_Stats_Data = (EEPROM_Emulator_Stats){0};
+    for (long i = 0; i < BENCH_YEAR_SAMPLES; i++)
+    {
+        sample(&bme280, i);
+        ok &= (BME280_EEPROM_WriteData(&bme280) == EEPROM_OK);
+        ok &= (BME280_EEPROM_Flush() == EEPROM_OK);
+        EEPROM_Emulator_Advance(60000000u);
+    }
+    print_wear("log, flush every sample");
+
+    printf("\n%-10s %10s %8s %10s %10s %10s %8s %8s\n", "Sampling", "Period", "Samples", "Late",
+           "Max late", "Jitter", "Missed", "Refused");
+    printf("%-10s %10s %8s %10s %10s %10s\n", "", "[ms]", "", "[ms]", "[ms]", "[ms]");
+    sampling("blocking", 10000, 1);
+    sampling("background", 10000, 0);
+    sampling("blocking", 12500, 1);
+    sampling("background", 12500, 0);
+    sampling("blocking", 25000, 1);
+    sampling("background", 25000, 0);
+
+    printf("\n%-22s %8s %10s %10s %10s %10s\n", "Compression", "Samples", "Per kB", "Ratio", "Write", "Read");
+    printf("%-22s %8s %10s %10s %10s %10s\n", "", "", "", "", "[ns]", "[ns]");
+    for (uint8_t i = 0; i < sizeof(TRACES) / sizeof(TRACES[0]); i++)
+    {
+        ok &= compression(&TRACES[i]);
+    }
+
+    printf("\n%-16s %8s %10s %10s %10s %10s\n", "Boot", "Samples", "Start", "Start", "Count", "Count");
+    printf("%-16s %8s %10s %10s %10s %10s\n", "", "", "[bytes]", "[ns]", "[bytes]", "[ns]");
+    boot("empty", 0);
+    boot("one block", BLOCK_SLOTS - KEYFRAME_SLOTS);
+    boot("half", BENCH_FULL_LOG / 2);
+    boot("full", BENCH_FULL_LOG);
+    boot("after 3 laps", 3 * BENCH_FULL_LOG + BENCH_FULL_LOG / 3);
+
+    // Samples of the rows not yet queued are lost at each power failure
+    EEPROM_Emulator_Reset();
+    power_fail();
+    long written = 0;
+    long restarts = 0;
+    for (long i = 0; i < 3 * BENCH_FULL_LOG; i++)
+    {
+        sample(&bme280, written);
+        ok &= (BME280_EEPROM_WriteData(&bme280) == EEPROM_OK);
+        written++;
+        if ( i % 3 == 0)
+        {
+            ok &= (BME280_EEPROM_Flush() == EEPROM_OK);
+        }
+        ok &= (EEPROM_Interface_Wait() == EEPROM_OK);
+        power_fail();
+        restarts++;
+        // At most a block of samples is lost. Only the flushed samples
+        // survive, each in a row closed by the flush
+        written = survived(written, BLOCK_SLOTS - 1);
+        ok &= (written >= 0) && check_log(written, BENCH_MIN_ROWS);
+    }
+    printf("\n%ld restarts, stored records %s\n", restarts, ok ? "match" : "DO NOT MATCH");
+
+    // Log already full and wrapping around, so that torn rows are written over valid ones
+    static const char* const FAULTS[] = {"torn", "erased", "corrupted"};
+    static uint8_t snapshot[CY_EEPROM_SIZE];
+    uint32_t programmed, total;
+    long flushed_lost, flushed_lost_max;
+    int fault_ok;
+
+    EEPROM_Emulator_Reset();
+    power_fail();
+    for (long i = 0; i < BENCH_FAULT_START; i++)
+    {
+        sample(&bme280, i);
+        ok &= (write_blocking(&bme280) == EEPROM_OK);
+    }
+    ok &= (BME280_EEPROM_Flush() == EEPROM_OK);
+    memcpy(snapshot, EEPROM_Emulator_Memory, CY_EEPROM_SIZE);
+    for (uint8_t f = EEPROM_EMULATOR_TORN; f <= EEPROM_EMULATOR_CORRUPTED; f++)
+    {
+        flushed_lost_max = 0;
+        fault_ok = fault(snapshot, (EEPROM_Emulator_Fault)f, EEPROM_EMULATOR_NO_FAULT, &total, &flushed_lost);
+        for (uint32_t cut = 0; cut < total; cut++)
+        {
+            fault_ok &= fault(snapshot, (EEPROM_Emulator_Fault)f, cut, &programmed, &flushed_lost);
+            flushed_lost_max = (flushed_lost > flushed_lost_max) ? flushed_lost : flushed_lost_max;
+        }
+        printf("%u power failures (every byte programmed, row %s), recovered logs %s, "
+               "%ld flushed samples lost\n", total, FAULTS[f], fault_ok ? "match" : "DO NOT MATCH",
+               flushed_lost_max);
+        ok &= fault_ok && (flushed_lost_max == 0);
+    }
+    return ok ? 0 : 1;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,158 @@
+/*
+*   Several BME280 sensors on one I2C bus, on the host bus model.
+*
+*   1 to BENCH_MAX_DEVICES sensors run in normal mode (x1 oversampling,
+*   0.5 ms standby: about 100 samples/s each). For BENCH_SECONDS the
+*   application reads all the sensors once per scheduling slot of
+*   BENCH_SLOT_US, one sensor at a time with BME280_ReadData, or with
+*   BME280_PollDevices, which queues the reads of all the sensors back
+*   to back. The new samples per second of all the sensors together, and
+*   the time the CPU is busy with the bus (waiting in the blocking reads,
+*   or in the I2C interrupt), are printed for both. Addresses other than
+*   0x76 and 0x77 stand for sensors behind an address translator or a bus
+*   switch; the compensation time is not modeled.
+*
+*   Errors of single sensors: with a sensor missing from the bus, and
+*   with a device structure on which BME280_Setup was not called,
+*   BME280_PollDevices must return an error while the other sensors
+*   are read as usual.
+*
+*   Build and run from this folder:
+*   gcc -O2 -I. -I../01-BME280.cydsn bme280_multi_bench.c bme280_bus_model.c
+*       ../01-BME280.cydsn/BME280.c ../01-BME280.cydsn/BME280_I2C_Interface.c
+*       ../01-BME280.cydsn/BME280_Compensation.c -o bme280_multi_bench
+*   ./bme280_multi_bench
+*
+*   \author Davide Marzorati
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "project.h"
+#include "BME280.h"
+#include "bme280_bus_model.h"
+
+#define BENCH_SECONDS 2
+#define BENCH_SLOT_US 2500
+#define BENCH_MAX_DEVICES 8
+
+static const uint8_t BENCH_ADDRESSES[BENCH_MAX_DEVICES] = {
+    BME280_I2C_ADDRESS_PRIMARY, BME280_I2C_ADDRESS_SECONDARY, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45
+};
+
+static const BME280_Settings BENCH_SETTINGS = {
+    BME280_NORMAL_MODE, BME280_OVERSAMPLING_1X, BME280_OVERSAMPLING_1X,
+    BME280_OVERSAMPLING_1X, BME280_FILTER_COEFF_OFF, BME280_TSTANBDY_0_5_MS, 0
+};
+
+static BME280 sensors[BENCH_MAX_DEVICES];
+static BME280* devices[BENCH_MAX_DEVICES];
+static BME280_Uncomp_Data last[BENCH_MAX_DEVICES];
+
+// Count the sensors with a sample different from the previous one
+static uint32_t count_new(uint32_t count)
+{
+    uint32_t samples = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if ( memcmp(&last[i], &sensors[i].uncomp_data, sizeof(last[i])) != 0)
+        {
+            last[i] = sensors[i].uncomp_data;
+            samples++;
+        }
+    }
+    return samples;
+}
+
+// Read the sensors once per slot, return the new samples
+static uint32_t run(uint32_t count, uint8_t polled, uint64_t* busy, int* failures)
+{
+    uint64_t end = BME280_Model_Time() + BENCH_SECONDS * 1000000000ull;
+    uint64_t slot, start;
+    uint32_t samples = 0;
+
+    BME280_Model_ClearStats();
+    *busy = 0;
+    while ( BME280_Model_Time() < end)
+    {
+        slot = BME280_Model_Time();
+        if ( polled)
+        {
+            *failures += (BME280_PollDevices(devices, count, BME280_ALL_COMP) != BME280_OK);
+        }
+        else
+        {
+            start = BME280_Model_Time();
+            for (uint32_t i = 0; i < count; i++)
+            {
+                *failures += (BME280_ReadData(devices[i], BME280_ALL_COMP) != BME280_OK);
+            }
+            *busy += BME280_Model_Time() - start;
+        }
+        samples += count_new(count);
+        // Other tasks until the next slot
+        if ( BME280_Model_Time() < slot + BENCH_SLOT_US * 1000u)
+        {
+            BME280_Model_Advance(slot + BENCH_SLOT_US * 1000u - BME280_Model_Time());
+        }
+        BME280_Model_Wait();
+    }
+    if ( polled)
+    {
+        *busy = (uint64_t)BME280_Model_Stats_Data.interrupts * BME280_MODEL_ISR_NS;
+    }
+    return samples;
+}
+
+int main(void)
+{
+    uint64_t busy_sequential, busy_polled;
+    uint32_t sequential, polled;
+    BME280 missing, not_set_up;
+    BME280* mixed[4];
+    int failures = 0;
+
+    BME280_Model_Reset();
+    for (uint32_t i = 0; i < BENCH_MAX_DEVICES; i++)
+    {
+        BME280_Model_AddDevice(BENCH_ADDRESSES[i]);
+        BME280_Setup(&sensors[i], &BME280_Model_I2C_Bus, BENCH_ADDRESSES[i]);
+        failures += (BME280_Start(&sensors[i]) != BME280_OK);
+        failures += (BME280_ApplySettings(&sensors[i], &BENCH_SETTINGS) != BME280_OK);
+        devices[i] = &sensors[i];
+    }
+
+    printf("Sensors  ReadData [samples/s, CPU busy]  PollDevices [samples/s, CPU busy]\n");
+    for (uint32_t count = 1; count <= BENCH_MAX_DEVICES; count *= 2)
+    {
+        sequential = run(count, 0, &busy_sequential, &failures);
+        polled = run(count, 1, &busy_polled, &failures);
+        printf("%7u  %18.0f %12.1f %%  %21.0f %12.1f %%\n", (unsigned)count,
+               (double)sequential / BENCH_SECONDS, busy_sequential / (BENCH_SECONDS * 1e7),
+               (double)polled / BENCH_SECONDS, busy_polled / (BENCH_SECONDS * 1e7));
+    }
+
+    // A sensor missing from the bus, and a device not set up
+    BME280_Setup(&missing, &BME280_Model_I2C_Bus, 0x50);
+    memset(&not_set_up, 0, sizeof(not_set_up));
+    mixed[0] = &sensors[0];
+    mixed[1] = &missing;
+    mixed[2] = &not_set_up;
+    mixed[3] = &sensors[1];
+    sensors[0].data.pressure = 0;
+    sensors[1].data.pressure = 0;
+    failures += (BME280_PollDevices(mixed, 4, BME280_ALL_COMP) != BME280_E_NULL_PTR);
+    BME280_Model_Wait();
+    failures += (missing.transaction.error != BME280_E_COMM_FAIL);
+    failures += (sensors[0].transaction.error != BME280_OK) || (sensors[0].data.pressure == 0);
+    failures += (sensors[1].transaction.error != BME280_OK) || (sensors[1].data.pressure == 0);
+    failures += (BME280_ReadData(&not_set_up, BME280_ALL_COMP) != BME280_E_NULL_PTR);
+    failures += (BME280_Start(&not_set_up) != BME280_E_NULL_PTR);
+    failures += (BME280_Setup(NULL, &BME280_Model_I2C_Bus, 0x50) != BME280_E_NULL_PTR);
+    failures += (BME280_Setup(&not_set_up, NULL, 0x50) != BME280_E_NULL_PTR);
+
+    printf("%s\n", failures ? "FAILED" : "Errors of single sensors as expected");
+    return failures ? 1 : 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,131 @@
+/*
+*   Table of BME280 settings chosen by BME280_Planner, to pick
+*   settings offline.
+*
+*   Without arguments, the settings with the lowest current are printed
+*   for a grid of sample periods and pressure noise levels, with humidity
+*   measured. With a sample period in ms, all the settings that meet it
+*   are printed as CSV, sorted by current.
+*
+*   Build and run from this folder:
+*   gcc -O2 -I. -I../01-BME280.cydsn bme280_planner_table.c
+*       ../01-BME280.cydsn/BME280_Planner.c -o bme280_planner_table
+*   ./bme280_planner_table
+*   ./bme280_planner_table 1000 > settings_1s.csv
+*
+*   \author Davide Marzorati
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "BME280_Planner.h"
+
+#define MAX_PLANS 512
+
+static const char* const MODES[] = {"sleep", "forced", "forced", "normal"};
+static const char* const OSR[] = {"skip", "1x", "2x", "4x", "8x", "16x", "16x", "16x"};
+static const char* const FILTER[] = {"off", "2", "4", "8", "16"};
+static const char* const STANDBY[] = {"0.5", "62.5", "125", "250", "500", "1000", "10", "20"};
+
+static int compare_current(const void* a, const void* b)
+{
+    const BME280_Plan* x = a;
+    const BME280_Plan* y = b;
+
+    if ( x->current != y->current)
+    {
+        return (x->current < y->current) ? -1 : 1;
+    }
+    return (int)x->pressure_noise - (int)y->pressure_noise;
+}
+
+static void print_grid(void)
+{
+    static const uint32_t periods[] = {10000, 50000, 100000, 1000000, 10000000, 60000000};
+    static const uint16_t noises[] = {25, 50, 100, 200, 330};
+    BME280_Plan_Target target = {.response_time = 0, .humidity = 1};
+    BME280_Plan plan;
+
+    printf("| Period [ms] | Noise [Pa] | Mode   | osr_p | osr_t | Filter | Standby [ms] "
+           "| Current [uA] | Noise [Pa] | Response [ms] |\n");
+    printf("|-------------|------------|--------|-------|-------|--------|--------------"
+           "|--------------|------------|---------------|\n");
+    for (unsigned i = 0; i < sizeof(periods) / sizeof(periods[0]); i++)
+    {
+        for (unsigned j = 0; j < sizeof(noises) / sizeof(noises[0]); j++)
+        {
+            target.sample_period = periods[i];
+            target.pressure_noise = noises[j];
+            printf("| %11.0f | %10.2f ", periods[i] / 1000.0, noises[j] / 100.0);
+            if ( BME280_Planner_Find(&target, &plan) != BME280_OK)
+            {
+                printf("| -      | -     | -     | -      | -            | -            "
+                       "| -          | -             |\n");
+                continue;
+            }
+            printf("| %-6s | %-5s | %-5s | %-6s | %-12s | %12.3f | %10.2f | %13.0f |\n",
+                   MODES[plan.settings.mode & 0x03], OSR[plan.settings.osr_p & 0x07],
+                   OSR[plan.settings.osr_t & 0x07], FILTER[plan.settings.filter],
+                   (plan.settings.mode == BME280_NORMAL_MODE) ? STANDBY[plan.settings.stanby_time] : "-",
+                   plan.current / 1000.0, plan.pressure_noise / 100.0,
+                   plan.response_time / 1000.0);
+        }
+    }
+}
+
+static void print_all(uint32_t period)
+{
+    static BME280_Plan plans[MAX_PLANS];
+    BME280_Settings settings = {.osr_t = BME280_OVERSAMPLING_1X,
+                                .osr_h = BME280_OVERSAMPLING_1X, .spi_enable = 0};
+    unsigned count = 0;
+
+    for (uint8_t osr_p = BME280_OVERSAMPLING_1X; osr_p <= BME280_OVERSAMPLING_16X; osr_p++)
+    {
+        settings.osr_p = osr_p;
+        settings.osr_t = (osr_p == BME280_OVERSAMPLING_16X) ? BME280_OVERSAMPLING_2X : BME280_OVERSAMPLING_1X;
+        for (uint8_t filter = BME280_FILTER_COEFF_OFF; filter <= BME280_FILTER_COEFF_16; filter++)
+        {
+            settings.filter = filter;
+            settings.mode = BME280_FORCED_MODE;
+            settings.stanby_time = BME280_TSTANBDY_0_5_MS;
+            BME280_Planner_Evaluate(&settings, period, &plans[count]);
+            count += (plans[count].sample_period <= period);
+            settings.mode = BME280_NORMAL_MODE;
+            for (uint8_t standby = BME280_TSTANBDY_0_5_MS; standby <= BME280_TSTANBDY_20_MS; standby++)
+            {
+                settings.stanby_time = standby;
+                BME280_Planner_Evaluate(&settings, 0, &plans[count]);
+                count += (plans[count].sample_period <= period);
+            }
+        }
+    }
+    qsort(plans, count, sizeof(plans[0]), compare_current);
+    printf("mode,osr_p,osr_t,osr_h,filter,standby_ms,measurement_ms,period_ms,"
+           "current_uA,noise_Pa,response_ms\n");
+    for (unsigned i = 0; i < count; i++)
+    {
+        const BME280_Settings* s = &plans[i].settings;
+        printf("%s,%s,%s,%s,%s,%s,%.3f,%.3f,%.3f,%.2f,%.1f\n", MODES[s->mode & 0x03],
+               OSR[s->osr_p & 0x07], OSR[s->osr_t & 0x07], OSR[s->osr_h & 0x07],
+               FILTER[s->filter], (s->mode == BME280_NORMAL_MODE) ? STANDBY[s->stanby_time] : "",
+               plans[i].measurement_time / 1000.0, plans[i].sample_period / 1000.0,
+               plans[i].current / 1000.0, plans[i].pressure_noise / 100.0,
+               plans[i].response_time / 1000.0);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if ( argc > 1)
+    {
+        print_all((uint32_t)(atof(argv[1]) * 1000));
+    }
+    else
+    {
+        print_grid();
+    }
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,185 @@
+/*
+*   Transactions to read a forced mode sample of the BME280 sensor, on
+*   the host bus model.
+*
+*   After each trigger (BME280_SetForcedMode) the application polls the
+*   sensor every (measurement time + BENCH_MARGIN_US) / polls, so that
+*   the sample is ready at the last poll:
+*   - status: BME280_ReadStatusRegister until the measuring bit is
+*             cleared, then BME280_ReadData;
+*   - burst:  BME280_ReadDataIfReady until it does not return
+*             BME280_E_NOT_READY.
+*   BENCH_SAMPLES samples are read each way from the same simulated
+*   sensor. The read transactions, the loop iterations, and the bits on
+*   the bus per sample (trigger write included) are printed; the
+*   compensated values must be the same.
+*
+*   BME280_ReadDataIfReady must also return BME280_E_NOT_READY on a
+*   sensor that was never triggered, on a second call after one trigger,
+*   and on a second call within the same period in normal mode.
+*
+*   Build and run from this folder:
+*   gcc -O2 -I. -I../01-BME280.cydsn bme280_ready_bench.c bme280_bus_model.c
+*       ../01-BME280.cydsn/BME280.c ../01-BME280.cydsn/BME280_I2C_Interface.c
+*       ../01-BME280.cydsn/BME280_Compensation.c -o bme280_ready_bench
+*   ./bme280_ready_bench
+*
+*   \author Davide Marzorati
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "project.h"
+#include "BME280.h"
+#include "bme280_bus_model.h"
+
+#define BENCH_SAMPLES 1000
+#define BENCH_MARGIN_US 100
+
+static const BME280_Settings BENCH_SETTINGS = {
+    BME280_SLEEP_MODE, BME280_OVERSAMPLING_1X, BME280_OVERSAMPLING_1X,
+    BME280_OVERSAMPLING_1X, BME280_FILTER_COEFF_OFF, BME280_TSTANBDY_0_5_MS, 0
+};
+
+static BME280 bme280;
+static BME280_Data status_data[BENCH_SAMPLES];
+static BME280_Data burst_data[BENCH_SAMPLES];
+
+/**
+*   \brief Counters of one way of reading the samples.
+*/
+typedef struct {
+    uint32_t reads;
+    uint32_t iterations;
+    uint32_t bits;
+} BenchCount;
+
+// Same sensor, same samples, for each way
+static int start_sensor(uint64_t* measurement_time)
+{
+    BME280_Model_Device* device;
+    int failures = 0;
+
+    BME280_Model_Reset();
+    device = BME280_Model_AddDevice(BME280_I2C_ADDRESS_PRIMARY);
+    memset(&bme280, 0, sizeof(bme280));
+    BME280_Setup(&bme280, &BME280_Model_I2C_Bus, BME280_I2C_ADDRESS_PRIMARY);
+    failures += (BME280_Start(&bme280) != BME280_OK);
+    failures += (BME280_ApplySettings(&bme280, &BENCH_SETTINGS) != BME280_OK);
+    // Measurement time of the model, as set by ctrl_meas
+    BME280_SetForcedMode(&bme280);
+    BME280_Model_Advance(100000000u);
+    *measurement_time = device->measurement_time;
+    BME280_Model_ClearStats();
+    return failures;
+}
+
+static int read_status(uint32_t polls, BenchCount* count)
+{
+    uint64_t measurement_time, interval;
+    uint8_t status;
+    int failures = start_sensor(&measurement_time);
+
+    interval = (measurement_time + BENCH_MARGIN_US * 1000u) / polls;
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        failures += (BME280_SetForcedMode(&bme280) != BME280_OK);
+        do
+        {
+            BME280_Model_Advance(interval);
+            failures += (BME280_ReadStatusRegister(&bme280, &status) != BME280_OK);
+            count->iterations++;
+        } while ( status & BME280_STATUS_MEASURING);
+        failures += (BME280_ReadData(&bme280, BME280_ALL_COMP) != BME280_OK);
+        status_data[i] = bme280.data;
+    }
+    count->reads = BME280_Model_Stats_Data.reads;
+    count->bits = BME280_Model_Stats_Data.bits;
+    return failures;
+}
+
+static int read_burst(uint32_t polls, BenchCount* count)
+{
+    uint64_t measurement_time, interval;
+    BME280_ErrorCode error;
+    int failures = start_sensor(&measurement_time);
+
+    interval = (measurement_time + BENCH_MARGIN_US * 1000u) / polls;
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        failures += (BME280_SetForcedMode(&bme280) != BME280_OK);
+        do
+        {
+            BME280_Model_Advance(interval);
+            error = BME280_ReadDataIfReady(&bme280, BME280_ALL_COMP);
+            count->iterations++;
+        } while ( error == BME280_E_NOT_READY);
+        failures += (error != BME280_OK);
+        burst_data[i] = bme280.data;
+    }
+    count->reads = BME280_Model_Stats_Data.reads;
+    count->bits = BME280_Model_Stats_Data.bits;
+    return failures;
+}
+
+static int check_repeats(void)
+{
+    BME280_Settings settings = BENCH_SETTINGS;
+    uint64_t measurement_time;
+    int failures = start_sensor(&measurement_time);
+
+    // start_sensor triggered a sample, read it once
+    failures += (BME280_ReadDataIfReady(&bme280, BME280_ALL_COMP) != BME280_OK);
+    failures += (BME280_ReadDataIfReady(&bme280, BME280_ALL_COMP) != BME280_E_NOT_READY);
+
+    // One trigger, two calls
+    failures += (BME280_SetForcedMode(&bme280) != BME280_OK);
+    BME280_Model_Advance(measurement_time + BENCH_MARGIN_US * 1000u);
+    failures += (BME280_ReadDataIfReady(&bme280, BME280_ALL_COMP) != BME280_OK);
+    failures += (BME280_ReadDataIfReady(&bme280, BME280_ALL_COMP) != BME280_E_NOT_READY);
+
+    // Normal mode, two calls after the first sample
+    settings.mode = BME280_NORMAL_MODE;
+    failures += (BME280_ApplySettings(&bme280, &settings) != BME280_OK);
+    BME280_Model_Advance(measurement_time + BENCH_MARGIN_US * 1000u);
+    failures += (BME280_ReadDataIfReady(&bme280, BME280_ALL_COMP) != BME280_OK);
+    failures += (BME280_ReadDataIfReady(&bme280, BME280_ALL_COMP) != BME280_E_NOT_READY);
+
+    // Never triggered
+    memset(&bme280, 0, sizeof(bme280));
+    BME280_Model_Reset();
+    BME280_Model_AddDevice(BME280_I2C_ADDRESS_PRIMARY);
+    BME280_Setup(&bme280, &BME280_Model_I2C_Bus, BME280_I2C_ADDRESS_PRIMARY);
+    failures += (BME280_Start(&bme280) != BME280_OK);
+    failures += (BME280_ReadDataIfReady(&bme280, BME280_ALL_COMP) != BME280_E_NOT_READY);
+
+    printf("Repeated reads: %s\n", failures ? "not detected" : "BME280_E_NOT_READY");
+    return failures;
+}
+
+int main(void)
+{
+    static const uint32_t POLLS[] = {1, 2, 4};
+    int failures = 0;
+
+    printf("Polls  status + ReadData [reads, iterations, bits]  ReadDataIfReady [reads, iterations, bits]\n");
+    for (uint32_t p = 0; p < sizeof(POLLS) / sizeof(POLLS[0]); p++)
+    {
+        BenchCount status = {0}, burst = {0};
+
+        failures += read_status(POLLS[p], &status);
+        failures += read_burst(POLLS[p], &burst);
+        failures += (memcmp(status_data, burst_data, sizeof(status_data)) != 0);
+        printf("%5u  %15.1f %11.1f %7.1f  %26.1f %11.1f %7.1f\n", (unsigned)POLLS[p],
+               (double)status.reads / BENCH_SAMPLES, (double)status.iterations / BENCH_SAMPLES,
+               (double)status.bits / BENCH_SAMPLES,
+               (double)burst.reads / BENCH_SAMPLES, (double)burst.iterations / BENCH_SAMPLES,
+               (double)burst.bits / BENCH_SAMPLES);
+    }
+
+    failures += check_repeats();
+    printf("%s\n", failures ? "FAILED" : "Same samples both ways");
+    return failures ? 1 : 0;
+}
+
+/* [] END OF FILE */
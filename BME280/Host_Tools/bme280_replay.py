@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""Replay a BME280 trace through the change format of the 01-BME280 project.
+
+The samples of a trace, as printed by bme280_decode.py, are filtered with
+the same rules as BME280_Telemetry_ReportOnChange: a sample is sent if a
+channel moved by more than its threshold since the last sample sent, or
+if no sample was sent for a heartbeat interval. The packets are decoded
+back with bme280_decode.ChangeDecoder, and the transmit rate and the
+reconstruction error of each channel are reported.
+
+Usage:
+    python3 bme280_replay.py trace.csv
+    python3 bme280_replay.py --threshold-p 6 --heartbeat-ms 30000 trace.csv
+    python3 bme280_replay.py --synthetic 20000
+"""
+
+import argparse
+import csv
+import math
+import random
+import struct
+
+from bme280_decode import CHANGE_HEADER, CHANGE_TAIL, ChangeDecoder
+
+# Length of the default packets with compensated values
+DEFAULT_PACKET_LEN = 16
+
+
+class Deadband:
+    """Port of BME280_Telemetry_ReportOnChange."""
+
+    def __init__(self, thresholds, heartbeat):
+        self.thresholds = thresholds
+        # Gaps must fit in the 16 bit sample number, as in main.c
+        self.heartbeat = min(max(heartbeat, 1), 0xFFFF)
+        self.last = None
+        self.sequence = 0
+        self.silence = 0
+
+    def report(self, sample):
+        """Return the change packet of a (t, p, h) sample, or b"" if not sent."""
+        sequence = self.sequence
+        self.sequence = (self.sequence + 1) & 0xFFFF
+        if self.silence > 0 and all(abs(x - y) <= th for x, y, th in
+                                    zip(sample, self.last, self.thresholds)):
+            self.silence -= 1
+            return b""
+        self.last = sample
+        self.silence = self.heartbeat - 1
+        t, p, h = sample
+        return CHANGE_HEADER + struct.pack(">HIiI", sequence, p, t, h) + CHANGE_TAIL
+
+
+def read_trace(path):
+    """Read (t, p, h) samples in device units from a bme280_decode.py CSV."""
+    samples = []
+    with open(path, newline="") as f:
+        for row in csv.DictReader(f):
+            samples.append((int(round(float(row["temperature_C"]) * 100)),
+                            int(row["pressure_Pa"]),
+                            int(round(float(row["humidity_RH"]) * 1024))))
+    return samples
+
+
+def synthetic_trace(count, seed=1):
+    """Slow random walk with noise similar to the sensor at 1x oversampling."""
+    rng = random.Random(seed)
+    t, p, h = 2200.0, 101325.0, 45 * 1024.0
+    samples = []
+    for _ in range(count):
+        t += rng.gauss(0, 0.5)
+        p += rng.gauss(0, 0.3)
+        h += rng.gauss(0, 5)
+        samples.append((int(round(t + rng.gauss(0, 0.5))),
+                        int(round(p + rng.gauss(0, 2.5))),
+                        int(round(h + rng.gauss(0, 20)))))
+    return samples
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("trace", nargs="?", help="CSV output of bme280_decode.py")
+    parser.add_argument("--synthetic", type=int, metavar="SAMPLES",
+                        help="replay a synthetic trace instead of a file")
+    parser.add_argument("--threshold-t", type=float, default=0.1, help="degC")
+    parser.add_argument("--threshold-p", type=float, default=12, help="Pa")
+    parser.add_argument("--threshold-h", type=float, default=0.5, help="%%RH")
+    parser.add_argument("--period-ms", type=float, default=500,
+                        help="sample period of the trace")
+    parser.add_argument("--heartbeat-ms", type=float, default=10000)
+    args = parser.parse_args()
+    if args.synthetic:
+        samples = synthetic_trace(args.synthetic)
+    elif args.trace:
+        samples = read_trace(args.trace)
+    else:
+        parser.error("a trace or --synthetic is needed")
+
+    # Same units and rounding as the firmware
+    thresholds = (int(args.threshold_t * 100), int(args.threshold_p),
+                  int(args.threshold_h * 1024))
+    deadband = Deadband(thresholds, int(args.heartbeat_ms // args.period_ms))
+    stream = b"".join(deadband.report(sample) for sample in samples)
+    decoder = ChangeDecoder()
+    rebuilt = decoder.feed(stream)
+
+    # The samples after the last packet cannot be rebuilt
+    count = len(rebuilt)
+    duration = len(samples) * args.period_ms / 1000.0
+    print("samples: %d, packets: %d (%.2f%%), rebuilt: %d" % (
+        len(samples), decoder.received, 100.0 * decoder.received / len(samples), count))
+    print("transmit rate: %.3f packets/s, %.1f B/s (default packets: %.1f B/s)" % (
+        decoder.received / duration, len(stream) / duration,
+        len(samples) * DEFAULT_PACKET_LEN / duration))
+    for i, (name, scale) in enumerate((("temperature_C", 100.0), ("pressure_Pa", 1.0),
+                                      ("humidity_RH", 1024.0))):
+        errors = [abs(rebuilt[k][1 + i] - samples[k][i]) / scale for k in range(count)]
+        print("%s error: max %.4g, rms %.4g, threshold %.4g" % (
+            name, max(errors), math.sqrt(sum(e * e for e in errors) / count),
+            thresholds[i] / scale))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,173 @@
+/*
+*   Transaction count of the BME280 configuration on the host bus model.
+*
+*   A sensor is configured at boot (oversampling, standby time, filter,
+*   normal mode) in three ways, and the I2C transactions, the bits on
+*   the bus, and the bus time are printed for each one:
+*   - register: each setting written as the setters used to do, with a
+*               read of the sensor mode, a write of sleep mode, and a
+*               read-modify-write of the register;
+*   - setters:  the setters of BME280.c, one after the other, which
+*               write only the changed registers of the shadow;
+*   - apply:    a single BME280_ApplySettings.
+*   The registers of the sensor must be the same after the three ways.
+*   BME280_ApplySettings is then called again with the same settings
+*   (no transaction expected), with a new filter in normal mode, and
+*   with an invalid shadow (registers read back once).
+*
+*   Build and run from this folder:
+*   gcc -O2 -I. -I../01-BME280.cydsn bme280_settings_bench.c bme280_bus_model.c
+*       ../01-BME280.cydsn/BME280.c ../01-BME280.cydsn/BME280_I2C_Interface.c
+*       ../01-BME280.cydsn/BME280_Compensation.c -o bme280_settings_bench
+*   ./bme280_settings_bench
+*
+*   \author Davide Marzorati
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "project.h"
+#include "BME280.h"
+#include "BME280_RegMap.h"
+#include "bme280_bus_model.h"
+
+static const BME280_Settings BENCH_SETTINGS = {
+    .mode = BME280_NORMAL_MODE,
+    .osr_p = BME280_OVERSAMPLING_16X,
+    .osr_t = BME280_OVERSAMPLING_2X,
+    .osr_h = BME280_OVERSAMPLING_1X,
+    .filter = BME280_FILTER_COEFF_16,
+    .stanby_time = BME280_TSTANBDY_62_5_MS,
+    .spi_enable = 0
+};
+
+static BME280 bme280;
+static BME280_Model_Device* device;
+
+/******************************************/
+/*            Configurations              */
+/******************************************/
+
+// Previous setters: mode read, sleep mode, read-modify-write of the register
+static void register_write(uint8_t address, uint8_t mask, uint8_t value)
+{
+    uint8_t ctrl_meas, data, pair[2];
+
+    bme280.bus->read(bme280.address, BME280_CTRL_MEAS_REG_ADDR, 1, &ctrl_meas);
+    if ( ctrl_meas & 0x03)
+    {
+        pair[0] = BME280_CTRL_MEAS_REG_ADDR;
+        pair[1] = ctrl_meas & ~0x03;
+        bme280.bus->write_pairs(bme280.address, 1, pair);
+    }
+    bme280.bus->read(bme280.address, address, 1, &data);
+    pair[0] = address;
+    pair[1] = (data & ~mask) | value;
+    bme280.bus->write_pairs(bme280.address, 1, pair);
+    if ( address == BME280_CTRL_HUM_REG_ADDR)
+    {
+        // ctrl_hum is effective only after a write of ctrl_meas
+        bme280.bus->read(bme280.address, BME280_CTRL_MEAS_REG_ADDR, 1, &ctrl_meas);
+        pair[0] = BME280_CTRL_MEAS_REG_ADDR;
+        pair[1] = ctrl_meas;
+        bme280.bus->write_pairs(bme280.address, 1, pair);
+    }
+}
+
+static void configure_register(void)
+{
+    const BME280_Settings* s = &BENCH_SETTINGS;
+
+    register_write(BME280_CTRL_HUM_REG_ADDR, 0x07, s->osr_h);
+    register_write(BME280_CTRL_MEAS_REG_ADDR, 0xE0, s->osr_t << 5);
+    register_write(BME280_CTRL_MEAS_REG_ADDR, 0x1C, s->osr_p << 2);
+    register_write(BME280_CONFIG_REG_ADDR, 0xE0, s->stanby_time << 5);
+    register_write(BME280_CONFIG_REG_ADDR, 0x1C, s->filter << 2);
+    register_write(BME280_CTRL_MEAS_REG_ADDR, 0x03, s->mode);
+}
+
+static void configure_setters(void)
+{
+    const BME280_Settings* s = &BENCH_SETTINGS;
+
+    BME280_SetHumidityOversampling(&bme280, s->osr_h);
+    BME280_SetTemperatureOversampling(&bme280, s->osr_t);
+    BME280_SetPressureOversampling(&bme280, s->osr_p);
+    BME280_SetStandbyTime(&bme280, s->stanby_time);
+    BME280_SetIIRFilter(&bme280, s->filter);
+    BME280_SetNormalMode(&bme280);
+}
+
+static void configure_apply(void)
+{
+    BME280_ApplySettings(&bme280, &BENCH_SETTINGS);
+}
+
+/******************************************/
+/*                 Bench                  */
+/******************************************/
+
+static void print_stats(const char* name)
+{
+    printf("%-24s %3u transactions %5u bits %7.1f us\n", name,
+           (unsigned)BME280_Model_Stats_Data.transactions,
+           (unsigned)BME280_Model_Stats_Data.bits,
+           BME280_Model_Stats_Data.bus_time / 1000.0);
+}
+
+// Start a new sensor, configure it, and return its configuration registers
+static uint32_t run(const char* name, void (*configure)(void))
+{
+    BME280_Model_Reset();
+    device = BME280_Model_AddDevice(BME280_I2C_ADDRESS_PRIMARY);
+    memset(&bme280, 0, sizeof(bme280));
+    BME280_Setup(&bme280, &BME280_Model_I2C_Bus, BME280_I2C_ADDRESS_PRIMARY);
+    if ( BME280_Start(&bme280) != BME280_OK)
+    {
+        printf("%s: sensor not started\n", name);
+        return 0;
+    }
+    BME280_Model_ClearStats();
+    configure();
+    print_stats(name);
+    return ((uint32_t)device->registers[BME280_CTRL_HUM_REG_ADDR] << 16)
+        | ((uint32_t)device->registers[BME280_CTRL_MEAS_REG_ADDR] << 8)
+        | device->registers[BME280_CONFIG_REG_ADDR];
+}
+
+int main(void)
+{
+    uint32_t expected, registers;
+    BME280_Settings settings = BENCH_SETTINGS;
+    int failures = 0;
+
+    printf("Boot configuration:\n");
+    expected = run("register", configure_register);
+    registers = run("setters", configure_setters);
+    failures += (registers != expected);
+    registers = run("apply", configure_apply);
+    failures += (registers != expected);
+
+    printf("Changes after the apply:\n");
+    BME280_Model_ClearStats();
+    BME280_ApplySettings(&bme280, &settings);
+    print_stats("same settings");
+    failures += (BME280_Model_Stats_Data.transactions != 0);
+
+    BME280_Model_ClearStats();
+    settings.filter = BME280_FILTER_COEFF_4;
+    BME280_ApplySettings(&bme280, &settings);
+    print_stats("filter in normal mode");
+    failures += (device->registers[BME280_CONFIG_REG_ADDR] != ((settings.stanby_time << 5) | (settings.filter << 2)))
+        || ((device->registers[BME280_CTRL_MEAS_REG_ADDR] & 0x03) != BME280_NORMAL_MODE);
+
+    BME280_Model_ClearStats();
+    bme280.shadow.valid = 0;
+    BME280_ApplySettings(&bme280, &settings);
+    print_stats("invalid shadow");
+
+    printf("%s\n", failures ? "FAILED: registers differ" : "Registers match");
+    return failures ? 1 : 0;
+}
+
+/* [] END OF FILE */
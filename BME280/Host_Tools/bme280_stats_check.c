@@ -0,0 +1,183 @@
+/*
+*   Windowed statistics of BME280_Statistics against a double precision
+*   reference.
+*
+*   Windows of 1 to BME280_STATS_MAX_WINDOW samples of several signals
+*   (constant, noise around typical values, slow ramps, steps, and values
+*   spread over the whole output range of each channel) are summarized
+*   with BME280_Statistics_Add, and partially with
+*   BME280_Statistics_GetSummary. For each window the reference mean and
+*   sample standard deviation are computed in double precision with two
+*   passes. Minimum and maximum must be the same, mean and standard
+*   deviation must be within half a unit of the last fractional bit of
+*   the reference (rounded to nearest). The largest error of mean and
+*   standard deviation, in units of the last fractional bit, and the
+*   largest standard deviation are printed for each channel.
+*
+*   Build and run from this folder:
+*   gcc -O2 -I. -I../01-BME280.cydsn bme280_stats_check.c
+*       ../01-BME280.cydsn/BME280_Statistics.c -lm -o bme280_stats_check
+*   ./bme280_stats_check
+*
+*   \author Davide Marzorati
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "BME280_Statistics.h"
+
+#define CHECK_RANDOM_WINDOWS 20000
+#define CHECK_SIGNALS 5
+#define CHECK_CHANNELS 3
+
+// Largest difference accepted from the reference rounded to nearest
+#define CHECK_TOLERANCE (0.5 + 1e-6)
+
+static const char* const CHANNEL_NAMES[CHECK_CHANNELS] = {"Pressure", "Temperature", "Humidity"};
+
+// Output range of each channel: Pa, 0.01 degC, 1/1024 %RH
+static const int32_t CHANNEL_MIN[CHECK_CHANNELS] = {30000, -4000, 0};
+static const int32_t CHANNEL_MAX[CHECK_CHANNELS] = {110000, 8500, 102400};
+static const int32_t CHANNEL_TYPICAL[CHECK_CHANNELS] = {101325, 2500, 40960};
+
+static int32_t samples[BME280_STATS_MAX_WINDOW][CHECK_CHANNELS];
+static double max_mean_error[CHECK_CHANNELS];
+static double max_std_dev_error[CHECK_CHANNELS];
+static double max_std_dev[CHECK_CHANNELS];
+static uint32_t windows = 0;
+static uint32_t failures = 0;
+
+static int32_t clamp(int64_t value, uint32_t channel)
+{
+    if ( value < CHANNEL_MIN[channel])
+        return CHANNEL_MIN[channel];
+    if ( value > CHANNEL_MAX[channel])
+        return CHANNEL_MAX[channel];
+    return (int32_t)value;
+}
+
+static int32_t uniform(int32_t low, int32_t high)
+{
+    return low + (int32_t)(((uint64_t)rand() * 65536u + (uint32_t)rand() % 65536u)
+                           % (uint64_t)(high - low + 1));
+}
+
+// Sample i of a signal
+static int32_t signal_value(uint32_t signal, uint32_t channel, uint32_t i)
+{
+    int64_t typical = CHANNEL_TYPICAL[channel];
+
+    switch ( signal)
+    {
+        case 0:
+            return (int32_t)typical;
+        case 1:
+            return clamp(typical + uniform(-20, 20), channel);
+        case 2:
+            return clamp(typical - 3000 + (int64_t)i / 7 + uniform(-3, 3), channel);
+        case 3:
+            return clamp(typical + ((i / 50) % 2) * 900 + uniform(-2, 2), channel);
+        default:
+            return uniform(CHANNEL_MIN[channel], CHANNEL_MAX[channel]);
+    }
+}
+
+static void check_channel(uint32_t channel, uint32_t count, const BME280_Stats_Channel* result)
+{
+    double mean = 0, m2 = 0, std_dev, deviation, error;
+    int32_t min = samples[0][channel], max = samples[0][channel];
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        mean += samples[i][channel];
+        min = (samples[i][channel] < min) ? samples[i][channel] : min;
+        max = (samples[i][channel] > max) ? samples[i][channel] : max;
+    }
+    mean /= count;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        deviation = samples[i][channel] - mean;
+        m2 += deviation * deviation;
+    }
+    mean *= (1 << BME280_STATS_FRAC_BITS);
+    std_dev = (count > 1) ? sqrt(m2 / (count - 1)) * (1 << BME280_STATS_FRAC_BITS) : 0.0;
+
+    failures += (result->min != min) || (result->max != max);
+    error = fabs(result->mean - mean);
+    max_mean_error[channel] = (error > max_mean_error[channel]) ? error : max_mean_error[channel];
+    failures += (error > CHECK_TOLERANCE);
+    // Never saturated: the standard deviation is below the output range
+    error = fabs(result->std_dev - std_dev);
+    max_std_dev_error[channel] = (error > max_std_dev_error[channel])
+                                 ? error : max_std_dev_error[channel];
+    max_std_dev[channel] = (std_dev > max_std_dev[channel]) ? std_dev : max_std_dev[channel];
+    failures += (error > CHECK_TOLERANCE);
+}
+
+static void check_window(uint32_t signal, uint32_t count)
+{
+    BME280_Statistics stats;
+    BME280_Stats_Summary summary, partial;
+    BME280_Data data;
+    uint8_t complete = 0;
+
+    BME280_Statistics_Init(&stats, (uint16_t)count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        for (uint32_t c = 0; c < CHECK_CHANNELS; c++)
+        {
+            samples[i][c] = signal_value(signal, c, i);
+        }
+        data.pressure = (uint32_t)samples[i][0];
+        data.temperature = samples[i][1];
+        data.humidity = (uint32_t)samples[i][2];
+        // Partial summary of the first half of the window
+        if ( i == count / 2 && i > 0)
+        {
+            BME280_Statistics_GetSummary(&stats, &partial);
+            failures += (partial.count != i);
+            check_channel(0, i, &partial.pressure);
+            check_channel(1, i, &partial.temperature);
+            check_channel(2, i, &partial.humidity);
+        }
+        complete = BME280_Statistics_Add(&stats, &data, &summary);
+        failures += (complete != (i + 1 == count));
+    }
+    failures += (summary.count != count);
+    check_channel(0, count, &summary.pressure);
+    check_channel(1, count, &summary.temperature);
+    check_channel(2, count, &summary.humidity);
+    windows++;
+}
+
+int main(void)
+{
+    static const uint32_t SIZES[] = {1, 2, 3, 7, 60, 1000, 4096, BME280_STATS_MAX_WINDOW};
+
+    srand(1);
+    for (uint32_t s = 0; s < CHECK_SIGNALS; s++)
+    {
+        for (uint32_t i = 0; i < sizeof(SIZES) / sizeof(SIZES[0]); i++)
+        {
+            check_window(s, SIZES[i]);
+        }
+    }
+    for (uint32_t i = 0; i < CHECK_RANDOM_WINDOWS; i++)
+    {
+        check_window(rand() % CHECK_SIGNALS, 1 + rand() % 300);
+    }
+
+    printf("%u windows\n", (unsigned)windows);
+    for (uint32_t c = 0; c < CHECK_CHANNELS; c++)
+    {
+        printf("%-12s max error: mean %.4f, standard deviation %.4f (1/%d), "
+               "max standard deviation %.1f\n", CHANNEL_NAMES[c], max_mean_error[c],
+               max_std_dev_error[c], 1 << BME280_STATS_FRAC_BITS,
+               max_std_dev[c] / (1 << BME280_STATS_FRAC_BITS));
+    }
+    printf("%u failures\n", (unsigned)failures);
+    return failures ? 1 : 0;
+}
+
+/* [] END OF FILE */
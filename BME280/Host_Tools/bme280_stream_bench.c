@@ -0,0 +1,138 @@
+/*
+*   Timer driven acquisition of BME280 data with a slow consumer, on the
+*   host bus model.
+*
+*   The sensor runs in normal mode (a sample every 8.5 ms), and
+*   BME280_Stream polls it every BENCH_POLL_MS from the SysTick
+*   interrupt, while the main loop reads the frames in batches of up to
+*   BENCH_BATCH and spends a given time on each frame (e.g., sending a
+*   16-byte packet on a 115200 baud UART), with optional stalls of the
+*   main loop every second. For each consumer, over BENCH_SECONDS (and
+*   the last stall): the frames acquired (stored or dropped) and read
+*   per second, the overruns, the high water mark of the buffer, and the
+*   jitter and the longest interval between the stored frames are printed.
+*
+*   The acquisition rate must be the sample rate of the sensor, whatever
+*   the consumer: frames are dropped only when the consumer falls behind
+*   by more than the BME280_STREAM_BUFFER_LENGTH frames of the buffer.
+*
+*   Build and run from this folder:
+*   gcc -O2 -I. -I../01-BME280.cydsn bme280_stream_bench.c bme280_bus_model.c
+*       ../01-BME280.cydsn/BME280.c ../01-BME280.cydsn/BME280_I2C_Interface.c
+*       ../01-BME280.cydsn/BME280_Compensation.c ../01-BME280.cydsn/BME280_Stream.c
+*       -o bme280_stream_bench
+*   ./bme280_stream_bench
+*
+*   \author Davide Marzorati
+*/
+
+#include <stdio.h>
+#include "project.h"
+#include "BME280.h"
+#include "BME280_Stream.h"
+#include "bme280_bus_model.h"
+
+#define BENCH_SECONDS 20
+#define BENCH_POLL_MS 2
+#define BENCH_BATCH 16
+
+// 16-byte packet on a 115200 baud UART, in us
+#define BENCH_UART_US 1389
+
+/**
+*   \brief Consumer of the frames.
+*/
+typedef struct {
+    const char* name;
+    uint32_t frame_us;      ///< Time spent on each frame
+    uint32_t stall_ms;      ///< Stall of the main loop every second
+    uint8_t overruns;       ///< Overruns expected
+} BenchConsumer;
+
+static const BenchConsumer CONSUMERS[] = {
+    {"UART",                      BENCH_UART_US, 0,   0},
+    {"UART, stall 250 ms/s",      BENCH_UART_US, 250, 0},
+    {"UART, stall 400 ms/s",      BENCH_UART_US, 400, 1},
+    {"12 ms per frame",           12000,         0,   1},
+};
+
+static const BME280_Settings BENCH_SETTINGS = {
+    BME280_NORMAL_MODE, BME280_OVERSAMPLING_1X, BME280_OVERSAMPLING_1X,
+    BME280_OVERSAMPLING_1X, BME280_FILTER_COEFF_OFF, BME280_TSTANBDY_0_5_MS, 0
+};
+
+static BME280 bme280;
+static uint8_t frames[BENCH_BATCH * BME280_P_T_H_DATA_LEN];
+
+int main(void)
+{
+    BME280_Stream_Stats stats;
+    BME280_Stream_Timing timing;
+    uint64_t start, end, next_stall;
+    double seconds;
+    uint32_t read;
+    uint16_t count;
+    int failures = 0;
+
+    BME280_Model_Reset();
+    BME280_Model_AddDevice(BME280_I2C_ADDRESS_PRIMARY);
+    BME280_Setup(&bme280, &BME280_Model_I2C_Bus, BME280_I2C_ADDRESS_PRIMARY);
+    failures += (BME280_Start(&bme280) != BME280_OK);
+    failures += (BME280_ApplySettings(&bme280, &BENCH_SETTINGS) != BME280_OK);
+
+    printf("Consumer                 acquired/s  read/s  overruns  high water  jitter [us]  max interval [us]\n");
+    for (uint32_t c = 0; c < sizeof(CONSUMERS) / sizeof(CONSUMERS[0]); c++)
+    {
+        const BenchConsumer* consumer = &CONSUMERS[c];
+
+        read = 0;
+        start = BME280_Model_Time();
+        end = start + BENCH_SECONDS * 1000000000ull;
+        next_stall = start + 1000000000ull;
+        failures += (BME280_Stream_Start(&bme280, BENCH_POLL_MS) != BME280_OK);
+        while ( BME280_Model_Time() < end)
+        {
+            count = BME280_Stream_Read(frames, BENCH_BATCH);
+            read += count;
+            if ( count > 0)
+            {
+                BME280_Model_Advance((uint64_t)count * consumer->frame_us * 1000u);
+            }
+            else
+            {
+                // Nothing to do until the next interrupt
+                BME280_Model_Advance(1000000u);
+            }
+            if ( consumer->stall_ms > 0 && BME280_Model_Time() >= next_stall)
+            {
+                BME280_Model_Advance((uint64_t)consumer->stall_ms * 1000000u);
+                next_stall += 1000000000ull;
+            }
+        }
+        BME280_Stream_Stop();
+        seconds = (BME280_Model_Time() - start) / 1e9;
+        BME280_Stream_GetStats(&stats);
+        // Frames still in the buffer
+        while ( (count = BME280_Stream_Read(frames, BENCH_BATCH)) > 0)
+        {
+            read += count;
+        }
+        BME280_Stream_GetTiming(&timing);
+
+        printf("%-24s %10.1f  %6.1f  %8u  %10u  %11u  %17u\n", consumer->name,
+               (stats.samples + stats.overruns) / seconds,
+               read / seconds, (unsigned)stats.overruns,
+               (unsigned)stats.high_water, (unsigned)timing.jitter,
+               (unsigned)timing.max_period);
+        // One frame per sample of the sensor, whatever the consumer
+        failures += ((stats.samples + stats.overruns + 2.0) * timing.nominal_period
+                        < seconds * 1e6);
+        failures += (stats.errors != 0) || (read != stats.samples);
+        failures += ((stats.overruns != 0) != consumer->overruns);
+    }
+
+    printf("%s\n", failures ? "FAILED" : "Acquisition independent of the consumer");
+    return failures ? 1 : 0;
+}
+
+/* [] END OF FILE */
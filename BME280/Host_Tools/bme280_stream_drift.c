@@ -0,0 +1,152 @@
+/*
+*   Timestamps and drift of BME280_Stream against a simulated sensor
+*   clock, on the host bus model.
+*
+*   The internal oscillator of the simulated sensor is off by a given
+*   error (BME280_Model_Device.clock_ppm), so that its samples come
+*   faster or slower than the typical sample period of the datasheet.
+*   BME280_Stream polls the sensor every 1 or 2 ms for BENCH_SECONDS,
+*   and the main loop reads the frames with their timestamps. For each
+*   case the drift, the mean period and the jitter of BME280_Stream_GetTiming,
+*   and the largest error of a timestamp from the time at which the
+*   model updated the data registers, are printed.
+*
+*   The drift must be the error of the sensor clock within
+*   BENCH_DRIFT_TOLERANCE ppm, with no gap, and each timestamp must be
+*   within half a poll period (plus the duration of the read) of the
+*   update of the sensor. The last cases give the same data at each
+*   measurement (BME280_Model_Device.constant): the frames are stored one
+*   sample period apart, and their timestamps must be within a poll
+*   period (plus the duration of the read) of the update. In all the
+*   cases, no sample of the sensor must be lost.
+*
+*   Build and run from this folder:
+*   gcc -O2 -I. -I../01-BME280.cydsn bme280_stream_drift.c bme280_bus_model.c
+*       ../01-BME280.cydsn/BME280.c ../01-BME280.cydsn/BME280_I2C_Interface.c
+*       ../01-BME280.cydsn/BME280_Compensation.c ../01-BME280.cydsn/BME280_Stream.c
+*       -o bme280_stream_drift
+*   ./bme280_stream_drift
+*
+*   \author Davide Marzorati
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "project.h"
+#include "BME280.h"
+#include "BME280_Stream.h"
+#include "bme280_bus_model.h"
+
+#define BENCH_SECONDS 60
+#define BENCH_DRIFT_TOLERANCE 50
+
+// Duration of a burst read of the data registers, in ns
+#define BENCH_READ_NS 300000
+
+/**
+*   \brief Sensor settings, clock error and poll period of a case.
+*/
+typedef struct {
+    const char* name;
+    uint8_t osr;                    ///< Oversampling of all the channels
+    uint8_t standby;                ///< Standby time
+    int32_t clock_ppm;              ///< Error of the sensor clock
+    uint32_t poll_ms;               ///< Poll period of the stream
+    uint8_t constant;               ///< Same data at each measurement
+} BenchCase;
+
+static const BenchCase CASES[] = {
+    {"x1, 0.5 ms",  BME280_OVERSAMPLING_1X,  BME280_TSTANBDY_0_5_MS, 0,      1, 0},
+    {"x1, 0.5 ms",  BME280_OVERSAMPLING_1X,  BME280_TSTANBDY_0_5_MS, 20000,  1, 0},
+    {"x1, 0.5 ms",  BME280_OVERSAMPLING_1X,  BME280_TSTANBDY_0_5_MS, -15000, 2, 0},
+    {"x16, 10 ms",  BME280_OVERSAMPLING_16X, BME280_TSTANBDY_10_MS,  3000,   2, 0},
+    {"x2, 62.5 ms", BME280_OVERSAMPLING_2X,  BME280_TSTANBDY_62_5_MS, -500,  2, 0},
+    {"x1, 0.5 ms",  BME280_OVERSAMPLING_1X,  BME280_TSTANBDY_0_5_MS, 0,      2, 1},
+    {"x2, 62.5 ms", BME280_OVERSAMPLING_2X,  BME280_TSTANBDY_62_5_MS, 0,     2, 1},
+};
+
+static BME280 bme280;
+
+static int run(const BenchCase* test)
+{
+    BME280_Settings settings = {
+        BME280_NORMAL_MODE, test->osr, test->osr, test->osr,
+        BME280_FILTER_COEFF_OFF, test->standby, 0
+    };
+    BME280_Model_Device* device;
+    BME280_Stream_Stats stats;
+    BME280_Stream_Timing timing;
+    uint8_t frame[BME280_P_T_H_DATA_LEN];
+    uint32_t stamp;
+    uint64_t start, end;
+    uint32_t first_update, updates;
+    int64_t error, max_error = 0;
+    int64_t max_allowed;
+    int failures = 0;
+
+    BME280_Model_Reset();
+    device = BME280_Model_AddDevice(BME280_I2C_ADDRESS_PRIMARY);
+    // Before the settings, which set the timing of the model
+    device->clock_ppm = test->clock_ppm;
+    device->constant = test->constant;
+    memset(&bme280, 0, sizeof(bme280));
+    BME280_Setup(&bme280, &BME280_Model_I2C_Bus, BME280_I2C_ADDRESS_PRIMARY);
+    failures += (BME280_Start(&bme280) != BME280_OK);
+    failures += (BME280_ApplySettings(&bme280, &settings) != BME280_OK);
+
+    start = BME280_Model_Time();
+    end = start + BENCH_SECONDS * 1000000000ull;
+    failures += (BME280_Stream_Start(&bme280, test->poll_ms) != BME280_OK);
+    // The first read is a reference, the updates after it are the samples
+    first_update = device->measurements;
+    while ( BME280_Model_Time() < end)
+    {
+        BME280_Model_Advance(1000000u);
+        // At most one frame per ms, read before the next update
+        while ( BME280_Stream_ReadStamped(frame, &stamp, 1) > 0)
+        {
+            error = (int64_t)stamp * 1000 - (int64_t)(device->last_update - start);
+            error = (error < 0) ? -error : error;
+            max_error = (error > max_error) ? error : max_error;
+        }
+    }
+    BME280_Stream_Stop();
+    BME280_Stream_GetStats(&stats);
+    BME280_Stream_GetTiming(&timing);
+    // An unchanged frame is stored 1.5 sample periods after the previous one
+    updates = device->measurements - first_update
+              - (test->constant && (end - device->last_update) < timing.nominal_period * 500ull);
+
+    printf("%-11s  %-8s  %+6d  %4u  %9u  %7u  %+6d  %6u  %5u  %5u  %9.0f  %4d\n", test->name,
+           test->constant ? "constant" : "noisy", (int)test->clock_ppm, (unsigned)test->poll_ms,
+           (unsigned)timing.nominal_period, (unsigned)timing.intervals, (int)timing.drift,
+           (unsigned)timing.mean_period, (unsigned)timing.jitter, (unsigned)timing.gaps,
+           max_error / 1000.0, (int)(updates - stats.samples));
+    failures += (stats.errors != 0) || (stats.overruns != 0) || (timing.gaps != 0);
+    failures += (stats.samples != updates);
+    failures += (timing.intervals + 2) * (uint64_t)timing.mean_period < BENCH_SECONDS * 1000000ull;
+    failures += (timing.drift > test->clock_ppm + BENCH_DRIFT_TOLERANCE);
+    failures += (timing.drift < test->clock_ppm - BENCH_DRIFT_TOLERANCE);
+    max_allowed = test->poll_ms * (test->constant ? 1000000 : 500000) + BENCH_READ_NS;
+    failures += (max_error > max_allowed);
+    return failures;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    printf("Settings     signal     clock  poll  nominal    intervals  drift  mean    jitter gaps   "
+           "max stamp error  lost\n");
+    printf("                        [ppm]  [ms]  [us]                 [ppm]  [us]    [us]          "
+           "[us]\n");
+    for (uint32_t c = 0; c < sizeof(CASES) / sizeof(CASES[0]); c++)
+    {
+        failures += run(&CASES[c]);
+    }
+
+    printf("%s\n", failures ? "FAILED" : "Drift of the sensor clock measured");
+    return failures ? 1 : 0;
+}
+
+/* [] END OF FILE */
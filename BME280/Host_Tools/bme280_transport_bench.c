@@ -0,0 +1,199 @@
+/*
+*   The BME280 driver over I2C and over SPI, on the host bus model.
+*
+*   The same sequence of API calls is run on a sensor on the I2C bus
+*   (BME280_Model_I2C_Bus) and on a sensor on the chip select of
+*   SPIM_BME280 (BME280_SPI_Bus, built from BME280_SPI_Interface.c):
+*   start, settings, forced mode samples read with BME280_ReadDataIfReady,
+*   normal mode samples read with BME280_ReadData and BME280_ReadDataAsync,
+*   status and mode reads, soft reset and start with stored calibration
+*   data. All the results must be the same. For each transport, the
+*   start up time, and the bits on the bus, the bus time and the CPU
+*   time of a sample read are printed, with the longest time with
+*   interrupts disabled.
+*
+*   Then the SPI sensor is also read by BME280_Stream every ms from the
+*   SysTick interrupt while the main loop reads it with BME280_ReadData:
+*   reads started by the interrupt during a transfer of the main loop
+*   must be refused with BME280_E_BUSY, with interrupts never disabled
+*   for a whole transfer, and no read may return corrupted data.
+*
+*   Build and run from this folder:
+*   gcc -O2 -I. -I../01-BME280.cydsn bme280_transport_bench.c bme280_bus_model.c
+*       ../01-BME280.cydsn/BME280.c ../01-BME280.cydsn/BME280_I2C_Interface.c
+*       ../01-BME280.cydsn/BME280_SPI_Interface.c ../01-BME280.cydsn/BME280_Compensation.c
+*       ../01-BME280.cydsn/BME280_Stream.c -o bme280_transport_bench
+*   ./bme280_transport_bench
+*
+*   \author Davide Marzorati
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "project.h"
+#include "BME280.h"
+#include "BME280_SPI_Interface.h"
+#include "BME280_Stream.h"
+#include "bme280_bus_model.h"
+
+#define BENCH_SAMPLES 100
+#define BENCH_STREAM_READS 10000
+
+// Normal mode reads: 1 ms after the end of the third measurement, then
+// every second measurement (BENCH_NORMAL, 16.5 ms per measurement)
+#define BENCH_FIRST_READ_NS 50000000u
+#define BENCH_READ_PERIOD_NS 33000000u
+
+// Results of the calls, one per call
+#define BENCH_RESULTS (8 + 3 * BENCH_SAMPLES)
+
+static const BME280_Settings BENCH_FORCED = {
+    BME280_FORCED_MODE, BME280_OVERSAMPLING_1X, BME280_OVERSAMPLING_1X,
+    BME280_OVERSAMPLING_1X, BME280_FILTER_COEFF_OFF, BME280_TSTANBDY_0_5_MS, 0
+};
+
+static const BME280_Settings BENCH_NORMAL = {
+    BME280_NORMAL_MODE, BME280_OVERSAMPLING_2X, BME280_OVERSAMPLING_4X,
+    BME280_OVERSAMPLING_1X, BME280_FILTER_COEFF_4, BME280_TSTANBDY_0_5_MS, 0
+};
+
+/**
+*   \brief Results of the API calls on one transport.
+*/
+typedef struct {
+    const char* name;
+    BME280_Calib_Data calib_data;
+    BME280_Data data[BENCH_RESULTS];
+    BME280_ErrorCode errors[BENCH_RESULTS];
+    uint32_t count;
+    double start_us;
+    double bits;
+    double bus_us;
+    double cpu_us;
+    double critical_us;
+} BenchRun;
+
+static BME280 bme280;
+static BenchRun runs[2] = {{.name = "I2C"}, {.name = "SPI"}};
+
+static void store(BenchRun* run, BME280_ErrorCode error)
+{
+    run->errors[run->count] = error;
+    run->data[run->count] = bme280.data;
+    run->count++;
+}
+
+static void run_api(BenchRun* run, const BME280_Bus* bus, uint8_t address)
+{
+    BME280_Calib_Data calib_data;
+    uint64_t start, next;
+    uint8_t status;
+
+    BME280_Model_Reset();
+    BME280_Model_AddDevice(address);
+    memset(&bme280, 0, sizeof(bme280));
+    bus->start();
+    store(run, BME280_Setup(&bme280, bus, address));
+
+    BME280_Model_ClearStats();
+    start = BME280_Model_Time();
+    store(run, BME280_Start(&bme280));
+    run->start_us = (BME280_Model_Time() - start) / 1000.0;
+    run->calib_data = bme280.calib_data;
+
+    // Forced mode
+    store(run, BME280_ApplySettings(&bme280, &BENCH_FORCED));
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        BME280_SetForcedMode(&bme280);
+        BME280_Model_Advance(4000000u);
+        BME280_ReadDataIfReady(&bme280, BME280_ALL_COMP);
+        BME280_Model_Advance(6000000u);
+        store(run, BME280_ReadDataIfReady(&bme280, BME280_ALL_COMP));
+    }
+
+    // Normal mode, blocking and non-blocking reads
+    store(run, BME280_ApplySettings(&bme280, &BENCH_NORMAL));
+    next = BME280_Model_Time() + BENCH_FIRST_READ_NS;
+    BME280_Model_ClearStats();
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        // Same time after the end of a measurement on both transports
+        BME280_Model_Advance(next - BME280_Model_Time());
+        next += BENCH_READ_PERIOD_NS;
+        start = BME280_Model_Time();
+        store(run, BME280_ReadData(&bme280, BME280_ALL_COMP));
+        run->cpu_us += (BME280_Model_Time() - start) / 1000.0 / BENCH_SAMPLES;
+    }
+    run->bits = (double)BME280_Model_Stats_Data.bits / BENCH_SAMPLES;
+    run->bus_us = BME280_Model_Stats_Data.bus_time / 1000.0 / BENCH_SAMPLES;
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        BME280_Model_Advance(next - BME280_Model_Time());
+        next += BENCH_READ_PERIOD_NS;
+        store(run, BME280_ReadDataAsync(&bme280, NULL, NULL));
+        BME280_Model_Wait();
+        BME280_ParseSensorData(&bme280, bme280.raw_data);
+        BME280_CompensateData(&bme280, BME280_ALL_COMP);
+    }
+
+    // Registers, reset, and start with stored calibration data
+    store(run, BME280_GetSensorMode(&bme280));
+    store(run, BME280_ReadStatusRegister(&bme280, &status));
+    bme280.data.pressure = status;
+    bme280.data.temperature = bme280.settings.mode;
+    store(run, BME280_Reset(&bme280));
+    calib_data = bme280.calib_data;
+    store(run, BME280_StartWithCalibData(&bme280, &calib_data));
+    run->critical_us = BME280_Model_Stats_Data.max_critical / 1000.0;
+}
+
+int main(void)
+{
+    BME280_Stream_Stats stats;
+    uint8_t frames[BME280_STREAM_BUFFER_LENGTH * BME280_P_T_H_DATA_LEN];
+    int failures = 0;
+
+    run_api(&runs[0], &BME280_Model_I2C_Bus, BME280_I2C_ADDRESS_PRIMARY);
+    run_api(&runs[1], &BME280_SPI_Bus, BME280_MODEL_SPI_DEVICE);
+
+    printf("Transport  start [us]  sample read: bits  bus [us]  CPU [us]  interrupts disabled [us]\n");
+    for (uint32_t r = 0; r < 2; r++)
+    {
+        printf("%-9s  %10.1f  %17.1f  %8.1f  %8.1f  %24.1f\n", runs[r].name, runs[r].start_us,
+               runs[r].bits, runs[r].bus_us, runs[r].cpu_us, runs[r].critical_us);
+        for (uint32_t i = 0; i < runs[r].count; i++)
+        {
+            failures += (runs[r].errors[i] != BME280_OK);
+        }
+    }
+    failures += (runs[0].count != runs[1].count);
+    failures += (memcmp(&runs[0].calib_data, &runs[1].calib_data, sizeof(runs[0].calib_data)) != 0);
+    failures += (memcmp(runs[0].data, runs[1].data, sizeof(runs[0].data)) != 0);
+
+    // Reads of the main loop and of the SysTick interrupt on the same bus
+    BME280_Model_ClearStats();
+    BME280_Stream_Start(&bme280, 1);
+    for (uint32_t i = 0; i < BENCH_STREAM_READS; i++)
+    {
+        // Work of the main loop between the reads, 20 to 120 us
+        BME280_Model_Advance(20000u + (i * 7919u) % 101u * 1000u);
+        failures += (BME280_ReadData(&bme280, BME280_ALL_COMP) != BME280_OK);
+        // Bytes of another transfer would give values out of the range
+        failures += (bme280.data.pressure < 30000) || (bme280.data.pressure > 110000);
+        BME280_Stream_Read(frames, BME280_STREAM_BUFFER_LENGTH);
+    }
+    BME280_Stream_Stop();
+    BME280_Stream_GetStats(&stats);
+    printf("Stream on SPI with reads of the main loop: %u new frames, %u repeated, %u refused "
+           "(last error %d), interrupts disabled at most %.1f us\n", (unsigned)stats.samples,
+           (unsigned)stats.repeats, (unsigned)stats.errors, stats.last_error,
+           BME280_Model_Stats_Data.max_critical / 1000.0);
+    failures += (stats.errors == 0) || (stats.last_error != BME280_E_BUSY) || (stats.samples == 0);
+    failures += (BME280_Model_Stats_Data.max_critical > 2000);
+
+    printf("%s\n", failures ? "FAILED" : "Same results over I2C and SPI");
+    return failures ? 1 : 0;
+}
+
+/* [] END OF FILE */
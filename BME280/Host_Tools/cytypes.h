@@ -0,0 +1,36 @@
+/*
+*   Minimal replacement of the PSoC Creator cytypes.h, to build
+*   the platform independent files of the driver on a host.
+*/
+
+#ifndef CY_BOOT_CYTYPES_H
+    #define CY_BOOT_CYTYPES_H
+
+    #include <stdint.h>
+    #include <stddef.h>
+
+    typedef uint8_t uint8;
+    typedef uint16_t uint16;
+    typedef uint32_t uint32;
+    typedef int8_t int8;
+    typedef int16_t int16;
+    typedef int32_t int32;
+    typedef uint32_t cystatus;
+
+    #define CYRET_SUCCESS ((cystatus)0x00u)
+    #define CYRET_BAD_PARAM ((cystatus)0x01u)
+    #define CYRET_LOCKED ((cystatus)0x04u)
+    #define CYRET_STARTED ((cystatus)0x07u)
+    #define CYRET_UNKNOWN ((cystatus)0xFFFFFFFFu)
+
+    #define CYDEV_BCLK__SYSCLK__HZ 24000000u
+
+    typedef volatile uint32 reg32;
+
+    // Registers of the Cortex-M3 are read from bme280_bus_model.c
+    uint32 CyHost_GetReg32(uintptr_t address);
+    #define CY_GET_REG32(addr) CyHost_GetReg32((uintptr_t)(addr))
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,185 @@
+/*
+*   Host emulator of the PSoC Creator EEPROM component.
+*
+*   \author Davide Marzorati
+*/
+
+#include <string.h>
+#include "eeprom_emulator.h"
+
+uint8_t EEPROM_Emulator_Memory[CY_EEPROM_SIZE];
+EEPROM_Emulator_Stats EEPROM_Emulator_Stats_Data;
+
+// Row programmed in background
+static uint8_t pending_data[CY_EEPROM_SIZEOF_ROW];
+static int pending_row = -1;
+static uint64_t pending_end;
+// Value of bytes_programmed at the power failure, and row left by it
+static uint32_t power_cut = EEPROM_EMULATOR_NO_FAULT;
+static EEPROM_Emulator_Fault cut_fault = EEPROM_EMULATOR_TORN;
+// Random bytes of the corrupted rows
+static uint32_t rng_state = 0x6D2B79F5u;
+
+static void EEPROM_Emulator_Busy(uint64_t us)
+{
+    EEPROM_Emulator_Stats_Data.busy_time += us;
+    EEPROM_Emulator_Stats_Data.time += us;
+}
+
+static void EEPROM_Emulator_Program(uint8 row, const uint8* data)
+{
+    uint8* memory = &EEPROM_Emulator_Memory[row * CY_EEPROM_SIZEOF_ROW];
+    uint32_t start = EEPROM_Emulator_Stats_Data.bytes_programmed;
+
+    EEPROM_Emulator_Stats_Data.row_programs++;
+    EEPROM_Emulator_Stats_Data.row_erases[row]++;
+    EEPROM_Emulator_Stats_Data.bytes_programmed += CY_EEPROM_SIZEOF_ROW;
+    // Rows programmed after the power failure are not changed
+    if ( start > power_cut || (start == power_cut && cut_fault == EEPROM_EMULATOR_TORN))
+    {
+        return;
+    }
+    memset(memory, 0, CY_EEPROM_SIZEOF_ROW);
+    if ( cut_fault == EEPROM_EMULATOR_TORN || power_cut - start >= CY_EEPROM_SIZEOF_ROW)
+    {
+        for (uint8 b = 0; b < CY_EEPROM_SIZEOF_ROW && start + b < power_cut; b++)
+        {
+            memory[b] = data[b];
+        }
+    }
+    else if ( cut_fault == EEPROM_EMULATOR_CORRUPTED)
+    {
+        // Cells left half erased read any value
+        for (uint8 b = 0; b < CY_EEPROM_SIZEOF_ROW; b++)
+        {
+            rng_state ^= rng_state << 13;
+            rng_state ^= rng_state >> 17;
+            rng_state ^= rng_state << 5;
+            memory[b] = (uint8)rng_state;
+        }
+    }
+}
+
+// A blocking write waits for the row programmed in background
+static void EEPROM_Emulator_Complete(void)
+{
+    if ( pending_row >= 0)
+    {
+        if ( EEPROM_Emulator_Stats_Data.time < pending_end)
+        {
+            EEPROM_Emulator_Busy(pending_end - EEPROM_Emulator_Stats_Data.time);
+        }
+        EEPROM_Query();
+    }
+}
+
+void EEPROM_Emulator_Reset(void)
+{
+    memset(EEPROM_Emulator_Memory, 0, sizeof(EEPROM_Emulator_Memory));
+    memset(&EEPROM_Emulator_Stats_Data, 0, sizeof(EEPROM_Emulator_Stats_Data));
+    pending_row = -1;
+    power_cut = EEPROM_EMULATOR_NO_FAULT;
+    cut_fault = EEPROM_EMULATOR_TORN;
+}
+
+void EEPROM_Emulator_Advance(uint32_t us)
+{
+    EEPROM_Emulator_Stats_Data.time += us;
+}
+
+void EEPROM_Emulator_CutPower(uint32_t bytes)
+{
+    power_cut = (bytes == EEPROM_EMULATOR_NO_FAULT) ? bytes : EEPROM_Emulator_Stats_Data.bytes_programmed + bytes;
+}
+
+void EEPROM_Emulator_SetFault(EEPROM_Emulator_Fault fault)
+{
+    cut_fault = fault;
+}
+
+void EEPROM_Start(void)
+{
+}
+
+void EEPROM_Stop(void)
+{
+}
+
+cystatus EEPROM_WriteByte(uint8 dataByte, uint16 address)
+{
+    uint8 row[CY_EEPROM_SIZEOF_ROW];
+
+    if ( address >= CY_EEPROM_SIZE)
+    {
+        return CYRET_BAD_PARAM;
+    }
+    // The component reads the row, changes the byte, and programs the row
+    EEPROM_Emulator_Complete();
+    memcpy(row, &EEPROM_Emulator_Memory[address - address % CY_EEPROM_SIZEOF_ROW], CY_EEPROM_SIZEOF_ROW);
+    row[address % CY_EEPROM_SIZEOF_ROW] = dataByte;
+    EEPROM_Emulator_Program(address / CY_EEPROM_SIZEOF_ROW, row);
+    EEPROM_Emulator_Busy(EEPROM_EMULATOR_ROW_TIME_US);
+    return CYRET_SUCCESS;
+}
+
+uint8 EEPROM_ReadByte(uint16 address)
+{
+    EEPROM_Emulator_Stats_Data.bytes_read++;
+    return (address < CY_EEPROM_SIZE) ? EEPROM_Emulator_Memory[address] : 0;
+}
+
+cystatus EEPROM_Write(const uint8* rowData, uint8 rowNumber)
+{
+    if ( rowNumber >= CY_EEPROM_NUMBER_ROWS)
+    {
+        return CYRET_BAD_PARAM;
+    }
+    EEPROM_Emulator_Complete();
+    EEPROM_Emulator_Program(rowNumber, rowData);
+    EEPROM_Emulator_Busy(EEPROM_EMULATOR_ROW_TIME_US);
+    return CYRET_SUCCESS;
+}
+
+cystatus EEPROM_StartWrite(const uint8* rowData, uint8 rowNumber)
+{
+    EEPROM_Emulator_Busy(EEPROM_EMULATOR_CALL_TIME_US);
+    if ( rowNumber >= CY_EEPROM_NUMBER_ROWS)
+    {
+        return CYRET_BAD_PARAM;
+    }
+    if ( pending_row >= 0)
+    {
+        return CYRET_LOCKED;
+    }
+    memcpy(pending_data, rowData, CY_EEPROM_SIZEOF_ROW);
+    pending_row = rowNumber;
+    pending_end = EEPROM_Emulator_Stats_Data.time + EEPROM_EMULATOR_ROW_TIME_US;
+    return CYRET_SUCCESS;
+}
+
+cystatus EEPROM_Query(void)
+{
+    EEPROM_Emulator_Busy(EEPROM_EMULATOR_CALL_TIME_US);
+    if ( pending_row >= 0 && EEPROM_Emulator_Stats_Data.time < pending_end)
+    {
+        return CYRET_STARTED;
+    }
+    if ( pending_row >= 0)
+    {
+        EEPROM_Emulator_Program((uint8)pending_row, pending_data);
+        pending_row = -1;
+    }
+    return CYRET_SUCCESS;
+}
+
+cystatus EEPROM_UpdateTemperature(void)
+{
+    return CYRET_SUCCESS;
+}
+
+void CyDelay(uint32 milliseconds)
+{
+    EEPROM_Emulator_Busy((uint64_t)milliseconds * 1000u);
+}
+
+/* [] END OF FILE */
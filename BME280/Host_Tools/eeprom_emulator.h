@@ -0,0 +1,118 @@
+/*
+*   Host emulator of the PSoC Creator EEPROM component.
+*
+*   The EEPROM is kept in RAM, every row program (erase and write of
+*   a row) is counted, per row and in total, and the time spent by the
+*   CPU waiting for the EEPROM is accumulated.
+*
+*   Time is simulated: it advances with the blocking calls (EEPROM_Write,
+*   EEPROM_WriteByte, CyDelay), with the polls of EEPROM_Query, and with
+*   EEPROM_Emulator_Advance for the work of the application. A row
+*   started with EEPROM_StartWrite is programmed in background, and is
+*   stored when EEPROM_Query is called after EEPROM_EMULATOR_ROW_TIME_US.
+*
+*   Power failures can be injected with EEPROM_Emulator_CutPower: a row
+*   program erases the row (all bytes 0) and then programs its bytes from
+*   the first one, so a program cut by the power failure leaves the row
+*   with the first bytes written and the others erased. With
+*   EEPROM_Emulator_SetFault the power fails during the erase instead,
+*   and the whole row is left erased or with random bytes.
+*
+*   \author Davide Marzorati
+*/
+
+#ifndef __EEPROM_EMULATOR_H
+    #define __EEPROM_EMULATOR_H
+
+    #include "EEPROM.h"
+
+    /**
+    *   \brief Time of a row program in us.
+    */
+    #ifndef EEPROM_EMULATOR_ROW_TIME_US
+        #define EEPROM_EMULATOR_ROW_TIME_US 20000u
+    #endif
+
+    /**
+    *   \brief Time taken by a call to EEPROM_Query or EEPROM_StartWrite in us.
+    */
+    #ifndef EEPROM_EMULATOR_CALL_TIME_US
+        #define EEPROM_EMULATOR_CALL_TIME_US 5u
+    #endif
+
+    /**
+    *   \brief Value of EEPROM_Emulator_CutPower for no power failure.
+    */
+    #define EEPROM_EMULATOR_NO_FAULT 0xFFFFFFFFu
+
+    /**
+    *   \brief Row left by a power failure during its program.
+    */
+    typedef enum {
+        EEPROM_EMULATOR_TORN,           ///< First bytes programmed, the others erased
+        EEPROM_EMULATOR_ERASED,         ///< Cut during the erase, all bytes erased
+        EEPROM_EMULATOR_CORRUPTED       ///< Cut during the erase, random bytes
+    } EEPROM_Emulator_Fault;
+
+    /**
+    *   \brief Counters of the emulator.
+    */
+    typedef struct {
+        uint32_t row_programs;                          ///< Row programs since the last reset
+        uint32_t row_erases[CY_EEPROM_NUMBER_ROWS];     ///< Programs of each row
+        uint64_t busy_time;                             ///< Time spent in EEPROM calls and CyDelay, in us
+        uint64_t time;                                  ///< Simulated time, in us
+        uint32_t bytes_read;                            ///< Bytes read with EEPROM_ReadByte
+        uint32_t bytes_programmed;                      ///< Bytes of the row programs, also the ones lost
+    } EEPROM_Emulator_Stats;
+
+    /**
+    *   \brief Content of the emulated EEPROM.
+    */
+    extern uint8_t EEPROM_Emulator_Memory[CY_EEPROM_SIZE];
+
+    /**
+    *   \brief Counters of the emulated EEPROM.
+    */
+    extern EEPROM_Emulator_Stats EEPROM_Emulator_Stats_Data;
+
+    /**
+    *   \brief Erase the emulated EEPROM (all bytes 0) and reset the counters.
+    */
+    void EEPROM_Emulator_Reset(void);
+
+    /**
+    *   \brief Advance the simulated time, e.g. for the work of the application.
+    *
+    *   \param[in] us : time in us
+    */
+    void EEPROM_Emulator_Advance(uint32_t us);
+
+    /**
+    *   \brief Cut the power during a later row program.
+    *
+    *   The byte number bytes of the row programs from now on (0 for the
+    *   first byte of the next program) and all the next ones are lost,
+    *   until this function is called again. The row being programmed is
+    *   left torn. EEPROM_Emulator_Reset restores the power.
+    *
+    *   \param[in] bytes : bytes programmed before the power failure, or
+    *                      EEPROM_EMULATOR_NO_FAULT
+    */
+    void EEPROM_Emulator_CutPower(uint32_t bytes);
+
+    /**
+    *   \brief Set the row left by the next power failures.
+    *
+    *   With #EEPROM_EMULATOR_ERASED and #EEPROM_EMULATOR_CORRUPTED, the
+    *   row whose program includes the byte of the power failure is
+    *   changed as a whole, also when the power fails at its first byte.
+    *   EEPROM_Emulator_Reset sets #EEPROM_EMULATOR_TORN.
+    *
+    *   \param[in] fault : row left by the power failure
+    */
+    void EEPROM_Emulator_SetFault(EEPROM_Emulator_Fault fault);
+
+#endif
+
+/* [] END OF FILE */
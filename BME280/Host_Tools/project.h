@@ -0,0 +1,17 @@
+/*
+*   Replacement of the project.h generated by PSoC Creator, with
+*   the components of the host bus model (bme280_bus_model.c).
+*/
+
+#ifndef CY_PROJECT_H
+    #define CY_PROJECT_H
+
+    #include "cytypes.h"
+    #include "CyLib.h"
+    #include "I2C_Master.h"
+    #include "SPIM_BME280.h"
+    #include "BME280_CS.h"
+
+#endif
+
+/* [] END OF FILE */